@@ -40,10 +40,11 @@ extern "C" int LLVMFuzzerTestOneInput( uint8_t* const p, size_t const sz ) {
   dns::dns_t _dns;
 
   nygma::pcap::with( std::move( data ), [&]( auto const& pcap ) noexcept {
+    constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
     if( not pcap.valid() ) { return; }
     pcap.for_each( [&]( auto const& pkt, auto const ) {
       _trace.rewind();
-      dissect::dissect_en10mb( _hash_policy, _trace, pkt._slice );
+      dissect::dissect_linktype<LINKTYPE>( _hash_policy, _trace, pkt._slice );
       if( _trace._assume_dns && _trace.valid() ) {
         auto const rc = _dns.dissect( _trace._dns_begin, _trace._end );
         if( rc == dns::dns_dissect_rc::OK ) { _dns_count++; }
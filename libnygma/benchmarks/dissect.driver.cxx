@@ -3,6 +3,7 @@
 #include <pest/pnch.hxx>
 #include <pest/xoshiro.hxx>
 
+#include <libnygma/dissect-simd.hxx>
 #include <libnygma/dissect.hxx>
 #include <libnygma/toeplitz.hxx>
 
@@ -10,6 +11,7 @@
 #include <cstdint>
 #include <iostream>
 #include <type_traits>
+#include <vector>
 
 namespace dissect = nygma::dissect;
 namespace toeplitz = nygma::toeplitz;
@@ -18,6 +20,8 @@ namespace xoshiro = emptyspace::xoshiro;
 using hash_type = toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_symmetric>;
 using bytestring_view = unclassified::bytestring_view;
 using dissect_tag = dissect::dissect_tag;
+using endianess = unclassified::endianess;
+namespace unsafe = unclassified::unsafe;
 
 // clang-format off
  
@@ -65,6 +69,25 @@ static const unsigned char pkt3[64] = {
 
 // clang-format on
 
+// extracts what `index_trace` indexes, like `dissect_en10mb_batch` does
+struct fields_trace : public dissect::dissect_trace {
+  std::uint32_t _h{ 0 };
+
+  template <typename T>
+  inline void operator()( T&& t ) noexcept {
+    using U = std::decay_t<T>;
+    if constexpr( std::is_same_v<U, dissect::ipv4> ) {
+      _h ^= unsafe::rd32<endianess::BE>( t._begin + 12 );
+      _h ^= unsafe::rd32<endianess::BE>( t._begin + 16 );
+    } else if constexpr( std::is_same_v<U, dissect::ipv6> ) {
+      _h ^= static_cast<std::uint32_t>( unsafe::rd128<endianess::BE>( t._begin + 8 ) );
+      _h ^= static_cast<std::uint32_t>( unsafe::rd128<endianess::BE>( t._begin + 24 ) );
+    } else if constexpr( std::is_same_v<U, dissect::tcp> || std::is_same_v<U, dissect::udp> ) {
+      _h ^= unsafe::rd32<endianess::BE>( t._begin );
+    }
+  }
+};
+
 int main() {
   emptyspace::pnch::config cfg;
   std::uint32_t h = 0;
@@ -114,6 +137,43 @@ int main() {
       .offset( offset )
       .report_to( std::cerr, "normalized" );
 
+  // batches of `B` packets from the mix, dissected one by one and at once. the batches rotate
+  // through a long random sequence, the branch predictor should not learn the mix
+  constexpr std::size_t B = 16;
+  constexpr std::size_t M = 1u << 12;
+  std::vector<nygma::packet_view> sequence( M + B );
+  for( auto& pkt : sequence ) { pkt._slice = mix[xo0() & ( N - 1 )]; }
+  auto const void_hash = dissect::void_hash_policy{};
+  auto fields = fields_trace{};
+  dissect::dissect_batch<B> out;
+  std::size_t at = 0;
+
+  cfg.run( "dissect x16 (scalar)",
+           [&]() {
+             auto const* const batch = sequence.data() + at;
+             for( std::size_t i = 0; i < B; ++i ) {
+               dissect::dissect_en10mb( void_hash, fields, batch[i]._slice );
+             }
+             at = ( at + B + 1 ) & ( M - 1 );
+             h ^= fields._h;
+           } )
+      .touch( h )
+      .report_to( std::cerr );
+
+#ifdef __AVX512F__
+  char const* const batched = "dissect x16 (batch avx512)";
+#else
+  char const* const batched = "dissect x16 (batch avx2)";
+#endif
+  cfg.run( batched,
+           [&]() {
+             dissect::dissect_en10mb_batch( sequence.data() + at, B, out );
+             at = ( at + B + 1 ) & ( M - 1 );
+             h ^= out._src4[0] ^ out._dport[B - 1] ^ out._ports;
+           } )
+      .touch( h )
+      .report_to( std::cerr );
+
   /*
   cfg.run(
          "dissect pkt2 (avx2)",
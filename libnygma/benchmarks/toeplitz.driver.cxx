@@ -7,6 +7,7 @@
 
 #include <array>
 #include <iostream>
+#include <string>
 
 namespace toeplitz = nygma::toeplitz;
 namespace xoshiro = emptyspace::xoshiro;
@@ -95,5 +96,84 @@ int main() {
       .offset( offset )
       .report_to( std::cerr, "normalized" );
 
+#if defined( __PCLMUL__ )
+  toeplitz::toeplitz_clmul<toeplitz::rss_key_symmetric> rss_clmul;
+  xoshiro::xoshiro256starstar64 xo2{ 0x2342 };
+  xoshiro::xoshiro256starstar64 xo6_2{ 0x2342 };
+
+  cfg.run( "v4: toeplitz_clmul",
+           [&]() {
+             v4._64 = xo2();
+             h ^= rss_clmul.hash<8>( v4._array.data() );
+           } )
+      .touch( h )
+      .report_to( std::cerr )
+      .offset( offset )
+      .report_to( std::cerr, "normalized" );
+
+  cfg.run( "v6: toeplitz_clmul",
+           [&]() {
+             v6._256[0] = xo6_2();
+             v6._256[1] = xo6_2();
+             v6._256[2] = xo6_2();
+             v6._256[3] = xo6_2();
+             h ^= rss_clmul.hash<32>( v6._array.data() );
+           } )
+      .touch( h )
+      .report_to( std::cerr )
+      .offset( offset )
+      .report_to( std::cerr, "normalized" );
+#endif
+
+  // batches of 16 tuples with ports ( `hash_batch<16>` ), one call per run. the tuples change
+  // between calls by a xor with a random word
+  constexpr std::size_t B = 16;
+  alignas( 32 ) std::uint32_t src4[B], dst4[B], out[B];
+  alignas( 32 ) __uint128_t src6[B], dst6[B];
+  alignas( 32 ) std::uint16_t sport[B], dport[B];
+  xoshiro::xoshiro256starstar64 xo_batch{ 0x4223 };
+  for( std::size_t i = 0; i < B; i++ ) {
+    src4[i] = static_cast<std::uint32_t>( xo_batch() );
+    dst4[i] = static_cast<std::uint32_t>( xo_batch() );
+    src6[i] = __uint128_t( xo_batch() ) << 64 | xo_batch();
+    dst6[i] = __uint128_t( xo_batch() ) << 64 | xo_batch();
+    sport[i] = static_cast<std::uint16_t>( xo_batch() );
+    dport[i] = static_cast<std::uint16_t>( xo_batch() );
+  }
+
+  auto batch = [&]( char const* const name, auto const& rss ) {
+    xoshiro::xoshiro256starstar64 xo{ 0x2342 };
+    cfg.run( std::string{ "v4+ports x16: " } + name,
+             [&]() {
+               src4[h % B] ^= static_cast<std::uint32_t>( xo() );
+               rss.template hash_batch<B>( src4, dst4, sport, dport, out );
+               h ^= out[0] ^ out[B - 1];
+             } )
+        .touch( h )
+        .report_to( std::cerr )
+        .offset( offset )
+        .report_to( std::cerr, "normalized" );
+    cfg.run( std::string{ "v6+ports x16: " } + name,
+             [&]() {
+               src6[h % B] ^= xo();
+               rss.template hash_batch<B>( src6, dst6, sport, dport, out );
+               h ^= out[0] ^ out[B - 1];
+             } )
+        .touch( h )
+        .report_to( std::cerr )
+        .offset( offset )
+        .report_to( std::cerr, "normalized" );
+  };
+
+  batch( "toeplitz_batch<toeplitz_scalar_lut>",
+         toeplitz::toeplitz_batch<toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_symmetric>>{} );
+#if defined( __PCLMUL__ )
+  batch( "toeplitz_batch<toeplitz_clmul>",
+         toeplitz::toeplitz_batch<toeplitz::toeplitz_clmul<toeplitz::rss_key_symmetric>>{} );
+#endif
+#if defined( __GFNI__ ) && defined( __AVX2__ )
+  batch( "toeplitz_gfni", toeplitz::toeplitz_gfni<toeplitz::rss_key_symmetric>{} );
+#endif
+
   return 0;
 }
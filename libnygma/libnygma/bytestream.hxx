@@ -53,7 +53,7 @@ class bytestream_ostream {
   bytestream_status::type write( std::byte const b ) noexcept {
     auto& self = downcast();
     auto const rc = self._write_byte_( b );
-    _status = rc;
+    _status |= rc;
     return rc;
   }
 
@@ -117,8 +117,9 @@ class cfile_ostream : public bytestream_ostream<cfile_ostream> {
 
   bytestream_status::type _write_bytes_( std::byte const* const p, std::size_t const n ) noexcept {
     if( invalid() ) { return bytestream_status::FAILED; }
+    if( n == 0 ) { return bytestream_status::OK; }
     if( auto rc = std::fwrite( p, n, 1, _handle ); rc != 1 ) { return bytestream_status::FAILED; }
-    return bytestream_status::FAILED;
+    return bytestream_status::OK;
   }
 
   template <typename T>
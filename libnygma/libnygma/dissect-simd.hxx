@@ -3,11 +3,15 @@
 #pragma once
 
 #include <libnygma/dissect.hxx>
+#include <libnygma/packet-view.hxx>
 #include <libnygma/support.hxx>
 
 #include <libunclassified/bytestring.hxx>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
 #include <immintrin.h>
@@ -46,7 +50,7 @@ using bytestring_view = unclassified::bytestring_view;
     }                                                                                                 \
   } while( false )
 
-// unfinished: do not use!
+// single packet, stops at L3. see `dissect_en10mb_batch` for the indexing hot path
 template <typename Trace, typename HashPolicy>
 static inline std::uint32_t dissect_en10mb_avx2( HashPolicy& hash_policy, Trace& trace,
                                                  bytestring_view const& view ) noexcept {
@@ -111,4 +115,271 @@ parse_vlan_mpls:
 
 #undef _next_
 
+//--batched-dissection---------------------------------------------------------
+//
+// dissects `N` ( a multiple of 8 ) ethernet frames at once. every header field is fetched with
+// one masked 32bit gather per 8 packets ( AVX-512: a single gather over 8 64bit addresses, AVX2:
+// two 4 lane gathers ), lanes failing a bounds check drop out of the masks of the next layer.
+// the result is a structure of arrays, lane `i` belongs to packet `i` of the batch.
+//
+// it covers what `index_trace` consumes from `dissect_en10mb`: 802.1q / qinq, ipv4 ( addresses of
+// all fragments, ports of first fragments only ), ipv6 ( without extension headers ) as well as
+// tcp / udp ports. the bounds checks match the scalar dissector with the exception of ipv4
+// headers shorter than 20 bytes, which get dropped. no flow hashes are computed. tunnels and
+// fragments are left to the scalar dissector, their lanes are only flagged in `_tunnel` and
+// `_fragment`.
+
+template <std::size_t N>
+struct dissect_batch {
+  static_assert( N > 0 and N % 8 == 0 and N <= 32 );
+  static constexpr std::size_t BATCHLEN = N;
+
+  std::size_t _count{ 0 };
+  // lane bitmasks: ipv4 / ipv6 headers, complete tcp or udp headers ( see `_proto` )
+  std::uint32_t _ipv4{ 0 };
+  std::uint32_t _ipv6{ 0 };
+  std::uint32_t _ports{ 0 };
+  // mpls, gre, ip-in-ip, vxlan or gtp-u: the other fields of these lanes are incomplete
+  std::uint32_t _tunnel{ 0 };
+  // ipv4 fragments and ipv6 packets starting with a fragment header
+  std::uint32_t _fragment{ 0 };
+  // addresses and ports as integers ( most significant byte first )
+  alignas( 32 ) std::uint32_t _src4[N];
+  alignas( 32 ) std::uint32_t _dst4[N];
+  alignas( 32 ) __uint128_t _src6[N];
+  alignas( 32 ) __uint128_t _dst6[N];
+  alignas( 32 ) std::uint16_t _sport[N];
+  alignas( 32 ) std::uint16_t _dport[N];
+  // L3 / L4 offsets within the packet, the L4 protocol ( ipv6: first next header )
+  alignas( 32 ) std::uint16_t _l3[N];
+  alignas( 32 ) std::uint16_t _l4[N];
+  alignas( 32 ) std::uint8_t _proto[N];
+};
+
+namespace detail {
+
+// the base addresses of 8 packets
+struct lanes {
+#if defined( __AVX512F__ )
+  __m512i _addr;
+#else
+  __m256i _lo;
+  __m256i _hi;
+#endif
+};
+
+inline lanes to_lanes( std::uint64_t const* const addr ) noexcept {
+#if defined( __AVX512F__ )
+  return { _mm512_loadu_si512( addr ) };
+#else
+  return { _mm256_loadu_si256( reinterpret_cast<__m256i const*>( addr ) ),
+           _mm256_loadu_si256( reinterpret_cast<__m256i const*>( addr + 4 ) ) };
+#endif
+}
+
+inline __m256i set1( int const x ) noexcept { return _mm256_set1_epi32( x ); }
+
+inline __m256i and_( __m256i const a, __m256i const b ) noexcept {
+  return _mm256_and_si256( a, b );
+}
+
+inline __m256i or_( __m256i const a, __m256i const b ) noexcept {
+  return _mm256_or_si256( a, b );
+}
+
+inline __m256i add( __m256i const a, int const b ) noexcept {
+  return _mm256_add_epi32( a, set1( b ) );
+}
+
+inline __m256i eq( __m256i const a, int const b ) noexcept {
+  return _mm256_cmpeq_epi32( a, set1( b ) );
+}
+
+// `mask ? a : b` per lane
+inline __m256i select( __m256i const mask, __m256i const a, __m256i const b ) noexcept {
+  return _mm256_blendv_epi8( b, a, mask );
+}
+
+// the 32bit words at `offset` of all lanes in `mask` ( all bits set ), zero for the other lanes
+inline __m256i gather32( lanes const& base, __m256i const offset, __m256i const mask ) noexcept {
+#if defined( __AVX512F__ )
+  auto const addr = _mm512_add_epi64( base._addr, _mm512_cvtepu32_epi64( offset ) );
+  auto const k = static_cast<__mmask8>( _mm256_movemask_ps( _mm256_castsi256_ps( mask ) ) );
+  return _mm512_mask_i64gather_epi32( _mm256_setzero_si256(), k, addr, nullptr, 1 );
+#else
+  // absolute addresses as indices of a null base
+  auto const* const null = static_cast<int const*>( nullptr );
+  auto const zero = _mm_setzero_si128();
+  auto const o_lo = _mm256_cvtepu32_epi64( _mm256_castsi256_si128( offset ) );
+  auto const o_hi = _mm256_cvtepu32_epi64( _mm256_extracti128_si256( offset, 1 ) );
+  auto const a_lo = _mm256_add_epi64( base._lo, o_lo );
+  auto const a_hi = _mm256_add_epi64( base._hi, o_hi );
+  auto const m_lo = _mm256_castsi256_si128( mask );
+  auto const m_hi = _mm256_extracti128_si256( mask, 1 );
+  auto const x = _mm256_mask_i64gather_epi32( zero, null, a_lo, m_lo, 1 );
+  auto const y = _mm256_mask_i64gather_epi32( zero, null, a_hi, m_hi, 1 );
+  return _mm256_set_m128i( y, x );
+#endif
+}
+
+inline __m256i gather32( lanes const& base, int const offset, __m256i const mask ) noexcept {
+  return gather32( base, set1( offset ), mask );
+}
+
+// `offset + len <= size` per lane
+inline __m256i fits( __m256i const size, __m256i const offset, __m256i const len ) noexcept {
+  return _mm256_cmpgt_epi32( size, add( _mm256_add_epi32( offset, len ), -1 ) );
+}
+
+inline __m256i fits( __m256i const size, __m256i const offset, int const len ) noexcept {
+  return fits( size, offset, set1( len ) );
+}
+
+// the big endian 16bit integer in the low bytes of every word
+inline __m256i be16_lo( __m256i const x ) noexcept {
+  auto const shuffle = _mm256_setr_epi8( 1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1,
+                                         1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1 );
+  return _mm256_shuffle_epi8( x, shuffle );
+}
+
+inline __m256i be32( __m256i const x ) noexcept {
+  auto const shuffle = _mm256_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+  return _mm256_shuffle_epi8( x, shuffle );
+}
+
+inline std::uint32_t bits( __m256i const mask ) noexcept {
+  return static_cast<std::uint32_t>( _mm256_movemask_ps( _mm256_castsi256_ps( mask ) ) );
+}
+
+// stores the low 16bits of the words of `a` and `b` ( both < 2^16 ) to `pa` / `pb`
+inline void store16( std::uint16_t* const pa, std::uint16_t* const pb, __m256i const a,
+                     __m256i const b ) noexcept {
+  auto const x = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), 0b11'01'10'00 );
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( pa ), _mm256_castsi256_si128( x ) );
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( pb ), _mm256_extracti128_si256( x, 1 ) );
+}
+
+// stores the low bytes of the words of `a` ( all < 2^8 ) to `p`
+inline void store8( std::uint8_t* const p, __m256i const a ) noexcept {
+  auto const x = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, a ), 0b11'01'10'00 );
+  auto const y = _mm_packus_epi16( _mm256_castsi256_si128( x ), _mm256_castsi256_si128( x ) );
+  _mm_storel_epi64( reinterpret_cast<__m128i*>( p ), y );
+}
+
+inline __uint128_t rd128_be( std::byte const* const p ) noexcept {
+  auto const shuffle = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+  auto const x = _mm_loadu_si128( reinterpret_cast<__m128i const*>( p ) );
+  auto const y = _mm_shuffle_epi8( x, shuffle );
+  __uint128_t r;
+  std::memcpy( &r, &y, sizeof( r ) );
+  return r;
+}
+
+// dissects the 8 packets at `addr` with sizes `size` into lanes `[k, k + 8)` of `out`
+template <std::size_t N>
+inline void dissect_en10mb_8( std::uint64_t const* const addr, std::uint32_t const* const size,
+                              std::size_t const k, dissect_batch<N>& out ) noexcept {
+  auto const base = to_lanes( addr );
+  auto const sz = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( size ) );
+  auto const zero = _mm256_setzero_si256();
+  auto const byte = set1( 0xff );
+
+  // the gathers of a layer only depend on the previous layer ( three gather latencies per batch ),
+  // they load whatever is in bounds and the masks get narrowed down afterwards
+
+  // L2: ethertype, 802.1q and qinq ( like `dissect_en10mb` )
+  auto const eth = fits( sz, zero, 20 );
+  auto const et0 = be16_lo( gather32( base, 12, eth ) );
+  auto const vlan_ex = be16_lo( gather32( base, 16, eth ) );
+  auto const vlan_et = be16_lo( gather32( base, 20, fits( sz, zero, 24 ) ) );
+  auto const tagged = or_( or_( eq( et0, 0x8100 ), eq( et0, 0x8a88 ) ), eq( et0, 0x9100 ) );
+  auto const vlan = and_( eth, tagged );
+  auto const qinq = and_( vlan, eq( vlan_ex, 0x8100 ) );
+  auto const et = select( vlan, select( qinq, vlan_et, vlan_ex ), et0 );
+  auto const l3 = add( select( vlan, select( qinq, set1( 8 ), set1( 4 ) ), zero ), 14 );
+
+  // L3
+  auto v4 = and_( and_( eth, eq( et, 0x0800 ) ), fits( sz, l3, 20 ) );
+  auto v6 = and_( and_( eth, eq( et, 0x86dd ) ), fits( sz, l3, 40 ) );
+  auto const l3_ok = or_( v4, v6 );
+  auto const ihl = _mm256_slli_epi32( and_( gather32( base, l3, v4 ), set1( 0x0f ) ), 2 );
+  // ipv6: payload length and next header, ipv4: identification and fragment offset
+  auto const w4 = gather32( base, add( l3, 4 ), l3_ok );
+  auto const w8 = gather32( base, add( l3, 8 ), v4 );
+  auto const w12 = gather32( base, add( l3, 12 ), v4 );
+  auto const w16 = gather32( base, add( l3, 16 ), v4 );
+  v4 = and_( v4, and_( _mm256_cmpgt_epi32( ihl, set1( 19 ) ), fits( sz, l3, ihl ) ) );
+  v6 = and_( v6, fits( sz, add( l3, 40 ), be16_lo( w4 ) ) );
+  auto const next = and_( _mm256_srli_epi32( w4, 16 ), byte );
+  auto const flags = and_( be16_lo( _mm256_srli_epi32( w4, 16 ) ), set1( 0x3fff ) );
+  auto const foffset = and_( flags, set1( 0x1fff ) );
+  auto const src4 = and_( v4, be32( w12 ) );
+  auto const dst4 = and_( v4, be32( w16 ) );
+  auto const proto = select( v4, and_( _mm256_srli_epi32( w8, 8 ), byte ), and_( v6, next ) );
+  auto const l4 = select( v4, _mm256_add_epi32( l3, ihl ), and_( v6, add( l3, 40 ) ) );
+
+  // L4: only the first fragment of an ipv4 datagram has ports
+  auto const later = and_( v4, _mm256_cmpgt_epi32( foffset, zero ) );
+  auto const l4_ok = _mm256_andnot_si256( later, or_( v4, v6 ) );
+  auto tcp = and_( and_( l4_ok, eq( proto, 6 ) ), fits( sz, l4, 20 ) );
+  auto const udp = and_( and_( l4_ok, eq( proto, 17 ) ), fits( sz, l4, 8 ) );
+  auto const doff = gather32( base, add( l4, 12 ), tcp );
+  auto const wp = be32( gather32( base, l4, or_( tcp, udp ) ) );
+  tcp = and_( tcp, fits( sz, l4, and_( _mm256_srli_epi32( doff, 2 ), set1( 0x3c ) ) ) );
+  auto const ports = or_( tcp, udp );
+
+  // tunnels, see `dissect_en10mb`
+  auto const mpls = and_( eth, or_( eq( et, 0x8847 ), eq( et, 0x8848 ) ) );
+  auto const ipip = and_( l4_ok, or_( or_( eq( proto, 4 ), eq( proto, 41 ) ), eq( proto, 47 ) ) );
+  auto const dport = and_( wp, set1( 0xffff ) );
+  auto const udp_tunnel = and_( udp, or_( eq( dport, VXLAN_PORT ), eq( dport, GTPU_PORT ) ) );
+  auto const tunnel = or_( or_( mpls, ipip ), udp_tunnel );
+  auto const fragment4 = _mm256_andnot_si256( eq( flags, 0 ), v4 );
+  auto const fragment = or_( fragment4, and_( v6, eq( next, 44 ) ) );
+
+  out._ipv4 |= bits( v4 ) << k;
+  out._ipv6 |= bits( v6 ) << k;
+  out._ports |= bits( ports ) << k;
+  out._tunnel |= bits( tunnel ) << k;
+  out._fragment |= bits( fragment ) << k;
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( out._src4 + k ), src4 );
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( out._dst4 + k ), dst4 );
+  auto const sport = and_( ports, _mm256_srli_epi32( wp, 16 ) );
+  store16( out._sport + k, out._dport + k, sport, and_( ports, dport ) );
+  store16( out._l3 + k, out._l4 + k, l3, l4 );
+  store8( out._proto + k, proto );
+
+  // ipv6 addresses are too wide for gathers
+  for( auto m = bits( v6 ); m != 0; m &= m - 1 ) {
+    auto const i = static_cast<unsigned>( __builtin_ctz( m ) );
+    auto const* const p = reinterpret_cast<std::byte const*>( addr[i] ) + out._l3[k + i];
+    out._src6[k + i] = rd128_be( p + 8 );
+    out._dst6[k + i] = rd128_be( p + 24 );
+  }
+}
+
+} // namespace detail
+
+// dissects the first `n` ( at most `N` ) packets of `pkts` into `out`
+template <std::size_t N>
+inline void dissect_en10mb_batch( packet_view const* const pkts, std::size_t const n,
+                                  dissect_batch<N>& out ) noexcept {
+  // sizes beyond any header offset, signed 32bit compares stay valid
+  constexpr std::size_t MAX_SIZE = 1u << 24;
+  alignas( 64 ) std::uint64_t addr[N];
+  alignas( 32 ) std::uint32_t size[N];
+  out._count = std::min( n, N );
+  out._ipv4 = out._ipv6 = out._ports = out._tunnel = out._fragment = 0;
+  for( std::size_t i = 0; i < N; ++i ) {
+    // missing packets have no bytes and fail every bounds check
+    auto const valid = i < out._count;
+    addr[i] = valid ? reinterpret_cast<std::uint64_t>( pkts[i].data() ) : 0u;
+    size[i] = valid ? static_cast<std::uint32_t>( std::min( pkts[i].size(), MAX_SIZE ) ) : 0u;
+  }
+  for( std::size_t k = 0; k < N; k += 8 ) {
+    detail::dissect_en10mb_8( addr + k, size + k, k, out );
+  }
+}
+
 } // namespace nygma::dissect
@@ -7,7 +7,9 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
+#include <vector>
 
 namespace dissect = nygma::dissect;
 
@@ -19,6 +21,22 @@ namespace {
 
 // clang-format off
 
+/* Frame (86 bytes) */
+// ipv6 / tcp
+static const unsigned char pkt1[86] = {
+0x1c, 0x36, 0xbb, 0x13, 0x43, 0xe2, 0x3a, 0x17, /* .6..C.:. */
+0xe1, 0xfb, 0xbb, 0xe0, 0x86, 0xdd, 0x64, 0x00, /* ......d. */
+0x00, 0x00, 0x00, 0x20, 0x06, 0x3a, 0x20, 0x01, /* ... .: . */
+0x05, 0x58, 0xfe, 0xed, 0x00, 0x00, 0x00, 0x00, /* .X...... */
+0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x26, 0x03, /* ......&. */
+0x30, 0x01, 0x19, 0x75, 0xd0, 0x00, 0x3d, 0xa3, /* 0..u..=. */
+0xc2, 0xea, 0x4a, 0x00, 0x2c, 0xcc, 0x00, 0x35, /* ..J.,..5 */
+0xec, 0xc0, 0xdd, 0x6b, 0x34, 0x5e, 0xe6, 0x00, /* ...k4^.. */
+0xe2, 0x32, 0x80, 0x10, 0x00, 0x10, 0xfb, 0x50, /* .2.....P */
+0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x1b, 0x4e, /* .......N */
+0x4f, 0x91, 0x3c, 0x1e, 0x32, 0x4f              /* O.<.2O */
+};
+
 /* Frame (78 bytes) */
 static const unsigned char pkt2[78] = {
 0x88, 0xb1, 0xe1, 0xd4, 0x88, 0x31, 0x1c, 0x36, /* .....1.6 */
@@ -48,6 +66,136 @@ static const unsigned char pkt3[64] = {
 
 // clang-format on
 
+using bytes = std::vector<std::byte>;
+
+bytes to_bytes( unsigned char const* const p, std::size_t const n ) {
+  bytes r( n );
+  std::memcpy( r.data(), p, n );
+  return r;
+}
+
+// `pkt2` behind a 802.1q tag, as udp
+bytes vlan_udp() {
+  auto r = to_bytes( pkt2, sizeof( pkt2 ) );
+  auto const tag = to_bytes( reinterpret_cast<unsigned char const*>( "\x81\x00\x00\x64" ), 4 );
+  r.insert( r.begin() + 12, tag.begin(), tag.end() );
+  r[18 + 9] = std::byte( 17 );
+  return r;
+}
+
+// a later fragment of `pkt2`
+bytes fragment() {
+  auto r = to_bytes( pkt2, sizeof( pkt2 ) );
+  r[14 + 6] = std::byte( 0x00 );
+  r[14 + 7] = std::byte( 0xb9 );
+  return r;
+}
+
+// `pkt1` as first fragment, behind an ipv6 fragment header
+bytes fragment6() {
+  auto r = to_bytes( pkt1, sizeof( pkt1 ) );
+  // tcp, offset 0 with more fragments, identification 42
+  unsigned char const fh[] = { 0x06, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x2a };
+  auto const header = to_bytes( fh, sizeof( fh ) );
+  r.insert( r.begin() + 54, header.begin(), header.end() );
+  r[14 + 5] = std::byte( 0x28 );
+  r[14 + 6] = std::byte( 44 );
+  return r;
+}
+
+// `pkt2` with another ip protocol
+bytes ip_protocol( unsigned const protocol ) {
+  auto r = to_bytes( pkt2, sizeof( pkt2 ) );
+  r[14 + 9] = std::byte( protocol );
+  return r;
+}
+
+// `vlan_udp` to another destination port
+bytes udp_port( unsigned const port ) {
+  auto r = vlan_udp();
+  r[18 + 20 + 2] = std::byte( port >> 8 );
+  r[18 + 20 + 3] = std::byte( port & 0xff );
+  return r;
+}
+
+// `pkt2` as payload of a mpls label
+bytes mpls() {
+  auto r = to_bytes( pkt2, sizeof( pkt2 ) );
+  auto const label = to_bytes( reinterpret_cast<unsigned char const*>( "\x00\x01\x01\x40" ), 4 );
+  r.insert( r.begin() + 14, label.begin(), label.end() );
+  r[12] = std::byte( 0x88 );
+  r[13] = std::byte( 0x47 );
+  return r;
+}
+
+// what `index_trace` takes from the scalar dissector
+struct fields_trace : public dissect::dissect_trace {
+  bool _ipv4{ false };
+  bool _ipv6{ false };
+  bool _ports{ false };
+  std::uint32_t _src4{ 0 };
+  std::uint32_t _dst4{ 0 };
+  __uint128_t _src6{ 0 };
+  __uint128_t _dst6{ 0 };
+  std::uint16_t _sport{ 0 };
+  std::uint16_t _dport{ 0 };
+
+  template <typename V>
+  void operator()( V&& v ) noexcept {
+    constexpr auto BE = unclassified::endianess::BE;
+    namespace unsafe = unclassified::unsafe;
+    using T = std::decay_t<V>;
+    if constexpr( std::is_same_v<T, dissect::ipv4> || std::is_same_v<T, dissect::ipv4f> ) {
+      _ipv4 = true;
+      _src4 = unsafe::rd32<BE>( v._begin + 12 );
+      _dst4 = unsafe::rd32<BE>( v._begin + 16 );
+    } else if constexpr( std::is_same_v<T, dissect::ipv6> ) {
+      _ipv6 = true;
+      _src6 = unsafe::rd128<BE>( v._begin + 8 );
+      _dst6 = unsafe::rd128<BE>( v._begin + 24 );
+    } else if constexpr( std::is_same_v<T, dissect::tcp> || std::is_same_v<T, dissect::udp> ) {
+      _ports = true;
+      _sport = unsafe::rd16<BE>( v._begin );
+      _dport = unsafe::rd16<BE>( v._begin + 2 );
+    }
+  }
+};
+
+// dissects `pkts` in batches of `N` and compares every lane with the scalar dissector
+template <std::size_t N, typename Expect>
+void expect_scalar_equivalence( std::vector<nygma::packet_view> const& pkts, Expect& expect ) {
+  using namespace emptyspace::pest;
+  dissect::dissect_batch<N> b;
+  for( std::size_t first = 0; first < pkts.size(); first += N ) {
+    auto const n = std::min( N, pkts.size() - first );
+    dissect::dissect_en10mb_batch( pkts.data() + first, n, b );
+    expect( b._count, equal_to( n ) );
+    for( std::size_t i = 0; i < n; ++i ) {
+      fields_trace t;
+      auto hash_policy = hash_type{};
+      dissect::dissect_en10mb( hash_policy, t, pkts[first + i]._slice );
+      auto const bit = 1u << i;
+      // tunnels and fragments are left to the scalar dissector
+      if( ( b._tunnel | b._fragment ) & bit ) { continue; }
+      expect( ( b._ipv4 & bit ) != 0, equal_to( t._ipv4 ) );
+      expect( ( b._ipv6 & bit ) != 0, equal_to( t._ipv6 ) );
+      expect( ( b._ports & bit ) != 0, equal_to( t._ports ) );
+      if( t._ipv4 ) {
+        expect( b._src4[i], equal_to( t._src4 ) );
+        expect( b._dst4[i], equal_to( t._dst4 ) );
+      }
+      if( t._ipv6 ) {
+        expect( b._src6[i] == t._src6, equal_to( true ) );
+        expect( b._dst6[i] == t._dst6, equal_to( true ) );
+      }
+      if( t._ports ) {
+        expect( b._sport[i], equal_to( t._sport ) );
+        expect( b._dport[i], equal_to( t._dport ) );
+      }
+    }
+  }
+}
+
 emptyspace::pest::suite basic( "dissect suite", []( auto& test ) {
   using namespace emptyspace::pest;
 
@@ -82,6 +230,67 @@ emptyspace::pest::suite basic( "dissect suite", []( auto& test ) {
     expect( trace.entries()[2]._data, equal_to( offset( 22 ) ) );
     expect( hash, equal_to( 0u ) );
   } );
+
+  test( "batch: dissect a mix", []( auto& expect ) {
+    auto const v = vlan_udp();
+    std::vector<nygma::packet_view> pkts{
+        bytestring_view{ pkt1 }, bytestring_view{ pkt2 }, bytestring_view{ pkt3 },
+        bytestring_view{ v.data(), v.size() } };
+    dissect::dissect_batch<8> b;
+    dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    expect( b._count, equal_to( 4u ) );
+    expect( b._ipv4, equal_to( 0b1010u ) );
+    expect( b._ipv6, equal_to( 0b0001u ) );
+    expect( b._ports, equal_to( 0b1011u ) );
+    // 172.16.101.110:53091 -> 8.8.8.8:53 ( tcp )
+    expect( b._src4[1], equal_to( 0xac10656eu ) );
+    expect( b._dst4[1], equal_to( 0x08080808u ) );
+    expect( b._sport[1], equal_to( 53091u ) );
+    expect( b._dport[1], equal_to( 53u ) );
+    expect( b._proto[1], equal_to( 6u ) );
+    expect( b._l3[1], equal_to( 14u ) );
+    expect( b._l4[1], equal_to( 34u ) );
+    // 2001:558:feed::1 -> 2603:3001:1975:d000:3da3:c2ea:4a00:2ccc
+    auto const src6 = ( __uint128_t( 0x20010558feed0000ull ) << 64 ) | 1u;
+    expect( b._src6[0] == src6, equal_to( true ) );
+    expect( b._sport[0], equal_to( 53u ) );
+    expect( b._l4[0], equal_to( 54u ) );
+    // 802.1q tagged udp
+    expect( b._l3[3], equal_to( 18u ) );
+    expect( b._proto[3], equal_to( 17u ) );
+    expect( b._dport[3], equal_to( 53u ) );
+  } );
+
+  test( "batch: tunnels are flagged", []( auto& expect ) {
+    // gre, ip-in-ip, ipv6-in-ip, vxlan, gtp-u, mpls and then esp, udp and two fragments
+    std::vector<bytes> const frames{ ip_protocol( 47 ), ip_protocol( 4 ), ip_protocol( 41 ),
+                                     udp_port( 4789 ), udp_port( 2152 ), mpls(),
+                                     ip_protocol( 50 ), udp_port( 4790 ), fragment(),
+                                     fragment6() };
+    std::vector<nygma::packet_view> pkts;
+    for( auto const& f : frames ) { pkts.emplace_back( bytestring_view{ f.data(), f.size() } ); }
+    dissect::dissect_batch<16> b;
+    dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    expect( b._tunnel, equal_to( 0b000'111'111u ) );
+    expect( b._ipv4, equal_to( 0b111'011'111u ) );
+    expect( b._ipv6, equal_to( 0b1'000'000'000u ) );
+    expect( b._fragment, equal_to( 0b1'100'000'000u ) );
+  } );
+
+  test( "batch: equivalent to the scalar dissector", []( auto& expect ) {
+    std::vector<bytes> frames{ to_bytes( pkt1, sizeof( pkt1 ) ), to_bytes( pkt2, sizeof( pkt2 ) ),
+                               to_bytes( pkt3, sizeof( pkt3 ) ), vlan_udp(), fragment(),
+                               fragment6(), ip_protocol( 47 ), udp_port( 4789 ), mpls() };
+    // every truncation of every frame
+    std::vector<nygma::packet_view> pkts;
+    for( auto const& f : frames ) {
+      for( std::size_t n = 0; n <= f.size(); ++n ) {
+        pkts.emplace_back( bytestring_view{ f.data(), n } );
+      }
+    }
+    expect_scalar_equivalence<8>( pkts, expect );
+    expect_scalar_equivalence<16>( pkts, expect );
+  } );
 } );
 
 } // namespace
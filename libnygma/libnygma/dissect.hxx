@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <libnygma/packet-view.hxx>
 #include <libnygma/support.hxx>
 #include <libunclassified/bytestring.hxx>
 
@@ -20,6 +21,8 @@ enum class dissect_tag {
   arp,
   ectp,
   eth,
+  gre,
+  gtpu,
   icmpv4,
   icmpv6,
   ipv4,
@@ -28,11 +31,14 @@ enum class dissect_tag {
   ipv6f,
   llc,
   lldp,
+  loopback,
   mpls,
   sctp,
+  sll,
   tcp,
   udp,
   vlan_8021q,
+  vxlan,
   unkown,
 };
 
@@ -46,6 +52,7 @@ class dissect_trace {
   struct entry {
     dissect_tag _tag;
     std::byte const* _data;
+    unsigned _depth;
   };
 
  private:
@@ -57,6 +64,7 @@ class dissect_trace {
     for( unsigned i = 0; i < _stack.size(); i++ ) {
       _stack[i]._tag = dissect_tag::unkown;
       _stack[i]._data = nullptr;
+      _stack[i]._depth = 0;
     }
     _idx = 0;
   }
@@ -69,17 +77,21 @@ class dissect_trace {
 
   inline auto const& operator[]( unsigned const index ) noexcept { return _stack[index]; }
 
-  inline void push( dissect_tag const tag, std::byte const* const p ) noexcept {
+  inline void push( dissect_tag const tag, std::byte const* const p,
+                    unsigned const depth = 0 ) noexcept {
     _stack[_idx & MASK]._tag = tag;
     _stack[_idx & MASK]._data = p;
+    _stack[_idx & MASK]._depth = depth;
     _idx++;
   }
 };
 
+// `_depth` is the number of tunnels the entity is encapsulated in, 0 for the outermost headers
 struct entity {
  public:
   std::byte const* const _begin;
   std::byte const* const _end;
+  unsigned const _depth;
 };
 
 struct arp final : public entity {
@@ -88,6 +100,12 @@ struct arp final : public entity {
 struct eth final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::eth;
 };
+struct gre final : public entity {
+  static constexpr dissect_tag _tag = dissect_tag::gre;
+};
+struct gtpu final : public entity {
+  static constexpr dissect_tag _tag = dissect_tag::gtpu;
+};
 struct icmpv4 final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::icmpv4;
 };
@@ -103,6 +121,7 @@ struct ipv4f final : public entity {
 struct ipv6 final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::ipv6;
 };
+// `_begin` is the fragment header, the ipv6 header was traced before
 struct ipv6f final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::ipv6f;
 };
@@ -118,6 +137,9 @@ struct unkown final : public entity {
 struct vlan_8021q final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::vlan_8021q;
 };
+struct vxlan final : public entity {
+  static constexpr dissect_tag _tag = dissect_tag::vxlan;
+};
 struct sctp final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::sctp;
 };
@@ -133,12 +155,18 @@ struct lldp final : public entity {
 struct ectp final : public entity {
   static constexpr dissect_tag _tag = dissect_tag::ectp;
 };
+struct loopback final : public entity {
+  static constexpr dissect_tag _tag = dissect_tag::loopback;
+};
+struct sll final : public entity {
+  static constexpr dissect_tag _tag = dissect_tag::sll;
+};
 
 class dissect_stack_trace : public dissect::dissect_trace {
  public:
   template <typename V>
   inline void operator()( V&& v ) noexcept {
-    push( v._tag, v._begin );
+    push( v._tag, v._begin, v._depth );
   }
 };
 
@@ -153,9 +181,10 @@ class dissect_stack_trace : public dissect::dissect_trace {
         case 0x8a88: goto parse_vlan_8021q;                                                           \
         case 0x9100: goto parse_vlan_8021q;                                                           \
         case 0x8847: goto parse_vlan_mpls;                                                            \
+        case 0x8848: goto parse_vlan_mpls;                                                            \
         case 0x88CC: goto parse_lldp;                                                                 \
         case 0x9000: goto parse_ectp;                                                                 \
-        default: trace.push( dissect_tag::unkown, p ); return hash;                                   \
+        default: trace.push( dissect_tag::unkown, p, depth ); return hash;                            \
       }                                                                                               \
     } else {                                                                                          \
       switch( x ) {                                                                                   \
@@ -163,9 +192,10 @@ class dissect_stack_trace : public dissect::dissect_trace {
         case 0x0806: goto parse_arp;                                                                  \
         case 0x86dd: goto parse_ipv6;                                                                 \
         case 0x8847: goto parse_vlan_mpls;                                                            \
+        case 0x8848: goto parse_vlan_mpls;                                                            \
         case 0x88CC: goto parse_lldp;                                                                 \
         case 0x9000: goto parse_ectp;                                                                 \
-        default: trace.push( dissect_tag::unkown, p ); return hash;                                   \
+        default: trace.push( dissect_tag::unkown, p, depth ); return hash;                            \
       }                                                                                               \
     }                                                                                                 \
   } while( false )
@@ -177,41 +207,104 @@ struct void_hash_policy {
   }
 };
 
-template <typename HashPolicy, typename Trace, bool Cont = true>
-static inline std::uint32_t dissect_en10mb( HashPolicy& hash_policy, Trace&& trace,
-                                            bytestring_view const& view ) noexcept {
+// tunnels ( GRE, VXLAN, GTP-U, IP-in-IP, MPLS pseudowires ) get decapsulated up to this depth
+constexpr unsigned DECAP_DEPTH = 4;
+// mpls label stack entries and gtp-u extension headers followed at most
+constexpr unsigned MPLS_LABELS = 8;
+constexpr unsigned GTPU_EXTENSIONS = 4;
+
+// the UDP destination ports of VXLAN and GTP-U
+constexpr unsigned VXLAN_PORT = 4789;
+constexpr unsigned GTPU_PORT = 2152;
+
+// the link layer headers in front of the first ethertype or ip header, see `pcap::linktype`
+constexpr unsigned LOOPBACK_SIZE = 4;
+constexpr unsigned SLL_SIZE = 16;
+constexpr unsigned SLL2_SIZE = 20;
+
+// dissects a frame of linktype `L`. if `Cont` is set, dissection continues after L3 and follows
+// tunnels: the inner headers go to `trace` as well ( with `_depth > 0` ) and the hash is the one
+// of the innermost ip header.
+//
+// the linktype is a template parameter, `pcap::with` picks the instantiation once per capture
+// ( `pcap_view::LINKTYPE` ) and only the entry into the shared parser differs.
+template <pcap::linktype::type L, typename HashPolicy, typename Trace, bool Cont = true>
+static inline std::uint32_t dissect_linktype( HashPolicy& hash_policy, Trace&& trace,
+                                              bytestring_view const& view ) noexcept {
   constexpr endianess BE = endianess::BE;
+  using linktype = pcap::linktype;
 
   std::byte const* const begin = view.data();
   std::byte const* const end = begin + view.size();
   std::byte const* p = begin;
   std::uint32_t hash = 0;
+  unsigned depth = 0;
+
+  if constexpr( L == linktype::en10mb ) {
+    if( view.size() < 20 ) { return 0u; }
+    goto parse_eth;
+  } else if constexpr( L == linktype::raw ) {
+    goto parse_ip;
+  } else if constexpr( L == linktype::null ) {
+    // the address family in the byte order of the capturing host ( `null` ) or big endian
+    // ( `loop` ), either way one of the outer bytes is zero
+    if( view.size() < LOOPBACK_SIZE ) { return 0u; }
+    trace( loopback{ { p, end, depth } } );
+    auto const family = static_cast<unsigned>( p[0] ) | static_cast<unsigned>( p[3] );
+    p += LOOPBACK_SIZE;
+    switch( family ) {
+      case 2: goto parse_ipv4;
+      case 24: goto parse_ipv6;
+      case 28: goto parse_ipv6;
+      case 30: goto parse_ipv6;
+      default: trace( unkown{ { p, end, depth } } ); return hash;
+    }
+  } else if constexpr( L == linktype::linux_sll ) {
+    if( view.size() < SLL_SIZE ) { return 0u; }
+    trace( sll{ { p, end, depth } } );
+    p += SLL_SIZE;
+    DISSECT_NEXT( true, unsafe::rd16<BE>( p - 2 ) );
+  } else if constexpr( L == linktype::linux_sll2 ) {
+    if( view.size() < SLL2_SIZE ) { return 0u; }
+    trace( sll{ { p, end, depth } } );
+    p += SLL2_SIZE;
+    DISSECT_NEXT( true, unsafe::rd16<BE>( begin ) );
+  } else {
+    static_assert( L == linktype::unsupported, "dissect_linktype: not a canonical linktype" );
+    return 0u;
+  }
 
-  if( view.size() < 20 ) { return 0u; }
-
-  trace( eth{ { p, end } } );
-  auto ethertype = unsafe::rd16<BE>( p + 12 );
-  auto const vlan_ex = unsafe::rd16<BE>( p + 16 );
-  auto const vlan_et = unsafe::rd16<BE>( p + 20 );
+parse_eth:
+  trace( eth{ { p, end, depth } } );
   p += 14;
 
-  DISSECT_NEXT( true, ethertype );
+  DISSECT_NEXT( true, unsafe::rd16<BE>( p - 2 ) );
 
-parse_vlan_8021q:
-  trace( vlan_8021q{ { p, end } } );
+parse_vlan_8021q : {
+  if( p + 4 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  trace( vlan_8021q{ { p, end, depth } } );
+  auto const vlan_ex = unsafe::rd16<BE>( p + 2 );
+  if( vlan_ex == 0x8100u and p + 8 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  auto const ethertype = vlan_ex == 0x8100u ? unsafe::rd16<BE>( p + 6 ) : vlan_ex;
   p += vlan_ex == 0x8100u ? 8 : 4;
-  ethertype = vlan_ex == 0x8100u ? vlan_et : vlan_ex;
   DISSECT_NEXT( false, ethertype );
+}
 
 parse_ipv4 : {
   if( p >= end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
   unsigned const x = static_cast<unsigned>( *p );
   unsigned const len = ( x & 0x0f ) << 2;
   if( p + len > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
   unsigned const part = unsafe::rd16<endianess::BE>( p + 6 );
@@ -219,18 +312,21 @@ parse_ipv4 : {
   //unsigned const foffset = part & 0b0001'1111'1111'1111u;
   hash = hash_policy.template hash<8>( p + 12 );
   if( part & 0b0011'1111'1111'1111u ) {
-    trace( ipv4f{ { p, end } } );
+    trace( ipv4f{ { p, end, depth } } );
     if( auto const foffset = part & 0b0001'1111'1111'1111u; foffset != 0 ) { return hash; }
   } else {
-    trace( ipv4{ { p, end } } );
+    trace( ipv4{ { p, end, depth } } );
   }
   if constexpr( Cont ) {
     unsigned const transport = static_cast<unsigned>( p[9] );
     p += len;
     switch( transport ) {
       case 1: goto parse_icmpv4;
+      case 4: goto parse_ipip;
       case 6: goto parse_tcp;
       case 17: goto parse_udp;
+      case 41: goto parse_ipip;
+      case 47: goto parse_gre;
       case 132: goto parse_sctp;
       default: return hash;
     }
@@ -240,68 +336,79 @@ parse_ipv4 : {
 
 parse_tcp : {
   if( p + 20 > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
   unsigned const len = ( unsigned( p[12] ) >> 2 ) & ~0b11u;
   if( p + len > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
-  trace( tcp{ { p, end } } );
+  trace( tcp{ { p, end, depth } } );
   return hash;
 }
 
 parse_udp:
   if( p + 8 > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
-  trace( udp{ { p, end } } );
+  trace( udp{ { p, end, depth } } );
+  if constexpr( Cont ) {
+    switch( unsafe::rd16<BE>( p + 2 ) ) {
+      case VXLAN_PORT: goto parse_vxlan;
+      case GTPU_PORT: goto parse_gtpu;
+      default: return hash;
+    }
+  }
   return hash;
 
 parse_icmpv4:
-  trace( icmpv4{ { p, end } } );
+  trace( icmpv4{ { p, end, depth } } );
   return hash;
 
 parse_icmpv6:
-  trace( icmpv6{ { p, end } } );
+  trace( icmpv6{ { p, end, depth } } );
   return hash;
 
 parse_sctp:
-  trace( unkown{ { p, end } } );
+  trace( unkown{ { p, end, depth } } );
   return hash;
 
 parse_lldp:
-  trace( unkown{ { p, end } } );
+  trace( unkown{ { p, end, depth } } );
   return hash;
 
 parse_ectp:
-  trace( unkown{ { p, end } } );
+  trace( unkown{ { p, end, depth } } );
   return hash;
 
 parse_arp:
-  trace( arp{ { p, end } } );
+  trace( arp{ { p, end, depth } } );
   return hash;
 
 parse_ipv6 : {
   if( p + 40 > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
   hash = hash_policy.template hash<32>( p + 8 );
   unsigned const len = unsafe::rd16<BE>( p + 4 );
   if( p + len + 40 > end ) {
-    trace( unkown{ { p, end } } );
+    trace( unkown{ { p, end, depth } } );
     return hash;
   }
-  trace( ipv6{ { p, end } } );
+  trace( ipv6{ { p, end, depth } } );
   if constexpr( Cont ) {
     unsigned const transport = static_cast<unsigned>( p[6] );
     p += 40;
     switch( transport ) {
+      case 4: goto parse_ipip;
       case 6: goto parse_tcp;
       case 17: goto parse_udp;
+      case 41: goto parse_ipip;
+      case 44: goto parse_ipv6_fragment;
+      case 47: goto parse_gre;
       case 58: goto parse_icmpv6;
       default: return hash;
     }
@@ -309,11 +416,158 @@ parse_ipv6 : {
   return hash;
 }
 
-parse_vlan_mpls:
-  trace( unkown{ { p, end } } );
+parse_ipv6_fragment : {
+  if( p + 8 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  trace( ipv6f{ { p, end, depth } } );
+  // like ipv4, only the first fragment has the upper layer header
+  if( unsafe::rd16<BE>( p + 2 ) & 0xfff8u ) { return hash; }
+  unsigned const transport = static_cast<unsigned>( p[0] );
+  p += 8;
+  switch( transport ) {
+    case 4: goto parse_ipip;
+    case 6: goto parse_tcp;
+    case 17: goto parse_udp;
+    case 41: goto parse_ipip;
+    case 47: goto parse_gre;
+    case 58: goto parse_icmpv6;
+    default: return hash;
+  }
+}
+
+parse_vlan_mpls : {
+  trace( mpls{ { p, end, depth } } );
+  // the label stack ends with the bottom of stack bit
+  for( unsigned i = 0;; ++i ) {
+    if( i == MPLS_LABELS or p + 4 > end ) {
+      trace( unkown{ { p, end, depth } } );
+      return hash;
+    }
+    auto const bottom = static_cast<unsigned>( p[2] ) & 0x01u;
+    p += 4;
+    if( bottom ) { break; }
+  }
+  if constexpr( Cont ) {
+    // no payload type on the wire, guess it like everyone else: ip or a pseudowire control word
+    // followed by an ethernet frame
+    if( p < end and ( static_cast<unsigned>( *p ) >> 4 ) == 0 ) {
+      if( depth == DECAP_DEPTH ) { return hash; }
+      depth++;
+      p += 4;
+      goto parse_inner_eth;
+    }
+    goto parse_ip;
+  }
   return hash;
 }
 
+parse_gre : {
+  if( p + 4 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  trace( gre{ { p, end, depth } } );
+  unsigned const flags = unsafe::rd16<BE>( p );
+  unsigned const protocol = unsafe::rd16<BE>( p + 2 );
+  // version 0 only ( 1 is pptp ), without the deprecated source routing
+  if( flags & 0x4007u ) { return hash; }
+  // optional checksum, key and sequence number, 4 bytes each
+  p += 4 + 4 * ( ( ( flags >> 15 ) & 1u ) + ( ( flags >> 13 ) & 1u ) + ( ( flags >> 12 ) & 1u ) );
+  if( depth == DECAP_DEPTH ) { return hash; }
+  depth++;
+  switch( protocol ) {
+    case 0x0800: goto parse_ipv4;
+    case 0x86dd: goto parse_ipv6;
+    case 0x6558: goto parse_inner_eth;
+    case 0x8847: goto parse_vlan_mpls;
+    default: trace( unkown{ { p, end, depth } } ); return hash;
+  }
+}
+
+parse_vxlan:
+  p += 8;
+  if( p + 8 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  // the vni flag has to be set
+  if( ( static_cast<unsigned>( *p ) & 0x08u ) == 0 ) { return hash; }
+  trace( vxlan{ { p, end, depth } } );
+  if( depth == DECAP_DEPTH ) { return hash; }
+  depth++;
+  p += 8;
+  goto parse_inner_eth;
+
+parse_gtpu : {
+  p += 8;
+  if( p + 8 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  // version 1, protocol type gtp and a t-pdu, everything else is signalling
+  unsigned const flags = static_cast<unsigned>( p[0] );
+  if( ( flags & 0xf0u ) != 0x30u or static_cast<unsigned>( p[1] ) != 0xffu ) { return hash; }
+  trace( gtpu{ { p, end, depth } } );
+  p += 8;
+  // sequence number, n-pdu number and the extension header chain are present if any flag is set
+  if( flags & 0x07u ) {
+    if( p + 4 > end ) {
+      trace( unkown{ { p, end, depth } } );
+      return hash;
+    }
+    auto next = static_cast<unsigned>( p[3] );
+    p += 4;
+    for( unsigned i = 0; next != 0; ++i ) {
+      // extension header lengths are in units of 4 bytes
+      unsigned const len = p < end ? static_cast<unsigned>( *p ) * 4 : 0;
+      if( i == GTPU_EXTENSIONS or len == 0 or p + len > end ) {
+        trace( unkown{ { p, end, depth } } );
+        return hash;
+      }
+      next = static_cast<unsigned>( p[len - 1] );
+      p += len;
+    }
+  }
+  if( depth == DECAP_DEPTH ) { return hash; }
+  depth++;
+  goto parse_ip;
+}
+
+parse_ipip:
+  if( depth == DECAP_DEPTH ) { return hash; }
+  depth++;
+  goto parse_ip;
+
+// ip of either version, the version nibble tells
+parse_ip:
+  if( p >= end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  switch( static_cast<unsigned>( *p ) >> 4 ) {
+    case 4: goto parse_ipv4;
+    case 6: goto parse_ipv6;
+    default: trace( unkown{ { p, end, depth } } ); return hash;
+  }
+
+parse_inner_eth:
+  if( p + 20 > end ) {
+    trace( unkown{ { p, end, depth } } );
+    return hash;
+  }
+  goto parse_eth;
+}
+
+// dissects an ethernet frame, see `dissect_linktype`
+template <typename HashPolicy, typename Trace, bool Cont = true>
+static inline std::uint32_t dissect_en10mb( HashPolicy& hash_policy, Trace&& trace,
+                                            bytestring_view const& view ) noexcept {
+  return dissect_linktype<pcap::linktype::en10mb, HashPolicy, Trace, Cont>(
+      hash_policy, std::forward<Trace>( trace ), view );
+}
+
 #undef DISSECT_NEXT
 
 } // namespace nygma::dissect
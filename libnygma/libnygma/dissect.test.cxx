@@ -7,6 +7,7 @@
 #include <array>
 #include <cstdint>
 #include <type_traits>
+#include <vector>
 
 namespace dissect = nygma::dissect;
 
@@ -73,8 +74,128 @@ static const unsigned char pkt_unsw_nb15[70] = {
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* ........ */
 0x00, 0x00, 0x00, 0x00, 0x00, 0x00              /* ...... */
 };
+
+// ipv4 / udp / vxlan / eth / ipv4 / tcp
+/* Frame (104 bytes) */
+static const unsigned char pkt_vxlan[104] = {
+0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00,
+0x00, 0x00, 0x00, 0x02, 0x08, 0x00, 0x45, 0x00,
+0x00, 0x5a, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11,
+0x00, 0x00, 0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00,
+0x00, 0x02, 0xc3, 0x50, 0x12, 0xb5, 0x00, 0x46,
+0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x2a, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+0x02, 0x00, 0x00, 0x00, 0x00, 0x02, 0x08, 0x00,
+0x45, 0x00, 0x00, 0x28, 0x00, 0x01, 0x00, 0x00,
+0x40, 0x06, 0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01,
+0xc0, 0xa8, 0x00, 0x02, 0x04, 0xd2, 0x00, 0x50,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x50, 0x02, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00
+};
+
+// ipv4 / udp / gtp-u ( with an extension header ) / ipv6 / udp
+/* Frame (106 bytes) */
+static const unsigned char pkt_gtpu[106] = {
+0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00,
+0x00, 0x00, 0x00, 0x02, 0x08, 0x00, 0x45, 0x00,
+0x00, 0x5c, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11,
+0x00, 0x00, 0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00,
+0x00, 0x02, 0x08, 0x68, 0x08, 0x68, 0x00, 0x48,
+0x00, 0x00, 0x34, 0xff, 0x00, 0x38, 0x00, 0x00,
+0x00, 0x01, 0x00, 0x00, 0x00, 0x85, 0x01, 0x00,
+0x00, 0x00, 0x60, 0x00, 0x00, 0x00, 0x00, 0x08,
+0x11, 0x40, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x01, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x02, 0x14, 0xe9, 0x00, 0x35, 0x00, 0x08,
+0x00, 0x00
+};
+
+// ipv6 / gre ( with key ) / ipv4 / udp
+/* Frame (90 bytes) */
+static const unsigned char pkt_gre[90] = {
+0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00,
+0x00, 0x00, 0x00, 0x02, 0x86, 0xdd, 0x60, 0x00,
+0x00, 0x00, 0x00, 0x24, 0x2f, 0x40, 0x20, 0x01,
+0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x01,
+0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x20, 0x00,
+0x08, 0x00, 0x00, 0x00, 0x00, 0x2a, 0x45, 0x00,
+0x00, 0x1c, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11,
+0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8,
+0x00, 0x02, 0x03, 0xe8, 0x07, 0xd0, 0x00, 0x08,
+0x00, 0x00
+};
+
+// mpls ( two labels ) / ipv4 / udp
+/* Frame (50 bytes) */
+static const unsigned char pkt_mpls[50] = {
+0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x00,
+0x00, 0x00, 0x00, 0x02, 0x88, 0x47, 0x00, 0x01,
+0x00, 0x40, 0x00, 0x02, 0x01, 0x40, 0x45, 0x00,
+0x00, 0x1c, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11,
+0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8,
+0x00, 0x02, 0x03, 0xe8, 0x07, 0xd0, 0x00, 0x08,
+0x00, 0x00
+};
 // clang-format on
 
+struct expected_entry {
+  dissect_tag _tag;
+  unsigned _offset;
+  unsigned _depth;
+};
+
+template <typename Expect>
+void expect_trace( Expect& expect, dissect::dissect_stack_trace const& trace,
+                   bytestring_view const& bs, std::initializer_list<expected_entry> entries ) {
+  using namespace emptyspace::pest;
+  expect( trace.index(), equal_to( static_cast<unsigned>( entries.size() ) ) );
+  unsigned i = 0;
+  for( auto const& e : entries ) {
+    expect( trace.entries()[i]._tag, equal_to( e._tag ) );
+    expect( trace.entries()[i]._data, equal_to( bs.data() + e._offset ) );
+    expect( trace.entries()[i]._depth, equal_to( e._depth ) );
+    i++;
+  }
+}
+
+// `n` ipv4 headers, each one encapsulated in the one before
+std::vector<std::byte> ipip( unsigned const n ) {
+  std::vector<std::byte> r( 14 + 20 * n, std::byte{ 0 } );
+  r[12] = std::byte{ 0x08 };
+  for( unsigned i = 0; i < n; ++i ) {
+    auto* const p = r.data() + 14 + 20 * i;
+    p[0] = std::byte{ 0x45 };
+    p[9] = std::byte{ 4 };
+  }
+  return r;
+}
+
+// `pkt2` with its ethernet header replaced by the link-layer header `link`
+std::vector<std::byte> relink( std::initializer_list<unsigned char> const link ) {
+  std::vector<std::byte> r;
+  for( auto const b : link ) { r.push_back( std::byte{ b } ); }
+  for( std::size_t i = 14; i < sizeof( pkt2 ); ++i ) { r.push_back( std::byte{ pkt2[i] } ); }
+  return r;
+}
+
+// `pkt1` behind an ipv6 fragment header with fragment offset `offset` ( in units of 8 bytes )
+std::vector<std::byte> fragment6( unsigned const offset ) {
+  std::vector<std::byte> r;
+  for( auto const b : pkt1 ) { r.push_back( std::byte{ b } ); }
+  unsigned char const header[] = { 0x06, 0x00, static_cast<unsigned char>( offset >> 5 ),
+                                   static_cast<unsigned char>( offset << 3 | 1 ),
+                                   0x00, 0x00, 0x00, 0x2a };
+  r.insert( r.begin() + 54, reinterpret_cast<std::byte const*>( header ),
+            reinterpret_cast<std::byte const*>( header ) + sizeof( header ) );
+  r[14 + 5] = std::byte{ 0x28 };
+  r[14 + 6] = std::byte{ 44 };
+  return r;
+}
+
 emptyspace::pest::suite basic( "dissect suite", []( auto& test ) {
   using namespace emptyspace::pest;
   test( "dissect pkt1", []( auto& expect ) {
@@ -144,6 +265,180 @@ emptyspace::pest::suite basic( "dissect suite", []( auto& test ) {
     expect( trace.entries()[2]._data, equal_to( offset( 34 ) ) );
     expect( hash, equal_to( 0u ) );
   } );
+
+  test( "dissect vxlan", []( auto& expect ) {
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ pkt_vxlan };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::ipv4, 14, 0 },
+                    { dissect_tag::udp, 34, 0 },
+                    { dissect_tag::vxlan, 42, 0 },
+                    { dissect_tag::eth, 50, 1 },
+                    { dissect_tag::ipv4, 64, 1 },
+                    { dissect_tag::tcp, 84, 1 } } );
+  } );
+
+  test( "dissect gtp-u", []( auto& expect ) {
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ pkt_gtpu };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::ipv4, 14, 0 },
+                    { dissect_tag::udp, 34, 0 },
+                    { dissect_tag::gtpu, 42, 0 },
+                    { dissect_tag::ipv6, 58, 1 },
+                    { dissect_tag::udp, 98, 1 } } );
+  } );
+
+  test( "dissect gre", []( auto& expect ) {
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ pkt_gre };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::ipv6, 14, 0 },
+                    { dissect_tag::gre, 54, 0 },
+                    { dissect_tag::ipv4, 62, 1 },
+                    { dissect_tag::udp, 82, 1 } } );
+  } );
+
+  test( "dissect mpls", []( auto& expect ) {
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ pkt_mpls };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::mpls, 14, 0 },
+                    { dissect_tag::ipv4, 22, 0 },
+                    { dissect_tag::udp, 42, 0 } } );
+  } );
+
+  test( "decapsulation depth is bounded", []( auto& expect ) {
+    auto const frame = ipip( dissect::DECAP_DEPTH + 3 );
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ frame.data(), frame.size() };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect( trace.index(), equal_to( dissect::DECAP_DEPTH + 2 ) );
+    auto const& last = trace.entries()[dissect::DECAP_DEPTH + 1];
+    expect( last._tag, equal_to( dissect_tag::ipv4 ) );
+    expect( last._depth, equal_to( dissect::DECAP_DEPTH ) );
+  } );
+
+  test( "truncated tunnels", []( auto& expect ) {
+    for( auto const& pkt : { bytestring_view{ pkt_vxlan }, bytestring_view{ pkt_gtpu },
+                             bytestring_view{ pkt_gre }, bytestring_view{ pkt_mpls },
+                             bytestring_view{ pkt3 } } ) {
+      auto const* const p = pkt.data();
+      for( std::size_t n = 20; n < pkt.size(); ++n ) {
+        // a copy of exactly `n` bytes, sanitizers catch reads beyond
+        std::vector<std::byte> const truncated( p, p + n );
+        auto trace = dissect::dissect_stack_trace{};
+        auto const hash_policy = hash_type{};
+        auto const bs = bytestring_view{ truncated.data(), n };
+        dissect::dissect_en10mb( hash_policy, trace, bs );
+        auto const& last = trace.entries()[trace.index() - 1];
+        expect( last._data <= truncated.data() + n, equal_to( true ) );
+      }
+    }
+  } );
+
+  test( "dissect ipv6 fragments", []( auto& expect ) {
+    auto const first = fragment6( 0 );
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ first.data(), first.size() };
+    dissect::dissect_en10mb( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::ipv6, 14, 0 },
+                    { dissect_tag::ipv6f, 54, 0 },
+                    { dissect_tag::tcp, 62, 0 } } );
+    // only the first fragment has a tcp header
+    auto const later = fragment6( 185 );
+    trace.rewind();
+    auto const bs2 = bytestring_view{ later.data(), later.size() };
+    dissect::dissect_en10mb( hash_policy, trace, bs2 );
+    expect_trace( expect, trace, bs2,
+                  { { dissect_tag::eth, 0, 0 },
+                    { dissect_tag::ipv6, 14, 0 },
+                    { dissect_tag::ipv6f, 54, 0 } } );
+  } );
+
+  test( "dissect raw ip", []( auto& expect ) {
+    using linktype = nygma::pcap::linktype;
+    auto const frame = relink( {} );
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ frame.data(), frame.size() };
+    dissect::dissect_linktype<linktype::raw>( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs, { { dissect_tag::ipv4, 0, 0 }, { dissect_tag::tcp, 20, 0 } } );
+  } );
+
+  test( "dissect bsd loopback", []( auto& expect ) {
+    using linktype = nygma::pcap::linktype;
+    // `AF_INET` in either byte order
+    for( auto const& frame : { relink( { 2, 0, 0, 0 } ), relink( { 0, 0, 0, 2 } ) } ) {
+      auto trace = dissect::dissect_stack_trace{};
+      auto const hash_policy = hash_type{};
+      auto const bs = bytestring_view{ frame.data(), frame.size() };
+      dissect::dissect_linktype<linktype::null>( hash_policy, trace, bs );
+      expect_trace( expect, trace, bs,
+                    { { dissect_tag::loopback, 0, 0 },
+                      { dissect_tag::ipv4, 4, 0 },
+                      { dissect_tag::tcp, 24, 0 } } );
+    }
+    auto const unknown = relink( { 0, 0, 0, 7 } );
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs = bytestring_view{ unknown.data(), unknown.size() };
+    dissect::dissect_linktype<linktype::null>( hash_policy, trace, bs );
+    expect_trace( expect, trace, bs,
+                  { { dissect_tag::loopback, 0, 0 }, { dissect_tag::unkown, 4, 0 } } );
+  } );
+
+  test( "dissect linux cooked captures", []( auto& expect ) {
+    using linktype = nygma::pcap::linktype;
+    auto const v1 = relink( { 0, 0, 0, 1, 0, 6, 1, 2, 3, 4, 5, 6, 0, 0, 0x08, 0x00 } );
+    auto const v2 = relink( { 0x08, 0x00, 0, 0, 0, 0, 0, 2, 0, 1, 0, 6, 1, 2, 3, 4, 5, 6, 0, 0 } );
+    auto trace = dissect::dissect_stack_trace{};
+    auto const hash_policy = hash_type{};
+    auto const bs1 = bytestring_view{ v1.data(), v1.size() };
+    dissect::dissect_linktype<linktype::linux_sll>( hash_policy, trace, bs1 );
+    expect_trace( expect, trace, bs1,
+                  { { dissect_tag::sll, 0, 0 },
+                    { dissect_tag::ipv4, 16, 0 },
+                    { dissect_tag::tcp, 36, 0 } } );
+    trace.rewind();
+    auto const bs2 = bytestring_view{ v2.data(), v2.size() };
+    dissect::dissect_linktype<linktype::linux_sll2>( hash_policy, trace, bs2 );
+    expect_trace( expect, trace, bs2,
+                  { { dissect_tag::sll, 0, 0 },
+                    { dissect_tag::ipv4, 20, 0 },
+                    { dissect_tag::tcp, 40, 0 } } );
+    // too short for the link-layer header
+    trace.rewind();
+    auto const short2 = bytestring_view{ v2.data(), dissect::SLL2_SIZE - 1 };
+    expect( dissect::dissect_linktype<linktype::linux_sll2>( hash_policy, trace, short2 ),
+            equal_to( 0u ) );
+    expect( trace.index(), equal_to( 0u ) );
+    // a vlan tag cut off right after the link-layer header
+    std::vector<std::byte> cut( v1.begin(), v1.begin() + dissect::SLL_SIZE + 2 );
+    cut[dissect::SLL_SIZE - 2] = std::byte{ 0x81 };
+    cut[dissect::SLL_SIZE - 1] = std::byte{ 0x00 };
+    trace.rewind();
+    auto const bs3 = bytestring_view{ cut.data(), cut.size() };
+    dissect::dissect_linktype<linktype::linux_sll>( hash_policy, trace, bs3 );
+    expect_trace( expect, trace, bs3,
+                  { { dissect_tag::sll, 0, 0 }, { dissect_tag::unkown, 16, 0 } } );
+  } );
 } );
 
 } // namespace
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libnygma/dissect.hxx>
+#include <libnygma/toeplitz.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <cstdint>
+#include <type_traits>
+
+namespace nygma {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+// the 5-tuple of the innermost ip header of a packet: addresses ( ipv4 zero extended ), ports ( 0
+// without tcp / udp header ), the protocol ( ipv6: the first next header ) and the ip version, 0
+// for packets without ip header.
+//
+// later fragments have no ports, `_later` marks them. `index_trace` fills in the ports of their
+// first fragment.
+struct flow_tuple {
+  __uint128_t _src{ 0 };
+  __uint128_t _dst{ 0 };
+  std::uint16_t _sport{ 0 };
+  std::uint16_t _dport{ 0 };
+  std::uint8_t _proto{ 0 };
+  std::uint8_t _version{ 0 };
+  bool _later{ false };
+
+  friend bool operator==( flow_tuple const&, flow_tuple const& ) noexcept = default;
+
+  // `o` belongs to this flow, in either direction. the ports of later fragments are not compared
+  bool matches( flow_tuple const& o ) const noexcept {
+    if( _version != o._version or _proto != o._proto ) { return false; }
+    auto const any = _later or o._later;
+    auto const forward = _src == o._src and _dst == o._dst and
+                         ( any or ( _sport == o._sport and _dport == o._dport ) );
+    auto const reverse = _src == o._dst and _dst == o._src and
+                         ( any or ( _sport == o._dport and _dport == o._sport ) );
+    return forward or reverse;
+  }
+
+  // follows the headers of a dissection ( see `flow_trace` ), the innermost ip header wins
+  template <typename V>
+  inline void update( V const& v ) noexcept {
+    constexpr endianess BE = endianess::BE;
+    using T = std::decay_t<V>;
+    namespace d = dissect;
+    if constexpr( std::is_same_v<T, d::ipv4> || std::is_same_v<T, d::ipv4f> ) {
+      auto const* const p = v._begin;
+      *this = { unsafe::rd32<BE>( p + 12 ), unsafe::rd32<BE>( p + 16 ), 0, 0,
+                static_cast<std::uint8_t>( p[9] ), 4, false };
+      if constexpr( std::is_same_v<T, d::ipv4f> ) {
+        _later = ( unsafe::rd16<BE>( p + 6 ) & 0x1fffu ) != 0;
+      }
+    } else if constexpr( std::is_same_v<T, d::ipv6> ) {
+      auto const* const p = v._begin;
+      *this = { unsafe::rd128<BE>( p + 8 ), unsafe::rd128<BE>( p + 24 ), 0, 0,
+                static_cast<std::uint8_t>( p[6] ), 6, false };
+    } else if constexpr( std::is_same_v<T, d::ipv6f> ) {
+      // the protocol of the fragmented datagram, like ipv4 fragments have it
+      _proto = static_cast<std::uint8_t>( v._begin[0] );
+      _later = ( unsafe::rd16<BE>( v._begin + 2 ) & 0xfff8u ) != 0;
+    } else if constexpr( std::is_same_v<T, d::tcp> || std::is_same_v<T, d::udp> ) {
+      _sport = unsafe::rd16<BE>( v._begin );
+      _dport = unsafe::rd16<BE>( v._begin + 2 );
+    }
+  }
+};
+
+// the toeplitz hash of `lo, hi, lport, hport, protocol`: the endpoints ( address and port ) of the
+// tuple ordered, so both directions of a flow get the same hash.
+//
+// the key ( `rss_key_i40e_pmd_52` ) does not repeat, the hash keeps all of its 32 bits and tuples
+// with permuted words hash differently. still, lookups by hash need to compare the tuples
+// ( `flow_tuple::matches` ).
+//
+// with `pclmulqdq` the hash does without the 48 KiB table of `toeplitz_scalar_lut`, which would
+// compete with the index builders for the L1 cache.
+inline std::uint32_t flow_hash( flow_tuple const& t ) noexcept {
+  constexpr endianess BE = endianess::BE;
+#if defined( __PCLMUL__ )
+  static constexpr toeplitz::toeplitz_clmul<toeplitz::rss_key_i40e_pmd_52> rss;
+#else
+  static constexpr toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_i40e_pmd_52> rss;
+#endif
+  auto const forward = t._src < t._dst or ( t._src == t._dst and t._sport <= t._dport );
+  auto const lo = forward ? t._src : t._dst;
+  auto const hi = forward ? t._dst : t._src;
+  auto const lport = forward ? t._sport : t._dport;
+  auto const hport = forward ? t._dport : t._sport;
+  std::byte data[40];
+  if( t._version == 4 ) {
+    unsafe::wr32<BE>( data, static_cast<std::uint32_t>( lo ) );
+    unsafe::wr32<BE>( data + 4, static_cast<std::uint32_t>( hi ) );
+    unsafe::wr16<BE>( data + 8, lport );
+    unsafe::wr16<BE>( data + 10, hport );
+    unsafe::wr32<BE>( data + 12, t._proto );
+    return rss.hash<16>( data );
+  }
+  unsafe::wr128<BE>( data, lo );
+  unsafe::wr128<BE>( data + 16, hi );
+  unsafe::wr16<BE>( data + 32, lport );
+  unsafe::wr16<BE>( data + 34, hport );
+  unsafe::wr32<BE>( data + 36, t._proto );
+  return rss.hash<40>( data );
+}
+
+// the flow of a single packet, e.g. `dissect_linktype<L>( hash, trace, slice )`
+struct flow_trace : public dissect::dissect_trace {
+  flow_tuple _tuple;
+
+  template <typename V>
+  inline void operator()( V&& v ) noexcept {
+    _tuple.update( v );
+  }
+
+  inline void rewind() noexcept {
+    dissect::dissect_trace::rewind();
+    _tuple = {};
+  }
+};
+
+} // namespace nygma
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libnygma/flow.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// ethernet + ipv4 + udp `10.0.0.1:1234 -> 10.0.0.2:53`, `reply` swaps the direction
+std::vector<std::byte> udp_frame( bool const reply = false ) {
+  std::uint8_t frame[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x08, 0x00, // eth
+      0x45, 0x00, 0x00, 0x1c, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11, 0x00, 0x00,             // ipv4
+      0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00, 0x00, 0x02,                                     //
+      0x04, 0xd2, 0x00, 0x35, 0x00, 0x08, 0x00, 0x00,                                     // udp
+  };
+  if( reply ) {
+    std::swap( frame[29], frame[33] );
+    std::swap( frame[34], frame[36] );
+    std::swap( frame[35], frame[37] );
+  }
+  std::vector<std::byte> r( sizeof( frame ) );
+  std::memcpy( r.data(), frame, sizeof( frame ) );
+  return r;
+}
+
+nygma::flow_tuple flow_of( std::vector<std::byte> const& frame ) {
+  nygma::flow_trace trace;
+  nygma::dissect::void_hash_policy hash;
+  unclassified::bytestring_view const view{ frame.data(), frame.size() };
+  nygma::dissect::dissect_en10mb( hash, trace, view );
+  return trace._tuple;
+}
+
+emptyspace::pest::suite basic( "flow suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "the tuple of a udp packet", []( auto& expect ) {
+    auto const t = flow_of( udp_frame() );
+    expect( t._version, equal_to( 4 ) );
+    expect( t._proto, equal_to( 17 ) );
+    expect( t._src == 0x0a000001u, equal_to( true ) );
+    expect( t._dst == 0x0a000002u, equal_to( true ) );
+    expect( t._sport, equal_to( 1234 ) );
+    expect( t._dport, equal_to( 53 ) );
+    expect( t._later, equal_to( false ) );
+  } );
+
+  test( "both directions are the same flow", []( auto& expect ) {
+    auto const request = flow_of( udp_frame() );
+    auto const reply = flow_of( udp_frame( true ) );
+    expect( request == reply, equal_to( false ) );
+    expect( request.matches( reply ), equal_to( true ) );
+    expect( reply.matches( request ), equal_to( true ) );
+    expect( nygma::flow_hash( request ), equal_to( nygma::flow_hash( reply ) ) );
+    auto tcp = request;
+    tcp._proto = 6;
+    expect( request.matches( tcp ), equal_to( false ) );
+    auto other = request;
+    other._dport = 54;
+    expect( request.matches( other ), equal_to( false ) );
+  } );
+
+  test( "flow hashes use all 32 bits", []( auto& expect ) {
+    auto const request = flow_of( udp_frame() );
+    // the protocol is hashed
+    auto tcp = request;
+    tcp._proto = 6;
+    expect( nygma::flow_hash( request ) != nygma::flow_hash( tcp ), equal_to( true ) );
+    // swapped ports and swapped address words are other flows
+    auto ports = request;
+    std::swap( ports._sport, ports._dport );
+    expect( nygma::flow_hash( request ) != nygma::flow_hash( ports ), equal_to( true ) );
+    auto words = request;
+    words._src = 0x00010a00u;
+    words._dst = 0x00020a00u;
+    expect( nygma::flow_hash( request ) != nygma::flow_hash( words ), equal_to( true ) );
+    // both ipv6 directions, and more than 2^16 distinct hashes over 2^17 flows
+    auto v6 = request;
+    v6._version = 6;
+    v6._src = __uint128_t( 0x20010db8u ) << 96 | 1u;
+    v6._dst = __uint128_t( 0x20010db8u ) << 96 | 2u;
+    auto v6r = v6;
+    std::swap( v6r._src, v6r._dst );
+    std::swap( v6r._sport, v6r._dport );
+    expect( nygma::flow_hash( v6 ), equal_to( nygma::flow_hash( v6r ) ) );
+    std::vector<std::uint32_t> hashes;
+    for( std::uint32_t i = 0; i < ( 1u << 17 ); ++i ) {
+      auto t = request;
+      t._src = 0x0a000000u | ( i >> 1 );
+      t._sport = static_cast<std::uint16_t>( 1024 + ( i & 1 ) );
+      hashes.push_back( nygma::flow_hash( t ) );
+    }
+    std::sort( hashes.begin(), hashes.end() );
+    auto const distinct = std::unique( hashes.begin(), hashes.end() ) - hashes.begin();
+    expect( distinct > ( 1 << 16 ), equal_to( true ) );
+  } );
+
+  test( "the ports of later fragments are not compared", []( auto& expect ) {
+    auto const first = flow_of( udp_frame() );
+    auto later = first;
+    later._sport = later._dport = 0;
+    expect( first.matches( later ), equal_to( false ) );
+    later._later = true;
+    expect( first.matches( later ), equal_to( true ) );
+  } );
+
+  test( "packets without ip header have no flow", []( auto& expect ) {
+    auto frame = udp_frame();
+    // arp
+    frame[12] = std::byte{ 0x08 };
+    frame[13] = std::byte{ 0x06 };
+    expect( flow_of( frame )._version, equal_to( 0 ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libunclassified/bytestring.hxx>
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+namespace nygma {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+// a fragmented datagram: addresses ( ipv4 zero extended ), identification, protocol and version
+struct fragment_key {
+  __uint128_t _src;
+  __uint128_t _dst;
+  std::uint32_t _id;
+  std::uint8_t _proto;
+  std::uint8_t _version;
+
+  friend bool operator==( fragment_key const&, fragment_key const& ) noexcept = default;
+
+  // `p` is the ipv4 header
+  static fragment_key ipv4( std::byte const* const p ) noexcept {
+    constexpr endianess BE = endianess::BE;
+    return { unsafe::rd32<BE>( p + 12 ), unsafe::rd32<BE>( p + 16 ), unsafe::rd16<BE>( p + 4 ),
+             static_cast<std::uint8_t>( p[9] ), 4 };
+  }
+
+  // `p` is the ipv6 header, `f` its fragment header
+  static fragment_key ipv6( std::byte const* const p, std::byte const* const f ) noexcept {
+    constexpr endianess BE = endianess::BE;
+    return { unsafe::rd128<BE>( p + 8 ), unsafe::rd128<BE>( p + 24 ), unsafe::rd32<BE>( f + 4 ),
+             static_cast<std::uint8_t>( f[0] ), 6 };
+  }
+};
+
+// the L4 ports of fragmented datagrams. the first fragment ( offset 0 ) carries the tcp / udp
+// header and provides the ports, later fragments look them up.
+//
+// the table has a fixed number of slots allocated once, a set of `WAYS` slots per key. entries
+// older than the timeout ( in stamp units, see `packet_view::_stamp` ) count as free, a full set
+// evicts its oldest entry. fragments arriving before their first fragment miss.
+class fragment_table {
+ public:
+  static constexpr std::size_t WAYS = 4;
+  // like the reassembly timeout of linux ( `ipfrag_time` )
+  static constexpr std::uint64_t TIMEOUT = 30'000'000'000ull;
+
+  struct entry {
+    fragment_key _key;
+    std::uint64_t _stamp;
+    std::uint16_t _sport;
+    std::uint16_t _dport;
+    bool _used;
+  };
+
+ private:
+  std::unique_ptr<entry[]> _entries;
+  std::size_t _mask;
+  std::uint64_t _timeout;
+
+ public:
+  // first fragments recorded, later fragments which got their ports, later fragments without
+  // recorded first fragment and live entries evicted for lack of space
+  std::uint64_t _inserted{ 0 };
+  std::uint64_t _found{ 0 };
+  std::uint64_t _missed{ 0 };
+  std::uint64_t _evicted{ 0 };
+
+  // `sets` gets rounded up to a power of two
+  explicit fragment_table( std::size_t const sets = 1024,
+                           std::uint64_t const timeout = TIMEOUT ) noexcept
+    : _mask{ std::bit_ceil( sets ) - 1 }, _timeout{ timeout } {
+    _entries = std::make_unique<entry[]>( capacity() );
+  }
+
+  std::size_t capacity() const noexcept { return ( _mask + 1 ) * WAYS; }
+
+  // the ( fixed ) memory used by the table in bytes
+  std::size_t memory() const noexcept { return capacity() * sizeof( entry ); }
+
+  void insert( fragment_key const& k, std::uint16_t const sport, std::uint16_t const dport,
+               std::uint64_t const now ) noexcept {
+    entry* const set = set_of( k );
+    // the entry of `k` ( a retransmitted first fragment ), a free one or the oldest
+    entry* same = nullptr;
+    entry* free = nullptr;
+    entry* oldest = set;
+    for( std::size_t i = 0; i < WAYS; ++i ) {
+      entry* const e = set + i;
+      if( not live( *e, now ) ) {
+        if( free == nullptr ) { free = e; }
+      } else if( e->_key == k ) {
+        same = e;
+      } else if( e->_stamp < oldest->_stamp ) {
+        oldest = e;
+      }
+    }
+    entry* const victim = same != nullptr ? same : free != nullptr ? free : oldest;
+    if( same == nullptr and free == nullptr ) { _evicted++; }
+    *victim = { k, now, sport, dport, true };
+    _inserted++;
+  }
+
+  // the entry of the first fragment of `k`, `nullptr` if there is none
+  entry const* lookup( fragment_key const& k, std::uint64_t const now ) noexcept {
+    entry* const set = set_of( k );
+    for( std::size_t i = 0; i < WAYS; ++i ) {
+      if( live( set[i], now ) and set[i]._key == k ) {
+        _found++;
+        return set + i;
+      }
+    }
+    _missed++;
+    return nullptr;
+  }
+
+ private:
+  inline bool live( entry const& e, std::uint64_t const now ) const noexcept {
+    return e._used and now <= e._stamp + _timeout;
+  }
+
+  inline entry* set_of( fragment_key const& k ) const noexcept {
+    auto const fold = []( __uint128_t const x ) {
+      return static_cast<std::uint64_t>( x ) ^ static_cast<std::uint64_t>( x >> 64 );
+    };
+    std::uint64_t h = fold( k._src ) * 0x9e3779b97f4a7c15ull;
+    h = ( h ^ fold( k._dst ) ) * 0x9e3779b97f4a7c15ull;
+    h = ( h ^ ( std::uint64_t( k._id ) << 16 | std::uint64_t( k._proto ) << 8 | k._version ) ) *
+        0x9e3779b97f4a7c15ull;
+    return _entries.get() + ( ( h >> 32 ) & _mask ) * WAYS;
+  }
+};
+
+} // namespace nygma
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libnygma/fragment-table.hxx>
+
+#include <cstdint>
+
+namespace {
+
+nygma::fragment_key key( std::uint32_t const id ) {
+  return { 0x0a000001u, 0x0a000002u, id, 17, 4 };
+}
+
+emptyspace::pest::suite basic( "fragment table suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+  using nygma::fragment_table;
+
+  test( "later fragments find the ports of the first one", []( auto& expect ) {
+    fragment_table t{ 16 };
+    t.insert( key( 1 ), 1234, 53, 0 );
+    auto const* const e = t.lookup( key( 1 ), 10 );
+    expect( e != nullptr, equal_to( true ) );
+    expect( e->_sport, equal_to( 1234u ) );
+    expect( e->_dport, equal_to( 53u ) );
+    expect( t.lookup( key( 2 ), 10 ) == nullptr, equal_to( true ) );
+    // same addresses and identification, another protocol
+    auto other = key( 1 );
+    other._proto = 6;
+    expect( t.lookup( other, 10 ) == nullptr, equal_to( true ) );
+    expect( t._inserted, equal_to( 1u ) );
+    expect( t._found, equal_to( 1u ) );
+    expect( t._missed, equal_to( 2u ) );
+  } );
+
+  test( "entries time out", []( auto& expect ) {
+    fragment_table t{ 16, 100 };
+    t.insert( key( 1 ), 1234, 53, 1000 );
+    expect( t.lookup( key( 1 ), 1100 ) != nullptr, equal_to( true ) );
+    expect( t.lookup( key( 1 ), 1101 ) == nullptr, equal_to( true ) );
+    // expired entries get reused without counting as evicted
+    for( std::uint32_t i = 0; i < 2 * t.capacity(); ++i ) { t.insert( key( i ), 1, 2, 2000 * i ); }
+    expect( t._evicted, equal_to( 0u ) );
+  } );
+
+  test( "memory is bounded", []( auto& expect ) {
+    fragment_table t{ 5 };
+    expect( t.capacity(), equal_to( 8 * fragment_table::WAYS ) );
+    expect( t.memory(), equal_to( t.capacity() * sizeof( fragment_table::entry ) ) );
+    std::uint32_t const n = 1000;
+    for( std::uint32_t i = 0; i < n; ++i ) { t.insert( key( i ), 1, 2, i ); }
+    expect( t._evicted, equal_to( n - t.capacity() ) );
+    // the most recent fragments survive
+    expect( t.lookup( key( n - 1 ), n ) != nullptr, equal_to( true ) );
+    std::size_t live = 0;
+    for( std::uint32_t i = 0; i < n; ++i ) { live += t.lookup( key( i ), n ) != nullptr; }
+    expect( live, equal_to( t.capacity() ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
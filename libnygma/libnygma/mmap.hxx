@@ -3,8 +3,11 @@
 #pragma once
 
 #include <libnygma/support.hxx>
+#include <libunclassified/backoff-strategy.hxx>
 #include <libunclassified/bytestring.hxx>
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <filesystem>
 #include <iostream>
@@ -216,7 +219,7 @@ class block_view {
   inline auto end() const noexcept { return _end; }
 
   bool in_cached_range( std::uint64_t const offset, std::size_t size ) const noexcept {
-    return offset >= _cached_offset && ( offset + size ) < _cached_offset + _cached_size;
+    return offset >= _cached_offset && ( offset + size ) <= _cached_offset + _cached_size;
   }
 
   inline bytestring_view const slice( std::uint64_t const offset,
@@ -256,6 +259,134 @@ class block_view {
     _end = _cached_size < _block.size();
     return bytestring_view{ _block.data(), _block.size() - n };
   }
+
+  // reads `n` bytes at `offset` into `p` past the block, e.g. packets larger than `BLOCKSZ`.
+  // returns the bytes read, fewer than `n` at the end of the file or on errors
+  std::size_t read( std::uint64_t const offset, std::byte* const p,
+                    std::size_t const n ) const noexcept {
+    if( not is_ok() ) { return 0; }
+    std::size_t done = 0;
+    auto o = static_cast<off_t>( offset );
+    while( done < n ) {
+      auto const rc = pread( _fd, p + done, n - done, o );
+      if( rc < 0 ) {
+        if( errno == EAGAIN || errno == EINTR ) { continue; }
+        break;
+      } else if( rc == 0 ) {
+        break;
+      }
+      done += static_cast<std::size_t>( rc );
+      o += rc;
+    }
+    return done;
+  }
+};
+
+// a `block_view` reading into `Count` blocks in turn: the slices of a block stay valid until the
+// consumer `release`s it, up to `Count - 1` blocks can be in flight to other threads. `prefetch`
+// of a new block waits for its buffer to become free, every block but the last has to get
+// released eventually ( see `ny index-pcap --pipeline` ).
+template <std::size_t BlockSz, std::size_t Count>
+class block_ring_view {
+  static_assert( Count >= 2 );
+
+ public:
+  static constexpr std::size_t BLOCKSZ = BlockSz;
+  static constexpr std::size_t COUNT = Count;
+  static constexpr auto INVALID = std::numeric_limits<std::uint64_t>::max();
+
+ private:
+  using backoff = unclassified::backoff_strategy::backoff3;
+
+  std::array<mmap_block<BLOCKSZ>, COUNT> _blocks;
+  int _fd{ -1 };
+  std::size_t _cached_size{ 0 };
+  std::uint64_t _cached_offset{ INVALID };
+  // the block of the cached range, counting from the first `prefetch`
+  std::uint64_t _generation{ 0 };
+  bool _end{ false };
+  // blocks before this one are not referenced anymore
+  alignas( 64 ) std::atomic<std::uint64_t> _released{ 0 };
+
+ public:
+  explicit block_ring_view( fs::path const& path, block_flags::type const flags ) noexcept {
+    _fd = open( path.c_str(), flags );
+  }
+
+  ~block_ring_view() noexcept {
+    if( _fd >= 0 ) { close( _fd ); }
+  }
+
+  block_ring_view( block_ring_view const& ) = delete;
+  block_ring_view& operator=( block_ring_view const& ) = delete;
+
+  inline auto cached_size() const noexcept { return _cached_size; }
+
+  inline auto cached_offset() const noexcept { return _cached_offset; }
+
+  constexpr auto block_size() const noexcept { return BLOCKSZ; }
+
+  inline auto is_ok() const noexcept { return _fd >= 0; }
+
+  inline auto end() const noexcept { return _end; }
+
+  // the block the slices handed out since the last `prefetch` point into
+  inline auto generation() const noexcept { return _generation; }
+
+  // called by the consumer: the blocks before `generation` can be reused
+  inline void release( std::uint64_t const generation ) noexcept {
+    _released.store( generation, std::memory_order_release );
+  }
+
+  bool in_cached_range( std::uint64_t const offset, std::size_t size ) const noexcept {
+    return offset >= _cached_offset && ( offset + size ) <= _cached_offset + _cached_size;
+  }
+
+  inline bytestring_view const slice( std::uint64_t const offset,
+                                      std::size_t const size ) const noexcept {
+    if( in_cached_range( offset, size ) ) {
+      auto const* p = current().data();
+      return bytestring_view{ p + offset - _cached_offset, size };
+    }
+    return bytestring_view{ nullptr, 0u };
+  }
+
+  bytestring_view const prefetch( std::uint64_t const offset ) noexcept {
+    if( not is_ok() ) { return bytestring_view{ nullptr, 0u }; }
+    if( offset == _cached_offset ) { return bytestring_view{ current().data(), _cached_size }; }
+    if( _cached_offset != INVALID ) { _generation++; }
+    // the buffer still holds the block `COUNT` generations back
+    for( backoff bo{};
+         _generation - _released.load( std::memory_order_acquire ) >= COUNT; ++bo ) {
+      bo();
+    }
+    auto* p = current().data();
+    std::size_t n = BLOCKSZ;
+    off_t o = static_cast<off_t>( offset );
+    while( n > 0 ) {
+      auto rc = pread( _fd, p, n, o );
+      if( rc < 0 ) {
+        if( errno == EAGAIN || errno == EINTR ) { continue; }
+        _end = true;
+        _cached_size = 0;
+        _cached_offset = INVALID;
+        break;
+      } else if( rc == 0 ) {
+        break;
+      }
+      n -= static_cast<std::size_t>( rc );
+      o += rc;
+      p += rc;
+    }
+    _cached_offset = offset;
+    _cached_size = BLOCKSZ - n;
+    _end = _cached_size < BLOCKSZ;
+    return bytestring_view{ current().data(), _cached_size };
+  }
+
+ private:
+  inline auto& current() noexcept { return _blocks[_generation % COUNT]; }
+  inline auto const& current() const noexcept { return _blocks[_generation % COUNT]; }
 };
 
 using block_view_2m = block_view<2ul << 20>;
@@ -264,5 +395,6 @@ using block_view_8k = block_view<8ul << 10>;
 using block_view_16k = block_view<16ul << 10>;
 using block_view_32k = block_view<32ul << 10>;
 using block_view_64k = block_view<64ul << 10>;
+using block_ring_view_2m = block_ring_view<2ul << 20, 8>;
 
 } // namespace nygma
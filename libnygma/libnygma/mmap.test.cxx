@@ -4,6 +4,9 @@
 
 #include <libnygma/mmap.hxx>
 
+#include <fstream>
+#include <string>
+
 namespace {
 
 emptyspace::pest::suite basic( "mmap suite", []( auto& test ) {
@@ -13,6 +16,38 @@ emptyspace::pest::suite basic( "mmap suite", []( auto& test ) {
     mmap_block<4096> blk;
     expect( blk.data() != nullptr, equal_to( true ) );
   } );
+
+  test( "block_ring_view keeps blocks valid until released", []( auto& expect ) {
+    auto const path = fs::temp_directory_path() / "nygma-block-ring-view.test";
+    {
+      std::ofstream os{ path, std::ios::binary };
+      for( char c : { 'a', 'b', 'c' } ) {
+        std::string const block( 4096, c );
+        os << block;
+      }
+      os << "d";
+    }
+    block_ring_view<4096, 2> v{ path, block_flags::rd };
+    expect( v.is_ok(), equal_to( true ) );
+    auto const a = v.prefetch( 0 );
+    expect( v.generation(), equal_to( 0u ) );
+    expect( v.prefetch( 0 ).data() == a.data(), equal_to( true ) );
+    auto const b = v.prefetch( 4096 );
+    expect( v.generation(), equal_to( 1u ) );
+    // the first block is still there
+    expect( a.rd8() == std::byte( 'a' ) and b.rd8() == std::byte( 'b' ), equal_to( true ) );
+    expect( v.in_cached_range( 4096, 16 ), equal_to( true ) );
+    expect( v.in_cached_range( 0, 16 ), equal_to( false ) );
+    v.release( 1 );
+    auto const c = v.prefetch( 8192 );
+    expect( c.data() == a.data() and c.rd8() == std::byte( 'c' ), equal_to( true ) );
+    expect( v.end(), equal_to( false ) );
+    v.release( 2 );
+    auto const d = v.prefetch( 12288 );
+    expect( d.size(), equal_to( 1u ) );
+    expect( v.end(), equal_to( true ) );
+    fs::remove( path );
+  } );
 } );
 
 }
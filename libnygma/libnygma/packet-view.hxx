@@ -8,6 +8,45 @@ namespace nygma {
 
 using bytestring_view = unclassified::bytestring_view;
 
+namespace pcap {
+
+// link-layer header types, see https://www.tcpdump.org/linktypes.html
+struct linktype {
+  using type = std::uint32_t;
+  enum : type {
+    // bsd loopback, a 4 byte protocol family in the byte order of the capturing host
+    null = 0,
+    en10mb = 1,
+    // ipv4 or ipv6 without link-layer header
+    raw = 101,
+    // openbsd loopback, like `null` in network byte order
+    loop = 108,
+    // linux cooked capture ( `tcpdump -i any` ), v1 and v2
+    linux_sll = 113,
+    ipv4 = 228,
+    ipv6 = 229,
+    linux_sll2 = 276,
+    unsupported = 0xffffffff,
+  };
+
+  // the linktype dissected in place of `t`, `unsupported` if there is no dissector for `t`
+  static constexpr type canonical( type const t ) noexcept {
+    switch( t ) {
+      case null: return null;
+      case loop: return null;
+      case en10mb: return en10mb;
+      case raw: return raw;
+      case ipv4: return raw;
+      case ipv6: return raw;
+      case linux_sll: return linux_sll;
+      case linux_sll2: return linux_sll2;
+      default: return unsupported;
+    }
+  }
+};
+
+} // namespace pcap
+
 struct packet_view {
   std::uint64_t _stamp{ 0 };
   std::uint32_t _hash{ 0 };
@@ -6,7 +6,9 @@
 #include <libnygma/pcap-view.hxx>
 #include <libunclassified/bytestring.hxx>
 
+#include <algorithm>
 #include <filesystem>
+#include <utility>
 
 extern "C" {
 #include <fcntl.h>
@@ -80,25 +82,49 @@ constexpr std::uint32_t pcap_header[6]{ pcap::format::PCAP_NSEC, 0x00040002, 0,
 namespace pcap {
 namespace {
 
+// the slices keep their link-layer headers, so does the output. views without a linktype ( e.g.
+// a `capture_set` ) get ethernet
 template <typename View, typename Stream>
 inline bool reassemble_begin( [[maybe_unused]] View const& pcap, Stream& os ) noexcept {
-  return os.write( reinterpret_cast<std::byte const*>( detail::pcap_header ),
-                   sizeof( detail::pcap_header ) );
+  std::uint32_t header[6];
+  std::copy_n( detail::pcap_header, 6, header );
+  if constexpr( requires { pcap._raw_linktype; } ) { header[5] = pcap._raw_linktype; }
+  return os.write( reinterpret_cast<std::byte const*>( header ), sizeof( header ) );
 }
 
-template <typename View, typename Iter, typename Stream>
-inline bool reassemble_stream( View& pcap, std::uint64_t const segment_offset, Iter begin,
-                               Iter const end, Stream& os ) noexcept {
+// `offset_of` yields offsets relative to the segment or packets of known size and timestamp
+// ( `_offset`, `_length` and `_stamp`, e.g. `riot::packet_entry` ). the latter get sliced with
+// one read of their exact size, their record headers are not read
+template <typename View, typename Location>
+inline packet_view slice_at( View& pcap, std::uint64_t const segment_offset,
+                             Location const& at ) noexcept {
+  if constexpr( requires { at._length; } ) {
+    auto const offset = segment_offset + at._offset;
+    if( at._length > 0 ) { return pcap.slice_exact( offset, at._length, at._stamp ); }
+    return pcap.slice( offset );
+  } else {
+    return pcap.slice( segment_offset + at );
+  }
+}
+
+// like `reassemble_stream`, packets failing `keep( packet_view )` are left out. `offset_of`
+// maps postings to offsets relative to the segment ( e.g. packet ordinals, see
+// `riot::posting_offsets` ) or to packets ( see `slice_at` )
+template <typename View, typename Iter, typename Stream, typename Keep, typename OffsetOf>
+inline bool reassemble_stream_if( View& pcap, std::uint64_t const segment_offset, Iter begin,
+                                  Iter const end, Stream& os, Keep&& keep,
+                                  OffsetOf&& offset_of ) noexcept {
   using iovec_type = typename Stream::iovec_type;
   std::uint32_t packet_header[4];
   iovec_type iov[2];
   iov[0].iov_base = packet_header;
   iov[0].iov_len = sizeof( packet_header );
-  while( begin != end ) {
-    auto const p = pcap.slice( *begin + segment_offset );
+  for( ; begin != end; begin++ ) {
+    auto const p = slice_at( pcap, segment_offset, offset_of( *begin ) );
     auto const stamp = p.stamp();
     auto const& slice = p._slice;
     if( slice.size() == 0u ) { return false; }
+    if( not keep( p ) ) { continue; }
     packet_header[0] = static_cast<std::uint32_t>( stamp / 1'000'000'000ull );
     packet_header[1] = static_cast<std::uint32_t>( stamp % 1'000'000'000ull );
     packet_header[2] = static_cast<unsigned>( slice.size() );
@@ -106,11 +132,34 @@ inline bool reassemble_stream( View& pcap, std::uint64_t const segment_offset, I
     iov[1].iov_base = const_cast<std::byte*>( slice.data() );
     iov[1].iov_len = static_cast<unsigned>( slice.size() );
     if( auto const rc = os.writev( iov, 2 ); not rc ) { return false; }
-    begin++;
   }
   return true;
 }
 
+// the postings are offsets relative to the segment
+template <typename View, typename Iter, typename Stream, typename Keep>
+inline bool reassemble_stream_if( View& pcap, std::uint64_t const segment_offset, Iter begin,
+                                  Iter const end, Stream& os, Keep&& keep ) noexcept {
+  auto const same = []( auto const o ) noexcept { return o; };
+  return reassemble_stream_if( pcap, segment_offset, begin, end, os, std::forward<Keep>( keep ),
+                               same );
+}
+
+template <typename View, typename Iter, typename Stream>
+inline bool reassemble_stream( View& pcap, std::uint64_t const segment_offset, Iter begin,
+                               Iter const end, Stream& os ) noexcept {
+  auto const all = []( packet_view const& ) noexcept { return true; };
+  return reassemble_stream_if( pcap, segment_offset, begin, end, os, all );
+}
+
+template <typename View, typename Iter, typename Stream, typename OffsetOf>
+inline bool reassemble_stream( View& pcap, std::uint64_t const segment_offset, Iter begin,
+                               Iter const end, Stream& os, OffsetOf&& offset_of ) noexcept {
+  auto const all = []( packet_view const& ) noexcept { return true; };
+  return reassemble_stream_if( pcap, segment_offset, begin, end, os, all,
+                               std::forward<OffsetOf>( offset_of ) );
+}
+
 template <typename View, typename Iter, typename Stream>
 inline bool reassemble_from( View& pcap, Iter begin, Iter const end, Stream& os ) noexcept {
   if( auto const rc = reassemble_begin( pcap, os ); not rc ) { return false; }
@@ -5,8 +5,15 @@
 #include <libnygma/pcap-reassembler.hxx>
 #include <libnygma/pcap-view.hxx>
 
+#include <filesystem>
+
 namespace {
 
+// the reassembled pcap of a test, it gets removed at the end of the test
+std::filesystem::path output_path() {
+  return std::filesystem::temp_directory_path() / "pcap-reassembler.test.pcap";
+}
+
 emptyspace::pest::suite basic( "pcap reassembler suite", []( auto& test ) {
   using namespace emptyspace::pest;
   using namespace nygma;
@@ -43,7 +50,7 @@ emptyspace::pest::suite basic( "pcap reassembler suite", []( auto& test ) {
       } );
     }
     { // reassemble pcap using the given offsets
-      auto os = pcap_ostream{ "./pcap-reassembler.test.pcap" };
+      auto os = pcap_ostream{ output_path() };
       auto bv = std::make_unique<block_view_2m>( "tests/data/pcap/1000.pcap", block_flags::rd );
       pcap::with( std::move( bv ), [&]( auto& pcap ) {
         expect( pcap.valid(), equal_to( true ) );
@@ -51,11 +58,67 @@ emptyspace::pest::suite basic( "pcap reassembler suite", []( auto& test ) {
       } );
     }
     std::error_code ec;
-    std::filesystem::path p{ "./pcap-reassembler.test.pcap" };
+    auto const p = output_path();
     auto const size = std::filesystem::file_size( p, ec );
     expect( not ec, equal_to( true ) );
     expect( size,
             equal_to( pcap::PCAP_HEADERSZ + 4u * pcap::PACKET_HEADERSZ + 75u + 95u + 62u + 82u ) );
+    std::filesystem::remove( p, ec );
+  } );
+
+  test( "reassemble a filtered pcap", []( auto& expect ) {
+    std::uint32_t const offsets[] = { 40, 222, 444, 600 };
+    {
+      auto os = pcap_ostream{ output_path() };
+      auto bv = std::make_unique<block_view_2m>( "tests/data/pcap/1000.pcap", block_flags::rd );
+      pcap::with( std::move( bv ), [&]( auto& pcap ) {
+        expect( pcap.valid(), equal_to( true ) );
+        pcap::reassemble_begin( pcap, os );
+        auto const keep = []( packet_view const& p ) { return p.size() != 95u; };
+        pcap::reassemble_stream_if( pcap, 0u, std::begin( offsets ), std::end( offsets ), os, keep );
+      } );
+    }
+    std::error_code ec;
+    auto const p = output_path();
+    auto const size = std::filesystem::file_size( p, ec );
+    expect( not ec, equal_to( true ) );
+    expect( size, equal_to( pcap::PCAP_HEADERSZ + 3u * pcap::PACKET_HEADERSZ + 75u + 62u + 82u ) );
+    std::filesystem::remove( p, ec );
+  } );
+
+  test( "reassemble packets of known size and timestamp", []( auto& expect ) {
+    struct entry {
+      std::uint32_t _offset;
+      std::uint32_t _length;
+      std::uint64_t _stamp;
+    };
+    // the timestamps come from the entries, the record headers are not read
+    entry const entries[] = { { 222, 95u, 42 }, { 444, 62u, 23 }, { 600, 0u, 0 } };
+    std::vector<packet_view> packets;
+    {
+      auto os = pcap_ostream{ output_path() };
+      auto bv = std::make_unique<block_view_2m>( "tests/data/pcap/1000.pcap", block_flags::rd );
+      pcap::with( std::move( bv ), [&]( auto& pcap ) {
+        pcap::reassemble_begin( pcap, os );
+        auto const keep = [&]( packet_view const& p ) {
+          packets.push_back( p );
+          return true;
+        };
+        auto const same = []( entry const& e ) { return e; };
+        pcap::reassemble_stream_if( pcap, 0u, std::begin( entries ), std::end( entries ), os,
+                                    keep, same );
+      } );
+    }
+    expect( packets.size(), equal_to( 3u ) );
+    expect( packets[0].stamp(), equal_to( 42u ) );
+    expect( packets[1].size(), equal_to( 62u ) );
+    // without a size the record header gets read
+    expect( packets[2].size(), equal_to( 82u ) );
+    expect( packets[2].stamp(), equal_to( 1424219007800276000ull ) );
+    std::error_code ec;
+    auto const size = std::filesystem::file_size( output_path(), ec );
+    expect( size, equal_to( pcap::PCAP_HEADERSZ + 3u * pcap::PACKET_HEADERSZ + 95u + 62u + 82u ) );
+    std::filesystem::remove( output_path(), ec );
   } );
 } );
 
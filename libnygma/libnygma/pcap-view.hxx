@@ -7,6 +7,8 @@
 #include <libunclassified/bytestring.hxx>
 
 #include <algorithm>
+#include <array>
+#include <vector>
 
 namespace nygma {
 
@@ -36,21 +38,19 @@ struct format {
   };
 };
 
-struct linktype {
-  using type = std::uint32_t;
-  enum : type { en10mb = 0x01 };
-};
-
 static constexpr std::size_t PCAP_HEADERSZ = 24;
 static constexpr std::size_t PACKET_HEADERSZ = 16;
 
 } // namespace pcap
 
-template <endianess E, pcap::format::type F, typename V>
+// `L` is the canonical linktype ( see `pcap::linktype::canonical` ), it selects the dissector
+template <endianess E, pcap::format::type F, typename V,
+          pcap::linktype::type L = pcap::linktype::en10mb>
 class pcap_view {
  public:
   static constexpr endianess ENDIANESS = E;
   static constexpr pcap::format::type FORMAT = F;
+  static constexpr pcap::linktype::type LINKTYPE = L;
 
   static_assert( FORMAT == pcap::format::PCAP_USEC || FORMAT == pcap::format::PCAP_NSEC );
 
@@ -175,11 +175,14 @@ class pcap_view {
   const_interator_type end() const noexcept { return const_interator_type{ _data.get(), true }; }
 };
 
-template <endianess E, pcap::format::type F, typename V>
+// see `pcap_view` for `L`
+template <endianess E, pcap::format::type F, typename V,
+          pcap::linktype::type L = pcap::linktype::en10mb>
 class pcap_block_view {
  public:
   static constexpr endianess ENDIANESS = E;
   static constexpr pcap::format::type FORMAT = F;
+  static constexpr pcap::linktype::type LINKTYPE = L;
 
   static_assert( FORMAT == pcap::format::PCAP_USEC || FORMAT == pcap::format::PCAP_NSEC );
 
@@ -193,6 +196,8 @@ class pcap_block_view {
   bool _valid;
 
   std::unique_ptr<V> _data;
+  // see `read_oversize`
+  mutable std::vector<std::byte> _oversize;
 
   explicit pcap_block_view( std::unique_ptr<V> data ) noexcept : _data{ std::move( data ) } {
     auto const bs = _data->prefetch( 0 );
@@ -257,23 +262,74 @@ class pcap_block_view {
     }
   }
 
+  // like `for_each` but hands up to `N` packets ( and their offsets ) at once to
+  // `f( packets, offsets, n )`. the slices of a batch are valid during the call only, batches
+  // never span two blocks
+  template <std::size_t N, typename Fn>
+  inline void for_each_batch( Fn&& f ) const noexcept {
+    std::array<packet_view, N> packets;
+    std::array<std::uint64_t, N> offsets;
+    std::size_t n = 0;
+    unsigned block_offset = pcap::PCAP_HEADERSZ;
+    std::uint64_t total_offset = 0;
+    bool done = false;
+    while( not done ) {
+      auto data = _data->prefetch( total_offset );
+      auto is = data.template istream_at<ENDIANESS>( block_offset );
+      while( is.available() > pcap::PACKET_HEADERSZ ) {
+        u32 raw_tv_sec, raw_tv_nsec, raw_caplen, raw_snaplen;
+        is >> raw_tv_sec >> raw_tv_nsec >> raw_caplen >> raw_snaplen;
+        auto const pkt_size = std::min( raw_caplen, raw_snaplen );
+        if( pkt_size > is.available() ) { break; }
+        packets[n]._stamp = to_timestamp_ns( raw_tv_sec, raw_tv_nsec );
+        packets[n]._slice = is.slice( pkt_size );
+        is.advance( pkt_size );
+        offsets[n] = total_offset + block_offset + pcap::PACKET_HEADERSZ;
+        block_offset += pkt_size + pcap::PACKET_HEADERSZ;
+        if( ++n == N ) {
+          f( packets.data(), offsets.data(), n );
+          n = 0;
+        }
+      }
+      // the next `prefetch` invalidates the slices
+      if( n > 0 ) {
+        f( packets.data(), offsets.data(), n );
+        n = 0;
+      }
+      total_offset += block_offset;
+      block_offset = 0;
+      done = _data->end();
+    }
+  }
+
+  // the packet behind the record header at `offset - PACKET_HEADERSZ`. the first read covers
+  // `size_estimate` bytes, larger packets ( e.g. jumbo frames ) take another one of their size
   packet_view const slice( std::uint64_t const offset,
                            std::size_t const size_estimate = 8196u ) const noexcept {
     if( offset < pcap::PCAP_HEADERSZ + pcap::PACKET_HEADERSZ ) { return {}; }
     auto const packet_offset = offset - pcap::PACKET_HEADERSZ;
-    if( not _data->in_cached_range( packet_offset, size_estimate ) ) {
-      _data->prefetch( packet_offset );
-    }
-    auto const slice = _data->slice( packet_offset, size_estimate );
+    auto const slice = fetch( packet_offset, size_estimate );
+    if( slice.size() < pcap::PACKET_HEADERSZ ) { return {}; }
     auto is = slice.template istream<ENDIANESS>();
     std::uint32_t raw_tv_sec, raw_tv_nsec, raw_caplen, raw_snaplen;
     is >> raw_tv_sec >> raw_tv_nsec >> raw_caplen >> raw_snaplen;
     auto const packet_size = std::min( raw_caplen, raw_snaplen );
-    if( packet_size > is.available() ) { return {}; } // TODO: retry with correct size estimate
     auto const stamp = to_timestamp_ns( raw_tv_sec, raw_tv_nsec );
+    if( packet_size > is.available() ) { return slice_exact( offset, packet_size, stamp ); }
     return { stamp, is.cursor(), packet_size };
   }
 
+  // the packet at `offset` of known size and timestamp ( see `ny index-pcap --fat-postings` ),
+  // its record header is not read
+  packet_view const slice_exact( std::uint64_t const offset, std::size_t const size,
+                                 std::uint64_t const stamp ) const noexcept {
+    if( offset < pcap::PCAP_HEADERSZ + pcap::PACKET_HEADERSZ ) { return {}; }
+    auto const slice = size > _data->block_size() ? read_oversize( offset, size )
+                                                  : fetch( offset, size );
+    if( slice.size() < size ) { return {}; }
+    return { stamp, slice.data(), size };
+  }
+
   class cursor {
     V* _block;
     bytestring_view _data{ nullptr, 0 };
@@ -350,6 +406,30 @@ class pcap_block_view {
 
   const_interator_type begin() const noexcept { return const_interator_type{ _data.get() }; }
   const_interator_type end() const noexcept { return const_interator_type{ nullptr, true }; }
+
+ private:
+  // the cached bytes at `offset`, at most `size` of them. the block gets read at `offset` unless
+  // all `size` bytes are cached, fewer bytes are left at the end of the file
+  bytestring_view const fetch( std::uint64_t const offset, std::size_t const size ) const noexcept {
+    if( not _data->in_cached_range( offset, size ) ) { _data->prefetch( offset ); }
+    auto const first = _data->cached_offset();
+    if( offset < first or offset - first >= _data->cached_size() ) {
+      return bytestring_view{ nullptr, 0 };
+    }
+    auto const n = std::min<std::uint64_t>( size, first + _data->cached_size() - offset );
+    return _data->slice( offset, static_cast<std::size_t>( n ) );
+  }
+
+  // packets larger than the block of `V` ( e.g. gro/tso frames behind a 16KiB block ) get read
+  // into a buffer of their own
+  bytestring_view const read_oversize( std::uint64_t const offset,
+                                       std::size_t const size ) const noexcept {
+    try {
+      if( _oversize.size() < size ) { _oversize.resize( size ); }
+    } catch( ... ) { return bytestring_view{ nullptr, 0 }; }
+    auto const n = _data->read( offset, _oversize.data(), size );
+    return bytestring_view{ _oversize.data(), n };
+  }
 };
 
 namespace pcap {
@@ -363,22 +443,59 @@ enum class error_code {
 };
 
 template <typename T, typename DataView,
-          template <endianess E, format::type F, typename V> typename PcapView, endianess E>
-static inline error_code specialize0( std::unique_ptr<DataView>&& view, std::uint32_t magic,
-                                      T&& t ) noexcept {
-  switch( magic ) {
-    case format::PCAP_NSEC: {
-      using pcap_view_type = PcapView<E, format::PCAP_NSEC, DataView>;
-      pcap_view_type pv{ std::move( view ) };
+          template <endianess, format::type, typename, linktype::type> typename PcapView,
+          endianess E, format::type F>
+static inline error_code specialize1( std::unique_ptr<DataView>&& view,
+                                      std::uint32_t const raw_linktype, T&& t ) noexcept {
+  // one instantiation per dissector, the packet loops never look at the linktype
+  switch( linktype::canonical( raw_linktype ) ) {
+    case linktype::null: {
+      PcapView<E, F, DataView, linktype::null> pv{ std::move( view ) };
       t( pv );
       return error_code::OK;
     }
-    case format::PCAP_USEC: {
-      using pcap_view_type = PcapView<E, format::PCAP_USEC, DataView>;
-      pcap_view_type pv{ std::move( view ) };
+    case linktype::en10mb: {
+      PcapView<E, F, DataView, linktype::en10mb> pv{ std::move( view ) };
       t( pv );
       return error_code::OK;
     }
+    case linktype::raw: {
+      PcapView<E, F, DataView, linktype::raw> pv{ std::move( view ) };
+      t( pv );
+      return error_code::OK;
+    }
+    case linktype::linux_sll: {
+      PcapView<E, F, DataView, linktype::linux_sll> pv{ std::move( view ) };
+      t( pv );
+      return error_code::OK;
+    }
+    case linktype::linux_sll2: {
+      PcapView<E, F, DataView, linktype::linux_sll2> pv{ std::move( view ) };
+      t( pv );
+      return error_code::OK;
+    }
+    default: {
+      PcapView<E, F, DataView, linktype::unsupported> pv{ std::move( view ) };
+      t( pv );
+      return error_code::OK;
+    }
+  }
+}
+
+template <typename T, typename DataView,
+          template <endianess, format::type, typename, linktype::type> typename PcapView,
+          endianess E>
+static inline error_code specialize0( std::unique_ptr<DataView>&& view, std::uint32_t magic,
+                                      std::uint32_t const raw_linktype, T&& t ) noexcept {
+  switch( magic ) {
+    case format::PCAP_NSEC:
+      return specialize1<T, DataView, PcapView, E, format::PCAP_NSEC>( std::move( view ),
+                                                                       raw_linktype,
+                                                                       std::forward<T>( t ) );
+    case format::PCAP_USEC:
+      return specialize1<T, DataView, PcapView, E, format::PCAP_USEC>( std::move( view ),
+                                                                       raw_linktype,
+                                                                       std::forward<T>( t ) );
     case format::PCAP_KUZNETZOV: return error_code::UNSUPPORTED_PCAP_FORMAT;
     case format::PCAP_FMESQUITA: return error_code::UNSUPPORTED_PCAP_FORMAT;
     case format::PCAP_NAVTEL: return error_code::UNSUPPORTED_PCAP_FORMAT;
@@ -392,13 +509,17 @@ static inline error_code with( bytestring_view const bs, T&& t ) noexcept {
   if( bs.rd8() == std::byte( 0xa1 ) ) {
     constexpr endianess BE{ endianess::BE };
     auto const magic = bs.rd32<BE>();
+    auto const raw_linktype = bs.rd32<BE>( 20 );
     return specialize0<T, bytestring_view, pcap_view, BE>( std::make_unique<bytestring_view>( bs ),
-                                                           magic, std::forward<T>( t ) );
+                                                           magic, raw_linktype,
+                                                           std::forward<T>( t ) );
   } else {
     constexpr endianess LE{ endianess::LE };
     auto const magic = bs.rd32<LE>();
+    auto const raw_linktype = bs.rd32<LE>( 20 );
     return specialize0<T, bytestring_view, pcap_view, LE>( std::make_unique<bytestring_view>( bs ),
-                                                           magic, std::forward<T>( t ) );
+                                                           magic, raw_linktype,
+                                                           std::forward<T>( t ) );
   }
 }
 
@@ -410,11 +531,15 @@ static inline error_code with( std::unique_ptr<V> view, T&& t ) noexcept {
   if( bs.rd8() == std::byte( 0xa1 ) ) {
     constexpr endianess BE{ endianess::BE };
     auto const magic = bs.template rd32<BE>();
-    return specialize0<T, V, pcap_block_view, BE>( std::move( view ), magic, std::forward<T>( t ) );
+    auto const raw_linktype = bs.template rd32<BE>( 20 );
+    return specialize0<T, V, pcap_block_view, BE>( std::move( view ), magic, raw_linktype,
+                                                   std::forward<T>( t ) );
   } else {
     constexpr endianess LE{ endianess::LE };
     auto const magic = bs.template rd32<LE>();
-    return specialize0<T, V, pcap_block_view, LE>( std::move( view ), magic, std::forward<T>( t ) );
+    auto const raw_linktype = bs.template rd32<LE>( 20 );
+    return specialize0<T, V, pcap_block_view, LE>( std::move( view ), magic, raw_linktype,
+                                                   std::forward<T>( t ) );
   }
 }
 
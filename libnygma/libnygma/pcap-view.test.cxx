@@ -5,6 +5,9 @@
 #include <libnygma/pcap-view.hxx>
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
 
 namespace pcap = nygma::pcap;
 
@@ -143,6 +146,26 @@ emptyspace::pest::suite basic_mmap( "pcap in-memory suite", []( auto& test ) {
     expect( c._last_stamp, equal_to( 1u ) );
     expect( c._last_size, equal_to( 0u ) );
   } );
+
+  test( "linktype selects the view", []( auto& expect ) {
+    auto const linktype_of = []( std::uint32_t const raw ) {
+      unsigned char header[sizeof( pcap_le_en10mb_1 )];
+      std::copy_n( pcap_le_en10mb_1, sizeof( header ), header );
+      std::copy_n( reinterpret_cast<unsigned char const*>( &raw ), 4, header + 20 );
+      bytestring_view data{ header };
+      std::uint32_t r = 0;
+      pcap::with( data, [&]( auto const& view ) { r = std::decay_t<decltype( view )>::LINKTYPE; } );
+      return r;
+    };
+    expect( linktype_of( 1 ), equal_to( std::uint32_t{ pcap::linktype::en10mb } ) );
+    expect( linktype_of( 0 ), equal_to( std::uint32_t{ pcap::linktype::null } ) );
+    expect( linktype_of( 108 ), equal_to( std::uint32_t{ pcap::linktype::null } ) );
+    expect( linktype_of( 101 ), equal_to( std::uint32_t{ pcap::linktype::raw } ) );
+    expect( linktype_of( 229 ), equal_to( std::uint32_t{ pcap::linktype::raw } ) );
+    expect( linktype_of( 113 ), equal_to( std::uint32_t{ pcap::linktype::linux_sll } ) );
+    expect( linktype_of( 276 ), equal_to( std::uint32_t{ pcap::linktype::linux_sll2 } ) );
+    expect( linktype_of( 105 ), equal_to( std::uint32_t{ pcap::linktype::unsupported } ) );
+  } );
 } );
 
 emptyspace::pest::suite basic_blockio( "pcap blockio suite", []( auto& test ) {
@@ -256,6 +279,39 @@ emptyspace::pest::suite basic_blockio( "pcap blockio suite", []( auto& test ) {
     } );
   } );
 
+  test( "batched replay `block_view{ 1000.pcap }`", []( auto& expect ) {
+    std::vector<query> queries;
+    std::vector<query> batched;
+    std::size_t max_batch = 0;
+    for( int i = 0; i < 2; ++i ) {
+      auto bv = std::make_unique<block_view_16k>( "tests/data/pcap/1000.pcap", block_flags::rd );
+      pcap::with( std::move( bv ), [&]( auto& pcap ) {
+        expect( pcap.valid(), equal_to( true ) );
+        if( not pcap.valid() ) { return; }
+        if( i == 0 ) {
+          pcap.for_each( [&]( auto& pkt, auto const offset ) {
+            queries.emplace_back( offset, pkt.size(), pkt.stamp() );
+          } );
+          return;
+        }
+        auto const collect = [&]( auto const* pkts, auto const* offsets, auto const n ) {
+          max_batch = std::max( max_batch, n );
+          for( std::size_t j = 0; j < n; ++j ) {
+            batched.emplace_back( offsets[j], pkts[j].size(), pkts[j].stamp() );
+          }
+        };
+        pcap.template for_each_batch<16>( collect );
+      } );
+    }
+    expect( max_batch, equal_to( 16u ) );
+    expect( batched.size(), equal_to( queries.size() ) );
+    for( std::size_t j = 0; j < std::min( batched.size(), queries.size() ); ++j ) {
+      expect( batched[j]._offset, equal_to( queries[j]._offset ) );
+      expect( batched[j]._size, equal_to( queries[j]._size ) );
+      expect( batched[j]._timestamp, equal_to( queries[j]._timestamp ) );
+    }
+  } );
+
   test( "bulk slice `block_view{ 1000.pcap }`", []( auto& expect ) {
     query queries[] = {
         // generated using the indexer ( with limit )
@@ -281,6 +337,45 @@ emptyspace::pest::suite basic_blockio( "pcap blockio suite", []( auto& test ) {
       }
     } );
   } );
+
+  test( "slice jumbo and oversized frames up to the end of the file", []( auto& expect ) {
+    auto const path = std::filesystem::temp_directory_path() / "pcap-view.test.jumbo.pcap";
+    std::uint32_t const sizes[] = { 100, 9000, 40000, 60 };
+    std::vector<std::uint64_t> offsets;
+    {
+      std::ofstream os{ path, std::ios::binary };
+      std::uint32_t const header[6]{ pcap::format::PCAP_NSEC, 0x00040002, 0, 0, 65535, 1 };
+      os.write( reinterpret_cast<char const*>( header ), sizeof( header ) );
+      std::uint64_t offset = pcap::PCAP_HEADERSZ;
+      for( std::uint32_t i = 0; i < 4; ++i ) {
+        std::uint32_t const record[4]{ 1424219007 + i, 42, sizes[i], sizes[i] };
+        os.write( reinterpret_cast<char const*>( record ), sizeof( record ) );
+        std::vector<char> const payload( sizes[i], static_cast<char>( 'a' + i ) );
+        os.write( payload.data(), static_cast<std::streamsize>( payload.size() ) );
+        offsets.push_back( offset + pcap::PACKET_HEADERSZ );
+        offset += pcap::PACKET_HEADERSZ + sizes[i];
+      }
+    }
+    auto bv = std::make_unique<nygma::block_view_16k>( path, nygma::block_flags::rd );
+    pcap::with( std::move( bv ), [&]( auto& pcap ) {
+      for( std::size_t i : { 3, 1, 2, 0, 2 } ) {
+        auto const pkt = pcap.slice( offsets[i] );
+        expect( pkt.size(), equal_to( sizes[i] ) );
+        expect( pkt.stamp(), equal_to( ( 1424219007ull + i ) * 1'000'000'000ull + 42 ) );
+        auto const c = std::byte( 'a' + i );
+        auto const same = std::all_of( pkt._slice.begin(), pkt._slice.end(),
+                                       [c]( auto const b ) { return b == c; } );
+        expect( same, equal_to( true ) );
+        // with the size known up front the record header is not read
+        auto const exact = pcap.slice_exact( offsets[i], sizes[i], 4223 );
+        expect( exact.size(), equal_to( sizes[i] ) );
+        expect( exact.stamp(), equal_to( 4223u ) );
+      }
+      // a size beyond the end of the file
+      expect( pcap.slice_exact( offsets[3], 61, 0 ).size(), equal_to( 0u ) );
+    } );
+    std::filesystem::remove( path );
+  } );
 } );
 } // namespace
 
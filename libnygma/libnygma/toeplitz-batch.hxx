@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libnygma/toeplitz-scalar-lut.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <array>
+#include <cstdint>
+
+#include <immintrin.h>
+
+namespace nygma::toeplitz {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+// batched hashing of tuples given as structure of arrays ( like `dissect::dissect_batch` ):
+// addresses as integers ( most significant byte first ) and ports, `hash_batch<N>( src, dst,
+// [ sport, dport, ] out )` writes the hashes of `N` tuples to `out`. the ipv4 / ipv6 overloads
+// hash the same bytes as `hash<8 / 12>` / `hash<32 / 36>` of the single tuple hashers.
+
+// one tuple at a time with a single tuple hasher ( `toeplitz_scalar_lut`, `toeplitz_clmul` )
+template <typename Hasher>
+struct toeplitz_batch {
+  Hasher _hasher;
+
+  template <std::size_t N>
+  inline std::uint32_t hash( std::byte const* const p ) const noexcept {
+    return _hasher.template hash<N>( p );
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( std::uint32_t const* const src, std::uint32_t const* const dst,
+                          std::uint32_t* const out ) const noexcept {
+    constexpr endianess BE = endianess::BE;
+    std::byte data[8];
+    for( std::size_t i = 0; i < N; i++ ) {
+      unsafe::wr32<BE>( data, src[i] );
+      unsafe::wr32<BE>( data + 4, dst[i] );
+      out[i] = _hasher.template hash<8>( data );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( std::uint32_t const* const src, std::uint32_t const* const dst,
+                          std::uint16_t const* const sport, std::uint16_t const* const dport,
+                          std::uint32_t* const out ) const noexcept {
+    constexpr endianess BE = endianess::BE;
+    std::byte data[12];
+    for( std::size_t i = 0; i < N; i++ ) {
+      unsafe::wr32<BE>( data, src[i] );
+      unsafe::wr32<BE>( data + 4, dst[i] );
+      unsafe::wr32<BE>( data + 8, std::uint32_t( sport[i] ) << 16 | dport[i] );
+      out[i] = _hasher.template hash<12>( data );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( __uint128_t const* const src, __uint128_t const* const dst,
+                          std::uint32_t* const out ) const noexcept {
+    constexpr endianess BE = endianess::BE;
+    std::byte data[32];
+    for( std::size_t i = 0; i < N; i++ ) {
+      unsafe::wr128<BE>( data, src[i] );
+      unsafe::wr128<BE>( data + 16, dst[i] );
+      out[i] = _hasher.template hash<32>( data );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( __uint128_t const* const src, __uint128_t const* const dst,
+                          std::uint16_t const* const sport, std::uint16_t const* const dport,
+                          std::uint32_t* const out ) const noexcept {
+    constexpr endianess BE = endianess::BE;
+    std::byte data[36];
+    for( std::size_t i = 0; i < N; i++ ) {
+      unsafe::wr128<BE>( data, src[i] );
+      unsafe::wr128<BE>( data + 16, dst[i] );
+      unsafe::wr32<BE>( data + 32, std::uint32_t( sport[i] ) << 16 | dport[i] );
+      out[i] = _hasher.template hash<36>( data );
+    }
+  }
+};
+
+#if defined( __GFNI__ ) && defined( __AVX2__ )
+
+// 8 tuples at a time with `gf2p8affineqb`. a qword holds the same input byte of 8 tuples, the
+// affine transformation with the 8x8 bit matrix of the key bits `8 * ( i + o ) ..` maps input byte
+// `i` to its share of output byte `o`. the hash is the xor of these shares over all input bytes:
+// one 256bit transformation per input byte and 8 tuples, without any table lookup.
+//
+// the matrices take 312 bytes instead of the 36 KiB of `toeplitz_scalar_lut`.
+template <typename Key>
+struct toeplitz_gfni {
+  static_assert( Key::key.size() >= RSSKEYSZ, "Key must be at least toeplitz::RSSKEYSZ long" );
+  static constexpr std::size_t MATRICES = RSSHASHSZ + 3;
+
+  // `_matrix[q]` byte `c` holds the key bits `8 * q + c ..` ( msb first ), its row for output bit
+  // `7 - c` of `gf2p8affineqb`
+  std::array<std::uint64_t, MATRICES> _matrix;
+
+ public:
+  constexpr toeplitz_gfni() noexcept : _matrix{} {
+    for( std::size_t q = 0; q < MATRICES; q++ ) {
+      for( std::size_t c = 0; c < 8; c++ ) {
+        std::uint64_t row = 0;
+        for( std::size_t b = 0; b < 8; b++ ) {
+          std::size_t const bit = 8 * q + c + b;
+          if( bit / 8 >= Key::key.size() ) { break; }
+          if( Key::key[bit / 8] & ( 0x80u >> ( bit % 8 ) ) ) { row |= 0x80u >> b; }
+        }
+        _matrix[q] |= row << ( 8 * c );
+      }
+    }
+  }
+
+ private:
+  // the shares of input byte `i`, byte `K` of the transposed tuples `t`, to output bytes 0 .. 3
+  template <int K>
+  inline __m256i share( __m256i const acc, __m256i const t, std::size_t const i ) const noexcept {
+    auto const x = _mm256_permute4x64_epi64( t, K * 0x55 );
+    auto const m = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( _matrix.data() + i ) );
+    return _mm256_xor_si256( acc, _mm256_gf2p8affine_epi64_epi8( x, m, 0 ) );
+  }
+
+  // input bytes `i .. i + 4` given as 32bit integers of 8 tuples
+  inline __m256i shares32( __m256i acc, __m256i const v, std::size_t const i ) const noexcept {
+    // bytes msb first per lane, then interleave the lanes: qword `k` is byte `k` of all tuples
+    auto const bytes = _mm256_setr_epi8( 3, 7, 11, 15, 2, 6, 10, 14, 1, 5, 9, 13, 0, 4, 8, 12, //
+                                         3, 7, 11, 15, 2, 6, 10, 14, 1, 5, 9, 13, 0, 4, 8, 12 );
+    auto const lanes = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+    auto const t = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( v, bytes ), lanes );
+    acc = share<0>( acc, t, i );
+    acc = share<1>( acc, t, i + 1 );
+    acc = share<2>( acc, t, i + 2 );
+    return share<3>( acc, t, i + 3 );
+  }
+
+  // input bytes `0 .. 32` given as two 128bit integers of 8 tuples
+  inline __m256i shares128( __m256i acc, __uint128_t const* const src,
+                            __uint128_t const* const dst ) const noexcept {
+    auto const msb = _mm256_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, //
+                                       15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+    __m256i r[8];
+    for( std::size_t i = 0; i < 8; i++ ) {
+      auto const s = _mm_loadu_si128( reinterpret_cast<__m128i const*>( src + i ) );
+      auto const d = _mm_loadu_si128( reinterpret_cast<__m128i const*>( dst + i ) );
+      r[i] = _mm256_shuffle_epi8( _mm256_set_m128i( d, s ), msb );
+    }
+    // 8x16 byte transpose per lane: the qwords of `lo` / `hi` are bytes `4k, 4k + 1` / `4k + 2,
+    // 4k + 3` of all tuples, the source address in the low, the destination in the high lane
+    __m256i a[8], b[8];
+    for( std::size_t i = 0; i < 4; i++ ) {
+      a[2 * i] = _mm256_unpacklo_epi8( r[2 * i], r[2 * i + 1] );
+      a[2 * i + 1] = _mm256_unpackhi_epi8( r[2 * i], r[2 * i + 1] );
+    }
+    for( std::size_t i = 0; i < 2; i++ ) {
+      b[4 * i] = _mm256_unpacklo_epi16( a[4 * i], a[4 * i + 2] );
+      b[4 * i + 1] = _mm256_unpackhi_epi16( a[4 * i], a[4 * i + 2] );
+      b[4 * i + 2] = _mm256_unpacklo_epi16( a[4 * i + 1], a[4 * i + 3] );
+      b[4 * i + 3] = _mm256_unpackhi_epi16( a[4 * i + 1], a[4 * i + 3] );
+    }
+    for( std::size_t k = 0; k < 4; k++ ) {
+      auto const lo = _mm256_unpacklo_epi32( b[k], b[4 + k] );
+      auto const hi = _mm256_unpackhi_epi32( b[k], b[4 + k] );
+      acc = share<0>( acc, lo, 4 * k );
+      acc = share<1>( acc, lo, 4 * k + 1 );
+      acc = share<2>( acc, lo, 4 * k + 16 );
+      acc = share<3>( acc, lo, 4 * k + 17 );
+      acc = share<0>( acc, hi, 4 * k + 2 );
+      acc = share<1>( acc, hi, 4 * k + 3 );
+      acc = share<2>( acc, hi, 4 * k + 18 );
+      acc = share<3>( acc, hi, 4 * k + 19 );
+    }
+    return acc;
+  }
+
+  inline __m256i ports( std::uint16_t const* const sport,
+                        std::uint16_t const* const dport ) const noexcept {
+    auto const s = _mm_loadu_si128( reinterpret_cast<__m128i const*>( sport ) );
+    auto const d = _mm_loadu_si128( reinterpret_cast<__m128i const*>( dport ) );
+    return _mm256_or_si256( _mm256_slli_epi32( _mm256_cvtepu16_epi32( s ), 16 ),
+                            _mm256_cvtepu16_epi32( d ) );
+  }
+
+  // qword `o` of `acc` holds output byte `o` of the 8 tuples
+  static inline void store( std::uint32_t* const out, __m256i const acc ) noexcept {
+    auto const lanes = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+    auto const bytes = _mm256_setr_epi8( 12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3, //
+                                         12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3 );
+    auto const x = _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( acc, lanes ), bytes );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( out ), x );
+  }
+
+  static inline __m256i load32( std::uint32_t const* const p ) noexcept {
+    return _mm256_loadu_si256( reinterpret_cast<__m256i const*>( p ) );
+  }
+
+ public:
+  template <std::size_t N>
+  inline void hash_batch( std::uint32_t const* const src, std::uint32_t const* const dst,
+                          std::uint32_t* const out ) const noexcept {
+    static_assert( N % 8 == 0, "N must be a multiple of 8" );
+    for( std::size_t i = 0; i < N; i += 8 ) {
+      auto acc = shares32( _mm256_setzero_si256(), load32( src + i ), 0 );
+      store( out + i, shares32( acc, load32( dst + i ), 4 ) );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( std::uint32_t const* const src, std::uint32_t const* const dst,
+                          std::uint16_t const* const sport, std::uint16_t const* const dport,
+                          std::uint32_t* const out ) const noexcept {
+    static_assert( N % 8 == 0, "N must be a multiple of 8" );
+    for( std::size_t i = 0; i < N; i += 8 ) {
+      auto acc = shares32( _mm256_setzero_si256(), load32( src + i ), 0 );
+      acc = shares32( acc, load32( dst + i ), 4 );
+      store( out + i, shares32( acc, ports( sport + i, dport + i ), 8 ) );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( __uint128_t const* const src, __uint128_t const* const dst,
+                          std::uint32_t* const out ) const noexcept {
+    static_assert( N % 8 == 0, "N must be a multiple of 8" );
+    for( std::size_t i = 0; i < N; i += 8 ) {
+      store( out + i, shares128( _mm256_setzero_si256(), src + i, dst + i ) );
+    }
+  }
+
+  template <std::size_t N>
+  inline void hash_batch( __uint128_t const* const src, __uint128_t const* const dst,
+                          std::uint16_t const* const sport, std::uint16_t const* const dport,
+                          std::uint32_t* const out ) const noexcept {
+    static_assert( N % 8 == 0, "N must be a multiple of 8" );
+    for( std::size_t i = 0; i < N; i += 8 ) {
+      auto const acc = shares128( _mm256_setzero_si256(), src + i, dst + i );
+      store( out + i, shares32( acc, ports( sport + i, dport + i ), 32 ) );
+    }
+  }
+};
+
+#endif
+
+} // namespace nygma::toeplitz
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libnygma/toeplitz-scalar-lut.hxx>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace nygma::toeplitz {
+
+#if defined( __PCLMUL__ )
+
+// carry-less multiplication, 4 input bytes per `pclmulqdq`. every output bit `j` of the toeplitz
+// hash is the parity of `data & key[ j .. )`, a correlation of data and key: with the key windows
+// bit reversed the product of a 32bit big endian data word `d` and the reversed window `w` of its
+// 63 key bits holds the 32 hash bits of `d` at bits 31 .. 62 ( in reverse order ).
+//
+// the table is 9 64bit windows ( 40 byte keys ) instead of the 36 KiB of `toeplitz_scalar_lut`.
+//
+// @see:
+//   - intel: carry-less multiplication instruction and its usage for computing the gcm mode
+template <typename Key>
+struct toeplitz_clmul {
+  static_assert( Key::key.size() >= RSSKEYSZ, "Key must be at least toeplitz::RSSKEYSZ long" );
+  static constexpr std::size_t WORDS = INPUTSZ<Key> / 4;
+
+  // `_window[i]` bit `s` is key bit `32 * i + s` ( key bits are numbered msb first )
+  std::array<std::uint64_t, WORDS> _window;
+
+ public:
+  constexpr toeplitz_clmul() noexcept : _window{} {
+    for( std::size_t i = 0; i < WORDS; i++ ) {
+      for( std::size_t s = 0; s < 63; s++ ) {
+        std::size_t const bit = 32 * i + s;
+        if( bit / 8 >= Key::key.size() ) { break; }
+        if( Key::key[bit / 8] & ( 0x80u >> ( bit % 8 ) ) ) { _window[i] |= 1ull << s; }
+      }
+    }
+  }
+
+ private:
+  static inline std::uint32_t reverse( std::uint32_t x ) noexcept {
+    x = __builtin_bswap32( x );
+    x = ( ( x >> 4 ) & 0x0f0f0f0fu ) | ( ( x & 0x0f0f0f0fu ) << 4 );
+    x = ( ( x >> 2 ) & 0x33333333u ) | ( ( x & 0x33333333u ) << 2 );
+    return ( ( x >> 1 ) & 0x55555555u ) | ( ( x & 0x55555555u ) << 1 );
+  }
+
+ public:
+  // `N` is 8 / 32 for addresses only and 12 / 36 for addresses followed by the ports. keys longer
+  // than `RSSKEYSZ` hash longer inputs
+  template <std::size_t N>
+  inline std::uint32_t hash( std::byte const* const p ) const noexcept {
+    static_assert( N % 4 == 0 && N <= INPUTSZ<Key>,
+                   "N must be a multiple of 4 bytes and at most the key length minus 4 bytes" );
+    __m128i acc = _mm_setzero_si128();
+    for( std::size_t i = 0; i < N / 4; i++ ) {
+      std::uint32_t d;
+      std::memcpy( &d, p + 4 * i, sizeof( d ) );
+      auto const x = _mm_cvtsi32_si128( static_cast<int>( __builtin_bswap32( d ) ) );
+      auto const w = _mm_cvtsi64_si128( static_cast<long long>( _window[i] ) );
+      acc = _mm_xor_si128( acc, _mm_clmulepi64_si128( x, w, 0x00 ) );
+    }
+    auto const bits = static_cast<std::uint64_t>( _mm_cvtsi128_si64( acc ) );
+    return reverse( static_cast<std::uint32_t>( bits >> 31 ) );
+  }
+};
+
+#endif
+
+} // namespace nygma::toeplitz
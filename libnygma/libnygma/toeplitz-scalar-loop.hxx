@@ -3,6 +3,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace nygma::toeplitz {
 
@@ -13,8 +14,7 @@ template <typename Key>
 struct toeplitz_scalar_loop {
   template <std::size_t N>
   inline std::uint32_t hash( std::byte const* data ) {
-    static_assert( N == 8 || N == 32, "N must be either 8 bytes (ipv4) or 32 bytes (ipv6)" );
-    // XXX: Perhaps an assertion about key length vs. data length?
+    static_assert( N + 4 <= Key::key.size(), "N must be at most the key length minus 4 bytes" );
     std::uint32_t v = ( Key::key[0] << 24 ) + ( Key::key[1] << 16 ) + ( Key::key[2] << 8 ) +
         Key::key[3];
     uint32_t hash = 0;
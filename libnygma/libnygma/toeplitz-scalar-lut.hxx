@@ -3,11 +3,17 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace nygma::toeplitz {
 
 static constexpr std::size_t RSSKEYSZ = 40;
-static constexpr std::size_t RSSHASHSZ = 32;
+// addresses and ports of ipv6 ( 36 bytes ) use all 320 key bits
+static constexpr std::size_t RSSHASHSZ = 36;
+
+// the longest input a key can hash, every input bit needs the 32 key bits starting at its position
+template <typename Key>
+static constexpr std::size_t INPUTSZ = Key::key.size() - 4;
 
 // @see:
 //   - DragonFlyBSD/tools/tools/toeplitz/toeplitz.c
@@ -15,11 +21,11 @@ static constexpr std::size_t RSSHASHSZ = 32;
 template <typename Key>
 struct toeplitz_scalar_lut {
   static_assert( Key::key.size() >= RSSKEYSZ, "Key must be at least toeplitz::RSSKEYSZ long" );
-  std::uint32_t _hash[RSSHASHSZ][256];
+  std::uint32_t _hash[INPUTSZ<Key>][256];
 
  public:
   constexpr toeplitz_scalar_lut() noexcept {
-    for( unsigned i = 0; i < RSSHASHSZ; i++ ) {
+    for( unsigned i = 0; i < INPUTSZ<Key>; i++ ) {
       std::uint32_t kk[8] = { 0 };
       for( unsigned b = 0; b < 8; b++ ) {
         for( unsigned j = 0; j < 32; j++ ) {
@@ -91,14 +97,25 @@ struct toeplitz_scalar_lut {
     return hash;
   }
 
+  template <std::size_t N>
+  inline std::uint32_t hashn( std::byte const* p ) const noexcept {
+    std::uint32_t hash = 0;
+    for( std::size_t i = 0; i < N; i++ ) { hash ^= _hash[i][static_cast<std::size_t>( p[i] )]; }
+    return hash;
+  }
+
  public:
+  // `N` is 8 / 32 for addresses only and 12 / 36 for addresses followed by the ports. keys longer
+  // than `RSSKEYSZ` hash longer inputs
   template <std::size_t N>
   constexpr std::uint32_t hash( std::byte const* const p ) const noexcept {
-    static_assert( N == 8 || N == 32, "N must be either 8 bytes (ipv4) or 32 bytes (ipv6)" );
+    static_assert( N <= INPUTSZ<Key>, "N must be at most the key length minus 4 bytes" );
     if constexpr( N == 8 ) {
       return hash8( p );
     } else if constexpr( N == 32 ) {
       return hash32( p );
+    } else {
+      return hashn<N>( p );
     }
   }
 };
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <libnygma/toeplitz-batch.hxx>
+#include <libnygma/toeplitz-clmul.hxx>
 #include <libnygma/toeplitz-keys.hxx>
 #include <libnygma/toeplitz-scalar-loop.hxx>
 #include <libnygma/toeplitz-scalar-lut.hxx>
@@ -1,12 +1,15 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
 #include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
 
 #include <libnygma/toeplitz.hxx>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <type_traits>
+#include <vector>
 
 extern "C" {
 #include <arpa/inet.h>
@@ -41,8 +44,27 @@ union ipv6 {
   std::array<std::byte, 32> _array;
 };
 
+// addresses followed by source and destination port
+union ipv4_ports {
+  struct {
+    std::uint32_t _ip[2];
+    std::uint16_t _port[2];
+  };
+  std::array<std::byte, 12> _array;
+};
+
+union ipv6_ports {
+  struct {
+    in6_addr _ip[2];
+    std::uint16_t _port[2];
+  };
+  std::array<std::byte, 36> _array;
+};
+
 static_assert( sizeof( ipv4 ) == 8 );
 static_assert( sizeof( ipv6 ) == 32 );
+static_assert( sizeof( ipv4_ports ) == 12 );
+static_assert( sizeof( ipv6_ports ) == 36 );
 
 template <std::size_t N, std::size_t M>
 static constexpr ipv4 make_v4( char const ( &src )[N], char const ( &dst )[M] ) {
@@ -60,6 +82,73 @@ static constexpr ipv6 make_v6( char const ( &src )[N], char const ( &dst )[M] )
   return ( data );
 }
 
+template <std::size_t N, std::size_t M>
+static ipv4_ports make_v4( char const ( &src )[N], char const ( &dst )[M], std::uint16_t const sp,
+                           std::uint16_t const dp ) {
+  auto data = ipv4_ports{};
+  data._ip[dir::ips] = ::inet_addr( src );
+  data._ip[dir::ipd] = ::inet_addr( dst );
+  data._port[dir::ips] = htons( sp );
+  data._port[dir::ipd] = htons( dp );
+  return ( data );
+}
+
+template <std::size_t N, std::size_t M>
+static ipv6_ports make_v6( char const ( &src )[N], char const ( &dst )[M], std::uint16_t const sp,
+                           std::uint16_t const dp ) {
+  auto data = ipv6_ports{};
+  ::inet_pton( AF_INET6, src, &data._ip[dir::ips] );
+  ::inet_pton( AF_INET6, dst, &data._ip[dir::ipd] );
+  data._port[dir::ips] = htons( sp );
+  data._port[dir::ipd] = htons( dp );
+  return ( data );
+}
+
+// `N` random tuples as structure of arrays, hashed one by one with `toeplitz_scalar_lut<ms>`
+template <std::size_t N>
+struct tuples {
+  std::uint32_t _src4[N], _dst4[N];
+  __uint128_t _src6[N], _dst6[N];
+  std::uint16_t _sport[N], _dport[N];
+
+  explicit tuples( std::uint64_t const seed ) {
+    emptyspace::xoshiro::xoshiro256starstar64 xo{ seed };
+    for( std::size_t i = 0; i < N; i++ ) {
+      _src4[i] = static_cast<std::uint32_t>( xo() );
+      _dst4[i] = static_cast<std::uint32_t>( xo() );
+      _src6[i] = __uint128_t( xo() ) << 64 | xo();
+      _dst6[i] = __uint128_t( xo() ) << 64 | xo();
+      _sport[i] = static_cast<std::uint16_t>( xo() );
+      _dport[i] = static_cast<std::uint16_t>( xo() );
+    }
+  }
+
+  // the expected hashes: v4, v4 + ports, v6, v6 + ports
+  std::vector<std::uint32_t> expected( unsigned const which ) const {
+    toeplitz::toeplitz_batch<toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_ms>> lut;
+    std::vector<std::uint32_t> r( N );
+    switch( which ) {
+      case 0: lut.hash_batch<N>( _src4, _dst4, r.data() ); break;
+      case 1: lut.hash_batch<N>( _src4, _dst4, _sport, _dport, r.data() ); break;
+      case 2: lut.hash_batch<N>( _src6, _dst6, r.data() ); break;
+      default: lut.hash_batch<N>( _src6, _dst6, _sport, _dport, r.data() ); break;
+    }
+    return r;
+  }
+
+  template <typename Hasher>
+  std::vector<std::uint32_t> actual( Hasher const& h, unsigned const which ) const {
+    std::vector<std::uint32_t> r( N );
+    switch( which ) {
+      case 0: h.template hash_batch<N>( _src4, _dst4, r.data() ); break;
+      case 1: h.template hash_batch<N>( _src4, _dst4, _sport, _dport, r.data() ); break;
+      case 2: h.template hash_batch<N>( _src6, _dst6, r.data() ); break;
+      default: h.template hash_batch<N>( _src6, _dst6, _sport, _dport, r.data() ); break;
+    }
+    return r;
+  }
+};
+
 emptyspace::pest::suite basic( "toeplitz suite", []( auto& test ) {
   using namespace emptyspace::pest;
 
@@ -202,6 +291,183 @@ emptyspace::pest::suite basic( "toeplitz suite", []( auto& test ) {
     auto hash = rss.hash<32>( data._array.data() );
     expect( hash, equal_to( 0x4b61e985u ) );
   } );
+
+  test( "v4+ports: toeplitz_scalar_lut<ms> 01", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_ms> rss;
+    auto data = make_v4( "66.9.149.187", "161.142.100.80", 2794, 1766 );
+    auto hash = rss.hash<12>( data._array.data() );
+    expect( hash, equal_to( 0x51ccc178u ) );
+  } );
+
+  test( "v4+ports: toeplitz_scalar_lut<ms> 02", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_ms> rss;
+    auto data = make_v4( "199.92.111.2", "65.69.140.83", 14230, 4739 );
+    auto hash = rss.hash<12>( data._array.data() );
+    expect( hash, equal_to( 0xc626b0eau ) );
+  } );
+
+  test( "v4+ports: toeplitz_scalar_loop<ms> 01", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_loop<toeplitz::rss_key_ms> rss;
+    auto data = make_v4( "66.9.149.187", "161.142.100.80", 2794, 1766 );
+    auto hash = rss.hash<12>( data._array.data() );
+    expect( hash, equal_to( 0x51ccc178u ) );
+  } );
+
+  test( "v6+ports: toeplitz_scalar_lut<ms> 01", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_ms> rss;
+    auto data = make_v6( "3ffe:2501:200:1fff::7", "3ffe:2501:200:3::1", 2794, 1766 );
+    auto hash = rss.hash<36>( data._array.data() );
+    expect( hash, equal_to( 0x40207d3du ) );
+  } );
+
+  test( "v6+ports: toeplitz_scalar_lut<ms> 02", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_ms> rss;
+    auto data = make_v6( "3ffe:501:8::260:97ff:fe40:efab", "ff02::1", 14230, 4739 );
+    auto hash = rss.hash<36>( data._array.data() );
+    expect( hash, equal_to( 0xdde51bbfu ) );
+  } );
+
+  test( "v6+ports: toeplitz_scalar_loop<ms> 01", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_loop<toeplitz::rss_key_ms> rss;
+    auto data = make_v6( "3ffe:2501:200:1fff::7", "3ffe:2501:200:3::1", 2794, 1766 );
+    auto hash = rss.hash<36>( data._array.data() );
+    expect( hash, equal_to( 0x40207d3du ) );
+  } );
+
+  test( "v4+ports: toeplitz_scalar_lut<sym> is symmetric", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_symmetric> rss;
+    auto a = make_v4( "66.9.149.187", "161.142.100.80", 2794, 1766 );
+    auto b = make_v4( "161.142.100.80", "66.9.149.187", 1766, 2794 );
+    expect( rss.hash<12>( a._array.data() ), equal_to( rss.hash<12>( b._array.data() ) ) );
+    // the key repeats every 16 bits, the hash only depends on the xor of the 16 bit words. other
+    // flows collide, e.g. the one with only the addresses swapped
+    auto c = make_v4( "161.142.100.80", "66.9.149.187", 2794, 1766 );
+    expect( rss.hash<12>( a._array.data() ), equal_to( rss.hash<12>( c._array.data() ) ) );
+  } );
+
+  test( "v6+ports: toeplitz_scalar_lut<sym> is symmetric", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_symmetric> rss;
+    auto a = make_v6( "3ffe:501:8::260:97ff:fe40:efab", "ff02::1", 14230, 4739 );
+    auto b = make_v6( "ff02::1", "3ffe:501:8::260:97ff:fe40:efab", 4739, 14230 );
+    expect( rss.hash<36>( a._array.data() ), equal_to( rss.hash<36>( b._array.data() ) ) );
+  } );
+
+  test( "toeplitz_scalar_lut<i40e_pmd_52> hashes 40 bytes like the loop", []( auto& expect ) {
+    toeplitz::toeplitz_scalar_lut<toeplitz::rss_key_i40e_pmd_52> lut;
+    toeplitz::toeplitz_scalar_loop<toeplitz::rss_key_i40e_pmd_52> loop;
+    emptyspace::xoshiro::xoshiro256starstar64 xo{ 0x2342 };
+    for( unsigned i = 0; i < 64; i++ ) {
+      std::array<std::byte, 40> data;
+      for( auto& b : data ) { b = static_cast<std::byte>( xo() ); }
+      expect( lut.hash<16>( data.data() ), equal_to( loop.hash<16>( data.data() ) ) );
+      expect( lut.hash<40>( data.data() ), equal_to( loop.hash<40>( data.data() ) ) );
+    }
+  } );
+#if defined( __PCLMUL__ )
+  test( "toeplitz_clmul<i40e_pmd_52> hashes 40 bytes like the loop", []( auto& expect ) {
+    toeplitz::toeplitz_clmul<toeplitz::rss_key_i40e_pmd_52> clmul;
+    toeplitz::toeplitz_scalar_loop<toeplitz::rss_key_i40e_pmd_52> loop;
+    emptyspace::xoshiro::xoshiro256starstar64 xo{ 0x4223 };
+    for( unsigned i = 0; i < 64; i++ ) {
+      std::array<std::byte, 40> data;
+      for( auto& b : data ) { b = static_cast<std::byte>( xo() ); }
+      expect( clmul.hash<16>( data.data() ), equal_to( loop.hash<16>( data.data() ) ) );
+      expect( clmul.hash<40>( data.data() ), equal_to( loop.hash<40>( data.data() ) ) );
+    }
+  } );
+
+  test( "v4: toeplitz_clmul<sym> 01", []( auto& expect ) {
+    toeplitz::toeplitz_clmul<toeplitz::rss_key_symmetric> rss;
+    auto data = make_v4( "66.9.149.187", "161.142.100.80" );
+    auto hash = rss.hash<8>( data._array.data() );
+    expect( hash, equal_to( 173607513u ) );
+  } );
+
+  test( "v4: toeplitz_clmul<ms> 01 .. 05", []( auto& expect ) {
+    toeplitz::toeplitz_clmul<toeplitz::rss_key_ms> rss;
+    expect( rss.hash<8>( make_v4( "66.9.149.187", "161.142.100.80" )._array.data() ),
+            equal_to( 0x323e8fc2u ) );
+    expect( rss.hash<8>( make_v4( "199.92.111.2", "65.69.140.83" )._array.data() ),
+            equal_to( 0xd718262au ) );
+    expect( rss.hash<8>( make_v4( "24.19.198.95", "12.22.207.184" )._array.data() ),
+            equal_to( 0xd2d0a5deu ) );
+    expect( rss.hash<8>( make_v4( "38.27.205.30", "209.142.163.6" )._array.data() ),
+            equal_to( 0x82989176u ) );
+    expect( rss.hash<8>( make_v4( "153.39.163.191", "202.188.127.2" )._array.data() ),
+            equal_to( 0x5d1809c5u ) );
+  } );
+
+  test( "v6: toeplitz_clmul<ms> 01 .. 03", []( auto& expect ) {
+    toeplitz::toeplitz_clmul<toeplitz::rss_key_ms> rss;
+    expect( rss.hash<32>( make_v6( "3ffe:2501:200:1fff::7", "3ffe:2501:200:3::1" )._array.data() ),
+            equal_to( 0x2cc18cd5u ) );
+    expect( rss.hash<32>( make_v6( "3ffe:501:8::260:97ff:fe40:efab", "ff02::1" )._array.data() ),
+            equal_to( 0x0f0c461cu ) );
+    auto data = make_v6( "3ffe:1900:4545:3:200:f8ff:fe21:67cf", "fe80::200:f8ff:fe21:67cf" );
+    expect( rss.hash<32>( data._array.data() ), equal_to( 0x4b61e985u ) );
+  } );
+
+  test( "v4+ports / v6+ports: toeplitz_clmul<ms>", []( auto& expect ) {
+    toeplitz::toeplitz_clmul<toeplitz::rss_key_ms> rss;
+    auto a = make_v4( "66.9.149.187", "161.142.100.80", 2794, 1766 );
+    expect( rss.hash<12>( a._array.data() ), equal_to( 0x51ccc178u ) );
+    auto b = make_v4( "199.92.111.2", "65.69.140.83", 14230, 4739 );
+    expect( rss.hash<12>( b._array.data() ), equal_to( 0xc626b0eau ) );
+    auto c = make_v6( "3ffe:2501:200:1fff::7", "3ffe:2501:200:3::1", 2794, 1766 );
+    expect( rss.hash<36>( c._array.data() ), equal_to( 0x40207d3du ) );
+    auto d = make_v6( "3ffe:501:8::260:97ff:fe40:efab", "ff02::1", 14230, 4739 );
+    expect( rss.hash<36>( d._array.data() ), equal_to( 0xdde51bbfu ) );
+  } );
+
+  test( "toeplitz_batch<toeplitz_clmul<ms>> hashes like the lut", []( auto& expect ) {
+    tuples<24> const t{ 0x2342 };
+    toeplitz::toeplitz_batch<toeplitz::toeplitz_clmul<toeplitz::rss_key_ms>> rss;
+    for( unsigned which = 0; which < 4; which++ ) {
+      expect( t.actual( rss, which ) == t.expected( which ), equal_to( true ) );
+    }
+  } );
+#endif
+
+#if defined( __GFNI__ ) && defined( __AVX2__ )
+  test( "toeplitz_gfni<ms>: ms vectors", []( auto& expect ) {
+    toeplitz::toeplitz_gfni<toeplitz::rss_key_ms> rss;
+    // the ms vectors in the first lanes, the others are zero
+    std::uint32_t src4[8] = { 0x420995bbu, 0xc75c6f02u }, dst4[8] = { 0xa18e6450u, 0x41458c53u };
+    std::uint16_t sport[8] = { 2794, 14230 }, dport[8] = { 1766, 4739 };
+    std::uint32_t out[8];
+    rss.hash_batch<8>( src4, dst4, out );
+    expect( out[0], equal_to( 0x323e8fc2u ) );
+    expect( out[1], equal_to( 0xd718262au ) );
+    expect( out[2], equal_to( 0u ) );
+    rss.hash_batch<8>( src4, dst4, sport, dport, out );
+    expect( out[0], equal_to( 0x51ccc178u ) );
+    expect( out[1], equal_to( 0xc626b0eau ) );
+    __uint128_t src6[8] = {}, dst6[8] = {};
+    src6[0] = __uint128_t( 0x3ffe250102001fffull ) << 64 | 0x7u;
+    dst6[0] = __uint128_t( 0x3ffe250102000003ull ) << 64 | 0x1u;
+    rss.hash_batch<8>( src6, dst6, out );
+    expect( out[0], equal_to( 0x2cc18cd5u ) );
+    rss.hash_batch<8>( src6, dst6, sport, dport, out );
+    expect( out[0], equal_to( 0x40207d3du ) );
+  } );
+
+  test( "toeplitz_gfni<ms> hashes like toeplitz_scalar_lut<ms>", []( auto& expect ) {
+    tuples<64> const t{ 0x4223 };
+    toeplitz::toeplitz_gfni<toeplitz::rss_key_ms> rss;
+    for( unsigned which = 0; which < 4; which++ ) {
+      expect( t.actual( rss, which ) == t.expected( which ), equal_to( true ) );
+    }
+  } );
+
+  test( "toeplitz_gfni<sym> is symmetric", []( auto& expect ) {
+    tuples<16> const t{ 0x2342 };
+    toeplitz::toeplitz_gfni<toeplitz::rss_key_symmetric> rss;
+    std::uint32_t a[16], b[16];
+    rss.hash_batch<16>( t._src6, t._dst6, t._sport, t._dport, a );
+    rss.hash_batch<16>( t._dst6, t._src6, t._dport, t._sport, b );
+    expect( std::equal( a, a + 16, b ), equal_to( true ) );
+  } );
+#endif
 } );
 
 } // namespace
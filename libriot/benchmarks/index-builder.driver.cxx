@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <argh/argh.hxx>
+#include <pest/pnch.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-arena.hxx>
+#include <libriot/index-bulk-builder.hxx>
+#include <libriot/index-compressor.hxx>
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+namespace argh = emptyspace::argh;
+namespace pnch = emptyspace::pnch;
+namespace fs = std::filesystem;
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+using map_index_type = riot::index_builder<std::uint32_t, map_type, 256>;
+using arena_index_type = riot::arena_index_builder<std::uint32_t, 256>;
+using bulk_index_type = riot::index_bulk_builder<std::uint32_t, 256>;
+
+static constexpr unsigned MINPKTSZ = 60;
+static constexpr unsigned MAXPKTSZ = 1600;
+
+} // namespace
+
+// the map based `index_builder` ( with `std::allocator` and with an arena ) against the radix
+// sorting `index_bulk_builder`: the same postings ( two per packet, like source and destination
+// address ) with `--unique` distinct keys
+int main( int argc, const char** argv ) {
+  argh::ArgumentParser argh( "index builder benchmark" );
+  argh::HelpFlag help( argh, "help", "guess what", { 'h', "help" } );
+  argh::ValueFlag<unsigned> packets( argh, "integer", "packets", { "packets" }, 10'000'000 );
+  argh::ValueFlag<unsigned> unique( argh, "integer", "distinct keys", { "unique" }, 1'000'000 );
+  argh::ValueFlag<std::string> path( argh, "path", "output path", { "path" }, "/tmp/index.iv4" );
+  argh::ValueFlag<std::string> engine( argh, "map|arena|bulk|all", "the builder", { 'e' }, "all" );
+
+  try {
+    argh.ParseCLI( argc, argv );
+
+    pnch::oneshot one;
+    one.pin();
+
+    // scans and floods: most keys are seen a few times only, some of them very often
+    std::vector<std::uint32_t> keys;
+    std::vector<std::uint32_t> offsets;
+    {
+      emptyspace::xoshiro::xoshiro128starstar32 xo{ 0x1337 };
+      std::uint32_t offset = 24;
+      auto const n = argh::get( unique );
+      for( unsigned i = 0; i < argh::get( packets ); ++i ) {
+        auto const hot = xo() % 4 == 0;
+        keys.push_back( hot ? xo() % 64 : xo() % n );
+        keys.push_back( xo() % n );
+        offsets.push_back( offset );
+        offset += MINPKTSZ + xo() % ( MAXPKTSZ - MINPKTSZ );
+      }
+    }
+
+    std::ostringstream results;
+    fs::path const index_path{ argh::get( path ) };
+
+    auto const run = [&]( std::string const& name, auto& index ) {
+      // clang-format off
+      one.run( name + ": adding postings", [&]() {
+        for( std::size_t i = 0; i < offsets.size(); ++i ) {
+          index.add( keys[2 * i], offsets[i] );
+          index.add( keys[2 * i + 1], offsets[i] );
+        }
+      } ).report_to( results );
+      one.run( name + ": counting keys", [&]() {
+        std::clog << name << ": distinct keys = " << index.key_count() << std::endl;
+      } ).report_to( results );
+      fs::remove( index_path );
+      nygma::cfile_ostream os{ index_path };
+      riot::svb256d1_serializer serialize{ os };
+      one.run( name + ": serializing ( svb256d1 )", [&]() {
+        index.accept( serialize, 0u );
+      } ).report_to( results );
+      // clang-format on
+      os.sync();
+      std::clog << name << ": serialized index size = " << fs::file_size( index_path ) << std::endl;
+    };
+
+    // the builder goes away after `accept`, one `free` per allocation or the arena at once
+    auto const destroy = [&]( std::string const& name, auto index ) {
+      one.run( name + ": destroying", [&]() { index.reset(); } ).report_to( results );
+    };
+
+    auto const e = argh::get( engine );
+    if( e == "map" or e == "all" ) {
+      auto index = std::make_unique<map_index_type>();
+      run( "map", *index );
+      destroy( "map", std::move( index ) );
+    }
+    if( e == "arena" or e == "all" ) {
+      auto index = std::make_unique<arena_index_type>();
+      run( "arena", *index );
+      destroy( "arena", std::move( index ) );
+    }
+    if( e == "bulk" or e == "all" ) {
+      auto index = std::make_unique<bulk_index_type>();
+      run( "bulk", *index );
+      destroy( "bulk", std::move( index ) );
+    }
+
+    std::clog << results.str() << std::endl;
+
+  } catch( argh::Help const& ) { //
+    std::cerr << argh;
+    return EXIT_SUCCESS;
+  } catch( argh::ValidationError const& e ) { //
+    std::cerr << e.what() << std::endl;
+    argh.Help( std::cerr );
+    return EXIT_FAILURE;
+  } catch( argh::Error const& e ) { //
+    std::cerr << "error: " << e.what() << std::endl << argh;
+    return EXIT_FAILURE;
+  } catch( std::exception const& e ) { //
+    std::cerr << "error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  } catch( ... ) { std::cerr << "error: unknown exception" << std::endl; }
+
+  return EXIT_SUCCESS;
+}
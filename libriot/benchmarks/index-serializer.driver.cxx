@@ -8,6 +8,7 @@
 
 #include <libriot/index-compressor.hxx>
 #include <libriot/index-serializer.hxx>
+#include <libriot/index-view.hxx>
 
 #include <array>
 #include <filesystem>
@@ -26,6 +27,7 @@ namespace fs = std::filesystem;
 
 template <typename K, typename V>
 using map_type = std::map<K, V>;
+using index512_type = typename riot::index_builder<std::uint32_t, map_type, 512>;
 using index256_type = typename riot::index_builder<std::uint32_t, map_type, 256>;
 using index128_type = typename riot::index_builder<std::uint32_t, map_type, 128>;
 
@@ -42,8 +44,9 @@ int main( int argc, const char** argv ) {
   argh::ValueFlag<unsigned> unique( argh, "integer", "index entries", { "unique" }, 123 );
   argh::ValueFlag<double> skew( argh, "double", "skew for the index entry prng", { "skew" }, 0.7 );
   argh::ValueFlag<std::string> path( argh, "path", "output path", { "path" }, "/tmp/index.iv4" );
-  argh::ValueFlag<std::string> compressor( argh, "uc256|svb256d1|bp128d1|bp256d1", "the compressor",
-                                           { 'c' }, "uc256" );
+  argh::ValueFlag<std::string> compressor(
+      argh, "uc256|svb256d1|svb512d1|bp128d1|bp256d1|bp512d1|ad256|pef256", "the compressor", { 'c' },
+      "uc256" );
 
   try {
     argh.ParseCLI( argc, argv );
@@ -126,6 +129,12 @@ int main( int argc, const char** argv ) {
       riot::svb256d1_serializer serialize{ os };
       one.run( "serializing the index ( svb256d1 )", [&]() { index.accept( serialize, 0u ); } )
           .report_to( results );
+    } else if( comp == "svb512d1" ) {
+      index512_type index;
+      fill_index( index );
+      riot::svb512d1_serializer serialize{ os };
+      one.run( "serializing the index ( svb512d1 )", [&]() { index.accept( serialize, 0u ); } )
+          .report_to( results );
     } else if( comp == "svq128d1" ) {
       index128_type index;
       fill_index( index );
@@ -138,12 +147,30 @@ int main( int argc, const char** argv ) {
       riot::bp256d1_serializer serialize{ os };
       one.run( "serializing the index ( bp256d1 )", [&]() { index.accept( serialize, 0u ); } )
           .report_to( results );
+    } else if( comp == "bp512d1" ) {
+      index512_type index;
+      fill_index( index );
+      riot::bp512d1_serializer serialize{ os };
+      one.run( "serializing the index ( bp512d1 )", [&]() { index.accept( serialize, 0u ); } )
+          .report_to( results );
     } else if( comp == "bp128d1" ) {
       index128_type index;
       fill_index( index );
       riot::bp128d1_serializer serialize{ os };
       one.run( "serializing the index ( bp128d1 )", [&]() { index.accept( serialize, 0u ); } )
           .report_to( results );
+    } else if( comp == "ad256" ) {
+      index256_type index;
+      fill_index( index );
+      riot::ad256_serializer serialize{ os };
+      one.run( "serializing the index ( ad256 )", [&]() { index.accept( serialize, 0u ); } )
+          .report_to( results );
+    } else if( comp == "pef256" ) {
+      index256_type index;
+      fill_index( index );
+      riot::pef256_serializer serialize{ os };
+      one.run( "serializing the index ( pef256 )", [&]() { index.accept( serialize, 0u ); } )
+          .report_to( results );
     } else {
       index256_type index;
       fill_index( index );
@@ -155,6 +182,38 @@ int main( int argc, const char** argv ) {
     os.sync();
 
     std::clog << "serialized index size = " << fs::file_size( index_path ) << std::endl;
+
+    // decode all postings of all keys, this is what bounds index scans
+    if( comp != "svq128d1" ) {
+      auto iv = riot::make_poly_index_view( index_path );
+      std::size_t offsets = 0;
+      // clang-format off
+      one.run( "decoding the index", [&]() {
+        for( auto const& [_, ip] : ips ) { offsets += iv->lookup_forward_32( ip ).size(); }
+      } ).report_to( results );
+      // clang-format on
+      std::clog << "decoded offsets = " << offsets << std::endl;
+
+      // intersect the shortest with the longest postings list, elias-fano skips instead of decoding
+      std::uint32_t shortest = 0, longest = 0;
+      std::size_t min = SIZE_MAX, max = 0;
+      for( auto const& [_, ip] : ips ) {
+        auto const n = iv->lookup_forward_32( ip ).size();
+        if( n < min ) { min = n, shortest = ip; }
+        if( n > max ) { max = n, longest = ip; }
+      }
+      auto const probe = iv->lookup_forward_32( shortest );
+      std::size_t hits = 0;
+      // clang-format off
+      one.run( "intersecting shortest & longest", [&]() {
+        for( std::size_t i = 0; i < 1000; ++i ) {
+          hits += iv->lookup_forward_and_32( longest, probe ).size();
+        }
+      } ).report_to( results );
+      // clang-format on
+      std::clog << "intersected " << min << " & " << max << " offsets, hits = " << hits << std::endl;
+    }
+
     std::clog << results.str() << std::endl;
 
   } catch( argh::Help const& ) { //
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// per block codec selection. every candidate codec encodes the block and the winner is recorded
+// in the first byte of the block payload ( as `method::type` ) followed by its compressed data:
+//
+//   [ method:1 ][ payload of the selected codec ]
+//
+// with a `Budget` of 0 the smallest encoding wins. otherwise the first candidate whose size is
+// within `Budget` percent of the smallest one wins, so candidates are listed fastest to decode
+// first ( ties always go to the faster codec ).
+//
+// `streamvqb` is not a candidate: it only computes the compressed size and has no decoder yet.
+
+#include <libriot/compress-bitpack-simd.hxx>
+#include <libriot/compress-streamvbyte-simd.hxx>
+#include <libriot/index-serializer.hxx>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace riot::adaptive {
+
+// uncompressed little endian integers ( same layout as `UC128` / `UC256` blocks )
+template <std::size_t BlockLen>
+struct raw {
+  using integer_type = std::uint32_t;
+  static constexpr std::size_t BLOCKLEN = BlockLen;
+  static constexpr std::size_t STEPLEN = 1;
+
+  static constexpr std::size_t estimate_compressed_size() noexcept {
+    return BLOCKLEN * sizeof( integer_type );
+  }
+
+  static inline std::size_t encode( integer_type const* const in, std::size_t const n,
+                                    std::byte* const out ) noexcept {
+    auto const blocklen = std::min( n, BLOCKLEN );
+    std::memcpy( out, in, blocklen * sizeof( integer_type ) );
+    return blocklen * sizeof( integer_type );
+  }
+
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    integer_type* const out ) noexcept {
+    auto const blocklen = std::min( n / sizeof( integer_type ), BLOCKLEN );
+    std::memcpy( out, in, blocklen * sizeof( integer_type ) );
+    return blocklen * sizeof( integer_type );
+  }
+};
+
+template <method::type Method, typename Codec>
+struct candidate {
+  static constexpr method::type METHOD = Method;
+  using codec_type = Codec;
+};
+
+template <std::size_t Budget, typename Candidate, typename... Candidates>
+struct adaptive_codec {
+  using integer_type = std::uint32_t;
+  static constexpr std::size_t BLOCKLEN = Candidate::codec_type::BLOCKLEN;
+  static constexpr std::size_t STEPLEN =
+      std::max( { Candidate::codec_type::STEPLEN, Candidates::codec_type::STEPLEN... } );
+  static constexpr std::size_t CANDIDATES = 1 + sizeof...( Candidates );
+  static constexpr std::size_t BUDGET = Budget;
+
+  static_assert( ( ( Candidates::codec_type::BLOCKLEN == BLOCKLEN ) && ... ) );
+  static_assert( BLOCKLEN % STEPLEN == 0 );
+
+  // safe overapproximation of the compressed size per block ( in bytes )
+  static constexpr std::size_t estimate_compressed_size() noexcept {
+    return 1 + std::max( { Candidate::codec_type::estimate_compressed_size(),
+                           Candidates::codec_type::estimate_compressed_size()... } );
+  }
+
+  // `n` needs to be a multiple of `STEPLEN`
+  static inline std::size_t encode( integer_type const* const in, std::size_t const n,
+                                    std::byte* const out ) noexcept {
+    static constexpr method::type methods[] = { Candidate::METHOD, Candidates::METHOD... };
+    std::byte tmp[CANDIDATES][estimate_compressed_size()];
+    std::size_t sizes[CANDIDATES];
+    std::size_t i = 0;
+    auto const trial = [&]<typename C>( C ) noexcept {
+      sizes[i] = C::codec_type::encode( in, n, tmp[i] );
+      i++;
+    };
+    trial( Candidate{} );
+    ( trial( Candidates{} ), ... );
+
+    auto const smallest = *std::min_element( sizes, sizes + CANDIDATES );
+    auto const limit = smallest + ( smallest * BUDGET ) / 100;
+    auto const selected = static_cast<std::size_t>(
+        std::find_if( sizes, sizes + CANDIDATES, [limit]( auto const s ) { return s <= limit; } ) -
+        sizes );
+
+    out[0] = std::byte( methods[selected] );
+    std::memcpy( out + 1, tmp[selected], sizes[selected] );
+    return 1 + sizes[selected];
+  }
+
+  // returns the number of consumed bytes or 0 on an unknown codec ( `out` is zeroed then )
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    integer_type* const out ) noexcept {
+    if( n > 0 ) {
+      auto const m = static_cast<method::type>( in[0] );
+      std::size_t consumed = 0;
+      auto const dispatch = [&]<typename C>( C ) noexcept {
+        if( m != C::METHOD ) { return false; }
+        consumed = 1 + C::codec_type::decode( in + 1, n - 1, out );
+        return true;
+      };
+      if( dispatch( Candidate{} ) || ( dispatch( Candidates{} ) || ... ) ) { return consumed; }
+    }
+    std::fill_n( out, BLOCKLEN, 0 );
+    return 0;
+  }
+
+  // the codec selected for the block at `in`
+  static constexpr method::type selected( std::byte const* const in ) noexcept {
+    return static_cast<method::type>( in[0] );
+  }
+};
+
+template <std::size_t Budget = 0>
+using ad128 = adaptive_codec<Budget,                                              //
+                             candidate<method::UC128, raw<128>>,                  //
+                             candidate<method::BP128D1, bitpack::bp128d1>,        //
+                             candidate<method::SVB128D1, streamvbyte::svb128d1_i128>>;
+
+template <std::size_t Budget = 0>
+using ad256 = adaptive_codec<Budget,                                              //
+                             candidate<method::UC256, raw<256>>,                  //
+                             candidate<method::BP256D1, bitpack::bp256d1>,        //
+                             candidate<method::SVB256D1, streamvbyte::svb256d1_i128>>;
+
+} // namespace riot::adaptive
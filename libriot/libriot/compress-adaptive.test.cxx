@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/compress-adaptive.hxx>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+emptyspace::pest::suite basic( "adaptive compression basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+  using ad256 = riot::adaptive::ad256<>;
+  using method = riot::method;
+
+  test( "ad256: dense runs select bitpack", []( auto& expect ) {
+    std::array<ad256::integer_type, ad256::BLOCKLEN> in;
+    std::array<std::byte, ad256::estimate_compressed_size()> out;
+    std::array<ad256::integer_type, ad256::BLOCKLEN> dec;
+    for( std::size_t i = 0; i < ad256::BLOCKLEN; ++i ) { in[i] = 1000u + 3u * i; }
+    auto n = ad256::encode( in.data(), ad256::BLOCKLEN, out.data() );
+    expect( n, equal_to( 68u ) );
+    expect( ad256::selected( out.data() ), equal_to( method::BP256D1 ) );
+    expect( ad256::decode( out.data(), n, dec.data() ), equal_to( n ) );
+    expect( in == dec, equal_to( true ) );
+  } );
+
+  test( "ad256: a single outlier selects streamvbyte", []( auto& expect ) {
+    std::array<ad256::integer_type, ad256::BLOCKLEN> in;
+    std::array<std::byte, ad256::estimate_compressed_size()> out;
+    std::array<ad256::integer_type, ad256::BLOCKLEN> dec;
+    for( std::size_t i = 0; i < ad256::BLOCKLEN; ++i ) {
+      in[i] = i < 100 ? i : 0x7fffffffu + i;
+    }
+    auto n = ad256::encode( in.data(), ad256::BLOCKLEN, out.data() );
+    expect( n, equal_to( 324u ) );
+    expect( ad256::selected( out.data() ), equal_to( method::SVB256D1 ) );
+    expect( ad256::decode( out.data(), n, dec.data() ), equal_to( n ) );
+    expect( in == dec, equal_to( true ) );
+  } );
+
+  test( "ad256: size budget prefers the faster codec", []( auto& expect ) {
+    using ad256b = riot::adaptive::ad256<50>;
+    std::array<ad256::integer_type, ad256::BLOCKLEN> in;
+    std::array<std::byte, ad256::estimate_compressed_size()> out;
+    std::array<ad256::integer_type, ad256::BLOCKLEN> dec;
+    in.fill( 0 );
+    for( std::size_t i = 0; i < ad256::STEPLEN; ++i ) { in[i] = i * 0x01000000u + i * 7u; }
+    auto n = ad256::encode( in.data(), ad256::STEPLEN, out.data() );
+    expect( n, equal_to( 32u ) );
+    expect( ad256::selected( out.data() ), equal_to( method::SVB256D1 ) );
+    n = ad256b::encode( in.data(), ad256::STEPLEN, out.data() );
+    expect( n, equal_to( 33u ) );
+    expect( ad256b::selected( out.data() ), equal_to( method::UC256 ) );
+    expect( ad256b::decode( out.data(), n, dec.data() ), equal_to( n ) );
+    expect( std::equal( in.begin(), in.begin() + ad256::STEPLEN, dec.begin() ), equal_to( true ) );
+  } );
+
+  test( "ad256: unknown codec", []( auto& expect ) {
+    std::array<std::byte, 16> in;
+    std::array<ad256::integer_type, ad256::BLOCKLEN> dec;
+    in.fill( std::byte( 0x42 ) );
+    dec.fill( 0xffffffffu );
+    expect( ad256::decode( in.data(), in.size(), dec.data() ), equal_to( 0u ) );
+    expect( std::all_of( dec.begin(), dec.end(), []( auto const x ) { return x == 0; } ),
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
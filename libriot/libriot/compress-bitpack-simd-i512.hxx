@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// 512bit vertical bitpacking: 16 lanes with 32 rows each ( 512 integers per block ). the layout
+// is the same as in `compress-bitpack-simd-i256.hxx` just twice as wide. instead of spelling out
+// all 33 pack/unpack kernels the shift/word schedule is unrolled at compile time.
+//
+// without avx512 a scalar fallback produces ( and consumes ) the exact same layout so index files
+// stay portable between hosts.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <immintrin.h>
+
+namespace riot::bitpack {
+
+namespace detail {
+
+namespace {
+
+constexpr std::size_t LANES512 = 16;
+constexpr std::size_t ROWS512 = 32;
+
+#if defined( __AVX512F__ )
+
+template <unsigned Bits, std::size_t I>
+inline void pack512_step( __m512i const* in, __m512i* out, __m512i& w ) noexcept {
+  constexpr unsigned shift = ( I * Bits ) & 31u;
+  constexpr std::size_t word = ( I * Bits ) >> 5;
+  __m512i const x = _mm512_loadu_si512( in + I );
+  if constexpr( shift == 0 ) {
+    w = x;
+  } else {
+    w = _mm512_or_si512( w, _mm512_slli_epi32( x, shift ) );
+  }
+  if constexpr( shift + Bits >= 32 ) {
+    _mm512_storeu_si512( out + word, w );
+    // carry the upper bits of `x` into the next word
+    if constexpr( shift + Bits > 32 ) { w = _mm512_srli_epi32( x, 32 - shift ); }
+  }
+}
+
+template <unsigned Bits, std::size_t I>
+inline void unpack512_step( __m512i const* in, __m512i* out, __m512i& w,
+                            __m512i const mask ) noexcept {
+  constexpr unsigned shift = ( I * Bits ) & 31u;
+  constexpr std::size_t word = ( I * Bits ) >> 5;
+  if constexpr( shift == 0 ) { w = _mm512_loadu_si512( in + word ); }
+  if constexpr( shift + Bits > 32 ) {
+    __m512i const next = _mm512_loadu_si512( in + word + 1 );
+#  if defined( __AVX512VBMI2__ )
+    __m512i const x = _mm512_shrdi_epi32( w, next, shift );
+#  else
+    __m512i const x =
+        _mm512_or_si512( _mm512_srli_epi32( w, shift ), _mm512_slli_epi32( next, 32 - shift ) );
+#  endif
+    _mm512_storeu_si512( out + I, _mm512_and_si512( x, mask ) );
+    w = next;
+  } else if constexpr( shift + Bits == 32 ) {
+    _mm512_storeu_si512( out + I, _mm512_srli_epi32( w, shift ) );
+  } else {
+    _mm512_storeu_si512( out + I, _mm512_and_si512( _mm512_srli_epi32( w, shift ), mask ) );
+  }
+}
+
+template <unsigned Bits>
+inline void pack512( std::uint32_t const* pin, std::byte* pout ) noexcept {
+  static_assert( Bits <= 32 );
+  if constexpr( Bits > 0 ) {
+    auto const* in = reinterpret_cast<__m512i const*>( pin );
+    auto* out = reinterpret_cast<__m512i*>( pout );
+    __m512i w = _mm512_setzero_si512();
+    [&]<std::size_t... I>( std::index_sequence<I...> ) {
+      ( pack512_step<Bits, I>( in, out, w ), ... );
+    }( std::make_index_sequence<ROWS512>{} );
+  }
+}
+
+template <unsigned Bits>
+inline void unpack512( std::byte const* pin, std::uint32_t* pout ) noexcept {
+  static_assert( Bits <= 32 );
+  auto* out = reinterpret_cast<__m512i*>( pout );
+  if constexpr( Bits == 0 ) {
+    for( std::size_t i = 0; i < ROWS512; ++i ) { _mm512_storeu_si512( out + i, _mm512_setzero_si512() ); }
+  } else {
+    auto const* in = reinterpret_cast<__m512i const*>( pin );
+    __m512i const mask = _mm512_set1_epi32( static_cast<int>( ( 1ull << Bits ) - 1 ) );
+    __m512i w = _mm512_setzero_si512();
+    [&]<std::size_t... I>( std::index_sequence<I...> ) {
+      ( unpack512_step<Bits, I>( in, out, w, mask ), ... );
+    }( std::make_index_sequence<ROWS512>{} );
+  }
+}
+
+#else
+
+template <unsigned Bits>
+inline void pack512( std::uint32_t const* in, std::byte* out ) noexcept {
+  static_assert( Bits <= 32 );
+  if constexpr( Bits > 0 ) {
+    for( std::size_t lane = 0; lane < LANES512; ++lane ) {
+      std::uint64_t acc = 0;
+      unsigned filled = 0;
+      std::size_t word = 0;
+      for( std::size_t row = 0; row < ROWS512; ++row ) {
+        acc |= std::uint64_t( in[row * LANES512 + lane] ) << filled;
+        filled += Bits;
+        if( filled >= 32 ) {
+          auto const w = static_cast<std::uint32_t>( acc );
+          std::memcpy( out + ( word * LANES512 + lane ) * 4, &w, 4 );
+          acc >>= 32;
+          filled -= 32;
+          word++;
+        }
+      }
+    }
+  }
+}
+
+template <unsigned Bits>
+inline void unpack512( std::byte const* in, std::uint32_t* out ) noexcept {
+  static_assert( Bits <= 32 );
+  if constexpr( Bits == 0 ) {
+    std::memset( out, 0, LANES512 * ROWS512 * sizeof( std::uint32_t ) );
+  } else {
+    constexpr std::uint64_t mask = ( 1ull << Bits ) - 1;
+    for( std::size_t lane = 0; lane < LANES512; ++lane ) {
+      std::uint64_t acc = 0;
+      unsigned available = 0;
+      std::size_t word = 0;
+      for( std::size_t row = 0; row < ROWS512; ++row ) {
+        if( available < Bits ) {
+          std::uint32_t w;
+          std::memcpy( &w, in + ( word * LANES512 + lane ) * 4, 4 );
+          acc |= std::uint64_t( w ) << available;
+          available += 32;
+          word++;
+        }
+        out[row * LANES512 + lane] = static_cast<std::uint32_t>( acc & mask );
+        acc >>= Bits;
+        available -= Bits;
+      }
+    }
+  }
+}
+
+#endif
+
+} // namespace
+
+} // namespace detail
+
+} // namespace riot::bitpack
@@ -4,6 +4,7 @@
 
 #include <libriot/compress-bitpack-simd-i128.hxx>
 #include <libriot/compress-bitpack-simd-i256.hxx>
+#include <libriot/compress-bitpack-simd-i512.hxx>
 #include <libriot/compress-delta-simd.hxx>
 #include <libriot/compress-integer.hxx>
 
@@ -316,6 +317,124 @@ struct bitpack_delta_i128 : bitpack_base<4, 128> {
   }
 };
 
+struct bitpack_delta_i512 : bitpack_base<16, 512> {
+  using delta = delta::delta_i512<integer_type, BLOCKLEN>;
+  static_assert( delta::STEPLEN == STEPLEN );
+
+  static inline std::size_t encode( integer_type const* const in, std::size_t n,
+                                    std::byte* const out ) noexcept {
+
+    integer_type tmp[BLOCKLEN] = { 0 };
+    auto const blocklen = std::min( n, BLOCKLEN );
+    auto const sv = in[0];
+    auto const bits = delta::delta_maxbits( in, BLOCKLEN, tmp, sv );
+    auto const ctrl_len = detail::encode_ctrl( bits, sv, out );
+
+    auto* const out_p = out + ctrl_len;
+    switch( bits ) {
+      case 0: detail::pack512<0>( tmp, out_p ); break;
+      case 1: detail::pack512<1>( tmp, out_p ); break;
+      case 2: detail::pack512<2>( tmp, out_p ); break;
+      case 3: detail::pack512<3>( tmp, out_p ); break;
+      case 4: detail::pack512<4>( tmp, out_p ); break;
+      case 5: detail::pack512<5>( tmp, out_p ); break;
+      case 6: detail::pack512<6>( tmp, out_p ); break;
+      case 7: detail::pack512<7>( tmp, out_p ); break;
+      case 8: detail::pack512<8>( tmp, out_p ); break;
+      case 9: detail::pack512<9>( tmp, out_p ); break;
+      case 10: detail::pack512<10>( tmp, out_p ); break;
+      case 11: detail::pack512<11>( tmp, out_p ); break;
+      case 12: detail::pack512<12>( tmp, out_p ); break;
+      case 13: detail::pack512<13>( tmp, out_p ); break;
+      case 14: detail::pack512<14>( tmp, out_p ); break;
+      case 15: detail::pack512<15>( tmp, out_p ); break;
+      case 16: detail::pack512<16>( tmp, out_p ); break;
+      case 17: detail::pack512<17>( tmp, out_p ); break;
+      case 18: detail::pack512<18>( tmp, out_p ); break;
+      case 19: detail::pack512<19>( tmp, out_p ); break;
+      case 20: detail::pack512<20>( tmp, out_p ); break;
+      case 21: detail::pack512<21>( tmp, out_p ); break;
+      case 22: detail::pack512<22>( tmp, out_p ); break;
+      case 23: detail::pack512<23>( tmp, out_p ); break;
+      case 24: detail::pack512<24>( tmp, out_p ); break;
+      case 25: detail::pack512<25>( tmp, out_p ); break;
+      case 26: detail::pack512<26>( tmp, out_p ); break;
+      case 27: detail::pack512<27>( tmp, out_p ); break;
+      case 28: detail::pack512<28>( tmp, out_p ); break;
+      case 29: detail::pack512<29>( tmp, out_p ); break;
+      case 30: detail::pack512<30>( tmp, out_p ); break;
+      case 31: detail::pack512<31>( tmp, out_p ); break;
+      case 32: detail::pack512<32>( tmp, out_p ); break;
+      default: __builtin_unreachable();
+    }
+
+    return ctrl_len + ( ( ( ( bits * blocklen ) + 511 ) >> 9 ) << 6 );
+  }
+
+  static inline void decode_block( std::byte const* const in, integer_type* const out,
+                                   unsigned const bits ) noexcept {
+    switch( bits ) {
+      case 0: detail::unpack512<0>( in, out ); break;
+      case 1: detail::unpack512<1>( in, out ); break;
+      case 2: detail::unpack512<2>( in, out ); break;
+      case 3: detail::unpack512<3>( in, out ); break;
+      case 4: detail::unpack512<4>( in, out ); break;
+      case 5: detail::unpack512<5>( in, out ); break;
+      case 6: detail::unpack512<6>( in, out ); break;
+      case 7: detail::unpack512<7>( in, out ); break;
+      case 8: detail::unpack512<8>( in, out ); break;
+      case 9: detail::unpack512<9>( in, out ); break;
+      case 10: detail::unpack512<10>( in, out ); break;
+      case 11: detail::unpack512<11>( in, out ); break;
+      case 12: detail::unpack512<12>( in, out ); break;
+      case 13: detail::unpack512<13>( in, out ); break;
+      case 14: detail::unpack512<14>( in, out ); break;
+      case 15: detail::unpack512<15>( in, out ); break;
+      case 16: detail::unpack512<16>( in, out ); break;
+      case 17: detail::unpack512<17>( in, out ); break;
+      case 18: detail::unpack512<18>( in, out ); break;
+      case 19: detail::unpack512<19>( in, out ); break;
+      case 20: detail::unpack512<20>( in, out ); break;
+      case 21: detail::unpack512<21>( in, out ); break;
+      case 22: detail::unpack512<22>( in, out ); break;
+      case 23: detail::unpack512<23>( in, out ); break;
+      case 24: detail::unpack512<24>( in, out ); break;
+      case 25: detail::unpack512<25>( in, out ); break;
+      case 26: detail::unpack512<26>( in, out ); break;
+      case 27: detail::unpack512<27>( in, out ); break;
+      case 28: detail::unpack512<28>( in, out ); break;
+      case 29: detail::unpack512<29>( in, out ); break;
+      case 30: detail::unpack512<30>( in, out ); break;
+      case 31: detail::unpack512<31>( in, out ); break;
+      case 32: detail::unpack512<32>( in, out ); break;
+      default: break;
+    }
+  }
+
+  static inline void decode_short( std::byte const* const in, std::size_t const n,
+                                   integer_type* const out, unsigned const bits ) noexcept {
+    std::byte tmp[estimate_compressed_size()] = { std::byte( 0 ) };
+    std::memcpy( tmp, in, n );
+    decode_block( tmp, out, bits );
+  }
+
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    integer_type* const out ) noexcept {
+    integer_type x{ 0 };
+    auto [bits, ctrl_len] = detail::decode_ctrl( in, n, x );
+    auto const n_in = ctrl_len + ( ( ( ( bits * BLOCKLEN ) + 511 ) >> 9 ) << 6 );
+    if( n < n_in ) {
+      decode_short( in + ctrl_len, n - ctrl_len, out, bits );
+      delta::undelta( out, BLOCKLEN, x );
+      return n;
+    }
+    decode_block( in + ctrl_len, out, bits );
+    delta::undelta( out, BLOCKLEN, x );
+    return n_in;
+  }
+};
+
+using bp512d1 = bitpack_delta_i512;
 using bp256d1 = bitpack_delta_i256;
 using bp128d1 = bitpack_delta_i128;
 
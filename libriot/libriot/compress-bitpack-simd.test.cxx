@@ -14,6 +14,7 @@ emptyspace::pest::suite basic( "bitpack compression suite", []( auto& test ) {
   using namespace emptyspace::pest;
   using bp256d1 = riot::bitpack::bp256d1;
   using bp128d1 = riot::bitpack::bp128d1;
+  using bp512d1 = riot::bitpack::bp512d1;
 
   test( "bp256d1: encode all zeros", []( auto& expect ) {
     std::array<bp256d1::integer_type, bp256d1::BLOCKLEN> in;
@@ -210,6 +211,78 @@ emptyspace::pest::suite basic( "bitpack compression suite", []( auto& test ) {
     expect( n_dec, equal_to( n ) );
     expect( in == dec, equal_to( true ) );
   } );
+  test( "bp512d1: enc/dec all zeros", []( auto& expect ) {
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> in;
+    std::array<std::byte, bp512d1::estimate_compressed_size()> out;
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> tmp;
+    in.fill( 0x0 );
+    tmp.fill( 0xffffffff );
+    out.fill( std::byte( 0xff ) );
+    auto n = bp512d1::encode( in.data(), bp512d1::BLOCKLEN, out.data() );
+    expect( n, equal_to( 2u ) );
+    expect( hexify( out, n ), equal_to( "0000" ) );
+    auto n_decoded = bp512d1::decode( out.data(), n, tmp.data() );
+    expect( n_decoded, equal_to( n ) );
+    expect( in == tmp, equal_to( true ) );
+  } );
+
+  test( "bp512d1: enc/dec BLOCKLEN", []( auto& expect ) {
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> in;
+    std::array<std::byte, bp512d1::estimate_compressed_size()> out;
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> dec;
+    in.fill( 0xff );
+    out.fill( std::byte( 0xff ) );
+    dec.fill( 0xffffffffu );
+    in[0] = 0xfe;
+    auto n = bp512d1::encode( in.data(), bp512d1::BLOCKLEN, out.data() );
+    expect( n, equal_to( 66u ) );
+    expect( hexify( out, n ),
+            equal_to( "01fe00000000010000000000000000000000000000000000000000000000000000000000000"
+                      "000000000000000000000000000000000000000000000000000000000" ) );
+    auto n_dec = bp512d1::decode( out.data(), n, dec.data() );
+    expect( n_dec, equal_to( n ) );
+    expect( in == dec, equal_to( true ) );
+  } );
+
+  test( "bp512d1: enc/dec every bit width", []( auto& expect ) {
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> in;
+    std::array<std::byte, bp512d1::estimate_compressed_size()> out;
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> dec;
+    emptyspace::xoshiro::xoshiro128starstar32 mt{ 0x42421337 };
+    for( unsigned bits = 1; bits <= 32; ++bits ) {
+      auto const mask = static_cast<bp512d1::integer_type>( ( 1ull << bits ) - 1 );
+      dec.fill( 0xffffffffu );
+      in[0] = 0x1337;
+      // force the maximum delta once so the block needs exactly `bits`
+      for( std::size_t i = 1; i < bp512d1::BLOCKLEN; ++i ) {
+        in[i] = in[i - 1] + ( i == 23 ? mask : mt() & mask );
+      }
+      auto n = bp512d1::encode( in.data(), bp512d1::BLOCKLEN, out.data() );
+      expect( n, equal_to( 3u + bits * 64u ) );
+      auto n_dec = bp512d1::decode( out.data(), n, dec.data() );
+      expect( n_dec, equal_to( n ) );
+      expect( in == dec, equal_to( true ) );
+    }
+  } );
+
+  test( "bp512d1: encode STEPLEN delta range <60, 2500>", []( auto& expect ) {
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> in;
+    std::array<std::byte, bp512d1::estimate_compressed_size()> out;
+    std::array<bp512d1::integer_type, bp512d1::BLOCKLEN> dec;
+    dec.fill( 0xffffffffu );
+    emptyspace::xoshiro::xoshiro128starstar32 mt{ 0x42421337 };
+    emptyspace::bitmask_distribution<bp512d1::integer_type> random{ 60, 2500 };
+    in[0] = random( mt );
+    for( std::size_t i = 1; i < bp512d1::STEPLEN; ++i ) { in[i] = in[i - 1] + random( mt ); }
+    std::fill_n( in.data() + bp512d1::STEPLEN, bp512d1::BLOCKLEN - bp512d1::STEPLEN,
+                 in[bp512d1::STEPLEN - 1] );
+    auto n = bp512d1::encode( in.data(), bp512d1::STEPLEN, out.data() );
+    // a partial block only keeps the words covering the first `STEPLEN` rows
+    expect( n < 3u + 12u * 64u );
+    auto n_dec = bp512d1::decode( out.data(), n, dec.data() );
+    expect( n_dec, equal_to( n ) );
+    for( std::size_t i = 0; i < bp512d1::STEPLEN; ++i ) { expect( in[i] == dec[i] ); }
+  } );
 } );
 
 } // namespace
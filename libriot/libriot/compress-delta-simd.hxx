@@ -290,4 +290,95 @@ struct delta_i256 {
   //}
 };
 
+
+#if defined( __AVX512F__ )
+
+inline std::uint32_t maxbits512_epi32( __m512i const x ) noexcept {
+  auto const ans = static_cast<std::uint32_t>( _mm512_reduce_or_epi32( x ) );
+  return 32 - _lzcnt_u32( ans );
+}
+
+template <typename I, std::size_t BlockLen>
+struct delta_i512 {
+  static constexpr std::size_t BLOCKLEN = BlockLen;
+  static constexpr std::size_t STEPLEN = 16;
+  using integer_type = I;
+
+  static_assert( std::is_integral_v<I> );
+  static_assert( sizeof( I ) == 4 );
+  static_assert( BlockLen % STEPLEN == 0 );
+
+  // `_mm512_alignr_epi32( x, prev, 15 )` shifts `x` up by one lane and pulls in the last lane
+  // of `prev`
+  static inline void delta( integer_type* const inout, std::size_t const n,
+                            integer_type const start = 0 ) noexcept {
+    auto const aligned = integer::align_up<STEPLEN>( n );
+    auto const blocklen = std::min( aligned, BLOCKLEN );
+    auto* p = inout;
+    auto const* const end = inout + blocklen;
+    __m512i prev = _mm512_set1_epi32( static_cast<int>( start ) );
+    while( p < end ) {
+      __m512i const x0_raw = _mm512_loadu_si512( p );
+      __m512i const x0 = _mm512_sub_epi32( x0_raw, _mm512_alignr_epi32( x0_raw, prev, 15 ) );
+      _mm512_storeu_si512( p, x0 );
+      prev = x0_raw;
+      p += STEPLEN;
+    }
+  }
+
+  static inline auto delta_maxbits( integer_type const* const in, std::size_t const n,
+                                    integer_type* const out, integer_type const start = 0 ) noexcept {
+    auto const aligned = integer::align_up<STEPLEN>( n );
+    auto const blocklen = std::min( aligned, BLOCKLEN );
+    auto* out_p = out;
+    auto const* p = in;
+    auto const* const end = in + blocklen;
+    __m512i prev = _mm512_set1_epi32( static_cast<int>( start ) );
+    __m512i max = _mm512_setzero_si512();
+    while( p < end ) {
+      __m512i const x0_raw = _mm512_loadu_si512( p );
+      __m512i const x0 = _mm512_sub_epi32( x0_raw, _mm512_alignr_epi32( x0_raw, prev, 15 ) );
+      _mm512_storeu_si512( out_p, x0 );
+      max = _mm512_or_si512( max, x0 );
+      prev = x0_raw;
+      out_p += STEPLEN;
+      p += STEPLEN;
+    }
+    return maxbits512_epi32( max );
+  }
+
+  // log2( 16 ) shift-and-add steps per vector, then carry the last lane of the previous vector
+  static inline void undelta( integer_type* const inout, std::size_t const n,
+                              integer_type const start = 0 ) noexcept {
+    auto const aligned = integer::align_up<STEPLEN>( n );
+    auto const blocklen = std::min( aligned, BLOCKLEN );
+    auto* p = inout;
+    auto const* const end = inout + blocklen;
+    __m512i const zero = _mm512_setzero_si512();
+    __m512i const last = _mm512_set1_epi32( 15 );
+    __m512i prev = _mm512_set1_epi32( static_cast<int>( start ) );
+    while( p < end ) {
+      __m512i x0 = _mm512_loadu_si512( p );
+      x0 = _mm512_add_epi32( x0, _mm512_alignr_epi32( x0, zero, 15 ) );
+      x0 = _mm512_add_epi32( x0, _mm512_alignr_epi32( x0, zero, 14 ) );
+      x0 = _mm512_add_epi32( x0, _mm512_alignr_epi32( x0, zero, 12 ) );
+      x0 = _mm512_add_epi32( x0, _mm512_alignr_epi32( x0, zero, 8 ) );
+      prev = _mm512_add_epi32( x0, _mm512_permutexvar_epi32( last, prev ) );
+      _mm512_storeu_si512( p, prev );
+      p += STEPLEN;
+    }
+  }
+};
+
+#else
+
+// without avx512 the 256bit kernels do the job ( the delta is independent of the vector width )
+template <typename I, std::size_t BlockLen>
+struct delta_i512 : delta_i256<I, BlockLen> {
+  static constexpr std::size_t STEPLEN = 16;
+  static_assert( BlockLen % STEPLEN == 0 );
+};
+
+#endif
+
 } // namespace riot::delta
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// partitioned elias-fano: a sorted sequence is cut into partitions of `PARTITION` integers. each
+// partition stores its integers relative to its first one with `l` low bits per integer and the
+// remaining high bits unary coded ( one set bit per integer, one cleared bit per bucket ).
+//
+//   [ n:4 ][ partitions:4 ]
+//   [ last:4 ][ offset:4 ] x partitions                          <- skip table
+//   [ base:4 ][ l:1 ][ lows:8 x lw ][ highs:8 x hw ] x partitions
+//
+// `offset` is relative to the first partition. `next_geq` finds the partition with a binary
+// search over the skip table and the bucket of `x` with a `select0` on the high bits, so no more
+// than one partition gets touched per call.
+
+#include <libunclassified/bytestring.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include <immintrin.h>
+
+namespace riot::eliasfano {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+constexpr std::size_t PARTITION = 256;
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t SKIP_SIZE = 8;
+constexpr std::size_t PARTITION_HEADER_SIZE = 5;
+
+namespace detail {
+
+constexpr auto LE = endianess::LE;
+
+struct partition_layout {
+  std::uint32_t _base;
+  unsigned _l;
+  std::size_t _lows_words;
+  std::size_t _highs_words;
+
+  static constexpr partition_layout of( std::uint32_t const* const in,
+                                        std::size_t const n ) noexcept {
+    auto const base = in[0];
+    auto const u = in[n - 1] - base;
+    unsigned l = 0;
+    if( u > n ) { l = static_cast<unsigned>( std::bit_width( u / n ) - 1 ); }
+    auto const highs_bits = n + ( u >> l ) + 1;
+    return { base, l, ( n * l + 63 ) / 64, ( highs_bits + 63 ) / 64 };
+  }
+
+  constexpr std::size_t size() const noexcept {
+    return PARTITION_HEADER_SIZE + 8 * ( _lows_words + _highs_words );
+  }
+};
+
+inline std::uint64_t rd_word( std::byte const* const p, std::size_t const i ) noexcept {
+  return unsafe::rd64<LE>( p + 8 * i );
+}
+
+// position of the `k`th cleared bit in `w` ( `k` < number of cleared bits )
+inline unsigned select0( std::uint64_t const w, unsigned const k ) noexcept {
+#if defined( __BMI2__ )
+  return static_cast<unsigned>( std::countr_zero( _pdep_u64( 1ull << k, ~w ) ) );
+#else
+  auto x = ~w;
+  for( unsigned i = 0; i < k; ++i ) { x &= x - 1; }
+  return static_cast<unsigned>( std::countr_zero( x ) );
+#endif
+}
+
+// a single decoded partition header
+struct partition {
+  std::uint32_t _base;
+  unsigned _l;
+  std::size_t _count;
+  std::byte const* _lows;
+  std::byte const* _highs;
+  std::size_t _highs_words;
+
+  // `l <= 32` so a single unaligned read suffices, the highs ( at least one word ) follow the lows
+  std::uint32_t low( std::size_t const i ) const noexcept {
+    auto const bit = i * _l;
+    auto const x = unsafe::rd64<LE>( _lows + ( bit >> 3 ) ) >> ( bit & 7 );
+    return static_cast<std::uint32_t>( x & ( ( 1ull << _l ) - 1 ) );
+  }
+
+  template <typename OutIt>
+  void decode( OutIt out ) const noexcept {
+    std::size_t i = 0;
+    for( std::size_t word = 0; word < _highs_words and i < _count; ++word ) {
+      for( auto w = rd_word( _highs, word ); w != 0 and i < _count; w &= w - 1, ++i ) {
+        auto const high = ( word << 6 ) + std::countr_zero( w ) - i;
+        *out++ = _base + ( static_cast<std::uint32_t>( high ) << _l | low( i ) );
+      }
+    }
+  }
+
+  // the first integer `>= x`, the partition must contain one ( `x <= last` )
+  std::uint32_t next_geq( std::uint32_t const x ) const noexcept {
+    if( x <= _base ) { return _base; }
+    auto const bucket = static_cast<std::size_t>( ( x - _base ) >> _l );
+    // skip `bucket` cleared bits, every set bit before is an integer of a smaller bucket
+    std::size_t word = 0;
+    std::size_t zeros = 0;
+    std::uint64_t w = rd_word( _highs, 0 );
+    std::size_t position = 0;
+    if( bucket > 0 ) {
+      while( true ) {
+        auto const z = static_cast<std::size_t>( std::popcount( ~w ) );
+        if( zeros + z >= bucket ) {
+          position = ( word << 6 ) + select0( w, static_cast<unsigned>( bucket - zeros - 1 ) ) + 1;
+          break;
+        }
+        zeros += z;
+        w = rd_word( _highs, ++word );
+      }
+    }
+    auto i = position - bucket;
+    word = position >> 6;
+    w = rd_word( _highs, word ) & ( ~0ull << ( position & 63 ) );
+    while( true ) {
+      while( w == 0 ) { w = rd_word( _highs, ++word ); }
+      auto const high = ( word << 6 ) + std::countr_zero( w ) - i;
+      auto const v = _base + ( static_cast<std::uint32_t>( high ) << _l | low( i ) );
+      if( v >= x ) { return v; }
+      w &= w - 1;
+      ++i;
+    }
+  }
+};
+
+} // namespace detail
+
+// safe overapproximation of the encoded size of `n` sorted integers ( in bytes )
+inline std::size_t estimate_compressed_size( std::uint32_t const* const in,
+                                             std::size_t const n ) noexcept {
+  auto const partitions = ( n + PARTITION - 1 ) / PARTITION;
+  std::size_t size = HEADER_SIZE + SKIP_SIZE * partitions;
+  for( std::size_t i = 0; i < n; i += PARTITION ) {
+    size += detail::partition_layout::of( in + i, std::min( PARTITION, n - i ) ).size();
+  }
+  return size;
+}
+
+// `in` needs to be sorted ( ascending ), `out` needs `estimate_compressed_size()` bytes
+inline std::size_t encode( std::uint32_t const* const in, std::size_t const n,
+                           std::byte* const out ) noexcept {
+  using detail::LE;
+  auto const partitions = ( n + PARTITION - 1 ) / PARTITION;
+  unsafe::wr32<LE>( out, static_cast<std::uint32_t>( n ) );
+  unsafe::wr32<LE>( out + 4, static_cast<std::uint32_t>( partitions ) );
+  auto* skip = out + HEADER_SIZE;
+  auto* const data = skip + SKIP_SIZE * partitions;
+  auto* p = data;
+  for( std::size_t first = 0; first < n; first += PARTITION ) {
+    auto const count = std::min( PARTITION, n - first );
+    auto const* const v = in + first;
+    auto const layout = detail::partition_layout::of( v, count );
+
+    unsafe::wr32<LE>( skip, v[count - 1] );
+    unsafe::wr32<LE>( skip + 4, static_cast<std::uint32_t>( p - data ) );
+    skip += SKIP_SIZE;
+
+    unsafe::wr32<LE>( p, layout._base );
+    p[4] = std::byte( layout._l );
+    auto* const lows = p + PARTITION_HEADER_SIZE;
+    auto* const highs = lows + 8 * layout._lows_words;
+    std::fill( lows, highs + 8 * layout._highs_words, std::byte( 0 ) );
+
+    auto const mask = layout._l == 0 ? 0ull : ( 1ull << layout._l ) - 1;
+    for( std::size_t i = 0; i < count; ++i ) {
+      auto const x = v[i] - layout._base;
+      if( layout._l > 0 ) {
+        auto const bit = i * layout._l;
+        auto const word = bit >> 6;
+        auto const shift = bit & 63;
+        auto const low = std::uint64_t( x ) & mask;
+        unsafe::wr64<LE>( lows + 8 * word, detail::rd_word( lows, word ) | low << shift );
+        if( shift + layout._l > 64 ) {
+          unsafe::wr64<LE>( lows + 8 * ( word + 1 ),
+                            detail::rd_word( lows, word + 1 ) | low >> ( 64 - shift ) );
+        }
+      }
+      auto const bit = ( x >> layout._l ) + i;
+      auto const word = bit >> 6;
+      unsafe::wr64<LE>( highs + 8 * word, detail::rd_word( highs, word ) | 1ull << ( bit & 63 ) );
+    }
+    p += layout.size();
+  }
+  return static_cast<std::size_t>( p - out );
+}
+
+//--read-only-access------------------------------------------------------------
+
+class sequence {
+  std::byte const* _p{ nullptr };
+  std::size_t _n{ 0 };
+  std::size_t _count{ 0 };
+  std::size_t _partitions{ 0 };
+
+  std::byte const* skip( std::size_t const i ) const noexcept {
+    return _p + HEADER_SIZE + SKIP_SIZE * i;
+  }
+
+  std::uint32_t last( std::size_t const i ) const noexcept {
+    return unsafe::rd32<detail::LE>( skip( i ) );
+  }
+
+  // `false` for truncated partitions
+  bool at( std::size_t const i, detail::partition& part ) const noexcept {
+    using detail::LE;
+    auto const* const data = skip( _partitions );
+    auto const* const end = _p + _n;
+    auto const* const p = data + unsafe::rd32<LE>( skip( i ) + 4 );
+    if( p + PARTITION_HEADER_SIZE > end ) { return false; }
+    part._base = unsafe::rd32<LE>( p );
+    part._l = static_cast<unsigned>( p[4] );
+    part._count = i + 1 == _partitions ? _count - i * PARTITION : PARTITION;
+    if( part._l > 32 ) { return false; }
+    auto const u = last( i ) - part._base;
+    auto const lows_words = ( part._count * part._l + 63 ) / 64;
+    part._highs_words = ( part._count + ( u >> part._l ) + 1 + 63 ) / 64;
+    part._lows = p + PARTITION_HEADER_SIZE;
+    part._highs = part._lows + 8 * lows_words;
+    return part._highs + 8 * part._highs_words <= end;
+  }
+
+ public:
+  // keeps track of the current partition for monotone `next_geq` calls
+  struct cursor {
+    std::size_t _partition{ 0 };
+  };
+
+  sequence() = default;
+
+  sequence( std::byte const* const p, std::size_t const n ) noexcept {
+    using detail::LE;
+    if( n < HEADER_SIZE ) { return; }
+    auto const count = unsafe::rd32<LE>( p );
+    auto const partitions = unsafe::rd32<LE>( p + 4 );
+    if( partitions != ( count + PARTITION - 1 ) / PARTITION ) { return; }
+    if( HEADER_SIZE + SKIP_SIZE * std::size_t( partitions ) > n ) { return; }
+    _p = p;
+    _n = n;
+    _count = count;
+    _partitions = partitions;
+  }
+
+  std::size_t size() const noexcept { return _count; }
+  bool empty() const noexcept { return _count == 0; }
+
+  template <typename OutIt>
+  bool decode( OutIt out ) const noexcept {
+    detail::partition part;
+    for( std::size_t i = 0; i < _partitions; ++i ) {
+      if( not at( i, part ) ) { return false; }
+      part.decode( out );
+    }
+    return true;
+  }
+
+  // the first integer `>= x` ( in `geq` ), `false` if there is none
+  bool next_geq( std::uint32_t const x, cursor& c, std::uint32_t& geq ) const noexcept {
+    // binary search for the first partition whose last integer is `>= x`
+    auto lo = c._partition;
+    auto hi = _partitions;
+    while( lo < hi ) {
+      auto const mid = lo + ( hi - lo ) / 2;
+      if( last( mid ) < x ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    c._partition = lo;
+    if( lo == _partitions ) { return false; }
+    detail::partition part;
+    if( not at( lo, part ) ) { return false; }
+    geq = part.next_geq( x );
+    return true;
+  }
+
+  // all integers of `values` ( sorted ) contained in the sequence
+  template <typename Container, typename OutIt>
+  void intersect( Container const& values, OutIt out ) const noexcept {
+    cursor c;
+    std::uint32_t geq;
+    for( auto const v : values ) {
+      if( not next_geq( v, c, geq ) ) { return; }
+      if( geq == v ) { *out++ = v; }
+    }
+  }
+};
+
+} // namespace riot::eliasfano
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/compress-eliasfano.hxx>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+namespace eliasfano = riot::eliasfano;
+
+std::vector<std::byte> encode( std::vector<std::uint32_t> const& values ) {
+  std::vector<std::byte> out( eliasfano::estimate_compressed_size( values.data(), values.size() ) );
+  out.resize( eliasfano::encode( values.data(), values.size(), out.data() ) );
+  return out;
+}
+
+// offsets of a packet stream with sizes cycling through [ 60, 1514 ]
+std::vector<std::uint32_t> offsets( std::size_t const n ) {
+  std::vector<std::uint32_t> r;
+  std::uint32_t off = 24;
+  for( std::size_t i = 0; i < n; ++i ) {
+    r.push_back( off );
+    off += 16 + 60 + static_cast<std::uint32_t>( ( i * 7919 ) % 1455 );
+  }
+  return r;
+}
+
+emptyspace::pest::suite basic( "eliasfano compression basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "roundtrip", []( auto& expect ) {
+    for( auto const n : { 1u, 2u, 255u, 256u, 257u, 1000u, 10000u } ) {
+      auto const values = offsets( n );
+      auto const buf = encode( values );
+      eliasfano::sequence const s{ buf.data(), buf.size() };
+      expect( s.size(), equal_to( n ) );
+      std::vector<std::uint32_t> dec;
+      expect( s.decode( std::back_inserter( dec ) ) );
+      expect( dec == values, equal_to( true ) );
+    }
+  } );
+
+  test( "layout", []( auto& expect ) {
+    std::vector<std::uint32_t> const values{ 3u, 5u, 9u };
+    auto const buf = encode( values );
+    // n, partitions | last, offset | base, l = 1 | lows ( all 0 ) | highs 0b100101
+    expect( buf.size(), equal_to( 8u + 8u + 5u + 8u + 8u ) );
+    expect( hexify( buf, buf.size() ), equal_to( "0300000001000000"
+                                                 "0900000000000000"
+                                                 "0300000001"
+                                                 "0000000000000000"
+                                                 "2500000000000000" ) );
+  } );
+
+  test( "next_geq", []( auto& expect ) {
+    auto const values = offsets( 10000 );
+    auto const buf = encode( values );
+    eliasfano::sequence const s{ buf.data(), buf.size() };
+    std::uint32_t geq = 0;
+    for( std::size_t i = 0; i < values.size(); i += 37 ) {
+      eliasfano::sequence::cursor c;
+      expect( s.next_geq( values[i], c, geq ) );
+      expect( geq, equal_to( values[i] ) );
+      expect( s.next_geq( values[i] + 1, c, geq ) );
+      expect( geq, equal_to( i + 1 < values.size() ? values[i + 1] : values[i] ) );
+    }
+    eliasfano::sequence::cursor c;
+    expect( s.next_geq( 0, c, geq ) );
+    expect( geq, equal_to( values.front() ) );
+    expect( not s.next_geq( values.back() + 1, c, geq ) );
+  } );
+
+  test( "intersect", []( auto& expect ) {
+    auto const values = offsets( 100000 );
+    auto const buf = encode( values );
+    eliasfano::sequence const s{ buf.data(), buf.size() };
+    std::vector<std::uint32_t> probe;
+    for( std::size_t i = 0; i < 10; ++i ) {
+      probe.push_back( values[i * 9973] );
+      probe.push_back( values[i * 9973] + 1 );
+    }
+    std::vector<std::uint32_t> r;
+    s.intersect( probe, std::back_inserter( r ) );
+    expect( r.size(), equal_to( 10u ) );
+    expect( r[9], equal_to( values[9 * 9973] ) );
+    // smaller than 32bit offsets
+    expect( buf.size() * 2 < values.size() * sizeof( std::uint32_t ), equal_to( true ) );
+  } );
+
+  test( "truncated", []( auto& expect ) {
+    auto const buf = encode( offsets( 600 ) );
+    eliasfano::sequence const s{ buf.data(), buf.size() - 8 };
+    std::vector<std::uint32_t> dec;
+    expect( not s.decode( std::back_inserter( dec ) ) );
+    expect( eliasfano::sequence{ buf.data(), 4 }.empty() );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
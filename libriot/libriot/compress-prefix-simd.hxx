@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// shared prefix elimination for blocks of sorted 128bit keys ( e.g. ipv6 addresses ). the keys of
+// a block share all bytes above the highest byte in which the first and the last key differ. only
+// the prefix ( once ) and the `w` low bytes of every key get stored:
+//
+//   [ w:1 ][ prefix:16 - w ][ suffix:w ] x n
+//
+// all integers are little endian, so `prefix` holds the high bytes and a suffix the low bytes of
+// a key. decoding ors the prefix into the masked 16 byte load of a suffix, `lower_bound` searches
+// the suffixes in place without decoding the block at all.
+//
+// keys are compared as integers: to share long prefixes ipv6 addresses need to be stored with
+// their most significant byte first ( i.e. byte swapped from network order on little endian ).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace riot::prefix {
+
+constexpr std::size_t KEYLEN = 16;
+constexpr std::size_t HEADER_SIZE = 1;
+
+namespace detail {
+
+alignas( 16 ) constexpr std::uint8_t MASK[2 * KEYLEN] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+// number of low bytes in which `a` and `b` differ
+inline unsigned width( __uint128_t const a, __uint128_t const b ) noexcept {
+  auto const x = a ^ b;
+  auto const hi = static_cast<std::uint64_t>( x >> 64 );
+  auto const lo = static_cast<std::uint64_t>( x );
+  if( hi != 0 ) { return 16 - static_cast<unsigned>( __builtin_clzll( hi ) ) / 8; }
+  if( lo != 0 ) { return 8 - static_cast<unsigned>( __builtin_clzll( lo ) ) / 8; }
+  return 0;
+}
+
+inline __uint128_t low_mask( unsigned const w ) noexcept {
+  return w == KEYLEN ? ~__uint128_t( 0 ) : ( __uint128_t( 1 ) << ( 8 * w ) ) - 1;
+}
+
+// reads the `w` byte suffix at `p`
+inline __uint128_t rd_suffix( std::byte const* const p, unsigned const w ) noexcept {
+  __uint128_t x = 0;
+  std::memcpy( &x, p, w );
+  return x;
+}
+
+} // namespace detail
+
+template <std::size_t BlockLen>
+struct prefix_key {
+  using integer_type = __uint128_t;
+  static constexpr std::size_t BLOCKLEN = BlockLen;
+
+  static constexpr std::size_t estimate_compressed_size() noexcept {
+    return HEADER_SIZE + KEYLEN + BLOCKLEN * KEYLEN;
+  }
+
+  // `in` has to be sorted
+  static inline std::size_t encode( integer_type const* const in, std::size_t const n,
+                                    std::byte* const out ) noexcept {
+    auto const blocklen = std::min( n, BLOCKLEN );
+    if( blocklen == 0 ) { return 0; }
+    auto const w = detail::width( in[0], in[blocklen - 1] );
+    out[0] = std::byte( w );
+    auto const prefix = in[0] & ~detail::low_mask( w );
+    std::byte tmp[KEYLEN];
+    std::memcpy( tmp, &prefix, KEYLEN );
+    auto* p = out + HEADER_SIZE;
+    std::memcpy( p, tmp + w, KEYLEN - w );
+    p += KEYLEN - w;
+    for( std::size_t i = 0; i < blocklen; ++i ) {
+      std::memcpy( tmp, &in[i], KEYLEN );
+      std::memcpy( p, tmp, w );
+      p += w;
+    }
+    return static_cast<std::size_t>( p - out );
+  }
+
+  // the suffix width of the block or `KEYLEN + 1` if `in` is too short for `m` keys
+  static inline unsigned width( std::byte const* const in, std::size_t const n,
+                                std::size_t const m ) noexcept {
+    if( n < HEADER_SIZE ) { return KEYLEN + 1; }
+    auto const w = static_cast<unsigned>( in[0] );
+    if( w > KEYLEN or n < HEADER_SIZE + KEYLEN - w + m * w ) { return KEYLEN + 1; }
+    return w;
+  }
+
+  static inline integer_type prefix_of( std::byte const* const in, unsigned const w ) noexcept {
+    std::byte tmp[KEYLEN] = {};
+    std::memcpy( tmp + w, in + HEADER_SIZE, KEYLEN - w );
+    integer_type x;
+    std::memcpy( &x, tmp, KEYLEN );
+    return x;
+  }
+
+  // the `i`th key of a valid block
+  static inline integer_type at( std::byte const* const in, std::size_t const i ) noexcept {
+    auto const w = static_cast<unsigned>( in[0] );
+    auto const* const suffixes = in + HEADER_SIZE + KEYLEN - w;
+    return prefix_of( in, w ) | detail::rd_suffix( suffixes + i * w, w );
+  }
+
+  // decodes the `m` keys of a block with `n` compressed bytes, returns the number of keys decoded
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    std::size_t const m, integer_type* const out ) noexcept {
+    auto const w = width( in, n, m );
+    if( w > KEYLEN ) { return 0; }
+    auto const prefix = prefix_of( in, w );
+    auto const* const suffixes = in + HEADER_SIZE + KEYLEN - w;
+    auto const* const end = in + n;
+    std::size_t i = 0;
+#if defined( __SSE2__ )
+    // full 16 byte loads as long as they stay within the block
+    __m128i pv;
+    std::memcpy( &pv, &prefix, KEYLEN );
+    auto const* const m_p = detail::MASK + KEYLEN - w;
+    auto const mask = _mm_loadu_si128( reinterpret_cast<__m128i const*>( m_p ) );
+    for( ; i < m and suffixes + i * w + KEYLEN <= end; ++i ) {
+      auto const s = _mm_loadu_si128( reinterpret_cast<__m128i const*>( suffixes + i * w ) );
+      auto const x = _mm_or_si128( pv, _mm_and_si128( s, mask ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( out + i ), x );
+    }
+#endif
+    for( ; i < m; ++i ) { out[i] = prefix | detail::rd_suffix( suffixes + i * w, w ); }
+    return m;
+  }
+
+  // the position of the first key not less than `k` within the `m` keys of a valid block
+  static inline std::size_t lower_bound( std::byte const* const in, std::size_t const m,
+                                         integer_type const k ) noexcept {
+    auto const w = static_cast<unsigned>( in[0] );
+    auto const prefix = prefix_of( in, w );
+    auto const high = k & ~detail::low_mask( w );
+    if( high < prefix ) { return 0; }
+    if( high > prefix ) { return m; }
+    auto const suffix = k & detail::low_mask( w );
+    auto const* const suffixes = in + HEADER_SIZE + KEYLEN - w;
+    std::size_t first = 0;
+    std::size_t count = m;
+    while( count > 0 ) {
+      auto const step = count / 2;
+      if( detail::rd_suffix( suffixes + ( first + step ) * w, w ) < suffix ) {
+        first += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    return first;
+  }
+};
+
+using pk128 = prefix_key<128>;
+using pk256 = prefix_key<256>;
+
+} // namespace riot::prefix
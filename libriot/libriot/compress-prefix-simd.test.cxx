@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/compress-prefix-simd.hxx>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+namespace prefix = riot::prefix;
+using key_type = __uint128_t;
+
+// addresses of a /64 network, most significant byte first
+std::vector<key_type> addresses( std::size_t const n ) {
+  key_type const net = ( key_type( 0x20010db8u ) << 96 ) | ( key_type( 0x42u ) << 64 );
+  std::vector<key_type> r;
+  for( std::size_t i = 0; i < n; ++i ) { r.push_back( net | ( i * 7919 ) ); }
+  std::sort( r.begin(), r.end() );
+  return r;
+}
+
+std::vector<std::byte> encode( std::vector<key_type> const& keys ) {
+  std::vector<std::byte> out( prefix::pk128::estimate_compressed_size() );
+  out.resize( prefix::pk128::encode( keys.data(), keys.size(), out.data() ) );
+  return out;
+}
+
+emptyspace::pest::suite basic( "prefix compression basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "roundtrip", []( auto& expect ) {
+    for( auto const n : { 1u, 2u, 17u, 127u, 128u } ) {
+      auto const keys = addresses( n );
+      auto const buf = encode( keys );
+      std::vector<key_type> dec( n );
+      expect( prefix::pk128::decode( buf.data(), buf.size(), n, dec.data() ), equal_to( n ) );
+      expect( dec == keys, equal_to( true ) );
+    }
+    // no shared prefix at all
+    std::vector<key_type> const spread{ 1u, ~key_type( 0 ) };
+    auto const buf = encode( spread );
+    expect( buf.size(), equal_to( 1u + 2u * 16u ) );
+    std::vector<key_type> dec( 2 );
+    prefix::pk128::decode( buf.data(), buf.size(), 2, dec.data() );
+    expect( dec == spread, equal_to( true ) );
+  } );
+
+  test( "layout", []( auto& expect ) {
+    auto const keys = addresses( 128 );
+    auto const buf = encode( keys );
+    // 128 * 7919 < 2^20: 3 byte suffixes and a 13 byte prefix
+    expect( std::to_integer<unsigned>( buf[0] ), equal_to( 3u ) );
+    expect( buf.size(), equal_to( 1u + 13u + 128u * 3u ) );
+    expect( prefix::pk128::at( buf.data(), 0 ) == keys[0], equal_to( true ) );
+    expect( prefix::pk128::at( buf.data(), 127 ) == keys[127], equal_to( true ) );
+    // truncated blocks
+    expect( prefix::pk128::width( buf.data(), buf.size() - 1, 128 ), equal_to( 17u ) );
+    std::vector<key_type> dec( 128 );
+    expect( prefix::pk128::decode( buf.data(), buf.size() - 1, 128, dec.data() ), equal_to( 0u ) );
+  } );
+
+  test( "lower_bound", []( auto& expect ) {
+    auto const keys = addresses( 100 );
+    auto const buf = encode( keys );
+    for( std::size_t i = 0; i < keys.size(); ++i ) {
+      expect( prefix::pk128::lower_bound( buf.data(), keys.size(), keys[i] ), equal_to( i ) );
+      expect( prefix::pk128::lower_bound( buf.data(), keys.size(), keys[i] + 1 ), equal_to( i + 1 ) );
+    }
+    // keys with a different prefix
+    expect( prefix::pk128::lower_bound( buf.data(), keys.size(), 0u ), equal_to( 0u ) );
+    expect( prefix::pk128::lower_bound( buf.data(), keys.size(), ~key_type( 0 ) ), equal_to( 100u ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
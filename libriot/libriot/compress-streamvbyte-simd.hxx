@@ -492,8 +492,182 @@ struct streamvbyte_i128 : public streamvbyte_base<BlockLen> {
   }
 };
 
+// 16 integers per step: 4 ctrl bytes followed by the data bytes of all 16 integers. encoding
+// squeezes out the unused bytes with `vpcompressb`, decoding builds one 64byte `vpermb` index out
+// of four `decode_shuffle_lut` rows. hosts without avx512-vbmi(2) fall back to scalar code which
+// reads and writes the same format.
+template <std::size_t BlockLen>
+struct streamvbyte_i512 : public streamvbyte_base<BlockLen> {
+  using base_type = streamvbyte_base<BlockLen>;
+  using integer_type = typename base_type::integer_type;
+  static constexpr std::size_t STEPLEN = 16;
+  static constexpr std::size_t CTRLBYTES_SIZE = 4;
+  static_assert( BlockLen % STEPLEN == 0 );
+
+  static inline std::size_t encode( integer_type const* const in, std::byte* const out ) noexcept {
+    return encode( in, base_type::BLOCKLEN, out );
+  }
+
+#if defined( __AVX512F__ ) && defined( __AVX512BW__ ) && defined( __AVX512VBMI__ ) &&             \
+    defined( __AVX512VBMI2__ ) && defined( __BMI2__ )
+
+  // `n` needs to be a multiple of `STEPLEN`
+  static inline std::size_t encode( integer_type const* const in, std::size_t const n,
+                                    std::byte* const out ) noexcept {
+    auto const blocklen = std::min( n, base_type::BLOCKLEN );
+    auto const c1 = _mm512_set1_epi32( 0xff );
+    auto const c2 = _mm512_set1_epi32( 0xffff );
+    auto const c3 = _mm512_set1_epi32( 0xffffff );
+
+    auto* out_p = out;
+    auto const* const end = in + blocklen;
+    auto const* p = in;
+    __m512i prev = _mm512_setzero_si512();
+    while( p < end ) {
+      __m512i const x_raw = _mm512_loadu_si512( p );
+      __m512i const x = _mm512_sub_epi32( x_raw, _mm512_alignr_epi32( x_raw, prev, 15 ) );
+      prev = x_raw;
+
+      // one bit per integer: more than 1, 2 or 3 bytes needed
+      auto const m1 = static_cast<unsigned>( _mm512_cmpgt_epu32_mask( x, c1 ) );
+      auto const m2 = static_cast<unsigned>( _mm512_cmpgt_epu32_mask( x, c2 ) );
+      auto const m3 = static_cast<unsigned>( _mm512_cmpgt_epu32_mask( x, c3 ) );
+
+      // 2bit length codes ( `len - 1` ), first integer in the lowest bits
+      auto const ctrl = _pdep_u32( m1 ^ m2 ^ m3, 0x55555555u ) | _pdep_u32( m2, 0xaaaaaaaau );
+      std::memcpy( out_p, &ctrl, CTRLBYTES_SIZE );
+      out_p += CTRLBYTES_SIZE;
+
+      // keep the first byte of every integer plus the bytes flagged by `m1`, `m2` and `m3`
+      auto const keep = 0x1111111111111111ull | _pdep_u64( m1, 0x2222222222222222ull ) |
+                        _pdep_u64( m2, 0x4444444444444444ull ) |
+                        _pdep_u64( m3, 0x8888888888888888ull );
+      _mm512_storeu_si512( out_p, _mm512_maskz_compress_epi8( keep, x ) );
+      out_p += _mm_popcnt_u64( keep );
+      p += STEPLEN;
+    }
+
+    return static_cast<std::size_t>( out_p - out );
+  }
+
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    integer_type* const out ) noexcept {
+    using detail::decode_shuffle_lut;
+    using detail::length_lut;
+    constexpr auto K = 0x0101010101010101ull;
+    auto const* const out_end = out + base_type::BLOCKLEN;
+    auto* out_p = out;
+    auto const* const end = in + n;
+    auto const* p = in;
+    __m512i const zero = _mm512_setzero_si512();
+    __m512i const last = _mm512_set1_epi32( 15 );
+    __m512i prev = zero;
+    while( ( p + CTRLBYTES_SIZE ) < end ) {
+      auto const ctrl0 = static_cast<std::uint8_t>( p[0] );
+      auto const ctrl1 = static_cast<std::uint8_t>( p[1] );
+      auto const ctrl2 = static_cast<std::uint8_t>( p[2] );
+      auto const ctrl3 = static_cast<std::uint8_t>( p[3] );
+      auto const o1 = static_cast<std::uint64_t>( length_lut[ctrl0] );
+      auto const o2 = o1 + length_lut[ctrl1];
+      auto const o3 = o2 + length_lut[ctrl2];
+      auto const len = o3 + length_lut[ctrl3];
+
+      if( p + CTRLBYTES_SIZE + len > end ) { return 0; }
+      if( out_p + STEPLEN > out_end ) { return 0; }
+
+      // the shuffle rows are relative to the start of each group of 4 integers
+      __m512i s = _mm512_castsi128_si512(
+          _mm_loadu_si128( reinterpret_cast<__m128i const*>( decode_shuffle_lut[ctrl0] ) ) );
+      s = _mm512_inserti32x4(
+          s, _mm_loadu_si128( reinterpret_cast<__m128i const*>( decode_shuffle_lut[ctrl1] ) ), 1 );
+      s = _mm512_inserti32x4(
+          s, _mm_loadu_si128( reinterpret_cast<__m128i const*>( decode_shuffle_lut[ctrl2] ) ), 2 );
+      s = _mm512_inserti32x4(
+          s, _mm_loadu_si128( reinterpret_cast<__m128i const*>( decode_shuffle_lut[ctrl3] ) ), 3 );
+      auto const zeros = _mm512_movepi8_mask( s );
+      auto const offsets = _mm512_set_epi64( static_cast<long long>( o3 * K ),
+                                             static_cast<long long>( o3 * K ),
+                                             static_cast<long long>( o2 * K ),
+                                             static_cast<long long>( o2 * K ),
+                                             static_cast<long long>( o1 * K ),
+                                             static_cast<long long>( o1 * K ), 0, 0 );
+      s = _mm512_add_epi8( s, offsets );
+
+      // masked load, never touches memory beyond the current step
+      auto const data = _mm512_maskz_loadu_epi8( _bzhi_u64( ~0ull, static_cast<unsigned>( len ) ),
+                                                 p + CTRLBYTES_SIZE );
+      __m512i x = _mm512_maskz_permutexvar_epi8( ~zeros, s, data );
+
+      x = _mm512_add_epi32( x, _mm512_alignr_epi32( x, zero, 15 ) );
+      x = _mm512_add_epi32( x, _mm512_alignr_epi32( x, zero, 14 ) );
+      x = _mm512_add_epi32( x, _mm512_alignr_epi32( x, zero, 12 ) );
+      x = _mm512_add_epi32( x, _mm512_alignr_epi32( x, zero, 8 ) );
+      prev = _mm512_add_epi32( x, _mm512_permutexvar_epi32( last, prev ) );
+      _mm512_storeu_si512( out_p, prev );
+
+      out_p += STEPLEN;
+      p += CTRLBYTES_SIZE + len;
+    }
+
+    return static_cast<std::size_t>( p - in );
+  }
+
+#else
+
+  // `n` needs to be a multiple of `STEPLEN`
+  static inline std::size_t encode( integer_type const* const in, std::size_t const n,
+                                    std::byte* const out ) noexcept {
+    auto const blocklen = std::min( n, base_type::BLOCKLEN );
+    auto* out_p = out;
+    integer_type prev = 0;
+    for( std::size_t i = 0; i < blocklen; i += STEPLEN ) {
+      auto* const ctrl_p = out_p;
+      std::memset( ctrl_p, 0, CTRLBYTES_SIZE );
+      out_p += CTRLBYTES_SIZE;
+      for( std::size_t j = 0; j < STEPLEN; ++j ) {
+        auto const x = in[i + j] - prev;
+        prev = in[i + j];
+        auto const code = ( x > 0xffu ) + ( x > 0xffffu ) + ( x > 0xffffffu );
+        ctrl_p[j >> 2] |= std::byte( code << ( ( j & 3 ) << 1 ) );
+        for( unsigned k = 0; k <= code; ++k ) { *out_p++ = std::byte( x >> ( k << 3 ) ); }
+      }
+    }
+    return static_cast<std::size_t>( out_p - out );
+  }
+
+  static inline std::size_t decode( std::byte const* const in, std::size_t const n,
+                                    integer_type* const out ) noexcept {
+    auto const* const out_end = out + base_type::BLOCKLEN;
+    auto* out_p = out;
+    auto const* const end = in + n;
+    auto const* p = in;
+    integer_type prev = 0;
+    while( ( p + CTRLBYTES_SIZE ) < end ) {
+      auto const* const ctrl_p = p;
+      auto const len = detail::length_lut[static_cast<std::uint8_t>( ctrl_p[0] )] +
+                       detail::length_lut[static_cast<std::uint8_t>( ctrl_p[1] )] +
+                       detail::length_lut[static_cast<std::uint8_t>( ctrl_p[2] )] +
+                       detail::length_lut[static_cast<std::uint8_t>( ctrl_p[3] )];
+      if( p + CTRLBYTES_SIZE + len > end ) { return 0; }
+      if( out_p + STEPLEN > out_end ) { return 0; }
+      p += CTRLBYTES_SIZE;
+      for( std::size_t j = 0; j < STEPLEN; ++j ) {
+        auto const code = ( static_cast<unsigned>( ctrl_p[j >> 2] ) >> ( ( j & 3 ) << 1 ) ) & 3u;
+        integer_type x = 0;
+        for( unsigned k = 0; k <= code; ++k ) { x |= integer_type( *p++ ) << ( k << 3 ); }
+        prev += x;
+        *out_p++ = prev;
+      }
+    }
+    return static_cast<std::size_t>( p - in );
+  }
+
+#endif
+};
+
 struct svb128_i128 : streamvbyte_i128<delta::nodelta, 128> {};
 struct svb128d1_i128 : streamvbyte_i128<delta::delta_regular, 128> {};
 struct svb256d1_i128 : streamvbyte_i128<delta::delta_regular, 256> {};
+struct svb512d1_i512 : streamvbyte_i512<512> {};
 
 } // namespace riot::streamvbyte
@@ -14,6 +14,7 @@ emptyspace::pest::suite basic( "streamvbyte compression basic suite", []( auto&
   using namespace emptyspace::pest;
   using svb128 = riot::streamvbyte::svb128_i128;
   using svb128d1 = riot::streamvbyte::svb128d1_i128;
+  using svb512d1 = riot::streamvbyte::svb512d1_i512;
 
   test( "svb128_i128: compress all zeros", []( auto& expect ) {
     std::array<svb128::integer_type, svb128::BLOCKLEN> in;
@@ -133,6 +134,61 @@ emptyspace::pest::suite basic( "streamvbyte compression basic suite", []( auto&
     expect( n_dec, equal_to( n ) );
     for( std::size_t i = 0; i < svb128d1::STEPLEN; ++i ) { expect( in[i] == dec[i] ); }
   } );
+  test( "svb512d1_i512: compress all zeros", []( auto& expect ) {
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> in;
+    std::array<std::byte, svb512d1::estimate_compressed_size()> out;
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> dec;
+    in.fill( 0x0 );
+    dec.fill( 0xffffffffu );
+    out.fill( std::byte( 0xff ) );
+    auto n = svb512d1::encode( in.data(), out.data() );
+    expect( n, equal_to( svb512d1::CTRLLEN + svb512d1::BLOCKLEN ) );
+    auto n_dec = svb512d1::decode( out.data(), n, dec.data() );
+    expect( n_dec, equal_to( n ) );
+    expect( in == dec, equal_to( true ) );
+  } );
+
+  test( "svb512d1_i512: compress STEPLEN", []( auto& expect ) {
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> in;
+    std::array<std::byte, svb512d1::estimate_compressed_size()> out;
+    in.fill( 0xff );
+    out.fill( std::byte( 0xff ) );
+    in[0] = 0xfe;
+    in[2] = 0x1ff;
+    in[3] = 0x10001ff;
+    auto n = svb512d1::encode( in.data(), svb512d1::STEPLEN, out.data() );
+    expect( n, equal_to( 27u ) );
+    expect( hexify( out, n ), equal_to( "d0030000fe0100010000000100fffffe0000000000000000000000" ) );
+  } );
+
+  test( "svb512d1_i512: enc/dec byte length mix", []( auto& expect ) {
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> in;
+    std::array<std::byte, svb512d1::estimate_compressed_size()> out;
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> dec;
+    dec.fill( 0xffffffffu );
+    emptyspace::xoshiro::xoshiro128starstar32 mt{ 0x42421337 };
+    in[0] = mt();
+    // cycle through 1, 2, 3 and 4 byte deltas
+    for( std::size_t i = 1; i < svb512d1::BLOCKLEN; ++i ) {
+      in[i] = in[i - 1] + ( mt() >> ( ( ( i * 7 ) & 3 ) << 3 ) );
+    }
+    auto n = svb512d1::encode( in.data(), svb512d1::BLOCKLEN, out.data() );
+    expect( n <= svb512d1::estimate_compressed_size() );
+    auto n_dec = svb512d1::decode( out.data(), n, dec.data() );
+    expect( n_dec, equal_to( n ) );
+    expect( in == dec, equal_to( true ) );
+  } );
+
+  test( "svb512d1_i512: truncated input", []( auto& expect ) {
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> in;
+    std::array<std::byte, svb512d1::estimate_compressed_size()> out;
+    std::array<svb512d1::integer_type, svb512d1::BLOCKLEN> dec;
+    in.fill( 0x11223344u );
+    in[0] = 0;
+    auto n = svb512d1::encode( in.data(), svb512d1::STEPLEN, out.data() );
+    expect( n, equal_to( 23u ) );
+    expect( svb512d1::decode( out.data(), n - 1, dec.data() ), equal_to( 0u ) );
+  } );
 } );
 
 } // namespace
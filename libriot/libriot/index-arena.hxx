@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libriot/index-builder.hxx>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <sys/mman.h>
+}
+
+namespace riot {
+
+// the memory of one index builder during a segment: bump allocation from 2MiB regions backed by
+// transparent huge pages where available. freed blocks go to a free list per power of two size
+// class ( the posting lists of `chunked_vector` grow by doubling ), they get reused but not
+// returned. `reset` unmaps all regions at once instead of one `free` per map node and posting
+// list.
+//
+// not thread safe, a builder belongs to one thread at a time.
+class arena {
+  static constexpr std::size_t REGIONSZ = 2ul << 20;
+  static constexpr std::size_t PAGESZ = 4ul << 10;
+  static constexpr std::size_t ALIGN = alignof( std::max_align_t );
+  static constexpr std::size_t CLASSES = 64;
+  // large blocks ( the posting lists of frequent keys ) get mappings of their own, they go away
+  // on `deallocate` like with `malloc`
+  static constexpr std::size_t LARGESZ = 256ul << 10;
+
+  struct region {
+    std::byte* _p;
+    std::size_t _size;
+  };
+
+  struct free_block {
+    free_block* _next;
+  };
+
+  std::vector<region> _regions;
+  std::byte* _cursor{ nullptr };
+  std::byte* _end{ nullptr };
+  std::array<free_block*, CLASSES> _free{};
+  std::unordered_map<void*, std::size_t> _large;
+  std::size_t _mapped{ 0 };
+
+ public:
+  arena() noexcept = default;
+
+  ~arena() noexcept { reset(); }
+
+  arena( arena const& ) = delete;
+  arena& operator=( arena const& ) = delete;
+
+  void* allocate( std::size_t const n ) {
+    auto const sz = align_up<ALIGN>( std::max<std::size_t>( n, 1 ) );
+    if( sz >= LARGESZ ) { return map_large( sz ); }
+    // the smallest class all blocks of are large enough
+    auto const c = static_cast<std::size_t>( std::bit_width( sz - 1 ) );
+    if( auto* b = _free[c]; b != nullptr ) {
+      _free[c] = b->_next;
+      return b;
+    }
+    if( static_cast<std::size_t>( _end - _cursor ) < sz ) { grow( sz ); }
+    auto* const p = _cursor;
+    _cursor += sz;
+    return p;
+  }
+
+  void deallocate( void* const p, std::size_t const n ) noexcept {
+    auto const sz = align_up<ALIGN>( std::max<std::size_t>( n, 1 ) );
+    if( sz >= LARGESZ ) { return unmap_large( p ); }
+    recycle( static_cast<std::byte*>( p ), sz );
+  }
+
+  // unmaps all regions, everything allocated so far is gone
+  void reset() noexcept {
+    for( auto const& r : _regions ) { munmap( static_cast<void*>( r._p ), r._size ); }
+    for( auto const& [p, bytes] : _large ) { munmap( p, bytes ); }
+    _regions.clear();
+    _large.clear();
+    _cursor = _end = nullptr;
+    _free.fill( nullptr );
+    _mapped = 0;
+  }
+
+  std::size_t memory() const noexcept { return _mapped; }
+  std::size_t region_count() const noexcept { return _regions.size(); }
+
+ private:
+  // a block of `sz` bytes goes to the largest class it can serve completely
+  void recycle( std::byte* const p, std::size_t const sz ) noexcept {
+    auto const c = static_cast<std::size_t>( std::bit_width( sz ) - 1 );
+    auto* const b = ::new( static_cast<void*>( p ) ) free_block{ _free[c] };
+    _free[c] = b;
+  }
+
+  static void* map( std::size_t const bytes ) {
+    auto const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* const p = mmap( nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0 );
+    if( p == MAP_FAILED ) { throw std::bad_alloc{}; }
+#if defined( MADV_HUGEPAGE )
+    if( bytes >= REGIONSZ ) { madvise( p, bytes, MADV_HUGEPAGE ); }
+#endif
+    return p;
+  }
+
+  void* map_large( std::size_t const sz ) {
+    auto const bytes = align_up<PAGESZ>( sz );
+    auto* const p = map( bytes );
+    _large.emplace( p, bytes );
+    _mapped += bytes;
+    return p;
+  }
+
+  void unmap_large( void* const p ) noexcept {
+    auto const it = _large.find( p );
+    if( it == _large.end() ) { return; }
+    munmap( p, it->second );
+    _mapped -= it->second;
+    _large.erase( it );
+  }
+
+  void grow( std::size_t const sz ) {
+    // the rest of the current region stays usable through the free lists
+    if( auto const rest = static_cast<std::size_t>( _end - _cursor ); rest >= ALIGN ) {
+      recycle( _cursor, rest );
+    }
+    auto const bytes = std::max( align_up<PAGESZ>( sz ), REGIONSZ );
+    auto* const p = map( bytes );
+    _regions.push_back( { static_cast<std::byte*>( p ), bytes } );
+    _cursor = static_cast<std::byte*>( p );
+    _end = _cursor + bytes;
+    _mapped += bytes;
+  }
+};
+
+// an allocator drawing from an `arena`, `index_builder` owns the arena ( see `allocator_source` )
+template <typename T>
+class arena_allocator {
+  static_assert( alignof( T ) <= alignof( std::max_align_t ) );
+
+  template <typename U>
+  friend class arena_allocator;
+
+  arena* _arena;
+
+ public:
+  using value_type = T;
+  using arena_type = arena;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit arena_allocator( arena* const a ) noexcept : _arena{ a } {}
+
+  template <typename U>
+  arena_allocator( arena_allocator<U> const& other ) noexcept : _arena{ other._arena } {}
+
+  T* allocate( std::size_t const n ) {
+    return static_cast<T*>( _arena->allocate( n * sizeof( T ) ) );
+  }
+
+  void deallocate( T* const p, std::size_t const n ) noexcept {
+    _arena->deallocate( p, n * sizeof( T ) );
+  }
+
+  template <typename U>
+  bool operator==( arena_allocator<U> const& other ) const noexcept {
+    return _arena == other._arena;
+  }
+};
+
+// the map of `index_builder` with its nodes in the arena of the builder
+template <typename K, typename V>
+using arena_map = std::map<K, V, std::less<K>, arena_allocator<std::pair<K const, V>>>;
+
+// an `index_builder` with map nodes, posting lists and chunks in an arena
+template <typename Key, std::size_t BlockLen, std::size_t VBlockLen = BlockLen>
+using arena_index_builder = index_builder<Key, arena_map, BlockLen, VBlockLen,
+                                          arena_allocator<std::array<offset_type, VBlockLen>>>;
+
+} // namespace riot
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-arena.hxx>
+#include <libriot/index-compressor.hxx>
+#include <libriot/index-serializer.hxx>
+#include <libriot/index-shards.hxx>
+#include <libriot/index-spill.hxx>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using map4_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using arena4_type = riot::arena_index_builder<std::uint32_t, 128>;
+using map6_type = riot::index_builder<__uint128_t, map_type, 128>;
+using arena6_type = riot::arena_index_builder<__uint128_t, 128>;
+
+template <template <typename> typename S, typename I>
+std::vector<std::byte> serialize( I& i ) {
+  std::vector<std::byte> data( 8u << 20 );
+  std::size_t n;
+  {
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    S<nygma::cfile_ostream> s{ os };
+    i.accept( s, 2342 );
+    n = static_cast<std::size_t>( os.current_position() );
+  }
+  data.resize( n );
+  return data;
+}
+
+template <typename F>
+void generate( std::uint32_t const seed, std::uint32_t const keys, F&& f ) {
+  auto xo = emptyspace::xoshiro::xoshiro128starstar32{ seed };
+  std::uint32_t o = 24;
+  for( unsigned i = 0; i < 50000; ++i ) {
+    auto const k = xo() % keys;
+    f( k, o );
+    if( xo() % 4 == 0 ) { f( k, o ); }
+    o += 1 + xo() % 1500;
+  }
+}
+
+emptyspace::pest::suite basic( "index-arena suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "freed blocks get reused by size class", []( auto& expect ) {
+    riot::arena a;
+    expect( a.memory(), equal_to( 0u ) );
+    auto* const p = a.allocate( 1024 );
+    auto* const q = a.allocate( 40 );
+    expect( reinterpret_cast<std::uintptr_t>( q ) % alignof( std::max_align_t ), equal_to( 0u ) );
+    a.deallocate( p, 1024 );
+    expect( a.allocate( 1000 ) == p, equal_to( true ) );
+    // a 48 byte block serves 32 byte requests only
+    a.deallocate( q, 40 );
+    expect( a.allocate( 40 ) == q, equal_to( false ) );
+    expect( a.allocate( 32 ) == q, equal_to( true ) );
+    expect( a.region_count(), equal_to( 1u ) );
+    // large blocks are mapped and unmapped on their own
+    auto* const l = a.allocate( 3u << 20 );
+    expect( a.region_count(), equal_to( 1u ) );
+    expect( a.memory(), equal_to( 5u << 20 ) );
+    a.deallocate( l, 3u << 20 );
+    expect( a.memory(), equal_to( 2u << 20 ) );
+    a.allocate( 1u << 20 );
+    a.reset();
+    expect( a.memory(), equal_to( 0u ) );
+  } );
+
+  test( "the same serialized indices as with std::allocator", []( auto& expect ) {
+    auto const same = [&]<template <typename> typename S>() {
+      map4_type m;
+      arena4_type a;
+      generate( 4223, 500, [&]( auto const k, auto const o ) {
+        m.add( k, o );
+        a.add( k, o );
+      } );
+      return a.key_count() == m.key_count() and serialize<S>( a ) == serialize<S>( m );
+    };
+    expect( same.template operator()<riot::uc128_serializer>(), equal_to( true ) );
+    expect( same.template operator()<riot::svb128d1_serializer>(), equal_to( true ) );
+    expect( same.template operator()<riot::rc128_serializer>(), equal_to( true ) );
+    map6_type m;
+    arena6_type a;
+    generate( 2342, 700, [&]( auto const k, auto const o ) {
+      auto const k6 = __uint128_t( 0x20010db8u ) << 96 | k;
+      m.add( k6, o );
+      a.add( k6, o );
+    } );
+    expect( serialize<riot::pk128_serializer>( a ) == serialize<riot::pk128_serializer>( m ),
+            equal_to( true ) );
+  } );
+
+  test( "merged shards keep the arenas of their posting lists", []( auto& expect ) {
+    map4_type m;
+    riot::index_shards<arena4_type> shards{ 3 };
+    generate( 1337, 2000, [&]( auto const k, auto const o ) {
+      m.add( k, o );
+      shards.add( k, o );
+    } );
+    auto merged = shards.take();
+    // the shards start over with arenas of their own
+    generate( 23, 100, [&]( auto const k, auto const o ) { shards.add( k, o ); } );
+    expect( shards.take()->key_count(), equal_to( 100u ) );
+    expect( serialize<riot::svb128d1_serializer>( *merged ) ==
+                serialize<riot::svb128d1_serializer>( m ),
+            equal_to( true ) );
+  } );
+
+  test( "spilling starts over with a new arena", []( auto& expect ) {
+    map4_type m;
+    riot::index_spilling<arena4_type> s{ 64u << 10 };
+    generate( 42, 1000, [&]( auto const k, auto const o ) {
+      m.add( k, o );
+      s.add( k, o );
+    } );
+    expect( s.run_count() > 1, equal_to( true ) );
+    expect( serialize<riot::svb128d1_serializer>( s ) == serialize<riot::svb128d1_serializer>( m ),
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -2,8 +2,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace riot {
@@ -66,6 +72,8 @@ class chunked_vector {
  public:
   chunked_vector() : _chunks{} {}
 
+  explicit chunked_vector( Alloc const& alloc ) : _chunks( alloc ) {}
+
   inline void push( T const t ) noexcept {
     if( t == _cached ) { return; }
     _cached = t;
@@ -99,25 +107,175 @@ class chunked_vector {
   }
 };
 
+// the allocators of an `index_builder`. stateless ones get default constructed, allocators with an
+// `arena_type` ( see `index-arena.hxx` ) draw from an arena owned by the builder. the arenas of
+// merged builders stay alive with the builder their posting lists moved to.
+template <typename Alloc>
+class allocator_source {
+ public:
+  Alloc allocator() const noexcept { return Alloc{}; }
+
+  void adopt( allocator_source& ) noexcept {}
+};
+
+template <typename Alloc>
+requires requires { typename Alloc::arena_type; }
+class allocator_source<Alloc> {
+  using arena_type = typename Alloc::arena_type;
+
+  std::unique_ptr<arena_type> _arena{ std::make_unique<arena_type>() };
+  std::vector<std::unique_ptr<arena_type>> _adopted;
+
+ public:
+  Alloc allocator() const noexcept { return Alloc{ _arena.get() }; }
+
+  // `o` starts over with an empty arena
+  void adopt( allocator_source& o ) {
+    _adopted.push_back( std::exchange( o._arena, std::make_unique<arena_type>() ) );
+  }
+};
+
+// an empty builder for the next segment configured like `i`, builders with state beyond their
+// postings provide `fresh` ( see `index_shards` and `index_spilling` )
+template <typename I>
+inline std::unique_ptr<I> fresh_of( I const& i ) {
+  if constexpr( requires { i.fresh(); } ) {
+    return i.fresh();
+  } else {
+    return std::make_unique<I>();
+  }
+}
+
+// one posting list from a contiguous `list`, in the layout of the serializer or in `VBlockLen`
+// blocks ( `list` gets padded )
+template <typename KeyType, std::size_t KBlockLen, std::size_t VBlockLen>
+void encode_posting_list( serializer<KeyType, KBlockLen, VBlockLen> auto& serializer,
+                          std::vector<offset_type>& list ) noexcept {
+  auto const n = list.size();
+  if constexpr( requires( offset_type const* p ) { serializer.encode_postings( p, n ); } ) {
+    serializer.encode_postings( list.data(), n );
+  } else {
+    list.resize( align_up<VBlockLen>( n ) );
+    for( std::size_t i = 0; i < n; i += VBlockLen ) {
+      auto const used = std::min( n - i, VBlockLen );
+      if( used != VBlockLen ) { fill_block<offset_type, VBlockLen>( list.data() + i, used ); }
+      auto const* const block = list.data() + i;
+      serializer.template encode_cblock<offset_type, VBlockLen>( block, used, i == 0 );
+    }
+  }
+}
+
+// the key directory behind the posting lists: the key blocks, the positions of the posting lists,
+// the optional key filter and the meta block. `for_each( f )` calls `f( key, position )` for all
+// keys in ascending order.
+template <typename KeyType, std::size_t KBlockLen, std::size_t VBlockLen, typename ForEach>
+void encode_directory( serializer<KeyType, KBlockLen, VBlockLen> auto& serializer,
+                       ForEach const& for_each, std::size_t const key_count,
+                       std::uint64_t const segment_begin ) noexcept {
+  using key_type = KeyType;
+  constexpr auto KBLOCKLEN = KBlockLen;
+  constexpr auto VBLOCKLEN = VBlockLen;
+
+  // - serialize all keys
+  auto const keys_begin = serializer.current_position();
+  auto keys = 0u;
+  key_type keyblock[KBLOCKLEN];
+  for_each( [&]( key_type const k, offset_type ) {
+    if( keys == KBLOCKLEN ) {
+      serializer.template encode_kblock<key_type, KBLOCKLEN>( keyblock, keys );
+      keys = 0;
+    }
+    keyblock[keys] = k;
+    keys++;
+  } );
+  if( keys > 0 ) {
+    fill_block<key_type, KBLOCKLEN>( keyblock, keys );
+    serializer.template encode_kblock<key_type, KBLOCKLEN>( keyblock, keys );
+  }
+  //auto const keys_end = serializer.current_position();
+
+  // - serialize all external offsets
+  auto const offsets_begin = serializer.current_position();
+  auto offsets = 0u;
+  offset_type offsetblock[VBLOCKLEN];
+  for_each( [&]( key_type, offset_type const o ) {
+    if( offsets == VBLOCKLEN ) {
+      serializer.template encode_oblock<offset_type, VBLOCKLEN>( offsetblock, offsets );
+      offsets = 0;
+    }
+    offsetblock[offsets] = o;
+    offsets++;
+  } );
+  if( offsets > 0 ) {
+    fill_block<offset_type, VBLOCKLEN>( offsetblock, offsets );
+    serializer.template encode_oblock<offset_type, VBLOCKLEN>( offsetblock, offsets );
+  }
+  //auto const offsets_end = serializer.current_position();
+
+  // - serialize the key filter ( optional )
+  if constexpr( requires( key_type const* p ) { serializer.encode_filter( p, offsets ); } ) {
+    std::vector<key_type> filter_keys;
+    filter_keys.reserve( key_count );
+    for_each( [&]( key_type const k, offset_type ) { filter_keys.push_back( k ); } );
+    serializer.encode_filter( filter_keys.data(), filter_keys.size() );
+  }
+
+  // - serialize meta data
+  serializer.template encode_mblock<key_type>( keys_begin, offsets_begin, segment_begin );
+}
+
 template <typename Key, template <typename K, typename V> typename Map, std::size_t BlockLen,
           std::size_t VBlockLen = BlockLen,
           typename Alloc = std::allocator<std::array<offset_type, BlockLen>>>
 class index_builder {
+ public:
+  using key_type = Key;
   static constexpr std::size_t KBLOCKLEN = BlockLen;
   static constexpr std::size_t VBLOCKLEN = VBlockLen;
-  using key_type = Key;
+
+ private:
   using chunk_index_type = std::uint32_t;
   using map_type = Map<key_type, chunk_index_type>;
   using chunked_vector_type = chunked_vector<offset_type, VBLOCKLEN, Alloc>;
+  // first, the map and the posting lists allocate from it
+  [[no_unique_address]] allocator_source<Alloc> _source;
   map_type _index;
   std::vector<chunked_vector_type> _chunks;
   chunk_index_type _last_used_chunk_index{ 0 };
+  // the chunks of all posting lists, see `memory`
+  std::size_t _chunk_count{ 0 };
 
  public:
-  index_builder() : _index{} {}
+  index_builder() : _index{ make_map() } {}
+
+  index_builder( index_builder&& ) noexcept = default;
+
+  // swaps, the posting lists of `this` go away before their allocators
+  index_builder& operator=( index_builder&& o ) noexcept {
+    using std::swap;
+    swap( _source, o._source );
+    swap( _index, o._index );
+    swap( _chunks, o._chunks );
+    swap( _last_used_chunk_index, o._last_used_chunk_index );
+    swap( _chunk_count, o._chunk_count );
+    return *this;
+  }
 
  private:
-  void update_chunk( chunk_index_type const i, offset_type const o ) noexcept { _chunks[i].push( o ); }
+  void update_chunk( chunk_index_type const i, offset_type const o ) noexcept {
+    auto const n = _chunks[i].chunk_count();
+    _chunks[i].push( o );
+    _chunk_count += _chunks[i].chunk_count() - n;
+  }
+
+  map_type make_map() const {
+    using map_allocator_type = typename map_type::allocator_type;
+    if constexpr( requires( Alloc const a ) { map_type( map_allocator_type( a ) ); } ) {
+      return map_type( map_allocator_type( _source.allocator() ) );
+    } else {
+      return map_type{};
+    }
+  }
 
  public:
   void add( key_type const k, offset_type const o ) noexcept {
@@ -126,14 +284,61 @@ class index_builder {
       update_chunk( it->second, o );
     } else {
       _index.insert( { k, _last_used_chunk_index } );
-      _chunks.emplace_back();
+      _chunks.emplace_back( _source.allocator() );
       update_chunk( _last_used_chunk_index, o );
       _last_used_chunk_index++;
     }
   }
 
+  // all offsets `[first, last)` ( ascending ) of `k` at once
+  template <typename It>
+  void add( key_type const k, It first, It const last ) noexcept {
+    if( first == last ) { return; }
+    auto it = _index.find( k );
+    auto i = _last_used_chunk_index;
+    if( it != _index.end() ) {
+      i = it->second;
+    } else {
+      _index.insert( { k, _last_used_chunk_index } );
+      _chunks.emplace_back( _source.allocator() );
+      _last_used_chunk_index++;
+    }
+    for( ; first != last; ++first ) { update_chunk( i, *first ); }
+  }
+
+  // takes over the keys of `o`, none of them may be a key of this builder ( e.g. the partitions of
+  // `index_shards` )
+  void merge( index_builder&& o ) {
+    auto const base = static_cast<chunk_index_type>( _chunks.size() );
+    for( auto const& [k, i] : o._index ) {
+      [[maybe_unused]] auto const inserted = _index.insert( { k, base + i } ).second;
+      assert( inserted );
+    }
+    _chunks.insert( _chunks.end(), std::make_move_iterator( o._chunks.begin() ),
+                    std::make_move_iterator( o._chunks.end() ) );
+    _last_used_chunk_index = static_cast<chunk_index_type>( _chunks.size() );
+    _chunk_count += std::exchange( o._chunk_count, 0 );
+    o._index.clear();
+    o._chunks.clear();
+    o._last_used_chunk_index = 0;
+    _source.adopt( o._source );
+    o._index = o.make_map();
+  }
+
   auto key_count() const noexcept { return _index.size(); }
 
+  // the approximate heap memory in bytes: map nodes, posting lists and their chunks
+  std::size_t memory() const noexcept {
+    constexpr std::size_t NODESZ = sizeof( typename map_type::value_type ) + 4 * sizeof( void* );
+    constexpr std::size_t CHUNKSZ = sizeof( typename chunked_vector_type::chunk_type );
+    return _index.size() * ( NODESZ + sizeof( chunked_vector_type ) ) + _chunk_count * CHUNKSZ;
+  }
+
+  template <typename F>
+  void for_each_key( F&& f ) const {
+    for( auto const& [k, _] : _index ) { f( k ); }
+  }
+
   std::pair<std::size_t, std::size_t> minmax_offset_count() const noexcept {
     if( _index.size() == 0 ) { return { 0, 0 }; }
     auto const [min, max] = std::minmax_element( _index.begin(), _index.end(), [&]( auto& a, auto& b ) {
@@ -142,11 +347,29 @@ class index_builder {
     return { _chunks[min->second].size(), _chunks[max->second].size() };
   }
 
+  // `f( k, first, last )` with the ascending offsets of every key
+  template <typename F>
+  void for_each_posting_list( F&& f ) const {
+    std::vector<offset_type> postings;
+    for( auto const& [k, i] : _index ) {
+      auto const& cs = _chunks[i];
+      auto remaining = cs.size();
+      postings.clear();
+      for( auto cit = cs.begin(); cit != cs.end(); ++cit ) {
+        auto const used = std::min( remaining, cit->size() );
+        postings.insert( postings.end(), cit->data(), cit->data() + used );
+        remaining -= used;
+      }
+      f( k, postings.cbegin(), postings.cend() );
+    }
+  }
+
   // this invalidates the index builder
   void accept( serializer<key_type, KBLOCKLEN, VBLOCKLEN> auto& serializer,
                std::uint64_t const segment_begin ) noexcept {
 
     // - serialize all chunked vectors ( and patch index to external offsets )
+    std::vector<offset_type> postings;
     for( auto it = _index.begin(); it != _index.end(); ++it ) {
       // replace `chunk_index_type` with the position
       // reported by the serializer
@@ -157,57 +380,37 @@ class index_builder {
       } else {
         it->second = o;
       }
-      auto cs = _chunks[chunk_index];
+      auto& cs = _chunks[chunk_index];
       auto remaining = cs.size();
-      auto begin = true;
-      for( auto cit = cs.begin(); cit != cs.end(); ++cit ) {
-        auto const used = std::min( remaining, cit->size() );
-        if( used != VBLOCKLEN ) { fill_block<offset_type, VBLOCKLEN>( cit->data(), used ); }
-        serializer.template encode_cblock<offset_type, VBLOCKLEN>( cit->data(), used, begin );
-        remaining -= used;
-        begin = false;
+      if constexpr( requires( offset_type const* p ) { serializer.encode_postings( p, remaining ); } ) {
+        // the serializer chooses its own layout ( e.g. containers per 64k offset chunk )
+        postings.clear();
+        for( auto cit = cs.begin(); cit != cs.end(); ++cit ) {
+          auto const used = std::min( remaining, cit->size() );
+          postings.insert( postings.end(), cit->data(), cit->data() + used );
+          remaining -= used;
+        }
+        serializer.encode_postings( postings.data(), postings.size() );
+      } else {
+        auto begin = true;
+        for( auto cit = cs.begin(); cit != cs.end(); ++cit ) {
+          auto const used = std::min( remaining, cit->size() );
+          if( used != VBLOCKLEN ) { fill_block<offset_type, VBLOCKLEN>( cit->data(), used ); }
+          serializer.template encode_cblock<offset_type, VBLOCKLEN>( cit->data(), used, begin );
+          remaining -= used;
+          begin = false;
+        }
       }
       assert( remaining == 0 );
     }
 
-    // - serialize all keys
-    auto const keys_begin = serializer.current_position();
-    auto keys = 0u;
-    key_type keyblock[KBLOCKLEN];
-    for( auto it = _index.begin(); it != _index.end(); ++it ) {
-      if( keys == KBLOCKLEN ) {
-        serializer.template encode_kblock<key_type, KBLOCKLEN>( keyblock, keys );
-        keys = 0;
-      }
-      keyblock[keys] = it->first;
-      keys++;
-    }
-    if( keys > 0 ) {
-      fill_block<key_type, KBLOCKLEN>( keyblock, keys );
-      serializer.template encode_kblock<key_type, KBLOCKLEN>( keyblock, keys );
-    }
-    //auto const keys_end = serializer.current_position();
-
-    // - serialize all external offsets
-    auto const offsets_begin = serializer.current_position();
-    auto offsets = 0u;
-    offset_type offsetblock[VBLOCKLEN];
-    for( auto it = _index.begin(); it != _index.end(); ++it ) {
-      if( offsets == VBLOCKLEN ) {
-        serializer.template encode_oblock<offset_type, VBLOCKLEN>( offsetblock, offsets );
-        offsets = 0;
-      }
-      offsetblock[offsets] = it->second;
-      offsets++;
-    }
-    if( offsets > 0 ) {
-      fill_block<offset_type, VBLOCKLEN>( offsetblock, offsets );
-      serializer.template encode_oblock<offset_type, VBLOCKLEN>( offsetblock, offsets );
-    }
-    //auto const offsets_end = serializer.current_position();
-
-    // - serialize meta data
-    serializer.template encode_mblock<key_type>( keys_begin, offsets_begin, segment_begin );
+    // - serialize the key directory
+    encode_directory<key_type, KBLOCKLEN, VBLOCKLEN>(
+        serializer,
+        [&]( auto const f ) {
+          for( auto const& [k, o] : _index ) { f( k, o ); }
+        },
+        _index.size(), segment_begin );
   }
 };
 
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-bulk-builder.hxx>
+#include <libriot/index-compressor.hxx>
+#include <libriot/index-serializer.hxx>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using map4_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using bulk4_type = riot::index_bulk_builder<std::uint32_t, 128>;
+using map6_type = riot::index_builder<__uint128_t, map_type, 128>;
+using bulk6_type = riot::index_bulk_builder<__uint128_t, 128>;
+
+// the serialized index, `S` is one of the `*128_serializer` templates
+template <template <typename> typename S, typename I>
+std::vector<std::byte> serialize( I& i ) {
+  std::vector<std::byte> data( 8u << 20 );
+  std::size_t n;
+  {
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    S<nygma::cfile_ostream> s{ os };
+    i.accept( s, 2342 );
+    n = static_cast<std::size_t>( os.current_position() );
+  }
+  data.resize( n );
+  return data;
+}
+
+// postings of `keys` keys with ascending offsets, some of them repeated ( a packet adds a key twice
+// if it is the source and the destination ) and some starting at the invalid offset `0`
+template <typename F>
+void generate( std::uint32_t const seed, std::uint32_t const keys, F&& f ) {
+  auto xo = emptyspace::xoshiro::xoshiro128starstar32{ seed };
+  std::uint32_t o = 0;
+  for( unsigned i = 0; i < 50000; ++i ) {
+    auto const k = xo() % keys;
+    f( k, o );
+    if( xo() % 4 == 0 ) { f( k, o ); }
+    o += xo() % 1500;
+  }
+}
+
+emptyspace::pest::suite basic( "index-bulk-builder suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "same keys and postings as index_builder", []( auto& expect ) {
+    map4_type m;
+    bulk4_type b;
+    generate( 1337, 3000, [&]( auto const k, auto const o ) {
+      m.add( k, o );
+      b.add( k, o );
+    } );
+    expect( b.key_count(), equal_to( m.key_count() ) );
+    std::vector<std::uint32_t> mk, bk;
+    m.for_each_key( [&]( auto const k ) { mk.push_back( k ); } );
+    b.for_each_key( [&]( auto const k ) { bk.push_back( k ); } );
+    expect( bk == mk, equal_to( true ) );
+    auto const [mmin, mmax] = m.minmax_offset_count();
+    auto const [bmin, bmax] = b.minmax_offset_count();
+    expect( bmin, equal_to( mmin ) );
+    expect( bmax, equal_to( mmax ) );
+  } );
+
+  test( "the serialized indices are identical", []( auto& expect ) {
+    auto const same = [&]<template <typename> typename S>() {
+      map4_type m;
+      bulk4_type b;
+      generate( 4223, 500, [&]( auto const k, auto const o ) {
+        m.add( k, o );
+        b.add( k, o );
+      } );
+      return serialize<S>( b ) == serialize<S>( m );
+    };
+    expect( same.template operator()<riot::uc128_serializer>(), equal_to( true ) );
+    expect( same.template operator()<riot::bp128d1_serializer>(), equal_to( true ) );
+    expect( same.template operator()<riot::svb128d1_serializer>(), equal_to( true ) );
+    // `encode_postings` instead of blocks
+    expect( same.template operator()<riot::rc128_serializer>(), equal_to( true ) );
+    expect( same.template operator()<riot::pef128_serializer>(), equal_to( true ) );
+  } );
+
+  test( "ipv6 keys", []( auto& expect ) {
+    map6_type m;
+    bulk6_type b;
+    generate( 2342, 700, [&]( auto const k, auto const o ) {
+      // a shared prefix, the upper digits are skipped by the radix sort
+      auto const k6 = __uint128_t( 0x20010db8u ) << 96 | __uint128_t( k % 7 ) << 64 | k;
+      m.add( k6, o );
+      b.add( k6, o );
+    } );
+    expect( b.key_count(), equal_to( m.key_count() ) );
+    expect( serialize<riot::pk128_serializer>( b ) == serialize<riot::pk128_serializer>( m ),
+            equal_to( true ) );
+  } );
+
+  test( "adding after a query and merging", []( auto& expect ) {
+    map4_type m;
+    bulk4_type b;
+    bulk4_type c;
+    m.add( 42, 10 );
+    b.add( 42, 10 );
+    expect( b.key_count(), equal_to( 1u ) );
+    m.add( 23, 20 );
+    b.add( 23, 20 );
+    m.add( 42, 30 );
+    c.add( 42, 30 );
+    m.add( 5, 40 );
+    c.add( 5, 40 );
+    b.merge( std::move( c ) );
+    expect( c.key_count(), equal_to( 0u ) );
+    expect( b.key_count(), equal_to( 3u ) );
+    expect( serialize<riot::uc128_serializer>( b ) == serialize<riot::uc128_serializer>( m ),
+            equal_to( true ) );
+  } );
+
+  test( "empty builders", []( auto& expect ) {
+    map4_type m;
+    bulk4_type b;
+    expect( b.key_count(), equal_to( 0u ) );
+    auto const [min, max] = b.minmax_offset_count();
+    expect( min + max, equal_to( 0u ) );
+    expect( serialize<riot::uc128_serializer>( b ) == serialize<riot::uc128_serializer>( m ),
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// merges the indices of many small segments ( e.g. of daily rotated captures ) into a single index
+// without dissecting the captures again. all sources live in one compacted offset space, usually
+// the concatenation of their captures. the postings of a source get rebased from its own segment
+// offset to the segment offset of the compacted index, so the sources of a compacted index need to
+// span less than 4GiB.
+//
+// keys are merged k-way over the ( sorted ) keys of all sources, the postings of a key are the
+// concatenation of its postings in all sources ( in source order ).
+
+#include <libriot/index-view.hxx>
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace riot {
+
+// the maximum span of the sources of a compacted index
+constexpr std::uint64_t COMPACTION_SPAN = 1ull << 32;
+
+template <typename KeyType>
+class index_compactor {
+ public:
+  using key_type = KeyType;
+  using offset_type = std::uint32_t;
+
+ private:
+  struct source {
+    poly_index_view const* _index;
+    std::uint64_t _segment_offset;
+    std::vector<key_type> _keys;
+    std::size_t _cursor{ 0 };
+  };
+
+  std::uint64_t const _segment_offset;
+  std::vector<source> _sources;
+
+  auto lookup( source const& s, key_type const k ) const {
+    if constexpr( sizeof( key_type ) == 16 ) {
+      return s._index->lookup_forward_128( k );
+    } else {
+      return s._index->lookup_forward_32( k );
+    }
+  }
+
+ public:
+  // `segment_offset` of the compacted index in the compacted offset space
+  explicit index_compactor( std::uint64_t const segment_offset ) noexcept
+    : _segment_offset{ segment_offset } {}
+
+  auto segment_offset() const noexcept { return _segment_offset; }
+  auto source_count() const noexcept { return _sources.size(); }
+
+  // `base` is the offset of the capture of `index` in the compacted offset space. sources need
+  // to be added in ascending order and `index` has to outlive the compactor
+  void add( poly_index_view const& index, std::uint64_t const base ) {
+    auto const segment_offset = base + index.segment_offset();
+    if( segment_offset < _segment_offset ) { throw std::runtime_error( "COMPACTION_INVALID_BASE" ); }
+    if( not _sources.empty() and segment_offset < _sources.back()._segment_offset ) {
+      throw std::runtime_error( "COMPACTION_UNORDERED_SOURCES" );
+    }
+    source s{ &index, segment_offset, {} };
+    if constexpr( sizeof( key_type ) == 16 ) {
+      index.collect_keys_128( s._keys );
+    } else {
+      index.collect_keys_32( s._keys );
+    }
+    _sources.push_back( std::move( s ) );
+  }
+
+  // adds the merged keys and postings to `builder`, throws if a posting does not fit into the
+  // compacted segment
+  template <typename IndexBuilder>
+  void merge( IndexBuilder& builder ) {
+    using entry = std::pair<key_type, std::size_t>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> heap;
+    for( std::size_t i = 0; i < _sources.size(); ++i ) {
+      if( not _sources[i]._keys.empty() ) { heap.push( { _sources[i]._keys.front(), i } ); }
+    }
+    std::vector<offset_type> postings;
+    while( not heap.empty() ) {
+      auto const k = heap.top().first;
+      postings.clear();
+      // equal keys pop in source order, so the concatenated postings stay sorted
+      while( not heap.empty() and heap.top().first == k ) {
+        auto& s = _sources[heap.top().second];
+        heap.pop();
+        auto const delta = s._segment_offset - _segment_offset;
+        auto const rs = lookup( s, k );
+        for( auto const v : rs.values() ) {
+          auto const rebased = delta + v;
+          if( rebased >= COMPACTION_SPAN ) { throw std::runtime_error( "COMPACTION_SPAN_EXCEEDED" ); }
+          postings.push_back( static_cast<offset_type>( rebased ) );
+        }
+        if( ++s._cursor < s._keys.size() ) {
+          heap.push( { s._keys[s._cursor], static_cast<std::size_t>( &s - _sources.data() ) } );
+        }
+      }
+      builder.add( k, postings.begin(), postings.end() );
+    }
+  }
+};
+
+} // namespace riot
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/index-builder.hxx>
+#include <libriot/index-compactor.hxx>
+#include <libriot/index-compressor.hxx>
+#include <libriot/index-view.hxx>
+
+#include <map>
+#include <vector>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using bytestring_view = unclassified::bytestring_view;
+using index_type = riot::index_builder<std::uint32_t, map_type, 128>;
+
+template <typename Serializer>
+std::vector<std::byte> serialize( index_type& idx, std::uint64_t const segment_offset ) {
+  std::vector<std::byte> data( 1 << 16 );
+  auto os = nygma::cfile_ostream{ data.data(), data.size() };
+  Serializer ser{ os };
+  idx.accept( ser, segment_offset );
+  data.resize( static_cast<std::size_t>( os.current_position() ) );
+  return data;
+}
+
+emptyspace::pest::suite basic( "index-compactor basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "merging three captures", []( auto& expect ) {
+    // capture 0 ( 1000 bytes ) and capture 1 ( 2 segments ) and capture 2, concatenated
+    index_type a, b, c, d;
+    a.add( 1u, 24 );
+    a.add( 2u, 100 );
+    a.add( 1u, 500 );
+    b.add( 2u, 24 );
+    b.add( 3u, 40 );
+    c.add( 1u, 8 );
+    c.add( 2u, 16 );
+    d.add( 4u, 24 );
+    d.add( 1u, 30 );
+    auto const da = serialize<riot::bp128d1_serializer<nygma::cfile_ostream>>( a, 0 );
+    auto const db = serialize<riot::svb128d1_serializer<nygma::cfile_ostream>>( b, 0 );
+    auto const dc = serialize<riot::uc128_serializer<nygma::cfile_ostream>>( c, 2000 );
+    auto const dd = serialize<riot::bp128d1_serializer<nygma::cfile_ostream>>( d, 0 );
+    auto const ia = riot::make_poly_index_view( bytestring_view{ da.data(), da.size() } );
+    auto const ib = riot::make_poly_index_view( bytestring_view{ db.data(), db.size() } );
+    auto const ic = riot::make_poly_index_view( bytestring_view{ dc.data(), dc.size() } );
+    auto const id = riot::make_poly_index_view( bytestring_view{ dd.data(), dd.size() } );
+
+    riot::index_compactor<std::uint32_t> compactor{ 0 };
+    compactor.add( *ia, 0 );
+    compactor.add( *ib, 1000 );
+    compactor.add( *ic, 1000 );
+    compactor.add( *id, 5000 );
+    expect( compactor.source_count(), equal_to( 4u ) );
+
+    index_type merged;
+    compactor.merge( merged );
+    expect( merged.key_count(), equal_to( 4u ) );
+    auto const dm = serialize<riot::bp128d1_serializer<nygma::cfile_ostream>>( merged, 0 );
+    auto const im = riot::make_poly_index_view( bytestring_view{ dm.data(), dm.size() } );
+    expect( im->segment_offset(), equal_to( 0u ) );
+    expect( im->lookup_forward_32( 1u ).values(), equal_to( { 24u, 500u, 3008u, 5030u } ) );
+    expect( im->lookup_forward_32( 2u ).values(), equal_to( { 100u, 1024u, 3016u } ) );
+    expect( im->lookup_forward_32( 3u ).values(), equal_to( { 1040u } ) );
+    expect( im->lookup_forward_32( 4u ).values(), equal_to( { 5024u } ) );
+  } );
+
+  test( "rebasing to the first source", []( auto& expect ) {
+    index_type a, b;
+    a.add( 7u, 24 );
+    b.add( 7u, 24 );
+    auto const da = serialize<riot::uc128_serializer<nygma::cfile_ostream>>( a, 0 );
+    auto const db = serialize<riot::uc128_serializer<nygma::cfile_ostream>>( b, 0 );
+    auto const ia = riot::make_poly_index_view( bytestring_view{ da.data(), da.size() } );
+    auto const ib = riot::make_poly_index_view( bytestring_view{ db.data(), db.size() } );
+
+    // the compacted segment starts with the second capture of the compacted offset space
+    riot::index_compactor<std::uint32_t> compactor{ 1ull << 40 };
+    compactor.add( *ia, 1ull << 40 );
+    compactor.add( *ib, ( 1ull << 40 ) + 100 );
+    index_type merged;
+    compactor.merge( merged );
+    auto const dm = serialize<riot::uc128_serializer<nygma::cfile_ostream>>( merged, 1ull << 40 );
+    auto const im = riot::make_poly_index_view( bytestring_view{ dm.data(), dm.size() } );
+    auto const rs = im->lookup_forward_32( 7u );
+    expect( rs.segment_offset(), equal_to( 1ull << 40 ) );
+    expect( rs.values(), equal_to( { 24u, 124u } ) );
+  } );
+
+  test( "invalid sources", []( auto& expect ) {
+    index_type a;
+    a.add( 7u, 24 );
+    auto const da = serialize<riot::uc128_serializer<nygma::cfile_ostream>>( a, 0 );
+    auto const ia = riot::make_poly_index_view( bytestring_view{ da.data(), da.size() } );
+
+    auto const throws = []( auto&& f ) {
+      try {
+        f();
+      } catch( std::runtime_error const& ) { return true; }
+      return false;
+    };
+    // sources before the compacted segment
+    expect( throws( [&] { riot::index_compactor<std::uint32_t>{ 100 }.add( *ia, 0 ); } ) );
+    // unordered sources
+    expect( throws( [&] {
+      riot::index_compactor<std::uint32_t> compactor{ 0 };
+      compactor.add( *ia, 100 );
+      compactor.add( *ia, 0 );
+    } ) );
+    // postings beyond 4GiB
+    expect( throws( [&] {
+      riot::index_compactor<std::uint32_t> compactor{ 0 };
+      compactor.add( *ia, riot::COMPACTION_SPAN - 10 );
+      index_type merged;
+      compactor.merge( merged );
+    } ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -3,9 +3,13 @@
 #pragma once
 
 #include <libriot/index-builder.hxx>
+#include <libriot/index-container.hxx>
 #include <libriot/index-serializer.hxx>
 
+#include <libriot/compress-adaptive.hxx>
 #include <libriot/compress-bitpack-simd.hxx>
+#include <libriot/compress-eliasfano.hxx>
+#include <libriot/compress-prefix-simd.hxx>
 #include <libriot/compress-streamvbyte-simd.hxx>
 #include <libriot/compress-streamvqb-simd.hxx>
 
@@ -32,6 +36,14 @@ svb128d1_serializer( OStream& ) -> svb128d1_serializer<OStream>;
 template <typename OStream>
 svb256d1_serializer( OStream& ) -> svb256d1_serializer<OStream>;
 
+template <typename OStream>
+struct svb512d1_serializer //
+  : compressing_serializer<OStream, method::SVB512D1, streamvbyte::svb512d1_i512, method::SVB512D1,
+                           streamvbyte::svb512d1_i512> {};
+
+template <typename OStream>
+svb512d1_serializer( OStream& ) -> svb512d1_serializer<OStream>;
+
 //--streamvqb------------------------------------------------------------------
 
 template <typename OStream>
@@ -44,6 +56,14 @@ svq128d1_serializer( OStream& ) -> svq128d1_serializer<OStream>;
 
 //--bitpack--------------------------------------------------------------------
 
+template <typename OStream>
+struct bp512d1_serializer //
+  : compressing_serializer<OStream, method::BP512D1, bitpack::bp512d1, method::BP512D1,
+                           bitpack::bp512d1> {};
+
+template <typename OStream>
+bp512d1_serializer( OStream& ) -> bp512d1_serializer<OStream>;
+
 template <typename OStream>
 struct bp256d1_serializer //
   : compressing_serializer<OStream, method::BP256D1, bitpack::bp256d1, method::BP256D1,
@@ -60,4 +80,147 @@ struct bp128d1_serializer //
 template <typename OStream>
 bp128d1_serializer( OStream& ) -> bp128d1_serializer<OStream>;
 
+//--adaptive-------------------------------------------------------------------
+
+// picks raw, bitpack or streamvbyte per block. `Budget` trades size for decoding speed
+// ( see `compress-adaptive.hxx` )
+template <typename OStream, std::size_t Budget = 0>
+struct ad256_serializer //
+  : compressing_serializer<OStream, method::AD256, adaptive::ad256<Budget>, method::AD256,
+                           adaptive::ad256<Budget>> {};
+
+template <typename OStream>
+ad256_serializer( OStream& ) -> ad256_serializer<OStream>;
+
+template <typename OStream, std::size_t Budget = 0>
+struct ad128_serializer //
+  : compressing_serializer<OStream, method::AD128, adaptive::ad128<Budget>, method::AD128,
+                           adaptive::ad128<Budget>> {};
+
+template <typename OStream>
+ad128_serializer( OStream& ) -> ad128_serializer<OStream>;
+
+//--containers-----------------------------------------------------------------
+
+// postings are stored as one record per 64k offset chunk holding an array, bitmap or run
+// container ( see `index-container.hxx` ). keys and key offsets use `Compressor`.
+template <typename OStream, method::type Method, typename Compressor, method::type KMethod>
+struct container_serializer //
+  : compressing_serializer<OStream, KMethod, Compressor, Method, Compressor> {
+  using base_type = compressing_serializer<OStream, KMethod, Compressor, Method, Compressor>;
+
+  std::array<std::byte, container::MAX_ENCODED_SIZE> _scrtch_containers;
+
+  template <typename... Args>
+  container_serializer( Args&&... args ) : base_type( std::forward<Args>( args )... ) {}
+
+  // all postings of a single key ( sorted ), called by `index_builder::accept` instead of
+  // `encode_cblock`
+  void encode_postings( offset_type const* const p, std::size_t const n ) noexcept {
+    auto const set = container::posting_set::from_sorted( p, n );
+    auto begin = true;
+    for( auto const& c : set.chunks() ) {
+      auto const enc = encoding::cblock( begin ? block_subtype::CBEGIN : block_subtype::CCONT );
+      auto* const serialized_p = _scrtch_containers.data();
+      auto const serialized_size = c.serialize( serialized_p );
+      // a chunk holds up to `CHUNKLEN` offsets, always store the cardinality
+      this->template encode_record<std::byte, container::CHUNKLEN + 1>(
+          enc, serialized_p, serialized_size, c._cardinality );
+      begin = false;
+    }
+  }
+};
+
+template <typename OStream>
+struct rc256_serializer //
+  : container_serializer<OStream, method::RC256, bitpack::bp256d1, method::BP256D1> {};
+
+template <typename OStream>
+rc256_serializer( OStream& ) -> rc256_serializer<OStream>;
+
+template <typename OStream>
+struct rc128_serializer //
+  : container_serializer<OStream, method::RC128, bitpack::bp128d1, method::BP128D1> {};
+
+template <typename OStream>
+rc128_serializer( OStream& ) -> rc128_serializer<OStream>;
+
+//--elias-fano-----------------------------------------------------------------
+
+// postings are stored as a single record holding a partitioned elias-fano sequence ( see
+// `compress-eliasfano.hxx` ). keys and key offsets use `Compressor`.
+template <typename OStream, method::type Method, typename Compressor, method::type KMethod>
+struct sequence_serializer //
+  : compressing_serializer<OStream, KMethod, Compressor, Method, Compressor> {
+  using base_type = compressing_serializer<OStream, KMethod, Compressor, Method, Compressor>;
+
+  // the sequence stores its own length, longer sequences get flagged as fully populated
+  static constexpr std::size_t BLOCKLEN = 1u << 24;
+
+  std::vector<std::byte> _scrtch_sequence;
+
+  template <typename... Args>
+  sequence_serializer( Args&&... args ) : base_type( std::forward<Args>( args )... ) {}
+
+  void encode_postings( offset_type const* const p, std::size_t const n ) noexcept {
+    _scrtch_sequence.resize( eliasfano::estimate_compressed_size( p, n ) );
+    auto const serialized_size = eliasfano::encode( p, n, _scrtch_sequence.data() );
+    this->template encode_record<std::byte, BLOCKLEN>(
+        encoding::cblock( block_subtype::CBEGIN ), _scrtch_sequence.data(), serialized_size, n );
+  }
+};
+
+template <typename OStream>
+struct pef256_serializer //
+  : sequence_serializer<OStream, method::PEF256, bitpack::bp256d1, method::BP256D1> {};
+
+template <typename OStream>
+pef256_serializer( OStream& ) -> pef256_serializer<OStream>;
+
+template <typename OStream>
+struct pef128_serializer //
+  : sequence_serializer<OStream, method::PEF128, bitpack::bp128d1, method::BP128D1> {};
+
+template <typename OStream>
+pef128_serializer( OStream& ) -> pef128_serializer<OStream>;
+
+//--prefix-keys----------------------------------------------------------------
+
+// 128bit keys with a shared prefix per key block ( see `compress-prefix-simd.hxx` ), postings and
+// key offsets use `Compressor`
+template <typename OStream, method::type KMethod, typename KCompressor, method::type VMethod,
+          typename VCompressor>
+struct prefix_key_serializer //
+  : compressing_serializer<OStream, KMethod, KCompressor, VMethod, VCompressor> {
+  static_assert( KCompressor::BLOCKLEN == VCompressor::BLOCKLEN );
+  using base_type = compressing_serializer<OStream, KMethod, KCompressor, VMethod, VCompressor>;
+
+  template <typename... Args>
+  prefix_key_serializer( Args&&... args ) : base_type( std::forward<Args>( args )... ) {}
+
+  // the padding of the last key block is not encoded
+  template <typename T, std::size_t BlockLen>
+  auto encode_kblock( T const* p, std::size_t const n ) noexcept
+      -> std::enable_if_t<BlockLen == KCompressor::BLOCKLEN, void> {
+    auto* const compressed_p = this->_scrtch_keys.data();
+    auto const compressed_size = KCompressor::encode( p, n, compressed_p );
+    this->template encode_record<std::byte, KCompressor::BLOCKLEN>(
+        encoding::kblock(), compressed_p, compressed_size, n );
+  }
+};
+
+template <typename OStream>
+struct pk256_serializer //
+  : prefix_key_serializer<OStream, method::PK256, prefix::pk256, method::BP256D1, bitpack::bp256d1> {};
+
+template <typename OStream>
+pk256_serializer( OStream& ) -> pk256_serializer<OStream>;
+
+template <typename OStream>
+struct pk128_serializer //
+  : prefix_key_serializer<OStream, method::PK128, prefix::pk128, method::BP128D1, bitpack::bp128d1> {};
+
+template <typename OStream>
+pk128_serializer( OStream& ) -> pk128_serializer<OStream>;
+
 } // namespace riot
@@ -126,6 +126,286 @@ emptyspace::pest::suite basic( "index-compressor basic suite", []( auto& test )
     expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
     expect( not iv->lookup_forward_128( 1 ) );
   } );
+  test( "bp512d1 compressed example values", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 512>;
+    index_type idx;
+
+    idx.add( 23421337u, 16 );
+    idx.add( 13372342u, 24 );
+    idx.add( 23421337u, 400 );
+    idx.add( 1u, 300 );
+    idx.add( 13372342u, 3000 );
+
+    std::byte data[4096];
+    auto os = nygma::cfile_ostream{ data };
+    auto cs = riot::bp512d1_serializer{ os };
+    idx.accept( cs, 0u );
+
+    expect( idx.key_count(), equal_to( 3u ) );
+    expect( os.ok(), equal_to( true ) );
+    expect( os.current_position(), equal_to( 314u ) );
+    expect( hexify( data, static_cast<std::size_t>( os.current_position() ) ),
+            equal_to(
+                "04010340012c0402420c1800000000a00b0000000000000000000000000000000000000000000000000"
+                "00000000000000000000000000000000000000000000000000000000000000000000402420910000000"
+                "00800100000000000000000000000000000000000000000000000000000000000000000000000000000"
+                "000000000000000000000000000000000000000010342180100000000b50bcc00e35599000000000000"
+                "00000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+                "00000000000030342070000000000060000004500000000000000000000000000000000000000000000"
+                "00000000000000000000000000000000000000000000000000000000000000000037133713060623019"
+                "0000000d500000000000000000000003713371341414141" ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data, len } );
+
+    expect( iv->size(), equal_to( 3u ) );
+    expect( iv->compression_method(), equal_to( riot::method::BP512D1 ) );
+    expect( iv->lookup_forward_32( 1 ).values(), equal_to( { 300u } ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u, 3000u } ) );
+    expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    expect( not iv->lookup_forward_128( 1 ) );
+  } );
+
+  test( "svb512d1 compressed example values", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 512>;
+    index_type idx;
+
+    idx.add( 23421337u, 16 );
+    idx.add( 13372342u, 24 );
+    idx.add( 23421337u, 400 );
+    idx.add( 1u, 300 );
+    idx.add( 13372342u, 3000 );
+
+    std::byte data[4096];
+    auto os = nygma::cfile_ostream{ data };
+    auto cs = riot::svb512d1_serializer{ os };
+    idx.accept( cs, 0u );
+
+    expect( idx.key_count(), equal_to( 3u ) );
+    expect( os.ok(), equal_to( true ) );
+    expect( os.current_position(), equal_to( 154u ) );
+    expect( hexify( data, static_cast<std::size_t>( os.current_position() ) ),
+            equal_to(
+                "040115010000002c010000000000000000000000000000000402150400000018a00b000000000000000"
+                "00000000000000402150400000010800100000000000000000000000000000103182800000001b50bcc"
+                "e3559900000000000000000000000000030314000000000018180000000000000000000000000037133"
+                "71307072301480000006300000000000000000000003713371341414141" ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data, len } );
+
+    expect( iv->size(), equal_to( 3u ) );
+    expect( iv->compression_method(), equal_to( riot::method::SVB512D1 ) );
+    expect( iv->lookup_forward_32( 1 ).values(), equal_to( { 300u } ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u, 3000u } ) );
+    expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    expect( not iv->lookup_forward_128( 1 ) );
+  } );
+
+  test( "ad256 compressed example values", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 256>;
+    // `accept` invalidates the builder so every serializer gets its own
+    auto const populate = []( index_type& idx ) {
+      idx.add( 23421337u, 16 );
+      idx.add( 13372342u, 24 );
+      idx.add( 23421337u, 400 );
+      idx.add( 1u, 300 );
+      idx.add( 13372342u, 3000 );
+      // one dense run spanning several blocks
+      for( std::uint32_t i = 0; i < 600; ++i ) { idx.add( 42u, 5000u + 60u * i ); }
+    };
+    index_type idx, idx_bp, idx_svb;
+    populate( idx );
+    populate( idx_bp );
+    populate( idx_svb );
+
+    std::byte data[8192];
+    auto os = nygma::cfile_ostream{ data };
+    auto cs = riot::ad256_serializer{ os };
+    idx.accept( cs, 0u );
+
+    std::byte data_bp[8192];
+    auto os_bp = nygma::cfile_ostream{ data_bp };
+    auto cs_bp = riot::bp256d1_serializer{ os_bp };
+    idx_bp.accept( cs_bp, 0u );
+
+    std::byte data_svb[8192];
+    auto os_svb = nygma::cfile_ostream{ data_svb };
+    auto cs_svb = riot::svb256d1_serializer{ os_svb };
+    idx_svb.accept( cs_svb, 0u );
+
+    expect( idx.key_count(), equal_to( 4u ) );
+    expect( os.ok(), equal_to( true ) );
+    expect( os.current_position(), equal_to( 601u ) );
+    // small blocks go streamvbyte, the dense run goes bitpack
+    expect( os.current_position() < os_bp.current_position(), equal_to( true ) );
+    expect( os.current_position() < os_svb.current_position(), equal_to( true ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data, len } );
+
+    expect( iv->size(), equal_to( 4u ) );
+    expect( iv->compression_method(), equal_to( riot::method::AD256 ) );
+    expect( iv->lookup_forward_32( 1 ).values(), equal_to( { 300u } ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u, 3000u } ) );
+    expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    auto const run = iv->lookup_forward_32( 42u ).values();
+    expect( run.size(), equal_to( 600u ) );
+    expect( run.front(), equal_to( 5000u ) );
+    expect( run.back(), equal_to( 5000u + 60u * 599u ) );
+    expect( not iv->lookup_forward_128( 1 ) );
+  } );
+
+  test( "rc256 container postings", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 256>;
+    index_type idx;
+
+    idx.add( 23421337u, 16 );
+    idx.add( 13372342u, 24 );
+    idx.add( 23421337u, 400 );
+    idx.add( 1u, 300 );
+    idx.add( 13372342u, 3000 );
+    // two dense keys sharing every 6th offset
+    for( std::uint32_t i = 1; i <= 12000; ++i ) {
+      if( i % 2 == 0 ) { idx.add( 53u, i ); }
+      if( i % 3 == 0 ) { idx.add( 443u, i ); }
+    }
+
+    std::vector<std::byte> data( 65536 );
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    auto cs = riot::rc256_serializer{ os };
+    idx.accept( cs, 0u );
+
+    expect( idx.key_count(), equal_to( 5u ) );
+    expect( os.ok(), equal_to( true ) );
+    // one bitmap ( 8k ), one array ( 4000 x 2 bytes ) and the sparse keys
+    expect( os.current_position(), equal_to( 16342u ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data.data(), len } );
+
+    expect( iv->size(), equal_to( 5u ) );
+    expect( iv->compression_method(), equal_to( riot::method::RC256 ) );
+    expect( iv->lookup_forward_32( 1 ).values(), equal_to( { 300u } ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u, 3000u } ) );
+    expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    expect( iv->lookup_forward_32( 53u ).size(), equal_to( 6000u ) );
+
+    // container wise intersection ( bitmap & bitmap )
+    auto const a = iv->lookup_containers_32( 53u );
+    auto const b = iv->lookup_containers_32( 443u );
+    expect( a.values().chunks()[0]._kind, equal_to( riot::container::kind::BITMAP ) );
+    auto const ab = a & b;
+    expect( ab.size(), equal_to( 2000u ) );
+    auto const forward = iv->lookup_forward_32( 53u ) & iv->lookup_forward_32( 443u );
+    expect( ab.values().values() == forward.values(), equal_to( true ) );
+    expect( not iv->lookup_containers_32( 42u ) );
+  } );
+
+  test( "pef256 elias-fano postings", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 256>;
+    auto const populate = []( index_type& idx ) {
+      idx.add( 23421337u, 16 );
+      idx.add( 13372342u, 24 );
+      idx.add( 23421337u, 400 );
+      idx.add( 1u, 300 );
+      idx.add( 13372342u, 3000 );
+      // a long list with irregular gaps
+      for( std::uint32_t i = 0, off = 16; i < 20000; ++i, off += 76 + ( i * 7919 ) % 1455 ) {
+        idx.add( 443u, off );
+      }
+    };
+    index_type idx, idx_bp;
+    populate( idx );
+    populate( idx_bp );
+
+    std::vector<std::byte> data( 65536 );
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    auto cs = riot::pef256_serializer{ os };
+    idx.accept( cs, 0u );
+
+    std::vector<std::byte> data_bp( 65536 );
+    auto os_bp = nygma::cfile_ostream{ data_bp.data(), data_bp.size() };
+    auto cs_bp = riot::bp256d1_serializer{ os_bp };
+    idx_bp.accept( cs_bp, 0u );
+
+    expect( idx.key_count(), equal_to( 4u ) );
+    expect( os.ok(), equal_to( true ) );
+    expect( os.current_position(), equal_to( 30642u ) );
+    // uniform gaps are the worst case, still within 10% of bitpacking
+    expect( os.current_position() * 10 < os_bp.current_position() * 11, equal_to( true ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data.data(), len } );
+
+    expect( iv->size(), equal_to( 4u ) );
+    expect( iv->compression_method(), equal_to( riot::method::PEF256 ) );
+    expect( iv->lookup_forward_32( 1 ).values(), equal_to( { 300u } ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u, 3000u } ) );
+    expect( iv->lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    auto const all = iv->lookup_forward_32( 443u );
+    expect( all.size(), equal_to( 20000u ) );
+
+    // skipping intersection of a short and a long list
+    auto const probe = iv->lookup_forward_32( 23421337u ) + iv->lookup_forward_32( 13372342u );
+    auto const skipped = iv->lookup_forward_and_32( 443u, probe );
+    auto const forward = probe & all;
+    expect( static_cast<bool>( skipped ) );
+    expect( probe.size(), equal_to( 4u ) );
+    expect( skipped.values(), equal_to( { 16u } ) );
+    expect( skipped.values() == forward.values(), equal_to( true ) );
+    expect( iv->lookup_forward_and_32( 42u, probe ).empty() );
+  } );
+
+  test( "pk128 prefix compressed 128bit keys", []( auto& expect ) {
+    using index_type = riot::index_builder<__uint128_t, map_type, 128>;
+    __uint128_t const net = ( __uint128_t( 0x20010db8u ) << 96 ) | ( __uint128_t( 0x42u ) << 64 );
+    auto const populate = [net]( index_type& idx ) {
+      for( std::uint32_t i = 0; i < 1000; ++i ) {
+        idx.add( net | ( i * 7919u ), 16 + i * 100 );
+        idx.add( net | ( i * 7919u ), 24 + i * 100 );
+      }
+    };
+    index_type idx, idx_uc;
+    populate( idx );
+    populate( idx_uc );
+
+    std::vector<std::byte> data( 1 << 17 );
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    auto cs = riot::pk128_serializer{ os };
+    idx.accept( cs, 0u );
+
+    std::vector<std::byte> data_uc( 1 << 17 );
+    auto os_uc = nygma::cfile_ostream{ data_uc.data(), data_uc.size() };
+    auto cs_uc = riot::uc128_serializer{ os_uc };
+    idx_uc.accept( cs_uc, 0u );
+
+    expect( os.ok(), equal_to( true ) );
+    // 16 byte keys shrink to 3 byte suffixes
+    auto const kb = riot::unsafe::rd32<riot::LE>( data.data() + os.current_position() - 24 );
+    auto const ob = riot::unsafe::rd32<riot::LE>( data.data() + os.current_position() - 20 );
+    auto const kb_uc = riot::unsafe::rd32<riot::LE>( data_uc.data() + os_uc.current_position() - 24 );
+    auto const ob_uc = riot::unsafe::rd32<riot::LE>( data_uc.data() + os_uc.current_position() - 20 );
+    expect( ( ob - kb ) * 4 < ob_uc - kb_uc, equal_to( true ) );
+
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const iv = riot::make_poly_index_view( bytestring_view{ data.data(), len } );
+    expect( iv->size(), equal_to( 1000u ) );
+    expect( iv->sizeof_domain_value(), equal_to( 16u ) );
+    for( std::uint32_t i = 0; i < 1000; i += 37 ) {
+      expect( iv->lookup_forward_128( net | ( i * 7919u ) ).values(),
+              equal_to( { 16 + i * 100, 24 + i * 100 } ) );
+      expect( iv->lookup_forward_128( net | ( i * 7919u + 1 ) ).empty() );
+    }
+    expect( iv->lookup_forward_128( 1u ).empty() );
+    expect( iv->lookup_forward_128( ~__uint128_t( 0 ) ).empty() );
+    expect( iv->compressed_size_128( net | 7919u ), equal_to( 21u ) );
+
+    std::vector<__uint128_t> keys;
+    iv->collect_keys_128( keys );
+    expect( keys.size(), equal_to( 1000u ) );
+    expect( keys[999] == ( net | ( 999u * 7919u ) ), equal_to( true ) );
+  } );
 } );
 
 } // namespace
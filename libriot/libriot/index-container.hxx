@@ -0,0 +1,473 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// roaring style postings: the 32bit offsets of a key are split into 64k chunks by their upper
+// 16 bits. the lower 16 bits of every chunk are stored in the smallest of three containers:
+//
+//   - ARRAY  : sorted `uint16_t` values ( 2 bytes per offset )
+//   - BITMAP : 65536 bits ( 8k bytes, independent of the cardinality )
+//   - RUN    : sorted `( start, length - 1 )` pairs of `uint16_t` ( 4 bytes per run )
+//
+// set operations work chunk by chunk. intersecting two bitmaps is a word wise `and` plus a
+// `popcount`, arrays are probed against bitmaps. runs only exist on disk and get materialized
+// into an array or a bitmap as soon as they take part in a set operation.
+//
+// bitmaps need dense postings: 64k byte offsets hold at most ~1100 packets, 64k packet ordinals
+// ( see `index-ordinals.hxx` ) are up to 64k packets.
+//
+// serialized chunk: [ hi:2 ][ kind:1 ][ container ] ( little endian ), the cardinality is stored
+// in the record header ( see `index-serializer.hxx` ).
+
+#include <libunclassified/bytestring.hxx>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace riot::container {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+constexpr std::size_t CHUNKLEN = 1u << 16;
+constexpr std::size_t ARRAY_MAX = 4096;
+constexpr std::size_t BITMAP_WORDS = CHUNKLEN / 64;
+constexpr std::size_t BITMAP_SIZE = BITMAP_WORDS * sizeof( std::uint64_t );
+constexpr std::size_t HEADER_SIZE = 3;
+// an array never exceeds the size of a bitmap and neither does a run container
+constexpr std::size_t MAX_ENCODED_SIZE = HEADER_SIZE + BITMAP_SIZE;
+
+struct kind {
+  using type = std::uint8_t;
+  enum : type {
+    ARRAY,
+    BITMAP,
+    RUN,
+  };
+};
+
+struct chunk {
+  std::uint16_t _hi{ 0 };
+  kind::type _kind{ kind::ARRAY };
+  std::uint32_t _cardinality{ 0 };
+  // array values or run pairs
+  std::vector<std::uint16_t> _values{};
+  std::vector<std::uint64_t> _words{};
+
+  constexpr std::uint32_t base() const noexcept { return std::uint32_t( _hi ) << 16; }
+
+  bool contains( std::uint16_t const lo ) const noexcept {
+    switch( _kind ) {
+      case kind::ARRAY: return std::binary_search( _values.begin(), _values.end(), lo );
+      case kind::BITMAP: return ( _words[lo >> 6] >> ( lo & 63 ) ) & 1;
+      case kind::RUN:
+        for( std::size_t i = 0; i < _values.size(); i += 2 ) {
+          if( lo < _values[i] ) { return false; }
+          if( lo <= _values[i] + _values[i + 1] ) { return true; }
+        }
+        return false;
+    }
+    return false;
+  }
+
+  template <typename OutIt>
+  void decode( OutIt out ) const {
+    decode( out, base() );
+  }
+
+  // `b` is or'ed into every value, `0` yields the lower 16 bits only
+  template <typename OutIt>
+  void decode( OutIt out, std::uint32_t const b ) const {
+    switch( _kind ) {
+      case kind::ARRAY:
+        for( auto const lo : _values ) { *out++ = b | lo; }
+        break;
+      case kind::BITMAP:
+        for( std::size_t i = 0; i < BITMAP_WORDS; ++i ) {
+          for( auto w = _words[i]; w != 0; w &= w - 1 ) {
+            *out++ = b | static_cast<std::uint32_t>( ( i << 6 ) + std::countr_zero( w ) );
+          }
+        }
+        break;
+      case kind::RUN:
+        for( std::size_t i = 0; i < _values.size(); i += 2 ) {
+          std::uint32_t const start = _values[i];
+          for( std::uint32_t lo = start; lo <= start + _values[i + 1]; ++lo ) { *out++ = b | lo; }
+        }
+        break;
+    }
+  }
+
+  //--conversions-------------------------------------------------------------
+
+  static chunk from_array( std::uint16_t const hi, std::vector<std::uint16_t>&& values ) {
+    chunk c{ hi, kind::ARRAY, static_cast<std::uint32_t>( values.size() ) };
+    c._values = std::move( values );
+    if( c._cardinality > ARRAY_MAX ) { c.to_bitmap(); }
+    return c;
+  }
+
+  static chunk from_bitmap( std::uint16_t const hi, std::vector<std::uint64_t>&& words ) {
+    chunk c{ hi, kind::BITMAP, 0 };
+    c._words = std::move( words );
+    for( auto const w : c._words ) {
+      c._cardinality += static_cast<std::uint32_t>( std::popcount( w ) );
+    }
+    if( c._cardinality <= ARRAY_MAX ) { c.to_array(); }
+    return c;
+  }
+
+  void to_bitmap() {
+    if( _kind == kind::BITMAP ) { return; }
+    std::vector<std::uint64_t> words( BITMAP_WORDS, 0 );
+    if( _kind == kind::ARRAY ) {
+      for( auto const lo : _values ) { words[lo >> 6] |= 1ull << ( lo & 63 ); }
+    } else {
+      for( std::size_t i = 0; i < _values.size(); i += 2 ) {
+        std::uint32_t const start = _values[i];
+        for( std::uint32_t lo = start; lo <= start + _values[i + 1]; ++lo ) {
+          words[lo >> 6] |= 1ull << ( lo & 63 );
+        }
+      }
+    }
+    _words = std::move( words );
+    _values.clear();
+    _kind = kind::BITMAP;
+  }
+
+  void to_array() {
+    if( _kind == kind::ARRAY ) { return; }
+    std::vector<std::uint16_t> values;
+    values.reserve( _cardinality );
+    decode( std::back_inserter( values ), 0 );
+    _values = std::move( values );
+    _words.clear();
+    _kind = kind::ARRAY;
+  }
+
+  // runs are only worth it for serialization, set operations want arrays or bitmaps
+  void materialize() {
+    if( _kind != kind::RUN ) { return; }
+    if( _cardinality > ARRAY_MAX ) {
+      to_bitmap();
+    } else {
+      to_array();
+    }
+  }
+
+  // pick the smallest container for `values` ( sorted, unique )
+  static chunk select( std::uint16_t const hi, std::uint16_t const* const p, std::size_t const n ) {
+    std::size_t runs = n > 0 ? 1 : 0;
+    for( std::size_t i = 1; i < n; ++i ) { runs += p[i] != p[i - 1] + 1; }
+    auto const array_size = 2 * n;
+    auto const run_size = 4 * runs;
+    chunk c{ hi, kind::ARRAY, static_cast<std::uint32_t>( n ) };
+    if( run_size < std::min( array_size, BITMAP_SIZE ) ) {
+      c._kind = kind::RUN;
+      c._values.reserve( 2 * runs );
+      for( std::size_t i = 0; i < n; ) {
+        auto j = i + 1;
+        while( j < n and p[j] == p[j - 1] + 1 ) { ++j; }
+        c._values.push_back( p[i] );
+        c._values.push_back( static_cast<std::uint16_t>( j - i - 1 ) );
+        i = j;
+      }
+    } else {
+      c._values.assign( p, p + n );
+      if( n > ARRAY_MAX ) { c.to_bitmap(); }
+    }
+    return c;
+  }
+
+  //--serialization-----------------------------------------------------------
+
+  std::size_t encoded_size() const noexcept {
+    switch( _kind ) {
+      case kind::BITMAP: return HEADER_SIZE + BITMAP_SIZE;
+      default: return HEADER_SIZE + _values.size() * sizeof( std::uint16_t );
+    }
+  }
+
+  std::size_t serialize( std::byte* const out ) const noexcept {
+    constexpr auto LE = endianess::LE;
+    unsafe::wr16<LE>( out, _hi );
+    out[2] = std::byte( _kind );
+    auto* p = out + HEADER_SIZE;
+    if( _kind == kind::BITMAP ) {
+      for( auto const w : _words ) {
+        unsafe::wr64<LE>( p, w );
+        p += 8;
+      }
+    } else {
+      for( auto const v : _values ) {
+        unsafe::wr16<LE>( p, v );
+        p += 2;
+      }
+    }
+    return static_cast<std::size_t>( p - out );
+  }
+
+  // `n` is the size of the serialized chunk, `cardinality` comes from the record header
+  static bool deserialize( std::byte const* const in, std::size_t const n,
+                           std::size_t const cardinality, chunk& c ) {
+    constexpr auto LE = endianess::LE;
+    if( n < HEADER_SIZE or cardinality == 0 or cardinality > CHUNKLEN ) { return false; }
+    c._hi = unsafe::rd16<LE>( in );
+    c._kind = static_cast<kind::type>( in[2] );
+    c._cardinality = static_cast<std::uint32_t>( cardinality );
+    c._values.clear();
+    c._words.clear();
+    auto const* p = in + HEADER_SIZE;
+    auto const size = n - HEADER_SIZE;
+    switch( c._kind ) {
+      case kind::ARRAY:
+        if( size != cardinality * 2 ) { return false; }
+        break;
+      case kind::RUN:
+        if( size % 4 != 0 ) { return false; }
+        break;
+      case kind::BITMAP:
+        if( size != BITMAP_SIZE ) { return false; }
+        c._words.resize( BITMAP_WORDS );
+        for( auto& w : c._words ) {
+          w = unsafe::rd64<LE>( p );
+          p += 8;
+        }
+        return true;
+      default: return false;
+    }
+    c._values.resize( size / 2 );
+    for( auto& v : c._values ) {
+      v = unsafe::rd16<LE>( p );
+      p += 2;
+    }
+    return true;
+  }
+
+  // decode a serialized chunk straight into absolute offsets
+  template <typename OutIt>
+  static bool expand( std::byte const* const in, std::size_t const n, std::size_t const cardinality,
+                      OutIt out ) {
+    constexpr auto LE = endianess::LE;
+    if( n < HEADER_SIZE ) { return false; }
+    std::uint32_t const b = std::uint32_t( unsafe::rd16<LE>( in ) ) << 16;
+    auto const* p = in + HEADER_SIZE;
+    auto const* const end = in + n;
+    switch( static_cast<kind::type>( in[2] ) ) {
+      case kind::ARRAY:
+        for( std::size_t i = 0; i < cardinality and p + 2 <= end; ++i, p += 2 ) {
+          *out++ = b | unsafe::rd16<LE>( p );
+        }
+        return true;
+      case kind::RUN:
+        for( ; p + 4 <= end; p += 4 ) {
+          std::uint32_t const start = unsafe::rd16<LE>( p );
+          std::uint32_t const last = start + unsafe::rd16<LE>( p + 2 );
+          for( auto lo = start; lo <= last; ++lo ) { *out++ = b | lo; }
+        }
+        return true;
+      case kind::BITMAP:
+        if( n - HEADER_SIZE != BITMAP_SIZE ) { return false; }
+        for( std::size_t i = 0; i < BITMAP_WORDS; ++i, p += 8 ) {
+          for( auto w = unsafe::rd64<LE>( p ); w != 0; w &= w - 1 ) {
+            *out++ = b | static_cast<std::uint32_t>( ( i << 6 ) + std::countr_zero( w ) );
+          }
+        }
+        return true;
+      default: return false;
+    }
+  }
+};
+
+//--chunk-wise-set-operations---------------------------------------------------
+
+namespace detail {
+
+inline std::uint64_t bit( std::uint16_t const lo ) noexcept { return 1ull << ( lo & 63 ); }
+
+inline chunk intersect( chunk a, chunk b ) {
+  a.materialize();
+  b.materialize();
+  if( a._kind == kind::ARRAY and b._kind == kind::ARRAY ) {
+    std::vector<std::uint16_t> r;
+    r.reserve( std::min( a._values.size(), b._values.size() ) );
+    std::set_intersection( a._values.begin(), a._values.end(), b._values.begin(), b._values.end(),
+                           std::back_inserter( r ) );
+    return chunk::from_array( a._hi, std::move( r ) );
+  }
+  if( a._kind == kind::BITMAP and b._kind == kind::BITMAP ) {
+    std::vector<std::uint64_t> r( BITMAP_WORDS );
+    for( std::size_t i = 0; i < BITMAP_WORDS; ++i ) { r[i] = a._words[i] & b._words[i]; }
+    return chunk::from_bitmap( a._hi, std::move( r ) );
+  }
+  auto const& array = a._kind == kind::ARRAY ? a : b;
+  auto const& bitmap = a._kind == kind::ARRAY ? b : a;
+  std::vector<std::uint16_t> r;
+  r.reserve( array._values.size() );
+  for( auto const lo : array._values ) {
+    if( bitmap._words[lo >> 6] & bit( lo ) ) { r.push_back( lo ); }
+  }
+  return chunk::from_array( a._hi, std::move( r ) );
+}
+
+inline chunk unite( chunk a, chunk b ) {
+  a.materialize();
+  b.materialize();
+  if( a._kind == kind::ARRAY and b._kind == kind::ARRAY ) {
+    std::vector<std::uint16_t> r;
+    r.reserve( a._values.size() + b._values.size() );
+    std::set_union( a._values.begin(), a._values.end(), b._values.begin(), b._values.end(),
+                    std::back_inserter( r ) );
+    return chunk::from_array( a._hi, std::move( r ) );
+  }
+  a.to_bitmap();
+  b.to_bitmap();
+  for( std::size_t i = 0; i < BITMAP_WORDS; ++i ) { a._words[i] |= b._words[i]; }
+  return chunk::from_bitmap( a._hi, std::move( a._words ) );
+}
+
+inline chunk subtract( chunk a, chunk b ) {
+  a.materialize();
+  b.materialize();
+  if( a._kind == kind::ARRAY ) {
+    std::vector<std::uint16_t> r;
+    r.reserve( a._values.size() );
+    if( b._kind == kind::ARRAY ) {
+      std::set_difference( a._values.begin(), a._values.end(), b._values.begin(), b._values.end(),
+                           std::back_inserter( r ) );
+    } else {
+      for( auto const lo : a._values ) {
+        if( not( b._words[lo >> 6] & bit( lo ) ) ) { r.push_back( lo ); }
+      }
+    }
+    return chunk::from_array( a._hi, std::move( r ) );
+  }
+  if( b._kind == kind::ARRAY ) {
+    for( auto const lo : b._values ) { a._words[lo >> 6] &= ~bit( lo ); }
+  } else {
+    for( std::size_t i = 0; i < BITMAP_WORDS; ++i ) { a._words[i] &= ~b._words[i]; }
+  }
+  return chunk::from_bitmap( a._hi, std::move( a._words ) );
+}
+
+} // namespace detail
+
+//--posting-sets----------------------------------------------------------------
+
+class posting_set {
+  std::vector<chunk> _chunks;
+
+ public:
+  using value_type = std::uint32_t;
+
+  posting_set() = default;
+  explicit posting_set( std::vector<chunk>&& chunks ) : _chunks{ std::move( chunks ) } {}
+
+  // `p` needs to be sorted, duplicates are dropped
+  static posting_set from_sorted( value_type const* const p, std::size_t const n ) {
+    std::vector<chunk> chunks;
+    std::vector<std::uint16_t> lows;
+    std::size_t i = 0;
+    while( i < n ) {
+      auto const hi = static_cast<std::uint16_t>( p[i] >> 16 );
+      lows.clear();
+      for( ; i < n and ( p[i] >> 16 ) == hi; ++i ) {
+        auto const lo = static_cast<std::uint16_t>( p[i] );
+        if( lows.empty() or lows.back() != lo ) { lows.push_back( lo ); }
+      }
+      chunks.push_back( chunk::select( hi, lows.data(), lows.size() ) );
+    }
+    return posting_set{ std::move( chunks ) };
+  }
+
+  auto const& chunks() const noexcept { return _chunks; }
+  auto& chunks() noexcept { return _chunks; }
+
+  std::size_t size() const noexcept {
+    std::size_t n = 0;
+    for( auto const& c : _chunks ) { n += c._cardinality; }
+    return n;
+  }
+
+  bool empty() const noexcept { return _chunks.empty(); }
+
+  bool contains( value_type const v ) const noexcept {
+    auto const hi = static_cast<std::uint16_t>( v >> 16 );
+    auto it = std::lower_bound( _chunks.begin(), _chunks.end(), hi,
+                                []( auto const& c, auto const h ) { return c._hi < h; } );
+    if( it == _chunks.end() or it->_hi != hi ) { return false; }
+    return it->contains( static_cast<std::uint16_t>( v ) );
+  }
+
+  template <typename OutIt>
+  void decode( OutIt out ) const {
+    for( auto const& c : _chunks ) { c.decode( out ); }
+  }
+
+  std::vector<value_type> values() const {
+    std::vector<value_type> r;
+    r.reserve( size() );
+    decode( std::back_inserter( r ) );
+    return r;
+  }
+
+  //--set-operations----------------------------------------------------------
+
+  static posting_set set_intersection( posting_set const& a, posting_set const& b ) {
+    std::vector<chunk> r;
+    auto it_a = a._chunks.begin();
+    auto it_b = b._chunks.begin();
+    while( it_a != a._chunks.end() and it_b != b._chunks.end() ) {
+      if( it_a->_hi < it_b->_hi ) {
+        ++it_a;
+      } else if( it_b->_hi < it_a->_hi ) {
+        ++it_b;
+      } else {
+        if( auto c = detail::intersect( *it_a, *it_b ); c._cardinality > 0 ) {
+          r.push_back( std::move( c ) );
+        }
+        ++it_a;
+        ++it_b;
+      }
+    }
+    return posting_set{ std::move( r ) };
+  }
+
+  static posting_set set_union( posting_set const& a, posting_set const& b ) {
+    std::vector<chunk> r;
+    r.reserve( a._chunks.size() + b._chunks.size() );
+    auto it_a = a._chunks.begin();
+    auto it_b = b._chunks.begin();
+    while( it_a != a._chunks.end() or it_b != b._chunks.end() ) {
+      if( it_b == b._chunks.end() or ( it_a != a._chunks.end() and it_a->_hi < it_b->_hi ) ) {
+        r.push_back( *it_a++ );
+      } else if( it_a == a._chunks.end() or it_b->_hi < it_a->_hi ) {
+        r.push_back( *it_b++ );
+      } else {
+        r.push_back( detail::unite( *it_a++, *it_b++ ) );
+      }
+    }
+    return posting_set{ std::move( r ) };
+  }
+
+  static posting_set set_complement( posting_set const& a, posting_set const& b ) {
+    std::vector<chunk> r;
+    r.reserve( a._chunks.size() );
+    auto it_b = b._chunks.begin();
+    for( auto const& c : a._chunks ) {
+      while( it_b != b._chunks.end() and it_b->_hi < c._hi ) { ++it_b; }
+      if( it_b == b._chunks.end() or it_b->_hi != c._hi ) {
+        r.push_back( c );
+      } else if( auto d = detail::subtract( c, *it_b ); d._cardinality > 0 ) {
+        r.push_back( std::move( d ) );
+      }
+    }
+    return posting_set{ std::move( r ) };
+  }
+};
+
+} // namespace riot::container
@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/index-container.hxx>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+using posting_set = riot::container::posting_set;
+using kind = riot::container::kind;
+using chunk = riot::container::chunk;
+
+posting_set make( std::vector<std::uint32_t> const& values ) {
+  return posting_set::from_sorted( values.data(), values.size() );
+}
+
+// every `step`th offset in [ first, first + n * step )
+std::vector<std::uint32_t> every( std::uint32_t const first, std::size_t const n,
+                                  std::uint32_t const step ) {
+  std::vector<std::uint32_t> r;
+  for( std::size_t i = 0; i < n; ++i ) {
+    r.push_back( first + static_cast<std::uint32_t>( i ) * step );
+  }
+  return r;
+}
+
+emptyspace::pest::suite basic( "index-container basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "container selection", []( auto& expect ) {
+    // sparse: array
+    auto const a = make( { 1u, 300u, 70000u } );
+    expect( a.chunks().size(), equal_to( 2u ) );
+    expect( a.chunks()[0]._kind, equal_to( kind::ARRAY ) );
+    expect( a.chunks()[1]._hi, equal_to( 1u ) );
+    expect( a.size(), equal_to( 3u ) );
+    // dense: bitmap
+    auto const b = make( every( 0, 10000, 3 ) );
+    expect( b.chunks().size(), equal_to( 1u ) );
+    expect( b.chunks()[0]._kind, equal_to( kind::BITMAP ) );
+    expect( b.size(), equal_to( 10000u ) );
+    // consecutive: run
+    auto const c = make( every( 0x20000u, 9000, 1 ) );
+    expect( c.chunks()[0]._kind, equal_to( kind::RUN ) );
+    expect( c.chunks()[0]._values.size(), equal_to( 2u ) );
+    expect( c.values() == every( 0x20000u, 9000, 1 ), equal_to( true ) );
+  } );
+
+  test( "duplicates are dropped", []( auto& expect ) {
+    auto const a = make( { 7u, 7u, 8u, 0x10000u, 0x10000u } );
+    expect( a.values(), equal_to( { 7u, 8u, 0x10000u } ) );
+  } );
+
+  test( "serialize and expand", []( auto& expect ) {
+    std::array<std::byte, riot::container::MAX_ENCODED_SIZE> buf;
+    for( auto const& values : { std::vector<std::uint32_t>{ 0x30001u, 0x30005u },
+                                every( 0x40000u, 10000, 5 ), every( 0x50010u, 100, 1 ) } ) {
+      auto const set = make( values );
+      auto const& c = set.chunks()[0];
+      auto const n = c.serialize( buf.data() );
+      expect( n, equal_to( c.encoded_size() ) );
+      std::vector<std::uint32_t> expanded;
+      expect( chunk::expand( buf.data(), n, c._cardinality, std::back_inserter( expanded ) ) );
+      expect( expanded == values, equal_to( true ) );
+      chunk d;
+      expect( chunk::deserialize( buf.data(), n, c._cardinality, d ) );
+      expect( d._kind, equal_to( c._kind ) );
+      expect( posting_set{ { d } }.values() == values, equal_to( true ) );
+    }
+  } );
+
+  test( "serialized array layout", []( auto& expect ) {
+    std::array<std::byte, riot::container::MAX_ENCODED_SIZE> buf;
+    auto const set = make( { 0x30001u, 0x30005u } );
+    auto const n = set.chunks()[0].serialize( buf.data() );
+    expect( hexify( buf, n ), equal_to( "03000001000500" ) );
+  } );
+
+  test( "intersection", []( auto& expect ) {
+    auto const dense_a = make( every( 0, 20000, 3 ) );
+    auto const dense_b = make( every( 0, 20000, 2 ) );
+    auto const sparse = make( { 6u, 7u, 12u, 70000u } );
+    auto const run = make( every( 0, 9000, 1 ) );
+
+    // bitmap & bitmap
+    auto const ab = posting_set::set_intersection( dense_a, dense_b );
+    expect( ab.size(), equal_to( 6667u ) );
+    expect( ab.chunks()[0]._kind, equal_to( kind::BITMAP ) );
+    expect( ab.contains( 6u ) );
+    expect( not ab.contains( 9u ) );
+
+    // array & bitmap
+    expect( posting_set::set_intersection( sparse, dense_a ).values(), equal_to( { 6u, 12u } ) );
+    expect( posting_set::set_intersection( dense_b, sparse ).values(), equal_to( { 6u, 12u } ) );
+
+    // run & bitmap
+    auto const ra = posting_set::set_intersection( run, dense_a );
+    expect( ra.size(), equal_to( 3000u ) );
+    expect( ra.chunks()[0]._kind, equal_to( kind::ARRAY ) );
+
+    std::vector<std::uint32_t> expected;
+    auto const va = dense_a.values();
+    auto const vb = dense_b.values();
+    std::set_intersection( va.begin(), va.end(), vb.begin(), vb.end(),
+                           std::back_inserter( expected ) );
+    expect( ab.values() == expected, equal_to( true ) );
+  } );
+
+  test( "union and complement", []( auto& expect ) {
+    auto const a = make( { 1u, 2u, 3u, 70000u } );
+    auto const b = make( { 3u, 4u, 140000u } );
+    expect( posting_set::set_union( a, b ).values(),
+            equal_to( { 1u, 2u, 3u, 4u, 70000u, 140000u } ) );
+    expect( posting_set::set_complement( a, b ).values(), equal_to( { 1u, 2u, 70000u } ) );
+
+    auto const dense = make( every( 0, 6000, 2 ) );
+    auto const odd = make( every( 1, 6000, 2 ) );
+    auto const all = posting_set::set_union( dense, odd );
+    expect( all.size(), equal_to( 12000u ) );
+    expect( all.chunks()[0]._kind, equal_to( kind::BITMAP ) );
+    auto const back = posting_set::set_complement( all, odd );
+    expect( back.values() == dense.values(), equal_to( true ) );
+    expect( posting_set::set_complement( dense, all ).empty() );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
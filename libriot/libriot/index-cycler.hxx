@@ -4,6 +4,7 @@
 
 #include <libnygma/bytestream.hxx>
 #include <libriot/index-builder.hxx>
+#include <libriot/index-serializer.hxx>
 
 #include <condition_variable>
 #include <deque>
@@ -121,6 +122,10 @@ class index_cycler {
     : _w{ w }, _directory{ directory }, _prefix{ prefix }, _suffix{ suffix }, _count{ 0 } {}
 
   auto count() const noexcept { return _count; }
+  auto const& suffix() const noexcept { return _suffix; }
+
+  // the common prefix of all index file paths ( without segment number and suffix )
+  std::filesystem::path stem() const { return _directory / _prefix; }
 
   template <template <typename OS = nygma::cfile_ostream> typename S, typename I>
   void accept( std::unique_ptr<I> i, std::uint64_t const segment_offset ) noexcept {
@@ -130,7 +135,8 @@ class index_cycler {
     // where the worker is live but `this` may have already been destructed.
     _w->send( [p = std::move( p ), d = i.get_deleter(), i = i.release(), segment_offset]() {
       nygma::cfile_ostream o{ p };
-      S<nygma::cfile_ostream> s{ o };
+      // every segment gets a key filter ( see `index-filter.hxx` )
+      filtering_serializer<S<nygma::cfile_ostream>> s{ o };
       i->accept( s, segment_offset );
       d( i );
     } );
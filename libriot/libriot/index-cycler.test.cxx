@@ -3,6 +3,7 @@
 #include <pest/pest.hxx>
 
 #include <libriot/index-cycler.hxx>
+#include <libriot/index-directory.hxx>
 #include <libriot/index-serializer.hxx>
 
 #include <map>
@@ -24,6 +25,7 @@ emptyspace::pest::suite basic( "index-cycler suite", []( auto& test ) {
     riot::index_cycler cyc( "/tmp", "index", ".i4" );
     expect( cyc.count(), equal_to( 0u ) );
     expect( cyc.path(), equal_to( "/tmp/index-0000.i4" ) );
+    expect( riot::directory::path( cyc.stem(), cyc.suffix() ), equal_to( "/tmp/index.i4d" ) );
   } );
 
   test( "the index-cycler accepts an index-builder", []( auto& expect ) {
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// a per capture key -> segment directory. for every key it stores the numbers of the segments
+// ( `-NNNN.i4` files ) containing the key as roaring style containers ( see
+// `index-container.hxx` ). point queries consult it to open only the segments that can contain
+// hits.
+//
+//   [ MAGIC:4 ][ keysize:1 ][ reserved:3 ][ segments:4 ][ keys:4 ]
+//   [ key:keysize ] x keys                                          <- sorted
+//   [ offset:4 ] x ( keys + 1 )                                     <- relative to the records
+//   [ cardinality:4 ][ size:4 ][ chunk:size ] x chunks x keys       <- records
+
+#include <libnygma/bytestream.hxx>
+#include <libnygma/mmap.hxx>
+#include <libriot/index-container.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <array>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace riot {
+
+namespace unsafe = unclassified::unsafe;
+
+namespace directory {
+
+constexpr std::uint32_t MAGIC = 0x13371338u;
+constexpr std::size_t HEADER_SIZE = 16;
+constexpr std::size_t RECORD_HEADER_SIZE = 8;
+
+// the directory belonging to the index files `<stem>-NNNN<suffix>`
+inline std::filesystem::path path( std::filesystem::path const& stem,
+                                   std::string_view const suffix ) {
+  auto p = stem;
+  p += suffix;
+  p += "d";
+  return p;
+}
+
+// keys are stored little endian, 128bit keys as a whole
+template <typename Key>
+inline void write_key( std::byte* const p, Key const k ) noexcept {
+  constexpr auto LE = unclassified::endianess::LE;
+  if constexpr( sizeof( Key ) == 16 ) {
+    unsafe::wr128<LE>( p, k );
+  } else {
+    unsafe::wr32<LE>( p, k );
+  }
+}
+
+template <typename Key>
+inline Key read_key( std::byte const* const p ) noexcept {
+  constexpr auto LE = unclassified::endianess::LE;
+  if constexpr( sizeof( Key ) == 16 ) {
+    return unsafe::rd128<LE>( p );
+  } else {
+    return unsafe::rd32<LE>( p );
+  }
+}
+
+} // namespace directory
+
+template <typename KeyType>
+class directory_builder {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+ public:
+  using key_type = KeyType;
+  using segment_type = std::uint32_t;
+
+ private:
+  std::map<key_type, std::vector<segment_type>> _segments;
+  segment_type _segment_count{ 0 };
+
+ public:
+  // segments need to be added in ascending order
+  void add( key_type const k, segment_type const segment ) {
+    auto& s = _segments[k];
+    if( s.empty() or s.back() != segment ) { s.push_back( segment ); }
+    _segment_count = std::max( _segment_count, segment + 1 );
+  }
+
+  // all keys of the index builder of `segment`, call this before the index builder gets accepted
+  template <typename IndexBuilder>
+  void add_segment( IndexBuilder const& index, segment_type const segment ) {
+    index.for_each_key( [&]( auto const k ) { add( k, segment ); } );
+    _segment_count = std::max( _segment_count, segment + 1 );
+  }
+
+  auto key_count() const noexcept { return _segments.size(); }
+  auto segment_count() const noexcept { return _segment_count; }
+
+  template <typename OStream>
+  void accept( OStream& os ) const {
+    std::vector<std::byte> keys( sizeof( key_type ) * _segments.size() );
+    std::vector<std::byte> offsets( 4 * ( _segments.size() + 1 ) );
+    std::vector<std::byte> records;
+    std::array<std::byte, container::MAX_ENCODED_SIZE> scrtch;
+    std::size_t i = 0;
+    for( auto const& [k, segments] : _segments ) {
+      directory::write_key( keys.data() + sizeof( key_type ) * i, k );
+      unsafe::wr32<LE>( offsets.data() + 4 * i, static_cast<std::uint32_t>( records.size() ) );
+      auto const set = container::posting_set::from_sorted( segments.data(), segments.size() );
+      for( auto const& c : set.chunks() ) {
+        auto const n = c.serialize( scrtch.data() );
+        std::byte header[directory::RECORD_HEADER_SIZE];
+        unsafe::wr32<LE>( header, c._cardinality );
+        unsafe::wr32<LE>( header + 4, static_cast<std::uint32_t>( n ) );
+        records.insert( records.end(), header, header + directory::RECORD_HEADER_SIZE );
+        records.insert( records.end(), scrtch.data(), scrtch.data() + n );
+      }
+      ++i;
+    }
+    unsafe::wr32<LE>( offsets.data() + 4 * i, static_cast<std::uint32_t>( records.size() ) );
+
+    std::byte header[directory::HEADER_SIZE]{};
+    unsafe::wr32<LE>( header, directory::MAGIC );
+    header[4] = std::byte( sizeof( key_type ) );
+    unsafe::wr32<LE>( header + 8, _segment_count );
+    unsafe::wr32<LE>( header + 12, static_cast<std::uint32_t>( _segments.size() ) );
+    os.write( header, directory::HEADER_SIZE );
+    os.write( keys.data(), keys.size() );
+    os.write( offsets.data(), offsets.size() );
+    os.write( records.data(), records.size() );
+  }
+
+  bool write( std::filesystem::path const& p ) const {
+    nygma::cfile_ostream os{ p };
+    accept( os );
+    return os.ok();
+  }
+};
+
+//--read-only-access------------------------------------------------------------
+
+template <typename KeyType>
+class directory_view {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+ public:
+  using key_type = KeyType;
+  using segment_type = std::uint32_t;
+
+ private:
+  std::byte const* _keys{ nullptr };
+  std::byte const* _offsets{ nullptr };
+  std::byte const* _records{ nullptr };
+  std::size_t _records_size{ 0 };
+  std::size_t _key_count{ 0 };
+  segment_type _segment_count{ 0 };
+
+  key_type key( std::size_t const i ) const noexcept {
+    return directory::read_key<key_type>( _keys + sizeof( key_type ) * i );
+  }
+
+ public:
+  directory_view() = default;
+
+  // an invalid view for truncated or foreign data
+  explicit directory_view( unclassified::bytestring_view const data ) noexcept {
+    if( data.size() < directory::HEADER_SIZE ) { return; }
+    auto const* const p = data.begin();
+    if( unsafe::rd32<LE>( p ) != directory::MAGIC ) { return; }
+    if( static_cast<std::size_t>( p[4] ) != sizeof( key_type ) ) { return; }
+    std::size_t const keys = unsafe::rd32<LE>( p + 12 );
+    auto const records = directory::HEADER_SIZE + keys * sizeof( key_type ) + 4 * ( keys + 1 );
+    if( records > data.size() ) { return; }
+    _keys = p + directory::HEADER_SIZE;
+    _offsets = _keys + keys * sizeof( key_type );
+    _records = p + records;
+    _records_size = data.size() - records;
+    _key_count = keys;
+    _segment_count = unsafe::rd32<LE>( p + 8 );
+  }
+
+  bool valid() const noexcept { return _keys != nullptr; }
+  auto key_count() const noexcept { return _key_count; }
+  auto segment_count() const noexcept { return _segment_count; }
+
+  // appends the segments containing `k` ( ascending ), unknown keys have no segments. `false` if
+  // the directory can not tell ( invalid view, corrupted records )
+  bool lookup( key_type const k, std::vector<segment_type>& segments ) const {
+    if( not valid() ) { return false; }
+    std::size_t lo = 0;
+    std::size_t hi = _key_count;
+    while( lo < hi ) {
+      auto const mid = lo + ( hi - lo ) / 2;
+      if( key( mid ) < k ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if( lo == _key_count or k < key( lo ) ) { return true; }
+    std::size_t const begin = unsafe::rd32<LE>( _offsets + 4 * lo );
+    std::size_t const end = unsafe::rd32<LE>( _offsets + 4 * ( lo + 1 ) );
+    if( begin > end or end > _records_size ) { return false; }
+    auto const* p = _records + begin;
+    auto const* const last = _records + end;
+    while( p < last ) {
+      if( p + directory::RECORD_HEADER_SIZE > last ) { return false; }
+      auto const cardinality = unsafe::rd32<LE>( p );
+      std::size_t const n = unsafe::rd32<LE>( p + 4 );
+      p += directory::RECORD_HEADER_SIZE;
+      if( p + n > last ) { return false; }
+      if( not container::chunk::expand( p, n, cardinality, std::back_inserter( segments ) ) ) {
+        return false;
+      }
+      p += n;
+    }
+    return true;
+  }
+};
+
+// owns the mapping of a directory file
+template <typename KeyType>
+class directory_handle {
+  std::unique_ptr<nygma::mmap_view> _map;
+  directory_view<KeyType> _view;
+
+ public:
+  explicit directory_handle( std::filesystem::path const& path )
+    : _map{ std::make_unique<nygma::mmap_view>( path ) }, _view{ _map->view() } {}
+
+  auto const& operator*() const noexcept { return _view; }
+  auto const* operator->() const noexcept { return &_view; }
+};
+
+} // namespace riot
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/index-builder.hxx>
+#include <libriot/index-directory.hxx>
+
+#include <map>
+#include <vector>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using bytestring_view = unclassified::bytestring_view;
+using index_type = riot::index_builder<std::uint32_t, map_type, 128>;
+
+template <typename Builder, std::size_t N>
+std::size_t serialize( std::byte ( &data )[N], Builder const& dir ) {
+  auto os = nygma::cfile_ostream{ data };
+  dir.accept( os );
+  return static_cast<std::size_t>( os.current_position() );
+}
+
+emptyspace::pest::suite basic( "index-directory basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "keys of index builders", []( auto& expect ) {
+    riot::directory_builder<std::uint32_t> dir;
+    for( std::uint32_t segment = 0; segment < 50; ++segment ) {
+      index_type idx;
+      // `1` is everywhere, `2` in every 10th segment, `3` only in the last one
+      idx.add( 1u, 16 );
+      if( segment % 10 == 0 ) { idx.add( 2u, 24 ); }
+      if( segment == 49 ) { idx.add( 3u, 32 ); }
+      idx.add( 1u, 400 );
+      dir.add_segment( idx, segment );
+    }
+    expect( dir.key_count(), equal_to( 3u ) );
+    expect( dir.segment_count(), equal_to( 50u ) );
+
+    std::byte data[1024];
+    auto const len = serialize( data, dir );
+    riot::directory_view<std::uint32_t> const view{ bytestring_view{ data, len } };
+    expect( view.valid() );
+    expect( view.key_count(), equal_to( 3u ) );
+    expect( view.segment_count(), equal_to( 50u ) );
+
+    std::vector<std::uint32_t> segments;
+    expect( view.lookup( 2u, segments ) );
+    expect( segments, equal_to( { 0u, 10u, 20u, 30u, 40u } ) );
+    segments.clear();
+    expect( view.lookup( 3u, segments ) );
+    expect( segments, equal_to( { 49u } ) );
+    segments.clear();
+    expect( view.lookup( 1u, segments ) );
+    expect( segments.size(), equal_to( 50u ) );
+    // unknown keys are in no segment
+    segments.clear();
+    expect( view.lookup( 42u, segments ) );
+    expect( segments.empty() );
+  } );
+
+  test( "128bit keys", []( auto& expect ) {
+    riot::directory_builder<__uint128_t> dir;
+    __uint128_t const k = ( __uint128_t( 0x20010db8u ) << 96 ) | 1u;
+    dir.add( k, 3 );
+    dir.add( k, 3 );
+    dir.add( k, 7 );
+    dir.add( 1u, 5 );
+
+    std::byte data[256];
+    auto const len = serialize( data, dir );
+    riot::directory_view<__uint128_t> const view{ bytestring_view{ data, len } };
+    expect( view.valid() );
+    expect( view.segment_count(), equal_to( 8u ) );
+    std::vector<std::uint32_t> segments;
+    expect( view.lookup( k, segments ) );
+    expect( segments, equal_to( { 3u, 7u } ) );
+    // keys are little endian, `1` sorts first
+    auto const* const keys = data + riot::directory::HEADER_SIZE;
+    expect( keys[0], equal_to( std::byte{ 1 } ) );
+    expect( keys[16], equal_to( std::byte{ 1 } ) );
+    expect( keys[31], equal_to( std::byte{ 0x20 } ) );
+
+    // the key size has to match
+    expect( not riot::directory_view<std::uint32_t>{ bytestring_view{ data, len } }.valid() );
+  } );
+
+  test( "invalid directories", []( auto& expect ) {
+    riot::directory_builder<std::uint32_t> dir;
+    dir.add( 1u, 0 );
+    dir.add( 2u, 1 );
+
+    std::byte data[256];
+    auto const len = serialize( data, dir );
+    std::vector<std::uint32_t> segments;
+    // truncated records
+    riot::directory_view<std::uint32_t> const truncated{ bytestring_view{ data, len - 2 } };
+    expect( truncated.valid() );
+    expect( not truncated.lookup( 2u, segments ) );
+    // truncated header
+    expect( not riot::directory_view<std::uint32_t>{ bytestring_view{ data, 8 } }.valid() );
+    // foreign data
+    data[0] = std::byte{ 0x42 };
+    riot::directory_view<std::uint32_t> const foreign{ bytestring_view{ data, len } };
+    expect( not foreign.valid() );
+    expect( not foreign.lookup( 1u, segments ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// a split block bloom filter over the key set of an index segment. every key sets 8 bits in a
+// single 256bit block ( one bit per 32bit word ), probing a key touches one cache line only. with
+// `BITS_PER_KEY = 16` the false positive rate is ~0.1%.
+//
+//   [ blocks:4 ][ word:4 x 8 ] x blocks
+//
+// the index serializer writes it as optional trailer in front of the META record ( see
+// `filtering_serializer` ), `index_view_handle` probes it before any key block gets decoded.
+
+#include <libunclassified/bytestring.hxx>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <immintrin.h>
+
+namespace riot::filter {
+
+namespace unsafe = unclassified::unsafe;
+using endianess = unclassified::endianess;
+
+constexpr std::size_t BITS_PER_KEY = 16;
+constexpr std::size_t BLOCK_SIZE = 32;
+constexpr std::size_t HEADER_SIZE = 4;
+
+namespace detail {
+
+constexpr auto LE = endianess::LE;
+
+alignas( 32 ) constexpr std::uint32_t SALT[8] = { 0x47b6137bu, 0x44974d91u, 0x8824ad5bu,
+                                                  0xa2b7289du, 0x705495c7u, 0x2df1424bu,
+                                                  0x9efc4947u, 0x5c6bfb31u };
+
+// murmur3 finalizer
+constexpr std::uint64_t mix( std::uint64_t x ) noexcept {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+constexpr std::uint64_t hash( std::uint32_t const k ) noexcept { return mix( k ); }
+constexpr std::uint64_t hash( std::uint64_t const k ) noexcept { return mix( k ); }
+constexpr std::uint64_t hash( __uint128_t const k ) noexcept {
+  return mix( static_cast<std::uint64_t>( k ) ^ mix( static_cast<std::uint64_t>( k >> 64 ) ) );
+}
+
+constexpr std::size_t block_of( std::uint64_t const h, std::size_t const blocks ) noexcept {
+  return static_cast<std::size_t>( ( ( h >> 32 ) * blocks ) >> 32 );
+}
+
+constexpr std::uint32_t bit_of( std::uint64_t const h, std::size_t const i ) noexcept {
+  return 1u << ( ( static_cast<std::uint32_t>( h ) * SALT[i] ) >> 27 );
+}
+
+} // namespace detail
+
+// number of blocks for `n` keys
+constexpr std::size_t block_count( std::size_t const n ) noexcept {
+  auto const blocks = ( n * BITS_PER_KEY + 8 * BLOCK_SIZE - 1 ) / ( 8 * BLOCK_SIZE );
+  return blocks == 0 ? 1 : blocks;
+}
+
+constexpr std::size_t encoded_size( std::size_t const n ) noexcept {
+  return HEADER_SIZE + BLOCK_SIZE * block_count( n );
+}
+
+// `out` needs `encoded_size( n )` bytes
+template <typename KeyType>
+std::size_t encode( KeyType const* const keys, std::size_t const n, std::byte* const out ) noexcept {
+  using detail::LE;
+  auto const blocks = block_count( n );
+  unsafe::wr32<LE>( out, static_cast<std::uint32_t>( blocks ) );
+  auto* const data = out + HEADER_SIZE;
+  std::memset( data, 0, BLOCK_SIZE * blocks );
+  for( std::size_t i = 0; i < n; ++i ) {
+    auto const h = detail::hash( keys[i] );
+    auto* const block = data + BLOCK_SIZE * detail::block_of( h, blocks );
+    for( std::size_t w = 0; w < 8; ++w ) {
+      unsafe::wr32<LE>( block + 4 * w, unsafe::rd32<LE>( block + 4 * w ) | detail::bit_of( h, w ) );
+    }
+  }
+  return HEADER_SIZE + BLOCK_SIZE * blocks;
+}
+
+template <typename KeyType>
+std::vector<std::byte> encode( std::vector<KeyType> const& keys ) {
+  std::vector<std::byte> out( encoded_size( keys.size() ) );
+  encode( keys.data(), keys.size(), out.data() );
+  return out;
+}
+
+//--read-only-access------------------------------------------------------------
+
+class view {
+  std::byte const* _blocks{ nullptr };
+  std::size_t _block_count{ 0 };
+
+ public:
+  view() = default;
+
+  // an invalid view ( which contains everything ) for truncated data
+  view( std::byte const* const p, std::size_t const n ) noexcept {
+    if( n < HEADER_SIZE ) { return; }
+    std::size_t const blocks = unsafe::rd32<detail::LE>( p );
+    if( blocks == 0 or HEADER_SIZE + BLOCK_SIZE * blocks != n ) { return; }
+    _blocks = p + HEADER_SIZE;
+    _block_count = blocks;
+  }
+
+  bool valid() const noexcept { return _blocks != nullptr; }
+  std::size_t size() const noexcept { return HEADER_SIZE + BLOCK_SIZE * _block_count; }
+
+  // `false` only if `k` is definitely not in the key set
+  template <typename KeyType>
+  bool may_contain( KeyType const k ) const noexcept {
+    if( not valid() ) { return true; }
+    auto const h = detail::hash( k );
+    auto const* const block = _blocks + BLOCK_SIZE * detail::block_of( h, _block_count );
+#if defined( __AVX2__ )
+    auto const salt = _mm256_load_si256( reinterpret_cast<__m256i const*>( detail::SALT ) );
+    auto const x = _mm256_set1_epi32( static_cast<int>( static_cast<std::uint32_t>( h ) ) );
+    auto const shift = _mm256_srli_epi32( _mm256_mullo_epi32( x, salt ), 27 );
+    auto const mask = _mm256_sllv_epi32( _mm256_set1_epi32( 1 ), shift );
+    auto const bits = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( block ) );
+    return _mm256_testc_si256( bits, mask ) != 0;
+#else
+    for( std::size_t w = 0; w < 8; ++w ) {
+      if( ( unsafe::rd32<detail::LE>( block + 4 * w ) & detail::bit_of( h, w ) ) == 0 ) {
+        return false;
+      }
+    }
+    return true;
+#endif
+  }
+};
+
+} // namespace riot::filter
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/index-filter.hxx>
+
+#include <vector>
+
+namespace {
+
+namespace filter = riot::filter;
+
+emptyspace::pest::suite basic( "index-filter basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "no false negatives", []( auto& expect ) {
+    std::vector<std::uint32_t> keys;
+    for( std::uint32_t i = 0; i < 100000; ++i ) { keys.push_back( 0x0a000000u + i * 7 ); }
+    auto const data = filter::encode( keys );
+    expect( data.size(), equal_to( filter::encoded_size( keys.size() ) ) );
+    filter::view const f{ data.data(), data.size() };
+    expect( f.valid() );
+    auto misses = 0u;
+    for( auto const k : keys ) { misses += not f.may_contain( k ); }
+    expect( misses, equal_to( 0u ) );
+  } );
+
+  test( "false positive rate", []( auto& expect ) {
+    std::vector<std::uint32_t> keys;
+    for( std::uint32_t i = 0; i < 100000; ++i ) { keys.push_back( i * 2 ); }
+    auto const data = filter::encode( keys );
+    filter::view const f{ data.data(), data.size() };
+    auto positives = 0u;
+    for( std::uint32_t i = 0; i < 1000000; ++i ) { positives += f.may_contain( i * 2 + 1 ); }
+    // ~0.1% expected
+    expect( positives < 5000u, equal_to( true ) );
+    // 2 bytes per key
+    expect( data.size(), equal_to( 4u + 32u * 6250u ) );
+  } );
+
+  test( "128bit keys", []( auto& expect ) {
+    __uint128_t const k = ( __uint128_t( 0x20010db8u ) << 96 ) | 1u;
+    std::vector<__uint128_t> const keys{ k, k + 1, 1u };
+    auto const data = filter::encode( keys );
+    expect( data.size(), equal_to( 36u ) );
+    filter::view const f{ data.data(), data.size() };
+    for( auto const x : keys ) { expect( f.may_contain( x ) ); }
+    // a single block: 3 x 8 bits set
+    auto bits = 0;
+    for( std::size_t i = 4; i < data.size(); ++i ) {
+      bits += __builtin_popcount( static_cast<unsigned>( data[i] ) );
+    }
+    expect( bits <= 24, equal_to( true ) );
+  } );
+
+  test( "invalid filters contain everything", []( auto& expect ) {
+    auto const data = filter::encode( std::vector<std::uint32_t>{ 1u, 2u } );
+    filter::view const truncated{ data.data(), data.size() - 1 };
+    expect( not truncated.valid() );
+    expect( truncated.may_contain( 42u ) );
+    expect( filter::view{}.may_contain( 42u ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// packet ordinals instead of byte offsets as postings ( `ny index-pcap --ordinals` ). the packets
+// of a segment are numbered from `1` in capture order, all indices of the segment share the
+// numbers, so set operations across indices work as before. the deltas of ordinals are small ( the
+// distance to the previous packet with the same key ) and bitpack to a few bits, byte offsets need
+// 10+ bits for the same packets.
+//
+// the ordinal table next to the index files ( `<stem>-NNNN.io` ) maps ordinals back to byte
+// offsets relative to the segment. the offsets are bitpacked in blocks of 128 ( `bp128d1` ), a
+// lookup decodes one block only.
+//
+//   [ MAGIC:4 ][ count:4 ][ blocks:4 ][ flags:4 ]
+//   [ position:4 ] x ( blocks + 1 )                   <- relative to the blocks
+//   [ block ] x blocks
+//
+// fat tables ( `flags & FAT`, `ny index-pcap --fat-postings` ) add the size and the timestamp of
+// the packets, slicing reads exactly the packet then and skips its record header. the columns
+// need to be ascending for `bp128d1`, the sizes are stored as the ends of the packets and the
+// nanosecond timestamps as their low and high 32 bits. in capture order the deltas are the packet
+// sizes and the gaps between packets, the high bits rarely change.
+//
+//   block = [ offsets ][ ends ][ stamps low ][ stamps high ]
+
+#include <libnygma/bytestream.hxx>
+#include <libnygma/mmap.hxx>
+#include <libriot/compress-bitpack-simd.hxx>
+#include <libriot/index-builder.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace riot {
+
+namespace unsafe = unclassified::unsafe;
+
+namespace ordinals {
+
+using compressor_type = bitpack::bp128d1;
+
+constexpr std::uint32_t MAGIC = 0x1337133au;
+constexpr std::size_t HEADER_SIZE = 16;
+constexpr std::size_t BLOCKLEN = compressor_type::BLOCKLEN;
+// the offset of unknown ordinals, it is beyond the end of any segment ( see `index_trace` )
+constexpr offset_type npos = std::numeric_limits<offset_type>::max();
+// the table has packet sizes and timestamps
+constexpr std::uint32_t FAT = 1u;
+
+// the ordinal table belonging to the index file `<stem>-NNNN<suffix>`
+inline std::filesystem::path path( std::filesystem::path const& index ) {
+  auto p = index;
+  p.replace_extension( ".io" );
+  return p;
+}
+
+} // namespace ordinals
+
+// a packet of a segment, `_length` is `0` without a fat table
+struct packet_entry {
+  offset_type _offset{ ordinals::npos };
+  std::uint32_t _length{ 0 };
+  std::uint64_t _stamp{ 0 };
+};
+
+class ordinal_table_builder {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+  std::vector<offset_type> _offsets;
+  std::vector<std::uint32_t> _lengths;
+  std::vector<std::uint64_t> _stamps;
+  bool _fat{ false };
+
+ public:
+  ordinal_table_builder() noexcept = default;
+
+  // a fat table keeps the sizes and timestamps of the packets too
+  explicit ordinal_table_builder( bool const fat ) noexcept : _fat{ fat } {}
+
+  // the ordinal of the packet at `o`, packets need to be added in ascending order
+  offset_type add( offset_type const o, std::uint32_t const length = 0,
+                   std::uint64_t const stamp = 0 ) {
+    _offsets.push_back( o );
+    if( _fat ) {
+      _lengths.push_back( length );
+      _stamps.push_back( stamp );
+    }
+    return static_cast<offset_type>( _offsets.size() );
+  }
+
+  auto size() const noexcept { return _offsets.size(); }
+  bool empty() const noexcept { return _offsets.empty(); }
+  bool fat() const noexcept { return _fat; }
+
+  void clear() noexcept {
+    _offsets.clear();
+    _lengths.clear();
+    _stamps.clear();
+  }
+
+  template <typename OStream>
+  void accept( OStream& os ) const {
+    using C = ordinals::compressor_type;
+    auto const n = _offsets.size();
+    auto const blocks = ( n + ordinals::BLOCKLEN - 1 ) / ordinals::BLOCKLEN;
+    std::vector<std::byte> positions( 4 * ( blocks + 1 ) );
+    std::vector<std::byte> records;
+    std::array<std::byte, C::estimate_compressed_size()> scrtch;
+    std::array<offset_type, ordinals::BLOCKLEN> block;
+    auto const encode = [&]( std::size_t const first, std::size_t const used, auto&& column ) {
+      for( std::size_t j = 0; j < used; ++j ) { block[j] = column( first + j ); }
+      if( used != ordinals::BLOCKLEN ) {
+        fill_block<offset_type, ordinals::BLOCKLEN>( block.data(), used );
+      }
+      auto const m = C::encode( block.data(), ordinals::BLOCKLEN, scrtch.data() );
+      records.insert( records.end(), scrtch.data(), scrtch.data() + m );
+    };
+    for( std::size_t i = 0; i < blocks; ++i ) {
+      auto const first = i * ordinals::BLOCKLEN;
+      auto const used = std::min( n - first, ordinals::BLOCKLEN );
+      unsafe::wr32<LE>( positions.data() + 4 * i, static_cast<std::uint32_t>( records.size() ) );
+      encode( first, used, [this]( auto const k ) { return _offsets[k]; } );
+      if( not _fat ) { continue; }
+      // ends past `2^32` wrap around like the deltas of `bp128d1`
+      encode( first, used, [this]( auto const k ) { return _offsets[k] + _lengths[k]; } );
+      encode( first, used, [this]( auto const k ) {
+        return static_cast<std::uint32_t>( _stamps[k] );
+      } );
+      encode( first, used, [this]( auto const k ) {
+        return static_cast<std::uint32_t>( _stamps[k] >> 32 );
+      } );
+    }
+    unsafe::wr32<LE>( positions.data() + 4 * blocks, static_cast<std::uint32_t>( records.size() ) );
+
+    std::byte header[ordinals::HEADER_SIZE]{};
+    unsafe::wr32<LE>( header, ordinals::MAGIC );
+    unsafe::wr32<LE>( header + 4, static_cast<std::uint32_t>( n ) );
+    unsafe::wr32<LE>( header + 8, static_cast<std::uint32_t>( blocks ) );
+    unsafe::wr32<LE>( header + 12, _fat ? ordinals::FAT : 0u );
+    os.write( header, ordinals::HEADER_SIZE );
+    os.write( positions.data(), positions.size() );
+    os.write( records.data(), records.size() );
+  }
+
+  bool write( std::filesystem::path const& p ) const {
+    nygma::cfile_ostream os{ p };
+    accept( os );
+    return os.ok();
+  }
+};
+
+//--read-only-access------------------------------------------------------------
+
+class ordinal_table_view {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+  std::byte const* _positions{ nullptr };
+  std::byte const* _records{ nullptr };
+  std::size_t _records_size{ 0 };
+  std::size_t _count{ 0 };
+  bool _fat{ false };
+  // postings come in ascending order, the block of the previous lookup is likely the next one.
+  // this makes lookups not thread safe
+  mutable std::size_t _cached{ std::numeric_limits<std::size_t>::max() };
+  mutable std::array<offset_type, ordinals::BLOCKLEN> _block;
+  mutable std::array<std::uint32_t, ordinals::BLOCKLEN> _ends;
+  mutable std::array<std::uint32_t, ordinals::BLOCKLEN> _stamps_lo;
+  mutable std::array<std::uint32_t, ordinals::BLOCKLEN> _stamps_hi;
+
+ public:
+  ordinal_table_view() = default;
+
+  // an invalid view for truncated or foreign data
+  explicit ordinal_table_view( unclassified::bytestring_view const data ) noexcept {
+    if( data.size() < ordinals::HEADER_SIZE ) { return; }
+    auto const* const p = data.begin();
+    if( unsafe::rd32<LE>( p ) != ordinals::MAGIC ) { return; }
+    std::size_t const count = unsafe::rd32<LE>( p + 4 );
+    std::size_t const blocks = unsafe::rd32<LE>( p + 8 );
+    if( blocks != ( count + ordinals::BLOCKLEN - 1 ) / ordinals::BLOCKLEN ) { return; }
+    auto const records = ordinals::HEADER_SIZE + 4 * ( blocks + 1 );
+    if( records > data.size() ) { return; }
+    _positions = p + ordinals::HEADER_SIZE;
+    _records = p + records;
+    _records_size = data.size() - records;
+    _count = count;
+    _fat = ( unsafe::rd32<LE>( p + 12 ) & ordinals::FAT ) != 0;
+  }
+
+  bool valid() const noexcept { return _positions != nullptr; }
+  auto size() const noexcept { return _count; }
+  bool fat() const noexcept { return _fat; }
+
+  // the byte offset of the packet numbered `ordinal`, `npos` for unknown ordinals
+  offset_type offset( offset_type const ordinal ) const noexcept {
+    if( ordinal == 0 or ordinal > _count ) { return ordinals::npos; }
+    auto const i = static_cast<std::size_t>( ordinal - 1 );
+    auto const b = i / ordinals::BLOCKLEN;
+    if( b != _cached and not decode( b ) ) { return ordinals::npos; }
+    return _block[i % ordinals::BLOCKLEN];
+  }
+
+  // the packet numbered `ordinal`, its size and timestamp are known in fat tables only
+  packet_entry packet( offset_type const ordinal ) const noexcept {
+    if( ordinal == 0 or ordinal > _count ) { return {}; }
+    auto const i = static_cast<std::size_t>( ordinal - 1 );
+    auto const b = i / ordinals::BLOCKLEN;
+    if( b != _cached and not decode( b ) ) { return {}; }
+    auto const j = i % ordinals::BLOCKLEN;
+    if( not _fat ) { return { _block[j], 0, 0 }; }
+    auto const stamp = std::uint64_t{ _stamps_hi[j] } << 32 | _stamps_lo[j];
+    return { _block[j], _ends[j] - _block[j], stamp };
+  }
+
+ private:
+  bool decode( std::size_t const b ) const noexcept {
+    using C = ordinals::compressor_type;
+    std::size_t begin = unsafe::rd32<LE>( _positions + 4 * b );
+    std::size_t const end = unsafe::rd32<LE>( _positions + 4 * ( b + 1 ) );
+    if( begin >= end or end > _records_size ) { return false; }
+    begin += C::decode( _records + begin, end - begin, _block.data() );
+    if( _fat ) {
+      for( auto* const column : { _ends.data(), _stamps_lo.data(), _stamps_hi.data() } ) {
+        if( begin >= end ) { return false; }
+        begin += C::decode( _records + begin, end - begin, column );
+      }
+    }
+    _cached = b;
+    return true;
+  }
+};
+
+// the segment offsets of the postings of an index file: the postings themselves, or with an
+// ordinal table next to the index file, the offsets of the packets they number. slicing passes
+// `packets()` to `reassemble_stream`
+class posting_offsets {
+  std::unique_ptr<nygma::mmap_view> _map;
+  ordinal_table_view _view;
+
+ public:
+  // postings are offsets
+  posting_offsets() noexcept = default;
+
+  explicit posting_offsets( std::filesystem::path const& index ) {
+    auto const p = ordinals::path( index );
+    std::error_code ec;
+    if( not std::filesystem::exists( p, ec ) ) { return; }
+    _map = std::make_unique<nygma::mmap_view>( p );
+    _view = ordinal_table_view{ _map->view() };
+    if( not _view.valid() ) { throw std::runtime_error( "INVALID_ORDINAL_TABLE" ); }
+  }
+
+  bool ordinals() const noexcept { return _map != nullptr; }
+  bool fat() const noexcept { return _view.fat(); }
+  auto const& table() const noexcept { return _view; }
+
+  offset_type operator()( offset_type const posting ) const noexcept {
+    return _map ? _view.offset( posting ) : posting;
+  }
+
+  packet_entry packet( offset_type const posting ) const noexcept {
+    return _map ? _view.packet( posting ) : packet_entry{ posting, 0, 0 };
+  }
+
+  // the postings as packets for `reassemble_stream`, fat tables spare slicing the record headers
+  auto packets() const noexcept {
+    return [this]( offset_type const posting ) noexcept { return packet( posting ); };
+  }
+};
+
+} // namespace riot
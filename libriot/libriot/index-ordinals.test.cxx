@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-ordinals.hxx>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using bytestring_view = unclassified::bytestring_view;
+
+template <std::size_t N>
+std::size_t serialize( std::byte ( &data )[N], riot::ordinal_table_builder const& table ) {
+  auto os = nygma::cfile_ostream{ data };
+  table.accept( os );
+  return static_cast<std::size_t>( os.current_position() );
+}
+
+// packets of 60 to 1500 bytes behind the pcap header
+std::vector<std::uint32_t> packet_offsets( std::size_t const n ) {
+  auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 4223 };
+  std::vector<std::uint32_t> offsets;
+  std::uint32_t o = 24;
+  for( std::size_t i = 0; i < n; ++i ) {
+    offsets.push_back( o );
+    o += 16 + 60 + xo() % 1440;
+  }
+  return offsets;
+}
+
+std::byte data[1u << 20];
+
+emptyspace::pest::suite basic( "index-ordinals basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "ordinals map to the offsets of their packets", []( auto& expect ) {
+    auto const offsets = packet_offsets( 1000 );
+    riot::ordinal_table_builder table;
+    for( std::size_t i = 0; i < offsets.size(); ++i ) {
+      expect( table.add( offsets[i] ), equal_to( i + 1 ) );
+    }
+    auto const len = serialize( data, table );
+    // 11 bits per offset, the last block is padded
+    expect( len < offsets.size() * 2, equal_to( true ) );
+    riot::ordinal_table_view const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.size(), equal_to( 1000u ) );
+    bool same = true;
+    for( std::size_t i = 0; i < offsets.size(); ++i ) {
+      same = same and view.offset( static_cast<std::uint32_t>( i + 1 ) ) == offsets[i];
+    }
+    expect( same, equal_to( true ) );
+    // out of order lookups decode other blocks
+    expect( view.offset( 999 ), equal_to( offsets[998] ) );
+    expect( view.offset( 3 ), equal_to( offsets[2] ) );
+    expect( view.offset( 1000 ), equal_to( offsets[999] ) );
+    expect( view.offset( 0 ), equal_to( riot::ordinals::npos ) );
+    expect( view.offset( 1001 ), equal_to( riot::ordinals::npos ) );
+  } );
+
+  test( "fat tables keep the sizes and timestamps of the packets", []( auto& expect ) {
+    auto const offsets = packet_offsets( 1000 );
+    auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 2342 };
+    std::vector<riot::packet_entry> packets;
+    std::uint64_t stamp = 1424219007658518000ull;
+    for( std::size_t i = 0; i < offsets.size(); ++i ) {
+      // gaps of microseconds, a few beyond `2^32` nanoseconds and some packets out of order
+      stamp += xo() % 1000 == 0 ? 5'000'000'000ull : xo() % 100'000;
+      auto const s = xo() % 50 == 0 ? stamp - 20'000 : stamp;
+      auto const next = i + 1 < offsets.size() ? offsets[i + 1] : offsets[i] + 9016;
+      packets.push_back( { offsets[i], next - offsets[i] - 16, s } );
+    }
+    // a jumbo frame ending past `2^32` at the end of a segment
+    packets.push_back( { 0xffffff00u, 9000, stamp + 1 } );
+    riot::ordinal_table_builder table{ true };
+    for( auto const& p : packets ) { table.add( p._offset, p._length, p._stamp ); }
+    auto const len = serialize( data, table );
+    riot::ordinal_table_view const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.fat(), equal_to( true ) );
+    expect( view.size(), equal_to( packets.size() ) );
+    bool same = true;
+    for( std::size_t i = packets.size(); i > 0; --i ) {
+      auto const p = view.packet( static_cast<std::uint32_t>( i ) );
+      auto const& q = packets[i - 1];
+      same = same and p._offset == q._offset and p._length == q._length and p._stamp == q._stamp;
+    }
+    expect( same, equal_to( true ) );
+    expect( view.offset( 1001 ), equal_to( 0xffffff00u ) );
+    expect( view.packet( 1002 )._offset, equal_to( riot::ordinals::npos ) );
+    // the offsets of thin tables only
+    riot::ordinal_table_builder thin;
+    for( auto const& p : packets ) { thin.add( p._offset, p._length, p._stamp ); }
+    auto const thin_len = serialize( data, thin );
+    expect( thin_len < len, equal_to( true ) );
+    riot::ordinal_table_view const thin_view{ bytestring_view{ data, thin_len } };
+    expect( thin_view.fat(), equal_to( false ) );
+    expect( thin_view.packet( 3 )._offset, equal_to( offsets[2] ) );
+    expect( thin_view.packet( 3 )._length, equal_to( 0u ) );
+  } );
+
+  test( "empty tables", []( auto& expect ) {
+    riot::ordinal_table_builder const table;
+    auto const len = serialize( data, table );
+    riot::ordinal_table_view const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.size(), equal_to( 0u ) );
+    expect( view.offset( 1 ), equal_to( riot::ordinals::npos ) );
+  } );
+
+  test( "truncated or foreign tables are invalid", []( auto& expect ) {
+    riot::ordinal_table_builder table;
+    for( auto const o : packet_offsets( 300 ) ) { table.add( o ); }
+    auto const len = serialize( data, table );
+    expect( not riot::ordinal_table_view{ bytestring_view{ data, 8 } }.valid(), equal_to( true ) );
+    expect( not riot::ordinal_table_view{ bytestring_view{ data, 24 } }.valid(), equal_to( true ) );
+    // the blocks of a truncated table are gone, their ordinals are unknown
+    riot::ordinal_table_view const truncated{ bytestring_view{ data, len - 32 } };
+    expect( truncated.valid(), equal_to( true ) );
+    expect( truncated.offset( 1 ) != riot::ordinals::npos, equal_to( true ) );
+    expect( truncated.offset( 300 ), equal_to( riot::ordinals::npos ) );
+    data[0] = std::byte{ 0x42 };
+    riot::ordinal_table_view const foreign{ bytestring_view{ data, len } };
+    expect( foreign.valid(), equal_to( false ) );
+  } );
+
+  test( "postings without an ordinal table are offsets", []( auto& expect ) {
+    riot::posting_offsets const offsets{ "/non-existent/capture-0000.i4" };
+    expect( offsets.ordinals(), equal_to( false ) );
+    expect( offsets( 4223 ), equal_to( 4223u ) );
+    expect( offsets.packets()( 4223 )._offset, equal_to( 4223u ) );
+    expect( offsets.packets()( 4223 )._length, equal_to( 0u ) );
+    expect( riot::ordinals::path( "/data/capture-0001.i4" ) == "/data/capture-0001.io",
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <libriot/index-container.hxx>
+
 #include <algorithm>
 #include <cstdint>
 #include <unordered_map>
@@ -60,6 +62,24 @@ struct std_vector_traits {
   }
 };
 
+// set operations work on 64k offset chunks ( see `index-container.hxx` )
+struct container_traits {
+  using value_type = std::uint32_t;
+  using container_type = container::posting_set;
+
+  static container_type set_union( container_type const& a, container_type const& b ) noexcept {
+    return container_type::set_union( a, b );
+  }
+
+  static container_type set_complement( container_type const& a, container_type const& b ) noexcept {
+    return container_type::set_complement( a, b );
+  }
+
+  static container_type set_intersection( container_type const& a, container_type const& b ) noexcept {
+    return container_type::set_intersection( a, b );
+  }
+};
+
 } // namespace detail
 
 //--result-sets---------------------------------------------------------------
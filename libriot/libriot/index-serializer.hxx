@@ -5,6 +5,7 @@
 #include <libnygma/bytestream.hxx>
 #include <libriot/compress-vbyte.hxx>
 #include <libriot/index-builder.hxx>
+#include <libriot/index-filter.hxx>
 
 #include <array>
 #include <vector>
@@ -32,11 +33,31 @@ struct method {
     SVB256D1,
     SVQ4x0D1,
     SVQ3x2D1,
+    BP512D1,
+    SVB512D1,
+    AD128,
+    AD256,
+    RC128,
+    RC256,
+    PEF128,
+    PEF256,
+    PK128,
+    PK256,
     UC128 = 0xfe,
     UC256 = 0xff,
   };
 };
 
+// the formerly reserved byte of the META record. readers ignoring it skip the trailer since it
+// does not start with an OBLOCK
+struct meta_flag {
+  using type = std::uint8_t;
+  enum : type {
+    NONE = 0x23,
+    FILTER = 0x24,
+  };
+};
+
 template <typename KeyType>
 constexpr auto to_keytype() {
   constexpr auto size = sizeof( KeyType );
@@ -88,6 +109,8 @@ union encoding {
 
   static constexpr encoding oblock() noexcept { return { tag::OBLOCK, block_subtype::NONE }; }
 
+  static constexpr encoding mblock() noexcept { return { tag::MBLOCK, block_subtype::NONE }; }
+
   static constexpr encoding cblock( block_subtype::type const subty ) noexcept {
     return { tag::CBLOCK, subty };
   }
@@ -138,12 +161,13 @@ struct bytestream_serializer_base {
 
   template <typename KeyType>
   void encode_meta_record( std::uint32_t const kb, std::uint32_t const ob, std::uint64_t const sb,
-                           method::type const kmethod, method::type const vmethod ) noexcept {
+                           method::type const kmethod, method::type const vmethod,
+                           meta_flag::type const flag = meta_flag::NONE ) noexcept {
     // total META record size = 32bytes
     _os.write( MAGIC, 1 );
     _os.write( std::byte( kmethod ) );
     _os.write( std::byte( vmethod ) );
-    _os.write( std::byte( 0x23 ) );
+    _os.write( std::byte( flag ) );
     _os.write( std::byte( to_keytype<KeyType>() ) );
     _os.write( &kb, 1 );
     _os.write( &ob, 1 );
@@ -151,6 +175,17 @@ struct bytestream_serializer_base {
     _os.write( MAGIC, 2 );
   }
 
+  // [ mblock:1 ][ filter ][ size:4 ] where `size` covers the whole trailer
+  template <typename KeyType>
+  void encode_filter_record( KeyType const* keys, std::size_t const n ) noexcept {
+    std::vector<std::byte> data( 1 + filter::encoded_size( n ) + 4 );
+    data[0] = encoding::mblock()._value;
+    auto const len = filter::encode( keys, n, data.data() + 1 );
+    auto const size = static_cast<std::uint32_t>( data.size() );
+    unclassified::unsafe::wr32<unclassified::endianess::LE>( data.data() + 1 + len, size );
+    _os.write( data.data(), data.size() );
+  }
+
  public:
   std::uint32_t current_position() const noexcept {
     return static_cast<std::uint32_t>( _os.current_position() );
@@ -215,7 +250,7 @@ struct compressing_serializer : public bytestream_serializer_base<OStream> {
   static constexpr method::type VMETHOD = VMethod;
 
   using offset_type = std::uint32_t;
-  using key_type = std::uint32_t;
+  using key_type = typename kcompressor_type::integer_type;
 
   std::array<std::byte, vcompressor_type::estimate_compressed_size()> _scrtch_chunks;
   std::array<std::byte, kcompressor_type::estimate_compressed_size()> _scrtch_keys;
@@ -265,4 +300,23 @@ struct compressing_serializer : public bytestream_serializer_base<OStream> {
   }
 };
 
+// writes a key filter ( see `index-filter.hxx` ) in front of the META record of `Serializer`
+template <typename Serializer>
+struct filtering_serializer : public Serializer {
+  bool _filter{ false };
+
+  template <typename KeyType>
+  void encode_filter( KeyType const* keys, std::size_t const n ) noexcept {
+    this->encode_filter_record( keys, n );
+    _filter = true;
+  }
+
+  template <typename KeyType>
+  void encode_mblock( offset_type const kb, offset_type const ob, std::uint64_t const sb ) noexcept {
+    auto const flag = _filter ? meta_flag::FILTER : meta_flag::NONE;
+    this->template encode_meta_record<KeyType>( kb, ob, sb, Serializer::KMETHOD, Serializer::VMETHOD,
+                                                flag );
+  }
+};
+
 } // namespace riot
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libriot/index-builder.hxx>
+#include <libunclassified/backoff-strategy.hxx>
+#include <libunclassified/ring.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace riot {
+
+namespace detail {
+
+// the builder threads of `index_shards`. every shard owns an index builder for a disjoint
+// partition of the keys and a spsc ring of posting batches filled by the dissecting thread
+template <typename Builder>
+class shard_pool {
+ public:
+  using builder_type = Builder;
+  using key_type = typename Builder::key_type;
+
+  struct posting {
+    key_type _key;
+    offset_type _offset;
+  };
+
+  static constexpr std::size_t SLOTSZ = 4096;
+  static constexpr std::int64_t SLOTS = 256;
+  // control batches: hand over the builder / terminate the thread
+  static constexpr std::uint32_t TAKE = ~0u;
+  static constexpr std::uint32_t STOP = ~0u - 1;
+
+  static constexpr std::uint32_t CAPACITY = ( SLOTSZ - alignof( posting ) ) / sizeof( posting );
+
+  struct batch {
+    std::uint32_t _count;
+    posting _postings[CAPACITY];
+  };
+
+  static_assert( sizeof( batch ) <= SLOTSZ );
+
+ private:
+  using ring_type = unclassified::ring<SLOTS, SLOTSZ>;
+  using idle_backoff = unclassified::backoff_strategy::backoff3;
+  using full_backoff = unclassified::backoff_strategy::backoff2;
+
+  struct shard {
+    ring_type _ring;
+    std::unique_ptr<builder_type> _builder;
+    // `TAKE` batches done, the builder belongs to the dissecting thread until the next batch
+    alignas( unclassified::CACHE_ALIGN ) std::atomic<std::uint64_t> _taken{ 0 };
+    std::thread _self;
+    // the batch being filled by the dissecting thread
+    std::int64_t _idx{ 0 };
+    batch* _open{ nullptr };
+
+    void run() noexcept {
+      for( ;; ) {
+        auto const idx = _ring.read_idx();
+        batch const* b{ nullptr };
+        for( idle_backoff bo{}; ( b = _ring.read_ptr<batch>( idx ) ) == nullptr; ++bo ) bo();
+        auto const n = b->_count;
+        if( n == STOP ) {
+          _ring.read_commit( idx );
+          return;
+        }
+        if( n == TAKE ) {
+          _ring.read_commit( idx );
+          _taken.fetch_add( 1, std::memory_order_release );
+          continue;
+        }
+        for( std::uint32_t i = 0; i < n; ++i ) {
+          _builder->add( b->_postings[i]._key, b->_postings[i]._offset );
+        }
+        _ring.read_commit( idx );
+      }
+    }
+  };
+
+  std::vector<std::unique_ptr<shard>> _shards;
+  std::uint64_t _takes{ 0 };
+
+ public:
+  // the builders of the shards are configured like `prototype` ( see `fresh_of` )
+  shard_pool( std::size_t const shards, builder_type const& prototype ) {
+    for( std::size_t i = 0; i < std::max<std::size_t>( shards, 1 ); ++i ) {
+      _shards.emplace_back( std::make_unique<shard>() );
+      _shards.back()->_builder = fresh_of( prototype );
+    }
+    for( auto& s : _shards ) { s->_self = std::thread( &shard::run, s.get() ); }
+  }
+
+  shard_pool( shard_pool const& ) = delete;
+  shard_pool& operator=( shard_pool const& ) = delete;
+
+  ~shard_pool() noexcept {
+    for( auto& s : _shards ) { control( *s, STOP ); }
+    for( auto& s : _shards ) { s->_self.join(); }
+  }
+
+  std::size_t size() const noexcept { return _shards.size(); }
+
+  // the shard of `k`: multiplicative hashing of the ( folded ) key, the keys themselves are
+  // addresses, ports and flow hashes with little entropy in their low bits
+  inline std::size_t shard_of( key_type const k ) const noexcept {
+    std::uint64_t x = static_cast<std::uint64_t>( k );
+    if constexpr( sizeof( key_type ) > sizeof( std::uint64_t ) ) {
+      x ^= static_cast<std::uint64_t>( k >> 64 );
+    }
+    auto const h = static_cast<std::uint32_t>( ( x * 0x9e3779b97f4a7c15ull ) >> 32 );
+    return ( static_cast<std::uint64_t>( h ) * _shards.size() ) >> 32;
+  }
+
+  inline void add( key_type const k, offset_type const o ) noexcept {
+    auto& s = *_shards[shard_of( k )];
+    if( s._open == nullptr ) { open( s ); }
+    s._open->_postings[s._open->_count++] = { k, o };
+    if( s._open->_count == CAPACITY ) { commit( s ); }
+  }
+
+  // the postings added so far as one builder, the shards start over with empty builders
+  std::unique_ptr<builder_type> take() {
+    _takes++;
+    for( auto& s : _shards ) { control( *s, TAKE ); }
+    std::unique_ptr<builder_type> merged;
+    for( auto& s : _shards ) {
+      for( idle_backoff bo{}; s->_taken.load( std::memory_order_acquire ) != _takes; ++bo ) bo();
+      auto b = std::exchange( s->_builder, fresh_of( *s->_builder ) );
+      if( not merged ) {
+        merged = std::move( b );
+      } else {
+        merged->merge( std::move( *b ) );
+      }
+    }
+    return merged;
+  }
+
+ private:
+  inline void open( shard& s ) noexcept {
+    s._idx = s._ring.write_idx();
+    for( full_backoff bo{}; ( s._open = s._ring.template write_ptr<batch>( s._idx ) ) == nullptr;
+         ++bo ) {
+      bo();
+    }
+    s._open->_count = 0;
+  }
+
+  inline void commit( shard& s ) noexcept {
+    s._ring.write_commit( s._idx );
+    s._open = nullptr;
+  }
+
+  inline void control( shard& s, std::uint32_t const what ) noexcept {
+    if( s._open != nullptr ) { commit( s ); }
+    open( s );
+    s._open->_count = what;
+    commit( s );
+  }
+};
+
+} // namespace detail
+
+// an index builder partitioned by key across builder threads ( `ny index-pcap --shards` ). `add`
+// only appends the posting to a batch of the shard owning the key, the shard threads do the map
+// inserts. the postings of a key all go to the same shard in order, `take` merges the disjoint
+// partitions into a builder equal to a `Builder` fed with the same postings.
+//
+// the shards live as long as any handle, `fresh` gives the handle for the next segment. `take`
+// has to happen before postings get added through the fresh handle ( see `index_trace::prepare`
+// and the cyclers ).
+template <typename Builder>
+class index_shards {
+ public:
+  using builder_type = Builder;
+  using key_type = typename Builder::key_type;
+
+ private:
+  using pool_type = detail::shard_pool<Builder>;
+  std::shared_ptr<pool_type> _pool;
+
+ public:
+  explicit index_shards( std::size_t const shards )
+    : _pool{ std::make_shared<pool_type>( shards, builder_type{} ) } {}
+
+  index_shards( std::size_t const shards, builder_type const& prototype )
+    : _pool{ std::make_shared<pool_type>( shards, prototype ) } {}
+
+  explicit index_shards( std::shared_ptr<pool_type> pool ) noexcept : _pool{ std::move( pool ) } {}
+
+  inline void add( key_type const k, offset_type const o ) noexcept { _pool->add( k, o ); }
+
+  std::size_t shard_count() const noexcept { return _pool->size(); }
+
+  std::unique_ptr<index_shards> fresh() const { return std::make_unique<index_shards>( _pool ); }
+
+  std::unique_ptr<builder_type> take() { return _pool->take(); }
+};
+
+// the builder of a finished segment, sharded or not
+template <typename I>
+inline auto builder_of( std::unique_ptr<I> i ) {
+  if constexpr( requires { i->take(); } ) {
+    return i->take();
+  } else {
+    return i;
+  }
+}
+
+} // namespace riot
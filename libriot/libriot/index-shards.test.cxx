@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-shards.hxx>
+
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using index_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using index6_type = riot::index_builder<__uint128_t, map_type, 128>;
+
+struct text_serializer {
+  std::ostream& _os;
+
+  text_serializer( std::ostream& os ) : _os{ os } {}
+
+  template <typename T>
+  void encode( T const* p, std::size_t const n ) noexcept {
+    _os << '[' << n << "] ";
+    for( unsigned i = 0; i < n; i++ ) {
+      _os << static_cast<std::uint64_t>( p[i] ) << ' ';
+      if constexpr( sizeof( T ) > 8 ) { _os << static_cast<std::uint64_t>( p[i] >> 64 ) << ' '; }
+    }
+    _os << std::endl;
+  }
+
+  template <typename T, std::size_t BlockLen>
+  void encode_cblock( T const* p, std::size_t const n, bool const ) noexcept {
+    encode( p, n );
+  }
+
+  template <typename T, std::size_t BlockLen>
+  void encode_oblock( T const* p, std::size_t const n ) noexcept {
+    encode( p, n );
+  }
+
+  template <typename T, std::size_t BlockLen>
+  void encode_kblock( T const* p, std::size_t const n ) noexcept {
+    encode( p, n );
+  }
+
+  template <typename KeyType>
+  void encode_mblock( std::uint32_t const kb, std::uint32_t const ob, std::uint64_t const ) noexcept {
+    _os << kb << ' ' << ob << std::endl;
+  }
+
+  std::uint32_t current_position() noexcept { return static_cast<std::uint32_t>( _os.tellp() ); }
+};
+
+template <typename I>
+std::string serialize( I& i ) {
+  std::ostringstream os;
+  text_serializer s{ os };
+  i.accept( s, 0 );
+  return os.str();
+}
+
+emptyspace::pest::suite basic( "index-shards suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "the merged shards equal a single builder", []( auto& expect ) {
+    auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 2342 };
+    index_type single;
+    riot::index_shards<index_type> shards{ 3 };
+    expect( shards.shard_count(), equal_to( 3u ) );
+    for( std::uint32_t o = 1; o < 100000; o++ ) {
+      // keys repeat, postings of a key get long enough to fill several chunks
+      auto const k = xo() % 1000;
+      single.add( k, o );
+      shards.add( k, o );
+    }
+    auto merged = shards.take();
+    expect( merged->key_count(), equal_to( single.key_count() ) );
+    expect( serialize( *merged ) == serialize( single ), equal_to( true ) );
+  } );
+
+  test( "segments: take starts over, fresh handles share the shards", []( auto& expect ) {
+    auto first = std::make_unique<riot::index_shards<index_type>>( 2 );
+    first->add( 23, 1 );
+    first->add( 42, 2 );
+    auto second = first->fresh();
+    auto a = riot::builder_of( std::move( first ) );
+    expect( a->key_count(), equal_to( 2u ) );
+    second->add( 1337, 3 );
+    auto b = second->take();
+    expect( b->key_count(), equal_to( 1u ) );
+    expect( second->take()->key_count(), equal_to( 0u ) );
+  } );
+
+  test( "ipv6 keys", []( auto& expect ) {
+    auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 4223 };
+    index6_type single;
+    riot::index_shards<index6_type> shards{ 4 };
+    for( std::uint32_t o = 1; o < 20000; o++ ) {
+      auto const k = __uint128_t( 0x20010db8u ) << 96 | ( xo() % 300 );
+      single.add( k, o );
+      shards.add( k, o );
+    }
+    auto merged = shards.take();
+    expect( serialize( *merged ) == serialize( single ), equal_to( true ) );
+  } );
+
+  test( "builders pass through builder_of", []( auto& expect ) {
+    auto i = std::make_unique<index_type>();
+    i->add( 23, 1 );
+    auto const* const p = i.get();
+    auto j = riot::builder_of( std::move( i ) );
+    expect( j.get() == p, equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,513 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// approximate per segment summaries of the ipv4 hosts ( `ny index-pcap --sketches` ) for the
+// questions which do not need posting lists: who the heavy hitters are and how many distinct
+// peers a host talked to. the sketches of many segments ( and captures ) merge, `ny sketch`
+// answers from them without decoding any index.
+//
+//   - count-min sketches of the packets and captured bytes per host, they estimate the counters
+//     of any host from a fixed size table
+//   - the `TOP` hosts with the most bytes ( the heavy hitters ) of the segment with their exact
+//     counters, the candidates for the heavy hitters of many segments
+//   - a hyperloglog of the peers of every host, sparse ( `index:2 rank:1` ) for hosts with few
+//     peers
+//
+// the sketches of the index files `<stem>-NNNN<suffix>` are in `<stem>-NNNN.sk`
+//
+//   [ MAGIC:4 ][ hosts:4 ][ top:4 ][ reserved:4 ][ first:8 ][ last:8 ]
+//   [ packets:4 ] x DEPTH x WIDTH                      <- count-min of the packets
+//   [ bytes:8 ] x DEPTH x WIDTH                        <- count-min of the bytes
+//   [ host:4 ][ packets:4 ][ bytes:8 ] x top           <- heavy hitters, sorted by host
+//   [ host:4 ] x hosts                                 <- sorted
+//   [ position:4 ] x ( hosts + 1 )                     <- relative to the registers
+//   [ registers ] x hosts
+//
+//   registers = [ n:2 ] ( [ index:2 ][ rank:1 ] x n | [ rank:1 ] x REGISTERS with n = DENSE )
+
+#include <libnygma/bytestream.hxx>
+#include <libnygma/mmap.hxx>
+#include <libriot/index-builder.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace riot {
+
+namespace unsafe = unclassified::unsafe;
+
+namespace sketch {
+
+constexpr std::uint32_t MAGIC = 0x1337133cu;
+constexpr std::size_t HEADER_SIZE = 32;
+// `2^PRECISION` registers per hyperloglog, a standard error of about 3%
+constexpr unsigned PRECISION = 10;
+constexpr std::size_t REGISTERS = 1u << PRECISION;
+constexpr std::uint16_t DENSE = 0xffffu;
+// the error of a count-min estimate is below `e / WIDTH` of all bytes of the segment with a
+// probability of `1 - e^-DEPTH`
+constexpr std::size_t DEPTH = 4;
+constexpr std::size_t WIDTH = 2048;
+constexpr std::size_t COUNTERS_SIZE = DEPTH * WIDTH * ( 4 + 8 );
+constexpr std::size_t TOP = 256;
+constexpr std::size_t TOP_RECORD_SIZE = 16;
+
+// the sketches belonging to the index file `<stem>-NNNN<suffix>`
+inline std::filesystem::path path( std::filesystem::path const& index ) {
+  auto p = index;
+  p.replace_extension( ".sk" );
+  return p;
+}
+
+// the finalizer of murmur3, the hosts of a subnet differ in their low bits only
+constexpr std::uint64_t mix( std::uint64_t x ) noexcept {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+// the counter of `host` in row `d` of a count-min sketch
+constexpr std::size_t cell( std::size_t const d, std::uint32_t const host ) noexcept {
+  auto const h = mix( host + ( d + 1 ) * 0x9e3779b97f4a7c15ull );
+  return d * WIDTH + static_cast<std::size_t>( h & ( WIDTH - 1 ) );
+}
+
+} // namespace sketch
+
+// the distinct elements of a set of hashes, registers are kept sparse until an eighth of them
+// is in use
+class hyperloglog {
+  static constexpr std::size_t M = sketch::REGISTERS;
+  static constexpr std::size_t SPARSE = M / 8;
+
+  // `index << 8 | rank`
+  std::vector<std::uint32_t> _sparse;
+  std::vector<std::uint8_t> _dense;
+
+ public:
+  void add( std::uint64_t const hash ) {
+    auto const index = static_cast<unsigned>( hash >> ( 64 - sketch::PRECISION ) );
+    auto const rest = ( hash << sketch::PRECISION ) | ( 1ull << ( sketch::PRECISION - 1 ) );
+    set( index, static_cast<std::uint8_t>( std::countl_zero( rest ) + 1 ) );
+  }
+
+  void set( unsigned const index, std::uint8_t const rank ) {
+    if( not _dense.empty() ) {
+      _dense[index] = std::max( _dense[index], rank );
+      return;
+    }
+    for( auto& r : _sparse ) {
+      if( r >> 8 != index ) { continue; }
+      if( ( r & 0xffu ) < rank ) { r = index << 8 | rank; }
+      return;
+    }
+    if( _sparse.size() < SPARSE ) {
+      _sparse.push_back( index << 8 | rank );
+      return;
+    }
+    _dense.assign( M, 0 );
+    for( auto const r : _sparse ) { _dense[r >> 8] = static_cast<std::uint8_t>( r ); }
+    _sparse = {};
+    _dense[index] = rank;
+  }
+
+  void merge( hyperloglog const& o ) {
+    o.for_each( [this]( unsigned const i, std::uint8_t const r ) { set( i, r ); } );
+  }
+
+  bool dense() const noexcept { return not _dense.empty(); }
+
+  // the registers in use
+  std::size_t size() const noexcept {
+    if( _dense.empty() ) { return _sparse.size(); }
+    return M - static_cast<std::size_t>( std::count( _dense.begin(), _dense.end(), 0 ) );
+  }
+
+  // `f( index, rank )` for the registers in use
+  template <typename F>
+  void for_each( F&& f ) const {
+    if( _dense.empty() ) {
+      for( auto const r : _sparse ) { f( r >> 8, static_cast<std::uint8_t>( r ) ); }
+      return;
+    }
+    for( unsigned i = 0; i < M; ++i ) {
+      if( _dense[i] != 0 ) { f( i, _dense[i] ); }
+    }
+  }
+
+  // linear counting for small sets ( most hosts have few peers ), the harmonic mean of the
+  // registers otherwise
+  double estimate() const noexcept {
+    double sum = 0;
+    std::size_t zeros = M;
+    for_each( [&]( unsigned, std::uint8_t const r ) {
+      sum += std::ldexp( 1.0, -static_cast<int>( r ) );
+      zeros--;
+    } );
+    sum += static_cast<double>( zeros );
+    auto const m = static_cast<double>( M );
+    auto const alpha = 0.7213 / ( 1.0 + 1.079 / m );
+    auto const e = alpha * m * m / sum;
+    if( e <= 2.5 * m and zeros > 0 ) { return m * std::log( m / static_cast<double>( zeros ) ); }
+    return e;
+  }
+};
+
+// the counters of a host, `_exact` unless estimated by a count-min sketch
+struct heavy_hitter {
+  std::uint32_t _host{ 0 };
+  std::uint64_t _packets{ 0 };
+  std::uint64_t _bytes{ 0 };
+  bool _exact{ true };
+};
+
+class sketch_builder {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+  struct host {
+    hyperloglog _peers;
+    std::uint64_t _bytes{ 0 };
+    std::uint32_t _packets{ 0 };
+    // a packet counts once per host, e.g. with the host in the outer and inner header of a tunnel
+    offset_type _posting{ std::numeric_limits<offset_type>::max() };
+  };
+
+  std::unordered_map<std::uint32_t, host> _hosts;
+  std::uint64_t _first{ std::numeric_limits<std::uint64_t>::max() };
+  std::uint64_t _last{ 0 };
+
+ public:
+  // a packet from `src` to `dst`, `posting` identifies it within the segment
+  void add( std::uint32_t const src, std::uint32_t const dst, offset_type const posting,
+            std::uint32_t const length, std::uint64_t const stamp ) {
+    _first = std::min( _first, stamp );
+    _last = std::max( _last, stamp );
+    count( src, dst, posting, length );
+    count( dst, src, posting, length );
+  }
+
+  auto host_count() const noexcept { return _hosts.size(); }
+  bool empty() const noexcept { return _hosts.empty(); }
+
+  // the counters of `host` so far
+  heavy_hitter lookup( std::uint32_t const host ) const noexcept {
+    auto const it = _hosts.find( host );
+    if( it == _hosts.end() ) { return { host, 0, 0, true }; }
+    return { host, it->second._packets, it->second._bytes, true };
+  }
+
+  void clear() noexcept {
+    _hosts.clear();
+    _first = std::numeric_limits<std::uint64_t>::max();
+    _last = 0;
+  }
+
+  template <typename OStream>
+  void accept( OStream& os ) const {
+    std::vector<std::uint32_t> hosts;
+    hosts.reserve( _hosts.size() );
+    std::vector<std::uint32_t> packets( sketch::DEPTH * sketch::WIDTH );
+    std::vector<std::uint64_t> bytes( sketch::DEPTH * sketch::WIDTH );
+    // a min heap of the hosts with the most bytes so far
+    using candidate = std::pair<std::uint64_t, std::uint32_t>;
+    std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate>> heap;
+    for( auto const& [k, h] : _hosts ) {
+      hosts.push_back( k );
+      for( std::size_t d = 0; d < sketch::DEPTH; ++d ) {
+        auto const c = sketch::cell( d, k );
+        packets[c] += h._packets;
+        bytes[c] += h._bytes;
+      }
+      if( heap.size() < sketch::TOP ) {
+        heap.emplace( h._bytes, k );
+      } else if( heap.top().first < h._bytes ) {
+        heap.pop();
+        heap.emplace( h._bytes, k );
+      }
+    }
+    std::sort( hosts.begin(), hosts.end() );
+    std::vector<std::uint32_t> top;
+    for( ; not heap.empty(); heap.pop() ) { top.push_back( heap.top().second ); }
+    std::sort( top.begin(), top.end() );
+
+    std::vector<std::byte> counters( sketch::COUNTERS_SIZE );
+    auto* p = counters.data();
+    for( auto const x : packets ) { unsafe::wr32<LE>( std::exchange( p, p + 4 ), x ); }
+    for( auto const x : bytes ) { unsafe::wr64<LE>( std::exchange( p, p + 8 ), x ); }
+
+    std::vector<std::byte> heavy( sketch::TOP_RECORD_SIZE * top.size() );
+    p = heavy.data();
+    for( auto const k : top ) {
+      auto const& h = _hosts.at( k );
+      unsafe::wr32<LE>( p, k );
+      unsafe::wr32<LE>( p + 4, h._packets );
+      unsafe::wr64<LE>( p + 8, h._bytes );
+      p += sketch::TOP_RECORD_SIZE;
+    }
+
+    std::vector<std::byte> keys( 4 * hosts.size() );
+    std::vector<std::byte> positions( 4 * ( hosts.size() + 1 ) );
+    std::vector<std::byte> registers;
+    std::size_t i = 0;
+    for( auto const k : hosts ) {
+      auto const& peers = _hosts.at( k )._peers;
+      unsafe::wr32<LE>( keys.data() + 4 * i, k );
+      unsafe::wr32<LE>( positions.data() + 4 * i, static_cast<std::uint32_t>( registers.size() ) );
+      auto const n = peers.size();
+      std::byte record[3];
+      // sparse unless it takes more space than all registers
+      if( 3 * n < sketch::REGISTERS ) {
+        unsafe::wr16<LE>( record, static_cast<std::uint16_t>( n ) );
+        registers.insert( registers.end(), record, record + 2 );
+        peers.for_each( [&]( unsigned const index, std::uint8_t const rank ) {
+          unsafe::wr16<LE>( record, static_cast<std::uint16_t>( index ) );
+          record[2] = std::byte{ rank };
+          registers.insert( registers.end(), record, record + 3 );
+        } );
+      } else {
+        unsafe::wr16<LE>( record, sketch::DENSE );
+        registers.insert( registers.end(), record, record + 2 );
+        auto const dense = registers.size();
+        registers.resize( dense + sketch::REGISTERS );
+        peers.for_each( [&]( unsigned const index, std::uint8_t const rank ) {
+          registers[dense + index] = std::byte{ rank };
+        } );
+      }
+      ++i;
+    }
+    unsafe::wr32<LE>( positions.data() + 4 * i, static_cast<std::uint32_t>( registers.size() ) );
+
+    std::byte header[sketch::HEADER_SIZE]{};
+    unsafe::wr32<LE>( header, sketch::MAGIC );
+    unsafe::wr32<LE>( header + 4, static_cast<std::uint32_t>( hosts.size() ) );
+    unsafe::wr32<LE>( header + 8, static_cast<std::uint32_t>( top.size() ) );
+    unsafe::wr64<LE>( header + 16, hosts.empty() ? 0 : _first );
+    unsafe::wr64<LE>( header + 24, _last );
+    os.write( header, sketch::HEADER_SIZE );
+    os.write( counters.data(), counters.size() );
+    os.write( heavy.data(), heavy.size() );
+    os.write( keys.data(), keys.size() );
+    os.write( positions.data(), positions.size() );
+    os.write( registers.data(), registers.size() );
+  }
+
+  bool write( std::filesystem::path const& p ) const {
+    nygma::cfile_ostream os{ p };
+    accept( os );
+    return os.ok();
+  }
+
+ private:
+  void count( std::uint32_t const k, std::uint32_t const peer, offset_type const posting,
+              std::uint32_t const length ) {
+    auto& h = _hosts[k];
+    if( peer != k ) { h._peers.add( sketch::mix( peer ) ); }
+    if( h._posting == posting ) { return; }
+    h._posting = posting;
+    h._packets++;
+    h._bytes += length;
+  }
+};
+
+//--read-only-access------------------------------------------------------------
+
+class sketch_view {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+  std::byte const* _packets{ nullptr };
+  std::byte const* _bytes{ nullptr };
+  std::byte const* _top{ nullptr };
+  std::byte const* _hosts{ nullptr };
+  std::byte const* _positions{ nullptr };
+  std::byte const* _registers{ nullptr };
+  std::size_t _registers_size{ 0 };
+  std::size_t _host_count{ 0 };
+  std::size_t _top_count{ 0 };
+  std::uint64_t _first{ 0 };
+  std::uint64_t _last{ 0 };
+
+ public:
+  sketch_view() = default;
+
+  // an invalid view for truncated or foreign data
+  explicit sketch_view( unclassified::bytestring_view const data ) noexcept {
+    if( data.size() < sketch::HEADER_SIZE ) { return; }
+    auto const* const p = data.begin();
+    if( unsafe::rd32<LE>( p ) != sketch::MAGIC ) { return; }
+    std::size_t const hosts = unsafe::rd32<LE>( p + 4 );
+    std::size_t const top = unsafe::rd32<LE>( p + 8 );
+    if( top > std::min( hosts, sketch::TOP ) ) { return; }
+    auto const registers = sketch::HEADER_SIZE + sketch::COUNTERS_SIZE +
+                           sketch::TOP_RECORD_SIZE * top + 4 * hosts + 4 * ( hosts + 1 );
+    if( registers > data.size() ) { return; }
+    _packets = p + sketch::HEADER_SIZE;
+    _bytes = _packets + 4 * sketch::DEPTH * sketch::WIDTH;
+    _top = _bytes + 8 * sketch::DEPTH * sketch::WIDTH;
+    _hosts = _top + sketch::TOP_RECORD_SIZE * top;
+    _positions = _hosts + 4 * hosts;
+    _registers = p + registers;
+    _registers_size = data.size() - registers;
+    _host_count = hosts;
+    _top_count = top;
+    _first = unsafe::rd64<LE>( p + 16 );
+    _last = unsafe::rd64<LE>( p + 24 );
+  }
+
+  bool valid() const noexcept { return _packets != nullptr; }
+  auto host_count() const noexcept { return _host_count; }
+  auto top_count() const noexcept { return _top_count; }
+  // the timestamps of the first and the last packet of the segment
+  auto first() const noexcept { return _first; }
+  auto last() const noexcept { return _last; }
+
+  // the heavy hitters of the segment in ascending order of their hosts
+  heavy_hitter top( std::size_t const i ) const noexcept {
+    auto const* const p = _top + sketch::TOP_RECORD_SIZE * i;
+    return { unsafe::rd32<LE>( p ), unsafe::rd32<LE>( p + 4 ), unsafe::rd64<LE>( p + 8 ), true };
+  }
+
+  // the counters of `host`: exact for the heavy hitters and absent hosts, the count-min estimates
+  // ( an upper bound ) otherwise
+  heavy_hitter counters( std::uint32_t const host ) const noexcept {
+    std::size_t lo = 0;
+    std::size_t hi = _top_count;
+    while( lo < hi ) {
+      auto const mid = lo + ( hi - lo ) / 2;
+      auto const k = unsafe::rd32<LE>( _top + sketch::TOP_RECORD_SIZE * mid );
+      if( k == host ) { return top( mid ); }
+      if( k < host ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    heavy_hitter e{ host, std::numeric_limits<std::uint64_t>::max(),
+                    std::numeric_limits<std::uint64_t>::max(), false };
+    for( std::size_t d = 0; d < sketch::DEPTH; ++d ) {
+      auto const c = sketch::cell( d, host );
+      e._packets = std::min<std::uint64_t>( e._packets, unsafe::rd32<LE>( _packets + 4 * c ) );
+      e._bytes = std::min( e._bytes, unsafe::rd64<LE>( _bytes + 8 * c ) );
+    }
+    // no host of the segment shares a counter with `host`
+    e._exact = e._packets == 0;
+    return e;
+  }
+
+  // merges the peers of `host` into `peers`, `false` for unknown hosts or truncated data
+  bool peers( std::uint32_t const host, hyperloglog& peers ) const {
+    std::size_t lo = 0;
+    std::size_t hi = _host_count;
+    while( lo < hi ) {
+      auto const mid = lo + ( hi - lo ) / 2;
+      if( unsafe::rd32<LE>( _hosts + 4 * mid ) < host ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if( lo == _host_count or unsafe::rd32<LE>( _hosts + 4 * lo ) != host ) { return false; }
+    std::size_t const begin = unsafe::rd32<LE>( _positions + 4 * lo );
+    std::size_t const end = unsafe::rd32<LE>( _positions + 4 * ( lo + 1 ) );
+    if( begin + 2 > end or end > _registers_size ) { return false; }
+    auto const* const p = _registers + begin;
+    auto const n = unsafe::rd16<LE>( p );
+    if( n == sketch::DENSE ) {
+      if( end - begin != 2 + sketch::REGISTERS ) { return false; }
+      for( unsigned i = 0; i < sketch::REGISTERS; ++i ) {
+        auto const rank = std::to_integer<std::uint8_t>( p[2 + i] );
+        if( rank != 0 ) { peers.set( i, rank ); }
+      }
+      return true;
+    }
+    if( end - begin != 2 + 3 * std::size_t{ n } ) { return false; }
+    for( std::size_t j = 0; j < n; ++j ) {
+      auto const* const r = p + 2 + 3 * j;
+      auto const index = unsafe::rd16<LE>( r );
+      if( index >= sketch::REGISTERS ) { return false; }
+      peers.set( index, std::to_integer<std::uint8_t>( r[2] ) );
+    }
+    return true;
+  }
+};
+
+// the sketches of an index file, the handle owns the mapping
+class sketch_file {
+  std::unique_ptr<nygma::mmap_view> _map;
+  sketch_view _view;
+
+ public:
+  explicit sketch_file( std::filesystem::path const& p )
+    : _map{ std::make_unique<nygma::mmap_view>( p ) }, _view{ _map->view() } {
+    if( not _view.valid() ) { throw std::runtime_error( "INVALID_SKETCH" ); }
+  }
+
+  // the sketches of the index file `index`, `nullptr` if it has none
+  static std::unique_ptr<sketch_file> of( std::filesystem::path const& index ) {
+    auto const p = sketch::path( index );
+    std::error_code ec;
+    if( not std::filesystem::exists( p, ec ) ) { return nullptr; }
+    return std::make_unique<sketch_file>( p );
+  }
+
+  auto const& operator*() const noexcept { return _view; }
+  auto const* operator->() const noexcept { return &_view; }
+};
+
+//--merging-the-sketches-of-many-segments---------------------------------------
+
+// the `n` hosts with the most bytes in all `segments`. the candidates are the heavy hitters of
+// the segments, their counters are summed over all segments ( estimated where a candidate is not
+// a heavy hitter of a segment )
+inline std::vector<heavy_hitter> heavy_hitters( std::vector<sketch_view> const& segments,
+                                                std::size_t const n ) {
+  std::vector<std::uint32_t> candidates;
+  for( auto const& s : segments ) {
+    for( std::size_t i = 0; i < s.top_count(); ++i ) { candidates.push_back( s.top( i )._host ); }
+  }
+  std::sort( candidates.begin(), candidates.end() );
+  candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+  std::vector<heavy_hitter> r;
+  r.reserve( candidates.size() );
+  for( auto const k : candidates ) {
+    heavy_hitter sum{ k, 0, 0, true };
+    for( auto const& s : segments ) {
+      auto const c = s.counters( k );
+      sum._packets += c._packets;
+      sum._bytes += c._bytes;
+      sum._exact = sum._exact and c._exact;
+    }
+    r.push_back( sum );
+  }
+  auto const more = []( auto const& a, auto const& b ) {
+    return a._bytes > b._bytes or ( a._bytes == b._bytes and a._host < b._host );
+  };
+  auto const m = std::min( n, r.size() );
+  std::partial_sort( r.begin(), r.begin() + static_cast<std::ptrdiff_t>( m ), r.end(), more );
+  r.resize( m );
+  return r;
+}
+
+// the peers of `host` in all `segments`
+inline hyperloglog peers_of( std::vector<sketch_view> const& segments, std::uint32_t const host ) {
+  hyperloglog peers;
+  for( auto const& s : segments ) { s.peers( host, peers ); }
+  return peers;
+}
+
+} // namespace riot
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-sketch.hxx>
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+using bytestring_view = unclassified::bytestring_view;
+
+template <std::size_t N>
+std::size_t serialize( std::byte ( &data )[N], riot::sketch_builder const& sketches ) {
+  auto os = nygma::cfile_ostream{ data };
+  sketches.accept( os );
+  return static_cast<std::size_t>( os.current_position() );
+}
+
+bool close_to( double const estimate, std::size_t const n, double const error ) {
+  return std::abs( estimate - static_cast<double>( n ) ) <= error * static_cast<double>( n );
+}
+
+struct counters {
+  std::uint64_t _packets{ 0 };
+  std::uint64_t _bytes{ 0 };
+  std::set<std::uint32_t> _peers;
+};
+
+std::byte data[1u << 22];
+std::byte other[1u << 22];
+
+emptyspace::pest::suite basic( "index-sketch basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "hyperloglog estimates", []( auto& expect ) {
+    for( std::size_t const n : { 1u, 40u, 3000u, 200000u } ) {
+      riot::hyperloglog hll;
+      for( std::uint64_t i = 0; i < n; ++i ) {
+        hll.add( riot::sketch::mix( i ) );
+        hll.add( riot::sketch::mix( i ) );
+      }
+      expect( close_to( hll.estimate(), n, 0.1 ), equal_to( true ) );
+      expect( hll.dense(), equal_to( n > 200 ) );
+    }
+    // the union of two sets
+    riot::hyperloglog a;
+    riot::hyperloglog b;
+    for( std::uint64_t i = 0; i < 5000; ++i ) { a.add( riot::sketch::mix( i ) ); }
+    for( std::uint64_t i = 4000; i < 9000; ++i ) { b.add( riot::sketch::mix( i ) ); }
+    a.merge( b );
+    expect( close_to( a.estimate(), 9000, 0.1 ), equal_to( true ) );
+    expect( riot::hyperloglog{}.estimate(), equal_to( 0.0 ) );
+  } );
+
+  test( "the sketches of a segment", []( auto& expect ) {
+    auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 4223 };
+    riot::sketch_builder builder;
+    std::map<std::uint32_t, counters> expected;
+    std::uint64_t stamp = 1424219007658518000ull;
+    for( std::uint32_t o = 1; o <= 100000; ++o ) {
+      auto const length = 60 + xo() % 1440;
+      stamp += xo() % 100'000;
+      // a few servers talking to many clients
+      auto const src = 0x0a000000u + xo() % 20000;
+      auto const dst = xo() % 4 == 0 ? src : 0xc0a80000u + xo() % 8;
+      builder.add( src, dst, o, length, stamp );
+      expected[src]._packets++;
+      expected[src]._bytes += length;
+      // a packet counts once per host
+      if( dst != src ) {
+        expected[src]._peers.insert( dst );
+        expected[dst]._peers.insert( src );
+        expected[dst]._packets++;
+        expected[dst]._bytes += length;
+      }
+    }
+    expect( builder.host_count(), equal_to( expected.size() ) );
+    auto const len = serialize( data, builder );
+    riot::sketch_view const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.host_count(), equal_to( expected.size() ) );
+    expect( view.top_count(), equal_to( riot::sketch::TOP ) );
+    expect( view.first() < view.last(), equal_to( true ) );
+    // the servers are heavy hitters with exact counters
+    for( std::uint32_t s = 0xc0a80000u; s < 0xc0a80008u; ++s ) {
+      auto const c = view.counters( s );
+      expect( c._exact, equal_to( true ) );
+      expect( c._packets, equal_to( expected[s]._packets ) );
+      expect( c._bytes, equal_to( expected[s]._bytes ) );
+      riot::hyperloglog peers;
+      expect( view.peers( s, peers ), equal_to( true ) );
+      expect( close_to( peers.estimate(), expected[s]._peers.size(), 0.1 ), equal_to( true ) );
+    }
+    // count-min estimates never underestimate
+    bool above = true;
+    for( auto const& [k, c] : expected ) {
+      auto const e = view.counters( k );
+      above = above and e._packets >= c._packets and e._bytes >= c._bytes;
+    }
+    expect( above, equal_to( true ) );
+    riot::hyperloglog none;
+    expect( view.peers( 0x01020304u, none ), equal_to( false ) );
+    auto const absent = view.counters( 0x01020304u );
+    expect( absent._exact, equal_to( absent._packets == 0 ) );
+  } );
+
+  test( "heavy hitters of many segments", []( auto& expect ) {
+    riot::sketch_builder first;
+    riot::sketch_builder second;
+    // host `1` is a heavy hitter of both segments, host `2` of the second one only
+    for( std::uint32_t o = 0; o < 1000; ++o ) {
+      first.add( 1, 100 + o % 10, o, 1000, o );
+      first.add( 0x10000u + o, 0x20000u + o, o, 10, o );
+      second.add( 1, 200 + o % 20, o, 100, o );
+      second.add( 2, 0x30000u, o, 900, o );
+    }
+    riot::sketch_view const a{ bytestring_view{ data, serialize( data, first ) } };
+    riot::sketch_view const b{ bytestring_view{ other, serialize( other, second ) } };
+    std::vector<riot::sketch_view> const segments{ a, b };
+    auto const top = riot::heavy_hitters( segments, 2 );
+    expect( top.size(), equal_to( 2u ) );
+    expect( top[0]._host, equal_to( 1u ) );
+    expect( top[0]._packets, equal_to( 2000u ) );
+    expect( top[0]._bytes, equal_to( 1'100'000u ) );
+    expect( top[0]._exact, equal_to( true ) );
+    expect( top[1]._host, equal_to( 2u ) );
+    expect( top[1]._bytes >= 900'000u, equal_to( true ) );
+    auto const peers = riot::peers_of( segments, 1 );
+    expect( close_to( peers.estimate(), 30, 0.1 ), equal_to( true ) );
+  } );
+
+  test( "empty and truncated sketches", []( auto& expect ) {
+    riot::sketch_builder const empty;
+    auto const n = serialize( data, empty );
+    riot::sketch_view const view{ bytestring_view{ data, n } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.top_count(), equal_to( 0u ) );
+    expect( view.counters( 42 )._packets, equal_to( 0u ) );
+    expect( view.counters( 42 )._exact, equal_to( true ) );
+    expect( riot::heavy_hitters( { view }, 10 ).empty(), equal_to( true ) );
+    riot::sketch_builder builder;
+    for( std::uint32_t o = 0; o < 1000; ++o ) { builder.add( o, o + 1, o, 64, o ); }
+    auto const len = serialize( data, builder );
+    riot::sketch_view const truncated{ bytestring_view{ data, len - 8 } };
+    expect( truncated.valid(), equal_to( true ) );
+    riot::hyperloglog peers;
+    expect( truncated.peers( 3, peers ), equal_to( true ) );
+    expect( truncated.peers( 999, peers ), equal_to( false ) );
+    riot::sketch_view const header{ bytestring_view{ data, 1024 } };
+    expect( header.valid(), equal_to( false ) );
+    expect( riot::sketch::path( "/data/capture-0001.i4" ) == "/data/capture-0001.sk",
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
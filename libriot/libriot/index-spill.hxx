@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libnygma/bytestream.hxx>
+#include <libriot/index-builder.hxx>
+#include <libriot/index-compactor.hxx>
+#include <libriot/index-compressor.hxx>
+#include <libriot/index-view.hxx>
+#include <libunclassified/femtolog.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include <stdlib.h>
+#include <unistd.h>
+}
+
+namespace riot {
+
+namespace detail {
+
+// the layout of spilled runs: ordinary compressed indices ( `index_view` reads them back )
+template <typename Key, std::size_t BlockLen>
+struct run_serializer;
+
+template <>
+struct run_serializer<std::uint32_t, 128> {
+  using type = svb128d1_serializer<nygma::cfile_ostream>;
+};
+template <>
+struct run_serializer<std::uint32_t, 256> {
+  using type = svb256d1_serializer<nygma::cfile_ostream>;
+};
+template <>
+struct run_serializer<__uint128_t, 128> {
+  using type = pk128_serializer<nygma::cfile_ostream>;
+};
+template <>
+struct run_serializer<__uint128_t, 256> {
+  using type = pk256_serializer<nygma::cfile_ostream>;
+};
+
+// the final merge of the runs: the merged posting lists go straight to the serializer, the keys
+// and list positions stay for the key directory
+template <typename Serializer, typename Key, std::size_t KBlockLen, std::size_t VBlockLen>
+class run_merger {
+  Serializer& _serializer;
+  std::vector<offset_type> _list;
+
+ public:
+  std::vector<Key> _keys;
+  std::vector<offset_type> _positions;
+
+  explicit run_merger( Serializer& s ) noexcept : _serializer{ s } {}
+
+  // a posting spanning a spill is in both runs, skip repetitions like `chunked_vector::push`
+  template <typename It>
+  void add( Key const k, It first, It const last ) {
+    _list.clear();
+    offset_type previous = 0;
+    for( ; first != last; ++first ) {
+      if( *first == previous ) { continue; }
+      previous = *first;
+      _list.push_back( previous );
+    }
+    _keys.push_back( k );
+    _positions.push_back( static_cast<offset_type>( _serializer.current_position() ) );
+    encode_posting_list<Key, KBlockLen, VBlockLen>( _serializer, _list );
+  }
+};
+
+} // namespace detail
+
+// an index builder with a memory budget ( `ny index-pcap --max-builder-memory` ). once `Builder`
+// exceeds `budget` bytes its postings get written as a sorted run to a temporary file and the
+// builder starts over. `accept` merges the runs and the rest in memory ( see `index_compactor` ),
+// the output is the same as the one of a `Builder` without budget.
+//
+// `add` is called from `index_trace` and must not throw: if a run can not be written the postings
+// stay in memory and the builder stops spilling, no posting gets lost. if the last run can not be
+// written either the runs get read back into memory.
+//
+// the runs are compressed indices with segment offset `0`, the merge keeps the keys of all runs
+// and one posting list in memory. without runs it is `Builder` plus one comparison per posting.
+template <typename Builder>
+class index_spilling {
+ public:
+  using builder_type = Builder;
+  using key_type = typename Builder::key_type;
+
+ private:
+  using run_serializer_type = typename detail::run_serializer<key_type, Builder::KBLOCKLEN>::type;
+
+  Builder _builder;
+  std::size_t _budget;
+  std::filesystem::path _directory;
+  std::vector<std::filesystem::path> _runs;
+  bool _spilling{ true };
+
+ public:
+  // a `budget` of `0` never spills
+  explicit index_spilling( std::size_t const budget = 0 )
+    : index_spilling( budget, std::filesystem::temp_directory_path() ) {}
+
+  index_spilling( std::size_t const budget, std::filesystem::path directory )
+    : _budget{ budget }, _directory{ std::move( directory ) } {}
+
+  ~index_spilling() noexcept { remove_runs(); }
+
+  index_spilling( index_spilling const& ) = delete;
+  index_spilling& operator=( index_spilling const& ) = delete;
+
+  inline void add( key_type const k, offset_type const o ) {
+    _builder.add( k, o );
+    if( _spilling and _budget != 0 and _builder.memory() > _budget ) { spill(); }
+  }
+
+  template <typename It>
+  void add( key_type const k, It first, It const last ) {
+    _builder.add( k, first, last );
+    if( _spilling and _budget != 0 and _builder.memory() > _budget ) { spill(); }
+  }
+
+  // the same budget for the next segment
+  std::unique_ptr<index_spilling> fresh() const {
+    return std::make_unique<index_spilling>( _budget, _directory );
+  }
+
+  // the postings of `o` come after the ones of `this`, see `index_shards::take`
+  void merge( index_spilling&& o ) {
+    _builder.merge( std::move( o._builder ) );
+    _runs.insert( _runs.end(), o._runs.begin(), o._runs.end() );
+    o._runs.clear();
+  }
+
+  std::size_t run_count() const noexcept { return _runs.size(); }
+  std::size_t budget() const noexcept { return _budget; }
+  std::size_t memory() const noexcept { return _builder.memory(); }
+
+  auto key_count() const {
+    if( _runs.empty() ) { return _builder.key_count(); }
+    return merged_keys().size();
+  }
+
+  template <typename F>
+  void for_each_key( F&& f ) const {
+    if( _runs.empty() ) { return _builder.for_each_key( std::forward<F>( f ) ); }
+    for( auto const k : merged_keys() ) { f( k ); }
+  }
+
+  // like `index_builder::accept` this invalidates the builder
+  void accept( serializer<key_type, Builder::KBLOCKLEN, Builder::VBLOCKLEN> auto& serializer,
+               std::uint64_t const segment_begin ) {
+    if( not _runs.empty() and _builder.key_count() > 0 and not spill() ) { unspill(); }
+    if( _runs.empty() ) { return _builder.accept( serializer, segment_begin ); }
+    // the compactor points into the handles, no reallocations
+    std::vector<index_view_handle> runs;
+    runs.reserve( _runs.size() );
+    index_compactor<key_type> compactor{ 0 };
+    for( auto const& p : _runs ) {
+      runs.emplace_back( make_poly_index_view( p ) );
+      compactor.add( *runs.back(), 0 );
+    }
+    using serializer_type = std::remove_reference_t<decltype( serializer )>;
+    detail::run_merger<serializer_type, key_type, Builder::KBLOCKLEN, Builder::VBLOCKLEN> merger{
+        serializer };
+    compactor.merge( merger );
+    runs.clear();
+    remove_runs();
+    encode_directory<key_type, Builder::KBLOCKLEN, Builder::VBLOCKLEN>(
+        serializer,
+        [&]( auto const f ) {
+          for( std::size_t i = 0; i < merger._keys.size(); ++i ) {
+            f( merger._keys[i], merger._positions[i] );
+          }
+        },
+        merger._keys.size(), segment_begin );
+  }
+
+ private:
+  // `false` if the run can not be written, the postings stay in `_builder` then
+  bool spill() {
+    auto tmpl = ( _directory / "riot-run-XXXXXX" ).string();
+    auto const fd = ::mkstemp( tmpl.data() );
+    if( fd < 0 ) {
+      flog( lvl::e, "unable to create a spill run in directory = ", _directory );
+      _spilling = false;
+      return false;
+    }
+    ::close( fd );
+    if( not write_run( tmpl ) ) {
+      flog( lvl::e, "unable to write spill run path = ", tmpl );
+      std::error_code ec;
+      std::filesystem::remove( tmpl, ec );
+      _spilling = false;
+      return false;
+    }
+    _runs.emplace_back( tmpl );
+    _builder = Builder{};
+    return true;
+  }
+
+  // writes the postings of `_builder` as a run to `p`, unlike `accept` this keeps the builder
+  bool write_run( std::filesystem::path const& p ) const {
+    std::int64_t size = 0;
+    {
+      nygma::cfile_ostream os{ p };
+      if( os.invalid() ) { return false; }
+      run_serializer_type s{ os };
+      detail::run_merger<run_serializer_type, key_type, Builder::KBLOCKLEN, Builder::VBLOCKLEN>
+          merger{ s };
+      _builder.for_each_posting_list(
+          [&]( auto const k, auto const first, auto const last ) { merger.add( k, first, last ); } );
+      encode_directory<key_type, Builder::KBLOCKLEN, Builder::VBLOCKLEN>(
+          s,
+          [&]( auto const f ) {
+            for( std::size_t i = 0; i < merger._keys.size(); ++i ) {
+              f( merger._keys[i], merger._positions[i] );
+            }
+          },
+          merger._keys.size(), 0 );
+      if( not os.ok() ) { return false; }
+      size = os.current_position();
+    }
+    // the buffered rest gets written on close
+    std::error_code ec;
+    auto const written = std::filesystem::file_size( p, ec );
+    return not ec and written == static_cast<std::uintmax_t>( size );
+  }
+
+  // the runs go back into memory, their postings come before the ones of `_builder`
+  void unspill() {
+    Builder all;
+    std::vector<index_view_handle> runs;
+    runs.reserve( _runs.size() );
+    index_compactor<key_type> compactor{ 0 };
+    for( auto const& p : _runs ) {
+      runs.emplace_back( make_poly_index_view( p ) );
+      compactor.add( *runs.back(), 0 );
+    }
+    compactor.merge( all );
+    runs.clear();
+    remove_runs();
+    _builder.for_each_posting_list(
+        [&]( auto const k, auto const first, auto const last ) { all.add( k, first, last ); } );
+    _builder = std::move( all );
+  }
+
+  // the distinct keys of the runs and the builder in ascending order
+  std::vector<key_type> merged_keys() const {
+    std::vector<key_type> keys;
+    for( auto const& p : _runs ) {
+      auto const run = make_poly_index_view( p );
+      if constexpr( sizeof( key_type ) == 16 ) {
+        run->collect_keys_128( keys );
+      } else {
+        run->collect_keys_32( keys );
+      }
+    }
+    _builder.for_each_key( [&]( auto const k ) { keys.push_back( k ); } );
+    std::sort( keys.begin(), keys.end() );
+    keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+    return keys;
+  }
+
+  void remove_runs() noexcept {
+    std::error_code ec;
+    for( auto const& p : _runs ) { std::filesystem::remove( p, ec ); }
+    _runs.clear();
+  }
+};
+
+} // namespace riot
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-bulk-builder.hxx>
+#include <libriot/index-compressor.hxx>
+#include <libriot/index-serializer.hxx>
+#include <libriot/index-shards.hxx>
+#include <libriot/index-spill.hxx>
+
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+extern "C" {
+#include <sys/resource.h>
+}
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+
+using map4_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using bulk4_type = riot::index_bulk_builder<std::uint32_t, 128>;
+using map6_type = riot::index_builder<__uint128_t, map_type, 128>;
+using bulk6_type = riot::index_bulk_builder<__uint128_t, 128>;
+
+template <template <typename> typename S, typename I>
+std::vector<std::byte> serialize( I& i ) {
+  std::vector<std::byte> data( 8u << 20 );
+  std::size_t n;
+  {
+    auto os = nygma::cfile_ostream{ data.data(), data.size() };
+    S<nygma::cfile_ostream> s{ os };
+    i.accept( s, 2342 );
+    n = static_cast<std::size_t>( os.current_position() );
+  }
+  data.resize( n );
+  return data;
+}
+
+// ascending offsets, repeated ones ( a packet adds a key twice ) included
+template <typename F>
+void generate( std::uint32_t const seed, std::uint32_t const keys, F&& f ) {
+  auto xo = emptyspace::xoshiro::xoshiro128starstar32{ seed };
+  std::uint32_t o = 24;
+  for( unsigned i = 0; i < 50000; ++i ) {
+    auto const k = xo() % keys;
+    f( k, o );
+    if( xo() % 4 == 0 ) { f( k, o ); }
+    o += 1 + xo() % 1500;
+  }
+}
+
+std::size_t run_files() {
+  namespace fs = std::filesystem;
+  std::size_t n = 0;
+  for( auto const& e : fs::directory_iterator( fs::temp_directory_path() ) ) {
+    if( e.path().filename().string().starts_with( "riot-run-" ) ) { n++; }
+  }
+  return n;
+}
+
+// files can not grow beyond `limit` bytes, writes fail instead of raising `SIGXFSZ`
+void limit_file_size( rlim_t const limit ) {
+  std::signal( SIGXFSZ, SIG_IGN );
+  rlimit r;
+  ::getrlimit( RLIMIT_FSIZE, &r );
+  r.rlim_cur = limit;
+  ::setrlimit( RLIMIT_FSIZE, &r );
+}
+
+// the spilling builder with a small budget against the plain one
+template <typename Builder, template <typename> typename S, typename K>
+bool same( K const key ) {
+  Builder b;
+  riot::index_spilling<Builder> s{ 16u << 10 };
+  generate( 1337, 2000, [&]( auto const k, auto const o ) {
+    b.add( key( k ), o );
+    s.add( key( k ), o );
+  } );
+  if( s.run_count() < 2 ) { return false; }
+  if( s.key_count() != b.key_count() ) { return false; }
+  std::vector<typename Builder::key_type> bk, sk;
+  b.for_each_key( [&]( auto const k ) { bk.push_back( k ); } );
+  s.for_each_key( [&]( auto const k ) { sk.push_back( k ); } );
+  return bk == sk and serialize<S>( s ) == serialize<S>( b );
+}
+
+emptyspace::pest::suite basic( "index-spill suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  auto const k4 = []( std::uint32_t const k ) { return k; };
+  auto const k6 = []( std::uint32_t const k ) {
+    return __uint128_t( 0x20010db8u ) << 96 | __uint128_t( k % 7 ) << 64 | k;
+  };
+
+  test( "spilled runs merge into the same index", [&]( auto& expect ) {
+    auto const before = run_files();
+    expect( same<map4_type, riot::svb128d1_serializer>( k4 ), equal_to( true ) );
+    expect( same<bulk4_type, riot::svb128d1_serializer>( k4 ), equal_to( true ) );
+    expect( same<map4_type, riot::uc128_serializer>( k4 ), equal_to( true ) );
+    // `encode_postings` instead of blocks
+    expect( same<bulk4_type, riot::pef128_serializer>( k4 ), equal_to( true ) );
+    expect( same<map6_type, riot::pk128_serializer>( k6 ), equal_to( true ) );
+    expect( same<bulk6_type, riot::pk128_serializer>( k6 ), equal_to( true ) );
+    expect( run_files(), equal_to( before ) );
+  } );
+
+  test( "no budget no runs", []( auto& expect ) {
+    riot::index_spilling<map4_type> s;
+    map4_type b;
+    generate( 4223, 500, [&]( auto const k, auto const o ) {
+      b.add( k, o );
+      s.add( k, o );
+    } );
+    expect( s.run_count(), equal_to( 0u ) );
+    expect( serialize<riot::bp128d1_serializer>( s ) == serialize<riot::bp128d1_serializer>( b ),
+            equal_to( true ) );
+  } );
+
+  test( "a posting spanning a spill and merging", []( auto& expect ) {
+    riot::index_spilling<bulk4_type> s{ 1 };
+    riot::index_spilling<bulk4_type> t{ 1 };
+    map4_type b;
+    s.add( 42, 10 );
+    s.add( 42, 10 );
+    t.add( 23, 20 );
+    t.add( 42, 30 );
+    b.add( 42, 10 );
+    b.add( 23, 20 );
+    b.add( 42, 30 );
+    expect( s.run_count(), equal_to( 2u ) );
+    auto fresh = s.fresh();
+    expect( fresh->budget(), equal_to( 1u ) );
+    s.merge( std::move( t ) );
+    expect( s.run_count(), equal_to( 4u ) );
+    expect( t.run_count(), equal_to( 0u ) );
+    expect( s.key_count(), equal_to( 2u ) );
+    expect( serialize<riot::uc128_serializer>( s ) == serialize<riot::uc128_serializer>( b ),
+            equal_to( true ) );
+    expect( s.run_count(), equal_to( 0u ) );
+  } );
+
+  test( "runs that can not be created stay in memory", []( auto& expect ) {
+    auto const missing = std::filesystem::temp_directory_path() / "riot-missing" / "directory";
+    riot::index_spilling<map4_type> s{ 1, missing };
+    map4_type b;
+    generate( 4223, 500, [&]( auto const k, auto const o ) {
+      b.add( k, o );
+      s.add( k, o );
+    } );
+    expect( s.run_count(), equal_to( 0u ) );
+    expect( serialize<riot::svb128d1_serializer>( s ) == serialize<riot::svb128d1_serializer>( b ),
+            equal_to( true ) );
+  } );
+
+  test( "runs that can not be written stay in memory", []( auto& expect ) {
+    auto const before = run_files();
+    riot::index_spilling<map4_type> s{ 16u << 10 };
+    map4_type b;
+    std::size_t n = 0;
+    std::size_t runs = 0;
+    generate( 1337, 2000, [&]( auto const k, auto const o ) {
+      // the first half spills, the second one fails to
+      if( ++n == 25000 ) {
+        runs = s.run_count();
+        limit_file_size( 64 );
+      }
+      b.add( k, o );
+      s.add( k, o );
+    } );
+    limit_file_size( RLIM_INFINITY );
+    expect( runs > 0, equal_to( true ) );
+    expect( s.run_count(), equal_to( runs ) );
+    expect( run_files(), equal_to( before + runs ) );
+    expect( serialize<riot::svb128d1_serializer>( s ) == serialize<riot::svb128d1_serializer>( b ),
+            equal_to( true ) );
+    expect( run_files(), equal_to( before ) );
+  } );
+
+  test( "sharded spilling builders", []( auto& expect ) {
+    using spilling_type = riot::index_spilling<map4_type>;
+    riot::index_shards<spilling_type> shards{ 3, spilling_type{ 8u << 10 } };
+    map4_type b;
+    generate( 2342, 1000, [&]( auto const k, auto const o ) {
+      b.add( k, o );
+      shards.add( k, o );
+    } );
+    auto merged = shards.take();
+    expect( merged->budget(), equal_to( 8u << 10 ) );
+    expect( merged->run_count() >= 3, equal_to( true ) );
+    expect( serialize<riot::svb128d1_serializer>( *merged ) ==
+                serialize<riot::svb128d1_serializer>( b ),
+            equal_to( true ) );
+    expect( shards.take()->budget(), equal_to( 8u << 10 ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+// per key counters next to the index files ( `ny index-pcap --key-stats` ): the packets and
+// captured bytes of every key of a segment and its first and last timestamp. "bytes per host" or
+// "top talkers" are answered from the counters ( `ny index-info`, `ny query 'stats( ... )'` )
+// instead of slicing all packets of a key.
+//
+// the counters of the index file `<stem>-NNNN<suffix>` are in `<stem>-NNNN<suffix>s`. keys are
+// sorted and grouped in blocks of 128, the first key of every block locates the block of a key,
+// a lookup decodes one block only.
+//
+//   [ MAGIC:4 ][ keysize:1 ][ reserved:3 ][ keys:4 ][ blocks:4 ][ base:8 ]
+//   [ key:keysize ] x blocks                           <- the first key of every block
+//   [ position:4 ] x ( blocks + 1 )                    <- relative to the blocks
+//   [ block ] x blocks
+//
+// the packets and bytes of a block are bitpacked as running sums ( `bp128d1` ), the deltas are
+// the counters of the keys. the timestamps are varints ( `vbkey` ) of the first timestamp
+// relative to `base` ( the earliest of the segment ) and of the time between first and last.
+//
+//   block = [ key:keysize ] x n [ packets ][ bytes ] ( [ first ][ last - first ] ) x n
+
+#include <libnygma/bytestream.hxx>
+#include <libnygma/mmap.hxx>
+#include <libriot/compress-bitpack-simd.hxx>
+#include <libriot/compress-vbyte.hxx>
+#include <libriot/index-builder.hxx>
+#include <libunclassified/bytestring.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace riot {
+
+namespace unsafe = unclassified::unsafe;
+
+namespace stats {
+
+using compressor_type = bitpack::bp128d1;
+
+constexpr std::uint32_t MAGIC = 0x1337133bu;
+constexpr std::size_t HEADER_SIZE = 24;
+constexpr std::size_t BLOCKLEN = compressor_type::BLOCKLEN;
+// a varint takes up to 9 bytes
+constexpr std::size_t MAX_VARINT_SIZE = 9;
+
+// the counters belonging to the index file `<stem>-NNNN<suffix>`
+inline std::filesystem::path path( std::filesystem::path const& index ) {
+  auto p = index;
+  p += "s";
+  return p;
+}
+
+template <typename Key>
+inline void write_key( std::byte* const p, Key const k ) noexcept {
+  constexpr auto LE = unclassified::endianess::LE;
+  if constexpr( sizeof( Key ) == 16 ) {
+    unsafe::wr128<LE>( p, k );
+  } else {
+    unsafe::wr32<LE>( p, k );
+  }
+}
+
+template <typename Key>
+inline Key read_key( std::byte const* const p ) noexcept {
+  constexpr auto LE = unclassified::endianess::LE;
+  if constexpr( sizeof( Key ) == 16 ) {
+    return unsafe::rd128<LE>( p );
+  } else {
+    return unsafe::rd32<LE>( p );
+  }
+}
+
+// ipv6 keys have no `std::hash`
+struct key_hash {
+  std::size_t operator()( std::uint32_t const k ) const noexcept {
+    return std::hash<std::uint32_t>{}( k );
+  }
+  std::size_t operator()( __uint128_t const k ) const noexcept {
+    auto const lo = static_cast<std::uint64_t>( k );
+    auto const hi = static_cast<std::uint64_t>( k >> 64 );
+    return std::hash<std::uint64_t>{}( lo ^ ( hi * 0x9e3779b97f4a7c15ull ) );
+  }
+};
+
+} // namespace stats
+
+// the packets of a key, `_bytes` are the captured bytes of the packets
+struct key_stats {
+  std::uint64_t _packets{ 0 };
+  std::uint64_t _bytes{ 0 };
+  std::uint64_t _first{ std::numeric_limits<std::uint64_t>::max() };
+  std::uint64_t _last{ 0 };
+
+  bool empty() const noexcept { return _packets == 0; }
+
+  void add( std::uint32_t const length, std::uint64_t const stamp ) noexcept {
+    _packets++;
+    _bytes += length;
+    _first = std::min( _first, stamp );
+    _last = std::max( _last, stamp );
+  }
+
+  // the counters of the key in another segment
+  void merge( key_stats const& o ) noexcept {
+    _packets += o._packets;
+    _bytes += o._bytes;
+    _first = std::min( _first, o._first );
+    _last = std::max( _last, o._last );
+  }
+};
+
+template <typename Key>
+class key_stats_builder {
+  static constexpr auto LE = unclassified::endianess::LE;
+
+  struct entry {
+    key_stats _stats;
+    // a packet counts once per key, even with the key in two of its headers
+    offset_type _posting{ std::numeric_limits<offset_type>::max() };
+  };
+
+  std::unordered_map<Key, entry, stats::key_hash> _keys;
+
+ public:
+  using key_type = Key;
+
+  // `posting` identifies the packet within the segment ( its offset or ordinal )
+  void add( key_type const k, offset_type const posting, std::uint32_t const length,
+            std::uint64_t const stamp ) {
+    auto& e = _keys[k];
+    if( e._posting == posting ) { return; }
+    e._posting = posting;
+    e._stats.add( length, stamp );
+  }
+
+  auto key_count() const noexcept { return _keys.size(); }
+  bool empty() const noexcept { return _keys.empty(); }
+  void clear() noexcept { _keys.clear(); }
+
+  key_stats lookup( key_type const k ) const noexcept {
+    auto const it = _keys.find( k );
+    return it == _keys.end() ? key_stats{} : it->second._stats;
+  }
+
+  template <typename OStream>
+  void accept( OStream& os ) const {
+    using C = stats::compressor_type;
+    using value_type = std::pair<key_type, key_stats>;
+    std::vector<value_type> sorted;
+    sorted.reserve( _keys.size() );
+    std::uint64_t base = std::numeric_limits<std::uint64_t>::max();
+    for( auto const& [k, e] : _keys ) {
+      sorted.emplace_back( k, e._stats );
+      base = std::min( base, e._stats._first );
+    }
+    std::sort( sorted.begin(), sorted.end(),
+               []( auto const& a, auto const& b ) { return a.first < b.first; } );
+    if( sorted.empty() ) { base = 0; }
+
+    auto const n = sorted.size();
+    auto const blocks = ( n + stats::BLOCKLEN - 1 ) / stats::BLOCKLEN;
+    std::vector<std::byte> fences( sizeof( key_type ) * blocks );
+    std::vector<std::byte> positions( 4 * ( blocks + 1 ) );
+    std::vector<std::byte> records;
+    std::array<std::byte, C::estimate_compressed_size()> scrtch;
+    std::array<offset_type, stats::BLOCKLEN> column;
+    std::byte key[sizeof( key_type )];
+    std::byte varint[stats::MAX_VARINT_SIZE];
+    // running sums, the counters of a segment wrap around like the deltas of `bp128d1`
+    auto const encode = [&]( std::size_t const first, std::size_t const used, auto&& counter ) {
+      offset_type sum = 0;
+      for( std::size_t j = 0; j < used; ++j ) {
+        sum += static_cast<offset_type>( counter( sorted[first + j].second ) );
+        column[j] = sum;
+      }
+      if( used != stats::BLOCKLEN ) {
+        fill_block<offset_type, stats::BLOCKLEN>( column.data(), used );
+      }
+      auto const m = C::encode( column.data(), stats::BLOCKLEN, scrtch.data() );
+      records.insert( records.end(), scrtch.data(), scrtch.data() + m );
+    };
+    auto const append_varint = [&]( std::uint64_t const x ) {
+      auto const m = vbkey::encode( varint, x );
+      records.insert( records.end(), varint, varint + m );
+    };
+    for( std::size_t i = 0; i < blocks; ++i ) {
+      auto const first = i * stats::BLOCKLEN;
+      auto const used = std::min( n - first, stats::BLOCKLEN );
+      stats::write_key( fences.data() + sizeof( key_type ) * i, sorted[first].first );
+      unsafe::wr32<LE>( positions.data() + 4 * i, static_cast<std::uint32_t>( records.size() ) );
+      for( std::size_t j = 0; j < used; ++j ) {
+        stats::write_key( key, sorted[first + j].first );
+        records.insert( records.end(), key, key + sizeof( key_type ) );
+      }
+      encode( first, used, []( key_stats const& s ) { return s._packets; } );
+      encode( first, used, []( key_stats const& s ) { return s._bytes; } );
+      for( std::size_t j = 0; j < used; ++j ) {
+        auto const& s = sorted[first + j].second;
+        append_varint( s._first - base );
+        append_varint( s._last - s._first );
+      }
+    }
+    unsafe::wr32<LE>( positions.data() + 4 * blocks, static_cast<std::uint32_t>( records.size() ) );
+
+    std::byte header[stats::HEADER_SIZE]{};
+    unsafe::wr32<LE>( header, stats::MAGIC );
+    header[4] = std::byte( sizeof( key_type ) );
+    unsafe::wr32<LE>( header + 8, static_cast<std::uint32_t>( n ) );
+    unsafe::wr32<LE>( header + 12, static_cast<std::uint32_t>( blocks ) );
+    unsafe::wr64<LE>( header + 16, base );
+    os.write( header, stats::HEADER_SIZE );
+    os.write( fences.data(), fences.size() );
+    os.write( positions.data(), positions.size() );
+    os.write( records.data(), records.size() );
+  }
+
+  bool write( std::filesystem::path const& p ) const {
+    nygma::cfile_ostream os{ p };
+    accept( os );
+    return os.ok();
+  }
+};
+
+//--read-only-access------------------------------------------------------------
+
+template <typename Key>
+class key_stats_view {
+  static constexpr auto LE = unclassified::endianess::LE;
+  static constexpr std::size_t KEYSZ = sizeof( Key );
+
+  std::byte const* _fences{ nullptr };
+  std::byte const* _positions{ nullptr };
+  std::byte const* _records{ nullptr };
+  std::size_t _records_size{ 0 };
+  std::size_t _count{ 0 };
+  std::size_t _blocks{ 0 };
+  std::uint64_t _base{ 0 };
+  // not thread safe, like `ordinal_table_view`
+  mutable std::size_t _cached{ std::numeric_limits<std::size_t>::max() };
+  mutable std::size_t _used{ 0 };
+  mutable std::array<Key, stats::BLOCKLEN> _keys;
+  mutable std::array<key_stats, stats::BLOCKLEN> _stats;
+
+ public:
+  using key_type = Key;
+
+  key_stats_view() = default;
+
+  // an invalid view for truncated or foreign data or counters of other keys
+  explicit key_stats_view( unclassified::bytestring_view const data ) noexcept {
+    if( data.size() < stats::HEADER_SIZE ) { return; }
+    auto const* const p = data.begin();
+    if( unsafe::rd32<LE>( p ) != stats::MAGIC ) { return; }
+    if( std::to_integer<std::size_t>( p[4] ) != KEYSZ ) { return; }
+    std::size_t const count = unsafe::rd32<LE>( p + 8 );
+    std::size_t const blocks = unsafe::rd32<LE>( p + 12 );
+    if( blocks != ( count + stats::BLOCKLEN - 1 ) / stats::BLOCKLEN ) { return; }
+    auto const records = stats::HEADER_SIZE + KEYSZ * blocks + 4 * ( blocks + 1 );
+    if( records > data.size() ) { return; }
+    _fences = p + stats::HEADER_SIZE;
+    _positions = _fences + KEYSZ * blocks;
+    _records = p + records;
+    _records_size = data.size() - records;
+    _count = count;
+    _blocks = blocks;
+    _base = unsafe::rd64<LE>( p + 16 );
+  }
+
+  bool valid() const noexcept { return _fences != nullptr; }
+  auto size() const noexcept { return _count; }
+
+  // the counters of `k`, empty for unknown keys
+  key_stats lookup( key_type const k ) const noexcept {
+    // the last block starting at or before `k`
+    std::size_t lo = 0;
+    std::size_t hi = _blocks;
+    while( lo < hi ) {
+      auto const mid = lo + ( hi - lo ) / 2;
+      if( stats::read_key<key_type>( _fences + KEYSZ * mid ) <= k ) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if( lo == 0 ) { return {}; }
+    auto const b = lo - 1;
+    if( b != _cached and not decode( b ) ) { return {}; }
+    auto const* const begin = _keys.data();
+    auto const* const end = begin + _used;
+    auto const* const it = std::lower_bound( begin, end, k );
+    if( it == end or *it != k ) { return {}; }
+    return _stats[static_cast<std::size_t>( it - begin )];
+  }
+
+  // all keys in ascending order with their counters, `false` for truncated data
+  template <typename F>
+  bool for_each( F&& f ) const {
+    for( std::size_t b = 0; b < _blocks; ++b ) {
+      if( b != _cached and not decode( b ) ) { return false; }
+      for( std::size_t j = 0; j < _used; ++j ) { f( _keys[j], _stats[j] ); }
+    }
+    return true;
+  }
+
+ private:
+  bool decode( std::size_t const b ) const noexcept {
+    using C = stats::compressor_type;
+    std::size_t begin = unsafe::rd32<LE>( _positions + 4 * b );
+    std::size_t const end = unsafe::rd32<LE>( _positions + 4 * ( b + 1 ) );
+    if( begin >= end or end > _records_size ) { return false; }
+    auto const used = std::min( _count - b * stats::BLOCKLEN, stats::BLOCKLEN );
+    if( KEYSZ * used >= end - begin ) { return false; }
+    for( std::size_t j = 0; j < used; ++j ) {
+      _keys[j] = stats::read_key<key_type>( _records + begin + KEYSZ * j );
+    }
+    begin += KEYSZ * used;
+    std::array<offset_type, stats::BLOCKLEN> column;
+    auto const counters = [&]( auto const set ) {
+      if( begin >= end ) { return false; }
+      begin += C::decode( _records + begin, end - begin, column.data() );
+      offset_type previous = 0;
+      for( std::size_t j = 0; j < used; ++j ) {
+        set( _stats[j], column[j] - previous );
+        previous = column[j];
+      }
+      return true;
+    };
+    if( not counters( []( key_stats& s, offset_type const x ) { s._packets = x; } ) ) {
+      return false;
+    }
+    if( not counters( []( key_stats& s, offset_type const x ) { s._bytes = x; } ) ) {
+      return false;
+    }
+    auto const varint = [&]( std::uint64_t& x ) {
+      if( begin >= end ) { return false; }
+      // `vbkey::decode` does not write, the records are read-only
+      auto* const p = const_cast<std::byte*>( _records + begin );
+      auto const n = vbkey::ndecode( p );
+      if( n > end - begin ) { return false; }
+      x = vbkey::decode( p, n );
+      begin += n;
+      return true;
+    };
+    for( std::size_t j = 0; j < used; ++j ) {
+      std::uint64_t first, span;
+      if( not varint( first ) or not varint( span ) ) { return false; }
+      _stats[j]._first = _base + first;
+      _stats[j]._last = _stats[j]._first + span;
+    }
+    _used = used;
+    _cached = b;
+    return true;
+  }
+};
+
+// the counters of an index file, the handle owns the mapping
+template <typename Key>
+class key_stats_file {
+  std::unique_ptr<nygma::mmap_view> _map;
+  key_stats_view<Key> _view;
+
+ public:
+  explicit key_stats_file( std::filesystem::path const& p )
+    : _map{ std::make_unique<nygma::mmap_view>( p ) }, _view{ _map->view() } {
+    if( not _view.valid() ) { throw std::runtime_error( "INVALID_KEY_STATS" ); }
+  }
+
+  // the counters of the index file `index`, `nullptr` if it has none
+  static std::unique_ptr<key_stats_file> of( std::filesystem::path const& index ) {
+    auto const p = stats::path( index );
+    std::error_code ec;
+    if( not std::filesystem::exists( p, ec ) ) { return nullptr; }
+    return std::make_unique<key_stats_file>( p );
+  }
+
+  auto const& operator*() const noexcept { return _view; }
+  auto const* operator->() const noexcept { return &_view; }
+};
+
+} // namespace riot
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+#include <pest/xoshiro.hxx>
+
+#include <libriot/index-stats.hxx>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace {
+
+using bytestring_view = unclassified::bytestring_view;
+
+template <std::size_t N, typename Key>
+std::size_t serialize( std::byte ( &data )[N], riot::key_stats_builder<Key> const& stats ) {
+  auto os = nygma::cfile_ostream{ data };
+  stats.accept( os );
+  return static_cast<std::size_t>( os.current_position() );
+}
+
+bool same( riot::key_stats const& a, riot::key_stats const& b ) {
+  return a._packets == b._packets and a._bytes == b._bytes and a._first == b._first and
+         a._last == b._last;
+}
+
+std::byte data[1u << 20];
+
+emptyspace::pest::suite basic( "index-stats basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "the counters of every key", []( auto& expect ) {
+    auto xo = emptyspace::xoshiro::xoshiro128starstar32{ 4223 };
+    riot::key_stats_builder<std::uint32_t> builder;
+    std::map<std::uint32_t, riot::key_stats> expected;
+    std::uint64_t stamp = 1424219007658518000ull;
+    for( std::uint32_t o = 1; o <= 20000; ++o ) {
+      auto const length = 60 + xo() % 1440;
+      // a few gaps beyond `2^32` nanoseconds
+      stamp += xo() % 500 == 0 ? 7'000'000'000ull : xo() % 100'000;
+      auto const src = xo() % 1000;
+      auto const dst = xo() % 3 == 0 ? src : 1000 + xo() % 50;
+      builder.add( src, o, length, stamp );
+      builder.add( dst, o, length, stamp );
+      expected[src].add( length, stamp );
+      // a packet counts once per key
+      if( dst != src ) { expected[dst].add( length, stamp ); }
+    }
+    expect( builder.key_count(), equal_to( expected.size() ) );
+    auto const len = serialize( data, builder );
+    riot::key_stats_view<std::uint32_t> const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.size(), equal_to( expected.size() ) );
+    bool all = true;
+    for( auto const& [k, s] : expected ) { all = all and same( view.lookup( k ), s ); }
+    expect( all, equal_to( true ) );
+    expect( view.lookup( 1050 ).empty(), equal_to( true ) );
+    expect( view.lookup( 0xffffffffu ).empty(), equal_to( true ) );
+    // in ascending order
+    std::vector<std::uint32_t> keys;
+    all = view.for_each( [&]( auto const k, auto const& s ) {
+      all = all and same( s, expected[k] );
+      keys.push_back( k );
+    } );
+    expect( all, equal_to( true ) );
+    expect( keys.size(), equal_to( expected.size() ) );
+    expect( std::is_sorted( keys.begin(), keys.end() ), equal_to( true ) );
+  } );
+
+  test( "ipv6 keys", []( auto& expect ) {
+    riot::key_stats_builder<__uint128_t> builder;
+    auto const k = []( std::uint32_t const i ) { return __uint128_t( 0x20010db8u ) << 96 | i; };
+    for( std::uint32_t o = 0; o < 300; ++o ) { builder.add( k( o % 200 ), o, 100 + o, 1000 + o ); }
+    auto const len = serialize( data, builder );
+    riot::key_stats_view<__uint128_t> const view{ bytestring_view{ data, len } };
+    expect( view.valid(), equal_to( true ) );
+    auto const s = view.lookup( k( 150 ) );
+    expect( s._packets, equal_to( 1u ) );
+    expect( s._bytes, equal_to( 250u ) );
+    auto const t = view.lookup( k( 42 ) );
+    expect( t._packets, equal_to( 2u ) );
+    expect( t._bytes, equal_to( 142u + 342u ) );
+    expect( t._first, equal_to( 1042u ) );
+    expect( t._last, equal_to( 1242u ) );
+    expect( view.lookup( k( 200 ) ).empty(), equal_to( true ) );
+    // the counters of other keys
+    riot::key_stats_view<std::uint32_t> const other{ bytestring_view{ data, len } };
+    expect( other.valid(), equal_to( false ) );
+  } );
+
+  test( "empty and truncated counters", []( auto& expect ) {
+    riot::key_stats_builder<std::uint32_t> const empty;
+    auto const n = serialize( data, empty );
+    riot::key_stats_view<std::uint32_t> const view{ bytestring_view{ data, n } };
+    expect( view.valid(), equal_to( true ) );
+    expect( view.lookup( 42 ).empty(), equal_to( true ) );
+    riot::key_stats_builder<std::uint32_t> builder;
+    for( std::uint32_t o = 0; o < 1000; ++o ) { builder.add( o, o, 64, o ); }
+    auto const len = serialize( data, builder );
+    riot::key_stats_view<std::uint32_t> const truncated{ bytestring_view{ data, len - 16 } };
+    expect( truncated.valid(), equal_to( true ) );
+    expect( truncated.lookup( 3 )._packets, equal_to( 1u ) );
+    expect( truncated.lookup( 999 ).empty(), equal_to( true ) );
+    expect( truncated.for_each( []( auto, auto const& ) {} ), equal_to( false ) );
+    riot::key_stats_view<std::uint32_t> const header{ bytestring_view{ data, 16 } };
+    expect( header.valid(), equal_to( false ) );
+    expect( riot::stats::path( "/data/capture-0001.i4" ) == "/data/capture-0001.i4s",
+            equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
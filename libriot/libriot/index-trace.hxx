@@ -2,20 +2,36 @@
 
 #pragma once
 
+#include <libnygma/dissect-simd.hxx>
 #include <libnygma/dissect.hxx>
+#include <libnygma/flow.hxx>
+#include <libnygma/fragment-table.hxx>
 #include <libriot/index-builder.hxx>
+#include <libriot/index-ordinals.hxx>
+#include <libriot/index-sketch.hxx>
+#include <libriot/index-stats.hxx>
 #include <libunclassified/bytestring.hxx>
 
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
 namespace riot {
 
 namespace unsafe = unclassified::unsafe;
 namespace dissect = nygma::dissect;
 using endianess = unclassified::endianess;
 
-template <typename V4IndexType, typename PortIndexType>
+// the flow index maps the symmetric flow hash of the innermost ip header ( see `nygma::flow_hash` )
+// to the packets of the flow, one posting per packet
+template <typename V4IndexType, typename PortIndexType, typename V6IndexType,
+          typename FlowIndexType>
 struct index_trace : public nygma::dissect::dissect_trace {
   using v4_index_type = V4IndexType;
   using port_index_type = PortIndexType;
+  using v6_index_type = V6IndexType;
+  using flow_index_type = FlowIndexType;
 
   static constexpr std::uint64_t SEGMENTSZ = ( 1ull << 32 ) - ( 4ull << 10 );
 
@@ -23,72 +39,247 @@ struct index_trace : public nygma::dissect::dissect_trace {
   std::uint64_t _v4_count{ 0 };
   std::uint64_t _udp_count{ 0 };
   std::uint64_t _tcp_count{ 0 };
+  // packets with decapsulated inner ip headers, the other counts are about the outermost headers
+  std::uint64_t _tunnel_count{ 0 };
   std::uint64_t _offset{ 0 };
   std::uint64_t _segment_offset{ 0 };
+  // timestamp of the current packet, it ages the fragment table
+  std::uint64_t _stamp{ 0 };
+  // captured size of the current packet
+  std::uint32_t _length{ 0 };
   std::size_t _count{ 0 };
+  // postings are packet ordinals instead of offsets, `_ordinal_table` maps the ordinals of the
+  // current segment back to offsets ( and sizes and timestamps with a fat table ). the cycler
+  // writes it along with the indices of the segment
+  bool _ordinals{ false };
+  ordinal_table_builder _ordinal_table;
+  // the packets, bytes and first / last timestamp of every key of the current segment ( see
+  // `key_stats_builder` ), the cycler writes them next to the indices of the segment
+  bool _key_stats{ false };
+  key_stats_builder<std::uint32_t> _v4_stats;
+  key_stats_builder<std::uint32_t> _port_stats;
+  key_stats_builder<__uint128_t> _v6_stats;
+  key_stats_builder<std::uint32_t> _flow_stats;
+  // the heavy hitters and peers of the ipv4 hosts of the current segment ( see `sketch_builder` ),
+  // the cycler writes them next to the indices of the segment
+  bool _sketches{ false };
+  sketch_builder _sketch;
+
+  // later fragments get indexed under the ports of their first fragment
+  nygma::fragment_table _fragments;
 
   std::unique_ptr<v4_index_type> _v4_index;
   std::unique_ptr<port_index_type> _port_index;
+  std::unique_ptr<v6_index_type> _v6_index;
+  std::unique_ptr<flow_index_type> _flow_index;
+
+ private:
+  // the first fragment of the current packet waits for its ports
+  bool _first_fragment{ false };
+  nygma::fragment_key _fragment_key{};
+  std::byte const* _ipv6_header{ nullptr };
+  // the flow of the current packet, it gets indexed once the packet is done
+  nygma::flow_tuple _flow{};
 
  public:
   index_trace()
     : _v4_index{ std::make_unique<v4_index_type>() },
-      _port_index{ std::make_unique<port_index_type>() } {}
+      _port_index{ std::make_unique<port_index_type>() },
+      _v6_index{ std::make_unique<v6_index_type>() },
+      _flow_index{ std::make_unique<flow_index_type>() } {}
+
+  // the indices of the first segment, e.g. `index_shards`
+  index_trace( std::unique_ptr<v4_index_type> v4, std::unique_ptr<port_index_type> ports,
+               std::unique_ptr<v6_index_type> v6, std::unique_ptr<flow_index_type> flows )
+    : _v4_index{ std::move( v4 ) },
+      _port_index{ std::move( ports ) },
+      _v6_index{ std::move( v6 ) },
+      _flow_index{ std::move( flows ) } {}
 
   template <typename V>
   inline void operator()( V&& v ) noexcept {
     constexpr endianess BE = endianess::BE;
     using T = std::decay_t<decltype( v )>;
+    _flow.update( v );
     if constexpr( std::is_same_v<T, dissect::ipv4> || std::is_same_v<T, dissect::ipv4f> ) {
       std::byte const* const p = v._begin + 12;
       auto* _src_begin = p;
       auto* _dst_begin = p + 4;
       auto _src_ip = unsafe::rd32<BE>( _src_begin );
       auto _dst_ip = unsafe::rd32<BE>( _dst_begin );
-      _v4_index->add( _src_ip, static_cast<std::uint32_t>( _offset ) );
-      _v4_index->add( _dst_ip, static_cast<std::uint32_t>( _offset ) );
-      _v4_count++;
+      index( *_v4_index, _v4_stats, _src_ip );
+      index( *_v4_index, _v4_stats, _dst_ip );
+      sketch( _src_ip, _dst_ip );
+      count( v._depth, _v4_count );
+      _first_fragment = false;
+      if constexpr( std::is_same_v<T, dissect::ipv4f> ) {
+        auto const later = unsafe::rd16<BE>( v._begin + 6 ) & 0x1fffu;
+        fragment( nygma::fragment_key::ipv4( v._begin ), later != 0 );
+      }
     } else if constexpr( std::is_same_v<T, dissect::ipv6> ) {
-      //std::byte const* const p = v._begin + 8;
-      //auto* _src_begin = p;
-      //auto* _src_end = p + 16;
-      //auto* _dst_begin = p + 16;
-      //auto* _dst_end = p + 32;
-      _v6_count++;
+      std::byte const* const p = v._begin + 8;
+      // most significant byte first, so the keys of a network share a prefix
+      auto _src_ip = unsafe::rd128<BE>( p );
+      auto _dst_ip = unsafe::rd128<BE>( p + 16 );
+      index( *_v6_index, _v6_stats, _src_ip );
+      index( *_v6_index, _v6_stats, _dst_ip );
+      count( v._depth, _v6_count );
+      _first_fragment = false;
+      _ipv6_header = v._begin;
+    } else if constexpr( std::is_same_v<T, dissect::ipv6f> ) {
+      auto const later = unsafe::rd16<BE>( v._begin + 2 ) & 0xfff8u;
+      fragment( nygma::fragment_key::ipv6( _ipv6_header, v._begin ), later != 0 );
     } else if constexpr( std::is_same_v<T, dissect::udp> ) {
       std::byte const* const p = v._begin;
       auto _src_port = unsafe::rd16<BE>( p );
       auto _dst_port = unsafe::rd16<BE>( p + 2 );
-      _port_index->add( _src_port, static_cast<std::uint32_t>( _offset ) );
-      _port_index->add( _dst_port, static_cast<std::uint32_t>( _offset ) );
-      _udp_count++;
+      index( *_port_index, _port_stats, _src_port );
+      index( *_port_index, _port_stats, _dst_port );
+      ports( _src_port, _dst_port );
+      if( v._depth == 0 ) { _udp_count++; }
     } else if constexpr( std::is_same_v<T, dissect::tcp> ) {
       std::byte const* const p = v._begin;
       auto _src_port = unsafe::rd16<BE>( p );
       auto _dst_port = unsafe::rd16<BE>( p + 2 );
-      _port_index->add( _src_port, static_cast<std::uint32_t>( _offset ) );
-      _port_index->add( _dst_port, static_cast<std::uint32_t>( _offset ) );
-      _tcp_count++;
+      index( *_port_index, _port_stats, _src_port );
+      index( *_port_index, _port_stats, _dst_port );
+      ports( _src_port, _dst_port );
+      if( v._depth == 0 ) { _tcp_count++; }
+    }
+  }
+
+  // adds the packets `pkts` dissected into `b` by `dissect_en10mb_batch`, `offsets` are their
+  // offsets. tunneled and fragmented packets get dissected once more by `dissect_en10mb`
+  template <std::size_t N, typename Cycler>
+  inline void add( nygma::packet_view const* const pkts, dissect::dissect_batch<N> const& b,
+                   std::uint64_t const* const offsets, Cycler const c ) noexcept {
+    dissect::void_hash_policy const hash;
+    for( std::size_t i = 0; i < b._count; ++i ) {
+      prepare( offsets[i], c, pkts[i]._stamp, static_cast<std::uint32_t>( pkts[i].size() ) );
+      auto const bit = 1u << i;
+      if( ( b._tunnel | b._fragment ) & bit ) {
+        dissect::dissect_en10mb( hash, *this, pkts[i]._slice );
+        continue;
+      }
+      if( b._ipv4 & bit ) {
+        index( *_v4_index, _v4_stats, b._src4[i] );
+        index( *_v4_index, _v4_stats, b._dst4[i] );
+        sketch( b._src4[i], b._dst4[i] );
+        _v4_count++;
+        _flow = { b._src4[i], b._dst4[i], 0, 0, b._proto[i], 4, false };
+      } else if( b._ipv6 & bit ) {
+        index( *_v6_index, _v6_stats, b._src6[i] );
+        index( *_v6_index, _v6_stats, b._dst6[i] );
+        _v6_count++;
+        _flow = { b._src6[i], b._dst6[i], 0, 0, b._proto[i], 6, false };
+      }
+      if( b._ports & bit ) {
+        _flow._sport = b._sport[i];
+        _flow._dport = b._dport[i];
+        index( *_port_index, _port_stats, b._sport[i] );
+        index( *_port_index, _port_stats, b._dport[i] );
+        if( b._proto[i] == 6 ) {
+          _tcp_count++;
+        } else {
+          _udp_count++;
+        }
+      }
     }
   }
 
   template <typename Cycler>
-  inline void prepare( std::uint64_t const offset, Cycler const c ) noexcept {
+  inline void prepare( std::uint64_t const offset, Cycler const c, std::uint64_t const stamp = 0,
+                       std::uint32_t const length = 0 ) noexcept {
+    // the previous packet belongs to the current segment
+    add_flow();
     if( offset - _segment_offset > SEGMENTSZ ) {
-      c( std::move( _v4_index ), std::move( _port_index ), _segment_offset );
+      auto v4 = std::exchange( _v4_index, fresh_of( *_v4_index ) );
+      auto ports = std::exchange( _port_index, fresh_of( *_port_index ) );
+      auto v6 = std::exchange( _v6_index, fresh_of( *_v6_index ) );
+      auto flows = std::exchange( _flow_index, fresh_of( *_flow_index ) );
+      c( std::move( v4 ), std::move( ports ), std::move( v6 ), std::move( flows ), _segment_offset );
       _segment_offset = offset;
-      _v4_index = std::make_unique<v4_index_type>();
-      _port_index = std::make_unique<port_index_type>();
+      _ordinal_table.clear();
+      clear_key_stats();
+      _sketch.clear();
     }
     // store relative offset to the beginning of a segment @ `_segment_offset`
     _offset = offset - _segment_offset;
+    if( _ordinals ) {
+      _offset = _ordinal_table.add( static_cast<std::uint32_t>( _offset ), length, stamp );
+    }
+    _stamp = stamp;
+    _length = length;
+    _first_fragment = false;
     dissect::dissect_trace::rewind();
   }
 
   template <typename Cycler>
   inline void finish( Cycler const c ) noexcept {
+    add_flow();
     // provide the last stored `_segment_offset` to the cycler
-    c( std::move( _v4_index ), std::move( _port_index ), _segment_offset );
+    c( std::move( _v4_index ), std::move( _port_index ), std::move( _v6_index ),
+       std::move( _flow_index ), _segment_offset );
+  }
+
+ private:
+  // adds the current packet to `i` under `k` and counts it in `s` with `--key-stats`
+  template <typename Index, typename Stats, typename Key>
+  inline void index( Index& i, Stats& s, Key const k ) noexcept {
+    auto const o = static_cast<std::uint32_t>( _offset );
+    i.add( k, o );
+    if( _key_stats ) { s.add( k, o, _length, _stamp ); }
+  }
+
+  inline void sketch( std::uint32_t const src, std::uint32_t const dst ) noexcept {
+    if( not _sketches ) { return; }
+    _sketch.add( src, dst, static_cast<std::uint32_t>( _offset ), _length, _stamp );
+  }
+
+  inline void clear_key_stats() noexcept {
+    _v4_stats.clear();
+    _port_stats.clear();
+    _v6_stats.clear();
+    _flow_stats.clear();
+  }
+
+  // a packet counts once, by its outermost ip header
+  inline void count( unsigned const depth, std::uint64_t& outer ) noexcept {
+    if( depth == 0 ) {
+      outer++;
+    } else if( depth == 1 ) {
+      _tunnel_count++;
+    }
+  }
+
+  // a first fragment records the ports of the following tcp / udp header, later fragments get the
+  // recorded ones
+  inline void fragment( nygma::fragment_key const& k, bool const later ) noexcept {
+    if( not later ) {
+      _first_fragment = true;
+      _fragment_key = k;
+      return;
+    }
+    if( auto const* const e = _fragments.lookup( k, _stamp ); e != nullptr ) {
+      index( *_port_index, _port_stats, e->_sport );
+      index( *_port_index, _port_stats, e->_dport );
+      // the fragment belongs to the flow of its first fragment
+      _flow._sport = e->_sport;
+      _flow._dport = e->_dport;
+    }
+  }
+
+  inline void ports( std::uint16_t const sport, std::uint16_t const dport ) noexcept {
+    if( _first_fragment ) {
+      _fragments.insert( _fragment_key, sport, dport, _stamp );
+      _first_fragment = false;
+    }
+  }
+
+  inline void add_flow() noexcept {
+    if( _flow._version == 0 ) { return; }
+    index( *_flow_index, _flow_stats, nygma::flow_hash( _flow ) );
+    _flow = {};
   }
 };
 
@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libriot/index-shards.hxx>
+#include <libriot/index-trace.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+template <typename K, typename V>
+using map_type = std::map<K, V>;
+using i4_type = riot::index_builder<std::uint32_t, map_type, 256>;
+using ix_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using i6_type = riot::index_builder<__uint128_t, map_type, 128>;
+using if_type = riot::index_builder<std::uint32_t, map_type, 128>;
+using trace_type = riot::index_trace<i4_type, ix_type, i6_type, if_type>;
+
+// ethernet + ipv6 + udp from `2001:db8::1` to `2001:db8::2:0:0:2`, `reply` swaps the direction
+std::vector<std::byte> ipv6_udp_frame( bool const reply = false ) {
+  std::uint8_t const frame[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x86, 0xdd, // eth
+      0x60, 0x00, 0x00, 0x00, 0x00, 0x08, 0x11, 0x40,                                     // ipv6
+      0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,                                     // src
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,                                     //
+      0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,                                     // dst
+      0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,                                     //
+      0x04, 0xd2, 0x00, 0x35, 0x00, 0x08, 0x00, 0x00,                                     // udp
+  };
+  std::vector<std::byte> r( sizeof( frame ) );
+  std::memcpy( r.data(), frame, sizeof( frame ) );
+  if( reply ) {
+    std::swap_ranges( r.begin() + 22, r.begin() + 38, r.begin() + 38 );
+    std::swap_ranges( r.begin() + 54, r.begin() + 56, r.begin() + 56 );
+  }
+  return r;
+}
+
+// ethernet + ipv4 + udp + vxlan from `10.0.0.1` to `10.0.0.2`, carrying `ipv6_udp_frame`
+std::vector<std::byte> vxlan_frame() {
+  std::uint8_t const outer[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x08, 0x00, // eth
+      0x45, 0x00, 0x00, 0x62, 0x00, 0x01, 0x00, 0x00, 0x40, 0x11, 0x00, 0x00,             // ipv4
+      0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00, 0x00, 0x02,                                     //
+      0xc3, 0x50, 0x12, 0xb5, 0x00, 0x4e, 0x00, 0x00,                                     // udp
+      0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2a, 0x00,                                     // vxlan
+  };
+  std::vector<std::byte> r( sizeof( outer ) );
+  std::memcpy( r.data(), outer, sizeof( outer ) );
+  auto const inner = ipv6_udp_frame();
+  r.insert( r.end(), inner.begin(), inner.end() );
+  return r;
+}
+
+// ethernet + ipv4 fragment of datagram `id` from `10.0.0.1` to `10.0.0.2` at `offset` ( in units
+// of 8 bytes ), the first one starts with udp `1234 -> 53`
+std::vector<std::byte> fragment_frame( unsigned const id, unsigned const offset ) {
+  std::uint8_t const frame[] = {
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x08, 0x00, // eth
+      0x45, 0x00, 0x00, 0x24, static_cast<std::uint8_t>( id >> 8 ),                       // ipv4
+      static_cast<std::uint8_t>( id ), static_cast<std::uint8_t>( 0x20 | offset >> 8 ),   //
+      static_cast<std::uint8_t>( offset ), 0x40, 0x11, 0x00, 0x00,                        //
+      0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00, 0x00, 0x02,                                     //
+      0x04, 0xd2, 0x00, 0x35, 0x00, 0x10, 0x00, 0x00,                                     // udp
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,                                     //
+  };
+  std::vector<std::byte> r( sizeof( frame ) );
+  std::memcpy( r.data(), frame, sizeof( frame ) );
+  return r;
+}
+
+// the postings of the port and the flow index
+struct postings {
+  std::map<std::uint32_t, std::vector<std::uint32_t>> _offsets;
+  void add( std::uint32_t const k, std::uint32_t const o ) noexcept { _offsets[k].push_back( o ); }
+};
+
+emptyspace::pest::suite basic( "index trace basic suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+
+  test( "ipv6 addresses get indexed most significant byte first", []( auto& expect ) {
+    auto const frame = ipv6_udp_frame();
+    trace_type trace;
+    nygma::dissect::void_hash_policy hash;
+    auto const noop = []( auto&&... ) {};
+    trace.prepare( 24 + 16, noop );
+    unclassified::bytestring_view const view{ frame.data(), frame.size() };
+    riot::dissect::dissect_en10mb( hash, trace, view );
+    expect( trace._v6_count, equal_to( 1u ) );
+    expect( trace._v4_count, equal_to( 0u ) );
+    expect( trace._udp_count, equal_to( 1u ) );
+
+    std::vector<__uint128_t> keys;
+    std::size_t ports = 0;
+    std::size_t flows = 0;
+    trace.finish( [&]( auto, auto ix, auto i6, auto f, std::uint64_t const segment_offset ) {
+      expect( segment_offset, equal_to( 0u ) );
+      ports = ix->key_count();
+      flows = f->key_count();
+      i6->for_each_key( [&]( auto const k ) { keys.push_back( k ); } );
+    } );
+    auto const net = __uint128_t( 0x20010db8u ) << 96;
+    expect( ports, equal_to( 2u ) );
+    expect( flows, equal_to( 1u ) );
+    expect( keys.size(), equal_to( 2u ) );
+    expect( keys[0] == ( net | 1u ), equal_to( true ) );
+    expect( keys[1] == ( net | ( __uint128_t( 2u ) << 48 ) | 2u ), equal_to( true ) );
+  } );
+
+  test( "batches index like single packets", []( auto& expect ) {
+    auto const frame = ipv6_udp_frame();
+    std::vector<nygma::packet_view> pkts;
+    std::vector<std::uint64_t> offsets;
+    for( std::size_t i = 0; i < 20; ++i ) {
+      pkts.emplace_back( unclassified::bytestring_view{ frame.data(), frame.size() - i % 3 } );
+      offsets.push_back( 40 + i * 100 );
+    }
+    auto const keys = []( auto const& index ) {
+      std::vector<__uint128_t> r;
+      index->for_each_key( [&]( auto const k ) { r.push_back( k ); } );
+      return r;
+    };
+
+    trace_type single;
+    nygma::dissect::void_hash_policy hash;
+    auto const noop = []( auto&&... ) {};
+    for( std::size_t i = 0; i < pkts.size(); ++i ) {
+      single.prepare( offsets[i], noop );
+      riot::dissect::dissect_en10mb( hash, single, pkts[i]._slice );
+    }
+
+    trace_type batched;
+    nygma::dissect::dissect_batch<16> b;
+    for( std::size_t i = 0; i < pkts.size(); i += 16 ) {
+      nygma::dissect::dissect_en10mb_batch( pkts.data() + i, pkts.size() - i, b );
+      batched.add( pkts.data() + i, b, offsets.data() + i, noop );
+    }
+
+    // truncated frames fail the ipv6 payload length check
+    expect( batched._v6_count, equal_to( 7u ) );
+    expect( batched._udp_count, equal_to( 7u ) );
+    expect( batched._v6_count, equal_to( single._v6_count ) );
+    expect( batched._udp_count, equal_to( single._udp_count ) );
+    expect( batched._offset, equal_to( single._offset ) );
+    expect( keys( batched._v6_index ) == keys( single._v6_index ), equal_to( true ) );
+    expect( batched._port_index->key_count(), equal_to( single._port_index->key_count() ) );
+    // the postings of the last packet get added by `finish`
+    single.finish( noop );
+    batched.finish( noop );
+    expect( keys( batched._flow_index ) == keys( single._flow_index ), equal_to( true ) );
+  } );
+
+  test( "sharded indices cycle segments like builders", []( auto& expect ) {
+    using s4 = riot::index_shards<i4_type>;
+    using sx = riot::index_shards<ix_type>;
+    using s6 = riot::index_shards<i6_type>;
+    using sf = riot::index_shards<if_type>;
+    auto const frames = std::vector<std::vector<std::byte>>{ vxlan_frame(), ipv6_udp_frame( true ),
+                                                             vxlan_frame() };
+    auto const offsets = std::vector<std::uint64_t>{ 40, 140, trace_type::SEGMENTSZ + 240 };
+    // segment offset and the keys of every index per segment
+    auto const run = [&]( auto& trace ) {
+      std::vector<std::uint64_t> r;
+      auto const cycler = [&]( auto i4, auto ix, auto i6, auto f, std::uint64_t const o ) {
+        r.push_back( o );
+        auto const keys = [&]( auto const& i ) {
+          r.push_back( i->key_count() );
+          i->for_each_key(
+              [&]( auto const k ) { r.push_back( static_cast<std::uint64_t>( k ) ); } );
+        };
+        keys( riot::builder_of( std::move( i4 ) ) );
+        keys( riot::builder_of( std::move( ix ) ) );
+        keys( riot::builder_of( std::move( i6 ) ) );
+        keys( riot::builder_of( std::move( f ) ) );
+      };
+      nygma::dissect::void_hash_policy hash;
+      for( std::size_t i = 0; i < frames.size(); ++i ) {
+        trace.prepare( offsets[i], cycler );
+        unclassified::bytestring_view const view{ frames[i].data(), frames[i].size() };
+        riot::dissect::dissect_en10mb( hash, trace, view );
+      }
+      trace.finish( cycler );
+      return r;
+    };
+    trace_type single;
+    riot::index_trace<s4, sx, s6, sf> sharded{ std::make_unique<s4>( 2 ), std::make_unique<sx>( 3 ),
+                                               std::make_unique<s6>( 2 ),
+                                               std::make_unique<sf>( 2 ) };
+    auto const expected = run( single );
+    expect( expected[0], equal_to( 0u ) );
+    expect( run( sharded ) == expected, equal_to( true ) );
+  } );
+
+  test( "both directions of a flow share the flow key", []( auto& expect ) {
+    std::vector<std::vector<std::byte>> const frames{ ipv6_udp_frame(), ipv6_udp_frame( true ),
+                                                      vxlan_frame() };
+    std::vector<nygma::packet_view> pkts;
+    for( auto const& f : frames ) {
+      pkts.emplace_back( unclassified::bytestring_view{ f.data(), f.size() } );
+    }
+    std::uint64_t const offsets[] = { 40, 140, 240 };
+    riot::index_trace<i4_type, ix_type, i6_type, postings> trace;
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    trace.add( pkts.data(), b, offsets, []( auto&&... ) {} );
+    trace.finish( []( auto&&... ) {} );
+    // the tunneled packet belongs to the flow of its innermost headers
+    auto const& flows = trace._flow_index->_offsets;
+    expect( flows.size(), equal_to( 1u ) );
+    expect( flows.begin()->second == std::vector<std::uint32_t>{ 40, 140, 240 }, equal_to( true ) );
+  } );
+
+  test( "tunnels index outer and inner headers", []( auto& expect ) {
+    auto const frame = vxlan_frame();
+    std::vector<nygma::packet_view> pkts;
+    pkts.emplace_back( unclassified::bytestring_view{ frame.data(), frame.size() } );
+    std::uint64_t const offset = 40;
+    trace_type trace;
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    expect( b._tunnel, equal_to( 1u ) );
+    trace.add( pkts.data(), b, &offset, []( auto&&... ) {} );
+    expect( trace._v4_count, equal_to( 1u ) );
+    expect( trace._v6_count, equal_to( 0u ) );
+    expect( trace._udp_count, equal_to( 1u ) );
+    expect( trace._tunnel_count, equal_to( 1u ) );
+    expect( trace._v4_index->key_count(), equal_to( 2u ) );
+    expect( trace._v6_index->key_count(), equal_to( 2u ) );
+    // 50000, 4789, 1234 and 53
+    expect( trace._port_index->key_count(), equal_to( 4u ) );
+  } );
+
+  test( "later fragments get the ports of the first one", []( auto& expect ) {
+    std::vector<std::vector<std::byte>> const frames{
+        fragment_frame( 7, 0 ), fragment_frame( 7, 2 ), fragment_frame( 8, 2 ),
+        fragment_frame( 7, 3 ) };
+    // the last one arrives after the fragment table timeout
+    std::uint32_t const seconds[] = { 0, 1, 1, 40 };
+    std::vector<nygma::packet_view> pkts;
+    std::vector<std::uint64_t> offsets;
+    for( std::size_t i = 0; i < frames.size(); ++i ) {
+      unclassified::bytestring_view const slice{ frames[i].data(), frames[i].size() };
+      pkts.emplace_back( seconds[i], 0u, slice );
+      offsets.push_back( 40 + i * 100 );
+    }
+    riot::index_trace<i4_type, postings, i6_type, postings> trace;
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    expect( b._fragment, equal_to( 0b1111u ) );
+    trace.add( pkts.data(), b, offsets.data(), []( auto&&... ) {} );
+    expect( trace._v4_count, equal_to( 4u ) );
+    expect( trace._udp_count, equal_to( 1u ) );
+    expect( trace._port_index->_offsets[53] == std::vector<std::uint32_t>{ 40, 140 },
+            equal_to( true ) );
+    expect( trace._port_index->_offsets[1234] == std::vector<std::uint32_t>{ 40, 140 },
+            equal_to( true ) );
+    expect( trace._fragments._inserted, equal_to( 1u ) );
+    expect( trace._fragments._found, equal_to( 1u ) );
+    expect( trace._fragments._missed, equal_to( 2u ) );
+    // fragments without ports are another flow
+    trace.finish( []( auto&&... ) {} );
+    nygma::flow_tuple const udp{ 0x0a000001u, 0x0a000002u, 1234, 53, 17, 4, false };
+    auto const h = nygma::flow_hash( udp );
+    expect( trace._flow_index->_offsets[h] == std::vector<std::uint32_t>{ 40, 140 },
+            equal_to( true ) );
+    expect( trace._flow_index->_offsets.size(), equal_to( 2u ) );
+  } );
+
+  test( "packet ordinals as postings", []( auto& expect ) {
+    auto const frame = ipv6_udp_frame();
+    std::vector<nygma::packet_view> pkts( 3, unclassified::bytestring_view{ frame.data(),
+                                                                          frame.size() } );
+    std::uint64_t const offsets[] = { 40, 140, 240 };
+    riot::index_trace<i4_type, postings, i6_type, postings> trace;
+    trace._ordinals = true;
+    std::vector<std::size_t> tables;
+    auto const cycler = [&]( auto&&... ) { tables.push_back( trace._ordinal_table.size() ); };
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    trace.add( pkts.data(), b, offsets, cycler );
+    expect( trace._port_index->_offsets[53] == std::vector<std::uint32_t>{ 1, 2, 3 },
+            equal_to( true ) );
+    // the next segment numbers its packets from `1` again
+    trace.prepare( trace_type::SEGMENTSZ + 4096, cycler );
+    expect( trace._offset, equal_to( 1u ) );
+    expect( trace._ordinal_table.size(), equal_to( 1u ) );
+    expect( tables == std::vector<std::size_t>{ 3 }, equal_to( true ) );
+    trace.finish( cycler );
+    expect( tables == std::vector<std::size_t>{ 3, 1 }, equal_to( true ) );
+  } );
+
+  test( "fat ordinal tables keep sizes and timestamps", []( auto& expect ) {
+    auto const frame = ipv6_udp_frame();
+    std::vector<nygma::packet_view> pkts;
+    for( std::uint64_t const stamp : { 1000u, 2000u, 3000u } ) {
+      pkts.emplace_back( stamp, unclassified::bytestring_view{ frame.data(), frame.size() } );
+    }
+    std::uint64_t const offsets[] = { 40, 140, 240 };
+    riot::index_trace<i4_type, postings, i6_type, postings> trace;
+    trace._ordinals = true;
+    trace._ordinal_table = riot::ordinal_table_builder{ true };
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    trace.add( pkts.data(), b, offsets, []( auto&&... ) {} );
+    std::byte data[1024];
+    auto os = nygma::cfile_ostream{ data };
+    trace._ordinal_table.accept( os );
+    auto const n = static_cast<std::size_t>( os.current_position() );
+    riot::ordinal_table_view const view{ unclassified::bytestring_view{ data, n } };
+    auto const p = view.packet( 2 );
+    expect( p._offset, equal_to( 140u ) );
+    expect( p._length, equal_to( frame.size() ) );
+    expect( p._stamp, equal_to( 2000u ) );
+  } );
+
+  test( "key stats count a packet once per key", []( auto& expect ) {
+    auto const request = ipv6_udp_frame();
+    auto const reply = ipv6_udp_frame( true );
+    // from port `53` to port `53`
+    auto const same_port = [] {
+      auto f = ipv6_udp_frame();
+      f[54] = std::byte{ 0x00 };
+      f[55] = std::byte{ 0x35 };
+      return f;
+    }();
+    std::vector<nygma::packet_view> pkts;
+    std::uint64_t stamp = 1000;
+    for( auto const* const f : { &request, &reply, &same_port } ) {
+      pkts.emplace_back( stamp, unclassified::bytestring_view{ f->data(), f->size() } );
+      stamp += 1000;
+    }
+    std::uint64_t const offsets[] = { 40, 140, 240 };
+    trace_type trace;
+    trace._key_stats = true;
+    std::vector<std::size_t> keys;
+    auto const cycler = [&]( auto&&... ) { keys.push_back( trace._port_stats.key_count() ); };
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    trace.add( pkts.data(), b, offsets, cycler );
+    auto const dns = trace._port_stats.lookup( 53 );
+    expect( dns._packets, equal_to( 3u ) );
+    expect( dns._bytes, equal_to( 3 * request.size() ) );
+    expect( dns._first, equal_to( 1000u ) );
+    expect( dns._last, equal_to( 3000u ) );
+    expect( trace._port_stats.lookup( 1234 )._packets, equal_to( 2u ) );
+    auto const src = __uint128_t( 0x20010db8u ) << 96 | 1;
+    expect( trace._v6_stats.lookup( src )._packets, equal_to( 3u ) );
+    // the flow of the last packet gets counted with the next one
+    trace.prepare( trace_type::SEGMENTSZ + 4096, cycler, 4000, 100 );
+    expect( keys == std::vector<std::size_t>{ 2 }, equal_to( true ) );
+    expect( trace._port_stats.empty(), equal_to( true ) );
+    expect( trace._flow_stats.empty(), equal_to( true ) );
+  } );
+
+  test( "sketches count the ipv4 hosts of a packet once", []( auto& expect ) {
+    // not fragmented, it takes the batch path
+    auto const plain = [] {
+      auto f = fragment_frame( 9, 0 );
+      f[20] = std::byte{ 0x00 };
+      return f;
+    }();
+    auto const tunnel = vxlan_frame();
+    std::vector<nygma::packet_view> pkts;
+    pkts.emplace_back( 1000, unclassified::bytestring_view{ plain.data(), plain.size() } );
+    pkts.emplace_back( 2000, unclassified::bytestring_view{ tunnel.data(), tunnel.size() } );
+    std::uint64_t const offsets[] = { 40, 140 };
+    trace_type trace;
+    trace._sketches = true;
+    std::vector<std::size_t> hosts;
+    auto const cycler = [&]( auto&&... ) { hosts.push_back( trace._sketch.host_count() ); };
+    nygma::dissect::dissect_batch<8> b;
+    nygma::dissect::dissect_en10mb_batch( pkts.data(), pkts.size(), b );
+    trace.add( pkts.data(), b, offsets, cycler );
+    auto const c = trace._sketch.lookup( 0x0a000001u );
+    expect( c._packets, equal_to( 2u ) );
+    expect( c._bytes, equal_to( plain.size() + tunnel.size() ) );
+    expect( trace._sketch.lookup( 0x0a000002u )._packets, equal_to( 2u ) );
+    trace.prepare( trace_type::SEGMENTSZ + 4096, cycler, 4000, 100 );
+    expect( hosts == std::vector<std::size_t>{ 2 }, equal_to( true ) );
+    expect( trace._sketch.empty(), equal_to( true ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -3,10 +3,15 @@
 #pragma once
 
 #include <libnygma/mmap.hxx>
+#include <libriot/compress-adaptive.hxx>
 #include <libriot/compress-bitpack-simd.hxx>
+#include <libriot/compress-eliasfano.hxx>
+#include <libriot/compress-prefix-simd.hxx>
 #include <libriot/compress-streamvbyte-simd.hxx>
 #include <libriot/compress-vbyte.hxx>
 #include <libriot/index-builder.hxx>
+#include <libriot/index-container.hxx>
+#include <libriot/index-filter.hxx>
 #include <libriot/index-resultset.hxx>
 #include <libriot/index-serializer.hxx>
 #include <libunclassified/bytestring.hxx>
@@ -99,9 +104,153 @@ using svb128d1 = decode_wrapper<method::SVB128D1, riot::streamvbyte::svb128d1_i1
 using svb256d1 = decode_wrapper<method::SVB256D1, riot::streamvbyte::svb256d1_i128>;
 using bp128d1 = decode_wrapper<method::BP128D1, riot::bitpack::bp128d1>;
 using bp256d1 = decode_wrapper<method::BP256D1, riot::bitpack::bp256d1>;
+using svb512d1 = decode_wrapper<method::SVB512D1, riot::streamvbyte::svb512d1_i512>;
+using bp512d1 = decode_wrapper<method::BP512D1, riot::bitpack::bp512d1>;
+// the budget only affects encoding
+using ad128 = decode_wrapper<method::AD128, riot::adaptive::ad128<>>;
+using ad256 = decode_wrapper<method::AD256, riot::adaptive::ad256<>>;
+// postings are stored as containers, `Decode` is used for keys and key offsets
+template <method::type CompressionMethod, typename Decode>
+struct container_wrapper : decode_wrapper<CompressionMethod, Decode> {
+  template <typename OutIt>
+  static void decode_container( std::byte const* const in, std::size_t n, std::size_t m,
+                                OutIt out ) noexcept {
+    container::chunk::expand( in, n, m, out );
+  }
+};
+
+template <typename VC>
+concept container_decoder = requires( std::byte const* p, std::size_t n, std::uint32_t* out ) {
+  VC::decode_container( p, n, n, out );
+};
+
+using rc128 = container_wrapper<method::RC128, riot::bitpack::bp128d1>;
+using rc256 = container_wrapper<method::RC256, riot::bitpack::bp256d1>;
+// postings are stored as one elias-fano sequence per key, `Decode` is used for keys and key offsets
+template <method::type CompressionMethod, typename Decode>
+struct sequence_wrapper : decode_wrapper<CompressionMethod, Decode> {
+  template <typename OutIt>
+  static void decode_sequence( std::byte const* const in, std::size_t n, std::size_t,
+                               OutIt out ) noexcept {
+    eliasfano::sequence{ in, n }.decode( out );
+  }
+
+  // the record header saturates at the block length, the sequence stores its own length
+  static std::size_t sequence_size( std::byte const* const in, std::size_t n ) noexcept {
+    return eliasfano::sequence{ in, n }.size();
+  }
+
+  template <typename Container, typename OutIt>
+  static void intersect_sequence( std::byte const* const in, std::size_t n,
+                                  Container const& values, OutIt out ) noexcept {
+    eliasfano::sequence{ in, n }.intersect( values, out );
+  }
+};
+
+template <typename VC>
+concept sequence_decoder = requires( std::byte const* p, std::size_t n, std::uint32_t* out ) {
+  VC::decode_sequence( p, n, n, out );
+};
+
+using pef128 = sequence_wrapper<method::PEF128, riot::bitpack::bp128d1>;
+using pef256 = sequence_wrapper<method::PEF256, riot::bitpack::bp256d1>;
 using raw128 = raw<method::UC128, 128>;
 using raw256 = raw<method::UC256, 256>;
 
+// sorted 128bit keys with a shared prefix per key block. the blocks get searched in place, so
+// opening an index only touches the block headers ( see `key_blocks` )
+template <method::type CompressionMethod, typename Codec>
+struct prefix_key128 {
+  using integer_type = __uint128_t;
+  static constexpr method::type COMPRESSION_METHOD = CompressionMethod;
+  static constexpr std::size_t BLOCKLEN = Codec::BLOCKLEN;
+  static constexpr std::size_t estimate_compressed_size() noexcept {
+    return Codec::estimate_compressed_size();
+  }
+
+  static bool valid( std::byte const* const in, std::size_t n, std::size_t m ) noexcept {
+    return m > 0 and m <= BLOCKLEN and Codec::width( in, n, m ) <= prefix::KEYLEN;
+  }
+
+  static integer_type first( std::byte const* const in ) noexcept { return Codec::at( in, 0 ); }
+
+  // the position of `k` within the `m` keys of a valid block or `m`
+  static std::size_t find( std::byte const* const in, std::size_t m, integer_type const k ) noexcept {
+    auto const i = Codec::lower_bound( in, m, k );
+    return i < m and Codec::at( in, i ) == k ? i : m;
+  }
+
+  template <typename OutIt>
+  static void decode( std::byte const* const in, std::size_t n, std::size_t m_, OutIt out ) noexcept {
+    auto const m = std::min( m_, BLOCKLEN );
+    integer_type tmp_out[BLOCKLEN];
+    auto const decoded = Codec::decode( in, n, m, tmp_out );
+    std::copy( tmp_out, tmp_out + decoded, out );
+  }
+};
+
+template <typename KC>
+concept seekable_key_decoder = requires( std::byte const* p, std::size_t n,
+                                         typename KC::integer_type k ) {
+  { KC::find( p, n, k ) } -> std::same_as<std::size_t>;
+  { KC::first( p ) } -> std::same_as<typename KC::integer_type>;
+};
+
+using pk128 = prefix_key128<method::PK128, riot::prefix::pk128>;
+using pk256 = prefix_key128<method::PK256, riot::prefix::pk256>;
+
+// the first key and the location of every key block. keys get found with a binary search over the
+// first keys plus a search within a single block, all keys get decoded on demand only
+template <typename KeyType>
+class key_blocks {
+ public:
+  using key_type = KeyType;
+  using find_fn = std::size_t ( * )( std::byte const*, std::size_t, key_type ) noexcept;
+  using decode_fn = void ( * )( std::byte const*, std::size_t, std::size_t, std::vector<key_type>& );
+
+ private:
+  struct block {
+    std::byte const* _p;
+    std::size_t _size;
+    std::size_t _count;
+    std::size_t _base;
+  };
+
+  std::vector<key_type> _firsts;
+  std::vector<block> _blocks;
+  std::size_t _count{ 0 };
+  find_fn _find{ nullptr };
+  decode_fn _decode{ nullptr };
+
+ public:
+  key_blocks() = default;
+  key_blocks( find_fn const f, decode_fn const d ) noexcept : _find{ f }, _decode{ d } {}
+
+  bool valid() const noexcept { return _find != nullptr; }
+  std::size_t size() const noexcept { return _count; }
+  std::size_t block_count() const noexcept { return _blocks.size(); }
+
+  void add( std::byte const* const p, std::size_t const n, std::size_t const m, key_type const first ) {
+    _firsts.push_back( first );
+    _blocks.push_back( { p, n, m, _count } );
+    _count += m;
+  }
+
+  // the position of `k` or `size()`
+  std::size_t find( key_type const k ) const noexcept {
+    auto const it = std::upper_bound( _firsts.begin(), _firsts.end(), k );
+    if( it == _firsts.begin() ) { return _count; }
+    auto const& b = _blocks[static_cast<std::size_t>( it - _firsts.begin() ) - 1];
+    auto const i = _find( b._p, b._count, k );
+    return i < b._count ? b._base + i : _count;
+  }
+
+  void decode( std::vector<key_type>& keys ) const {
+    keys.reserve( keys.size() + _count );
+    for( auto const& b : _blocks ) { _decode( b._p, b._size, b._count, keys ); }
+  }
+};
+
 } // namespace detail
 
 constexpr std::size_t METASZ = 32;
@@ -111,6 +260,8 @@ constexpr std::size_t META_KEYTY_OFFSET = 25;
 constexpr std::size_t META_KMETHOD_OFFSET = 28;
 constexpr std::size_t META_VMETHOD_OFFSET = 27;
 constexpr std::size_t META_SEGMENT_OFFSET = 16;
+constexpr std::size_t META_FLAG_OFFSET = 26;
+constexpr std::size_t FILTER_TRAILER_SIZE = 5;
 constexpr std::uint32_t MAGIC = 0x13371337u;
 constexpr std::uint32_t MAGIC2 = 0x41414141u;
 constexpr endianess LE = endianess::LE;
@@ -120,6 +271,10 @@ using resultset_forward_value_type = std::uint32_t;
 using resultset_forward_traits = detail::std_vector_traits<resultset_forward_value_type>;
 using resultset_forward_type = resultset<resultset_forward_traits, detail::resultset_kind::FORWARD>;
 
+// ... or as roaring style containers for container wise set operations ...
+using resultset_container_type =
+    resultset<detail::container_traits, detail::resultset_kind::FORWARD>;
+
 // ... for reverse lookup not so much ...
 using resultset_reverse_value_32 = std::uint32_t;
 using resultset_reverse_value_64 = std::uint64_t;
@@ -144,19 +299,26 @@ class index_view {
  private:
   bytestring_view const _data;
   std::uint64_t const _segment_offset;
-  std::vector<key_type> _keys;
+  // decoded on first use if the keys are seekable
+  mutable std::vector<key_type> _keys;
   std::vector<value_type> _offsets;
   inverted_index_type _inverted_index;
+  filter::view _filter;
+  detail::key_blocks<key_type> _key_blocks;
 
  public:
   index_view( bytestring_view const data, std::uint64_t const segment_offset,
-              std::vector<key_type>&& keys, std::vector<offset_type>&& offsets ) noexcept
+              std::vector<key_type>&& keys, std::vector<offset_type>&& offsets,
+              filter::view const f = {}, detail::key_blocks<key_type>&& kb = {} ) noexcept
     : _data{ data },
       _segment_offset{ segment_offset },
       _keys{ std::move( keys ) },
-      _offsets{ std::move( offsets ) } {
-    auto const truncate = std::min( _keys.size(), _offsets.size() );
-    _keys.resize( truncate );
+      _offsets{ std::move( offsets ) },
+      _filter{ f },
+      _key_blocks{ std::move( kb ) } {
+    auto const key_count = _key_blocks.valid() ? _key_blocks.size() : _keys.size();
+    auto const truncate = std::min( key_count, _offsets.size() );
+    _keys.resize( std::min( _keys.size(), truncate ) );
     _offsets.resize( truncate );
   }
 
@@ -167,8 +329,9 @@ class index_view {
   index_view& operator=( index_view&& ) = default;
 
  private:
-  template <typename OutIt>
-  bool decode( value_type const offset, OutIt out ) const noexcept {
+  // calls `f( p, compressed_size, uncompressed_size )` for all cblocks of a key
+  template <typename F>
+  bool for_each_cblock( value_type const offset, F&& f ) const noexcept {
     auto const* p = _data.begin() + offset;
     if( p + 1 + METASZ >= _data.end() ) { return false; }
     auto const* const end = _data.end() - METASZ;
@@ -181,25 +344,58 @@ class index_view {
       auto const uncompressed_size = enc._ulen == 0b11 ? VC::BLOCKLEN : vbyte::decode( p, enc._ulen );
       auto const compressed_size = vbyte::decode( p + n, enc._clen );
       if( p + n + m + compressed_size > end ) { return false; }
-      VC::decode( p + n + m, compressed_size, uncompressed_size, out );
+      if( not f( p + n + m, compressed_size, uncompressed_size ) ) { return false; }
       p += n + m + compressed_size;
       enc._value = *p++;
     } while( p < end and enc._tag == tag::CBLOCK and enc._type != block_subtype::CBEGIN );
     return true;
   }
 
+  // the position of `k` or `npos`
+  static constexpr std::size_t npos = ~std::size_t( 0 );
+  std::size_t find_key( key_type const k ) const noexcept {
+    if( _key_blocks.valid() ) {
+      auto const o = _key_blocks.find( k );
+      return o < _offsets.size() ? o : npos;
+    }
+    auto it = std::lower_bound( _keys.begin(), _keys.end(), k );
+    if( it == _keys.end() || k < *it ) { return npos; }
+    return static_cast<std::size_t>( it - _keys.begin() );
+  }
+
+  template <typename OutIt>
+  bool decode( value_type const offset, OutIt out ) const noexcept {
+    return for_each_cblock( offset, [&]( auto const* p, auto const n, auto const m ) {
+      if constexpr( detail::container_decoder<VC> ) {
+        VC::decode_container( p, n, m, out );
+      } else if constexpr( detail::sequence_decoder<VC> ) {
+        VC::decode_sequence( p, n, m, out );
+      } else {
+        VC::decode( p, n, m, out );
+      }
+      return true;
+    } );
+  }
+
  public:
-  auto key_count() const noexcept { return _keys.size(); }
+  auto key_count() const noexcept { return _offsets.size(); }
   constexpr auto segment_offset() const noexcept { return _segment_offset; }
   constexpr auto compression_method() const noexcept { return VC::COMPRESSION_METHOD; }
-  constexpr auto const& keys() const noexcept { return _keys; }
+  auto const& keys() const noexcept {
+    if( _key_blocks.valid() and _keys.empty() ) {
+      _key_blocks.decode( _keys );
+      _keys.resize( std::min( _keys.size(), _offsets.size() ) );
+    }
+    return _keys;
+  }
   constexpr auto const& offsets() const noexcept { return _offsets; }
+  constexpr auto const& key_filter() const noexcept { return _filter; }
 
   template <typename OutIt>
   bool lookup_forward( key_type const k, OutIt out ) const noexcept {
-    auto it = std::lower_bound( _keys.begin(), _keys.end(), k );
-    if( it == _keys.end() || k < *it ) { return false; }
-    auto const o = static_cast<std::size_t>( it - _keys.begin() );
+    if( not _filter.may_contain( k ) ) { return false; }
+    auto const o = find_key( k );
+    if( o == npos ) { return false; }
     assert( o < _offsets.size() );
     return decode( _offsets[o], out );
   }
@@ -210,23 +406,87 @@ class index_view {
     return resultset_forward_type{ _segment_offset, rc, std::move( values ) };
   }
 
+  // `values & lookup_forward( k )`. elias-fano indices skip to the elements of `values` instead of
+  // decoding all postings of `k`
+  resultset_forward_type lookup_forward_and( key_type const k,
+                                             resultset_forward_type const& values ) const noexcept {
+    if constexpr( detail::sequence_decoder<VC> ) {
+      if( values.segment_offset() != _segment_offset ) {
+        return resultset_forward_type{ values.segment_offset() };
+      }
+      if( not _filter.may_contain( k ) ) { return resultset_forward_type{ _segment_offset, true }; }
+      resultset_forward_type::container_type r;
+      auto const o = find_key( k );
+      if( o == npos ) { return resultset_forward_type{ _segment_offset, true }; }
+      assert( o < _offsets.size() );
+      for_each_cblock( _offsets[o], [&]( auto const* p, auto const n, auto ) {
+        VC::intersect_sequence( p, n, values.values(), std::back_inserter( r ) );
+        return true;
+      } );
+      return resultset_forward_type{ _segment_offset, true, std::move( r ) };
+    } else {
+      return values & lookup_forward( k );
+    }
+  }
+
+  // the number of postings of `k` from the record headers, nothing gets decoded
+  std::size_t posting_count( key_type const k ) const noexcept {
+    if( not _filter.may_contain( k ) ) { return 0; }
+    auto const o = find_key( k );
+    if( o == npos ) { return 0; }
+    assert( o < _offsets.size() );
+    std::size_t count = 0;
+    for_each_cblock( _offsets[o], [&]( auto const* p, auto const n, auto const m ) {
+      if constexpr( detail::sequence_decoder<VC> ) {
+        count += VC::sequence_size( p, n );
+      } else {
+        count += m;
+      }
+      return true;
+    } );
+    return count;
+  }
+
+  // container indices hand out their chunks as is, all others get converted
+  resultset_container_type lookup_containers( key_type const k ) const noexcept {
+    if( not _filter.may_contain( k ) ) { return resultset_container_type{ _segment_offset }; }
+    auto const o = find_key( k );
+    if( o == npos ) { return resultset_container_type{ _segment_offset }; }
+    assert( o < _offsets.size() );
+    if constexpr( detail::container_decoder<VC> ) {
+      std::vector<container::chunk> chunks;
+      auto const rc = for_each_cblock( _offsets[o], [&]( auto const* p, auto const n, auto const m ) {
+        container::chunk c;
+        if( not container::chunk::deserialize( p, n, m, c ) ) { return false; }
+        chunks.push_back( std::move( c ) );
+        return true;
+      } );
+      return resultset_container_type{ _segment_offset, rc, std::move( chunks ) };
+    } else {
+      std::vector<value_type> values;
+      auto const rc = decode( _offsets[o], std::back_inserter( values ) );
+      return resultset_container_type{
+          _segment_offset, rc, container::posting_set::from_sorted( values.data(), values.size() ) };
+    }
+  }
+
   value_type compressed_size( key_type const k ) const noexcept {
     value_type last_offset = static_cast<value_type>( _data.size() - METASZ );
-    auto it = std::lower_bound( _keys.begin(), _keys.end(), k );
-    if( it == _keys.end() || k < *it ) { return 0; }
-    auto const o = static_cast<std::size_t>( it - _keys.begin() );
+    auto const o = find_key( k );
+    if( o == npos ) { return 0; }
     assert( o < _offsets.size() );
-    auto const next_offset = o == _keys.size() - 1 ? last_offset : _offsets[o + 1];
+    auto const next_offset = o == _offsets.size() - 1 ? last_offset : _offsets[o + 1];
     return next_offset - _offsets[o];
   }
 
   template <typename OutIt>
   void output_keys( OutIt& out ) const {
     value_type last_offset = static_cast<value_type>( _data.size() - METASZ );
-    for( std::size_t i = 0; i < _keys.size(); i++ ) {
+    auto const& ks = keys();
+    for( std::size_t i = 0; i < ks.size(); i++ ) {
       std::ostringstream k_and_size;
-      auto const next_offset = i == _keys.size() - 1 ? last_offset : _offsets.at( i + 1 );
-      k_and_size << _keys[i];
+      auto const next_offset = i == ks.size() - 1 ? last_offset : _offsets.at( i + 1 );
+      k_and_size << ks[i];
       k_and_size << " : ";
       k_and_size << next_offset - _offsets.at( i );
       out = k_and_size.str();
@@ -288,7 +548,7 @@ class index_view {
   void prepare_reverse_lookups() noexcept {
     if( not _inverted_index.empty() ) { return; }
     std::vector<value_type> values;
-    for( auto const& k : _keys ) {
+    for( auto const& k : keys() ) {
       values.clear();
       if( auto const rc = lookup_forward( k, std::back_inserter( values ) ); ! rc ) {
         _inverted_index.clear();
@@ -350,6 +610,9 @@ class poly_index_view {
     virtual resultset_forward_type lookup_forward_32( key32_t const k ) noexcept = 0;
     virtual resultset_forward_type lookup_forward_64( key64_t const k ) noexcept = 0;
     virtual resultset_forward_type lookup_forward_128( key128_t const k ) noexcept = 0;
+    virtual resultset_container_type lookup_containers_32( key32_t const k ) noexcept = 0;
+    virtual resultset_forward_type lookup_forward_and_32( key32_t const k,
+                                                          resultset_forward_type const& v ) noexcept = 0;
     virtual resultset_forward_type lookup_reverse( value_type const v ) noexcept = 0;
     virtual resultset_forward_type scan_and( resultset_forward_type const& v ) noexcept = 0;
     virtual resultset_forward_type scan_or( resultset_forward_type const& v ) noexcept = 0;
@@ -358,6 +621,7 @@ class poly_index_view {
     virtual resultset_reverse_32 lookup_inverse_32( value_type const v ) noexcept = 0;
     virtual resultset_reverse_64 lookup_inverse_64( value_type const v ) noexcept = 0;
     virtual resultset_reverse_128 lookup_inverse_128( value_type const v ) noexcept = 0;
+    virtual std::size_t posting_count_32( key32_t const k ) const noexcept = 0;
     virtual value_type compressed_size( key64_t const v ) const noexcept = 0;
     virtual value_type compressed_size_128( key128_t const v ) const noexcept = 0;
     virtual void prepare_reverse_lookups() noexcept = 0;
@@ -367,6 +631,8 @@ class poly_index_view {
     virtual std::uint64_t segment_offset() const noexcept = 0;
     virtual void output_keys( std::ostream& os ) const noexcept = 0;
     virtual void output_histogram( std::vector<value_type>& sizes ) const noexcept = 0;
+    virtual void collect_keys_32( std::vector<key32_t>& keys ) const = 0;
+    virtual void collect_keys_128( std::vector<key128_t>& keys ) const = 0;
   };
 
   template <typename T, typename VC>
@@ -399,6 +665,18 @@ class poly_index_view {
       _view.output_histogram( it );
     }
 
+    void collect_keys_32( std::vector<key32_t>& keys ) const override {
+      if constexpr( std::is_same_v<key32_t, typename index_view<T, VC>::key_type> ) {
+        keys.insert( keys.end(), _view.keys().begin(), _view.keys().end() );
+      }
+    }
+
+    void collect_keys_128( std::vector<key128_t>& keys ) const override {
+      if constexpr( std::is_same_v<key128_t, typename index_view<T, VC>::key_type> ) {
+        keys.insert( keys.end(), _view.keys().begin(), _view.keys().end() );
+      }
+    }
+
     //--forward-lookup-wrappers-----------------------------------------------
 
     resultset_forward_type lookup_forward_32( key32_t const k ) noexcept override {
@@ -422,6 +700,28 @@ class poly_index_view {
       return resultset_forward_type{ 0 };
     }
 
+    resultset_container_type lookup_containers_32( key32_t const k ) noexcept override {
+      if constexpr( std::is_same_v<key32_t, typename index_view<T, VC>::key_type> ) {
+        return _view.lookup_containers( k );
+      }
+      return resultset_container_type{ 0 };
+    }
+
+    resultset_forward_type lookup_forward_and_32( key32_t const k,
+                                                  resultset_forward_type const& v ) noexcept override {
+      if constexpr( std::is_same_v<key32_t, typename index_view<T, VC>::key_type> ) {
+        return _view.lookup_forward_and( k, v );
+      }
+      return resultset_forward_type{ 0 };
+    }
+
+    std::size_t posting_count_32( key32_t const k ) const noexcept override {
+      if constexpr( std::is_same_v<key32_t, typename index_view<T, VC>::key_type> ) {
+        return _view.posting_count( k );
+      }
+      return 0;
+    }
+
     value_type compressed_size( key64_t const k ) const noexcept override {
       if constexpr( std::is_same_v<key128_t, typename index_view<T, VC>::key_type> ) { return 0; }
       return _view.compressed_size( static_cast<typename index_view<T, VC>::key_type>( k ) );
@@ -485,6 +785,8 @@ class poly_index_view {
   std::unique_ptr<base> _p;
 
  public:
+  poly_index_view() = default;
+
   template <typename T, typename VC>
   poly_index_view( index_view<T, VC>&& iv )
     : _p{ std::make_unique<view<T, VC>>( std::forward<index_view<T, VC>>( iv ) ) } {}
@@ -495,6 +797,7 @@ class poly_index_view {
   poly_index_view( poly_index_view&& ) noexcept = default;
   poly_index_view& operator=( poly_index_view&& ) noexcept = default;
 
+  bool valid() const noexcept { return _p != nullptr; }
   auto size() const noexcept { return _p->size(); }
   auto key_count() const noexcept { return _p->size(); }
   auto sizeof_domain_value() const noexcept { return _p->sizeof_domain_value(); }
@@ -506,6 +809,10 @@ class poly_index_view {
     return _p->output_histogram( sizes );
   }
 
+  // appends all keys ( ascending ), nothing if the key type differs
+  void collect_keys_32( std::vector<key32_t>& keys ) const { return _p->collect_keys_32( keys ); }
+  void collect_keys_128( std::vector<key128_t>& keys ) const { return _p->collect_keys_128( keys ); }
+
   resultset_forward_type scan_and( resultset_forward_type const& values ) const noexcept {
     return _p->scan_and( values );
   }
@@ -534,6 +841,19 @@ class poly_index_view {
     return _p->lookup_forward_128( k );
   }
 
+  resultset_container_type lookup_containers_32( key32_t const k ) const noexcept {
+    return _p->lookup_containers_32( k );
+  }
+
+  resultset_forward_type lookup_forward_and_32( key32_t const k,
+                                                resultset_forward_type const& v ) const noexcept {
+    return _p->lookup_forward_and_32( k, v );
+  }
+
+  std::size_t posting_count_32( key32_t const k ) const noexcept {
+    return _p->posting_count_32( k );
+  }
+
   value_type compressed_size_128( key128_t const k ) const noexcept {
     return _p->compressed_size_128( k );
   }
@@ -571,6 +891,14 @@ class poly_index_view {
       case method::SVB256D1: DISPTACH( type, detail::svb256d1, fn ); break;                           \
       case method::BP128D1: DISPTACH( type, detail::bp128d1, fn ); break;                             \
       case method::BP256D1: DISPTACH( type, detail::bp256d1, fn ); break;                             \
+      case method::SVB512D1: DISPTACH( type, detail::svb512d1, fn ); break;                           \
+      case method::BP512D1: DISPTACH( type, detail::bp512d1, fn ); break;                             \
+      case method::AD128: DISPTACH( type, detail::ad128, fn ); break;                                 \
+      case method::AD256: DISPTACH( type, detail::ad256, fn ); break;                                 \
+      case method::RC128: DISPTACH( type, detail::rc128, fn ); break;                                 \
+      case method::RC256: DISPTACH( type, detail::rc256, fn ); break;                                 \
+      case method::PEF128: DISPTACH( type, detail::pef128, fn ); break;                               \
+      case method::PEF256: DISPTACH( type, detail::pef256, fn ); break;                               \
       default: break;                                                                                 \
     }                                                                                                 \
   } while( false )
@@ -591,6 +919,20 @@ class poly_index_view {
 
 namespace detail {
 
+// the key filter in front of the META record, an invalid view ( containing everything ) for
+// indices without one
+inline filter::view key_filter( bytestring_view const data ) noexcept {
+  auto const sz = data.size();
+  if( sz < METASZ + FILTER_TRAILER_SIZE ) { return {}; }
+  auto const* const p = data.data();
+  if( static_cast<std::uint8_t>( p[sz - META_FLAG_OFFSET] ) != meta_flag::FILTER ) { return {}; }
+  std::size_t const size = unsafe::rd32<LE>( p + sz - METASZ - 4 );
+  if( size < FILTER_TRAILER_SIZE or size > sz - METASZ ) { return {}; }
+  auto const* const trailer = p + sz - METASZ - size;
+  if( encoding{ trailer[0] }._tag != tag::MBLOCK ) { return {}; }
+  return filter::view{ trailer + 1, size - FILTER_TRAILER_SIZE };
+}
+
 template <typename Compressor, typename OutIt>
 void build_oblock( bytestring_view const data, OutIt out ) {
   auto const sz = data.size();
@@ -637,14 +979,59 @@ void build_kblock( bytestring_view const data, OutIt out ) {
   }
 }
 
+// only locates the key blocks, see `key_blocks`
+template <seekable_key_decoder KeyCompressor>
+auto build_key_blocks( bytestring_view const data ) {
+  using key_t = typename KeyCompressor::integer_type;
+  using blocks_type = key_blocks<key_t>;
+  auto const find = []( std::byte const* p, std::size_t const m, key_t const k ) noexcept {
+    return KeyCompressor::find( p, m, k );
+  };
+  auto const decode = []( std::byte const* p, std::size_t const n, std::size_t const m,
+                          std::vector<key_t>& keys ) {
+    KeyCompressor::decode( p, n, m, std::back_inserter( keys ) );
+  };
+  blocks_type blocks{ find, decode };
+  auto const sz = data.size();
+  auto const* p = data.data();
+  auto const* const end = p + sz - METASZ;
+  auto const key_block = unsafe::rd32<LE>( p + sz - META_KBLOCK_OFFSET );
+  if( key_block + METASZ > sz ) { throw std::runtime_error( "INVALID_KEYBLOCK" ); }
+  p += key_block;
+  while( p < end ) {
+    encoding const enc{ p[0] };
+    if( enc._tag != tag::KBLOCK ) { break; }
+    p++;
+    auto const uncompressed_size = enc._ulen == 0b11 ? KeyCompressor::BLOCKLEN
+                                                     : vbyte::decode( p, enc._ulen );
+    auto const n = enc._ulen == 0b11 ? 0u : enc._ulen + 1;
+    auto const m = enc._clen + 1u;
+    auto const compressed_size = vbyte::decode( p + n, enc._clen );
+    if( p + n + m + compressed_size > end ) { throw std::runtime_error( "INVALID_KEYBLOCK" ); }
+    auto const* const block = p + n + m;
+    if( not KeyCompressor::valid( block, compressed_size, uncompressed_size ) ) {
+      throw std::runtime_error( "INVALID_KEYBLOCK" );
+    }
+    blocks.add( block, compressed_size, uncompressed_size, KeyCompressor::first( block ) );
+    p += n + m + compressed_size;
+  }
+  return blocks;
+}
+
 template <typename KC, typename VC, typename F>
 static auto from( bytestring_view const data, std::uint64_t const segment_offset, F const f ) {
   using key_t = typename KC::integer_type;
   std::vector<key_t> keys;
   std::vector<offset_type> offsets;
-  detail::build_kblock<KC>( data, std::back_inserter( keys ) );
+  key_blocks<key_t> blocks;
+  if constexpr( seekable_key_decoder<KC> ) {
+    blocks = detail::build_key_blocks<KC>( data );
+  } else {
+    detail::build_kblock<KC>( data, std::back_inserter( keys ) );
+  }
   detail::build_oblock<VC>( data, std::back_inserter( offsets ) );
-  return f( index_view<key_t, VC>( data, segment_offset, std::move( keys ), std::move( offsets ) ) );
+  return f( index_view<key_t, VC>( data, segment_offset, std::move( keys ), std::move( offsets ),
+                                   key_filter( data ), std::move( blocks ) ) );
 }
 
 #define DISPATCH_VALUE_COMPRESSION( m )                                                               \
@@ -656,33 +1043,47 @@ static auto from( bytestring_view const data, std::uint64_t const segment_offset
       case method::SVB256D1: return from<KC, detail::svb256d1>( data, meta.segment_offset, f );       \
       case method::BP128D1: return from<KC, detail::bp128d1>( data, meta.segment_offset, f );         \
       case method::BP256D1: return from<KC, detail::bp256d1>( data, meta.segment_offset, f );         \
+      case method::SVB512D1: return from<KC, detail::svb512d1>( data, meta.segment_offset, f );       \
+      case method::BP512D1: return from<KC, detail::bp512d1>( data, meta.segment_offset, f );         \
+      case method::AD128: return from<KC, detail::ad128>( data, meta.segment_offset, f );             \
+      case method::AD256: return from<KC, detail::ad256>( data, meta.segment_offset, f );             \
+      case method::RC128: return from<KC, detail::rc128>( data, meta.segment_offset, f );             \
+      case method::RC256: return from<KC, detail::rc256>( data, meta.segment_offset, f );             \
+      case method::PEF128: return from<KC, detail::pef128>( data, meta.segment_offset, f );           \
+      case method::PEF256: return from<KC, detail::pef256>( data, meta.segment_offset, f );           \
       default: throw std::runtime_error( "UNSUPPORTED_VALUE_COMPRESSION_METHOD" );                    \
     }                                                                                                 \
   } while( false )
 
-template <typename F>
-static auto from( bytestring_view const data, F const f ) {
+struct meta_record {
+  std::uint32_t magic0;
+  std::uint8_t kmethod;
+  std::uint8_t vmethod;
+  std::uint8_t reserved;
+  std::uint8_t keyty;
+  std::uint32_t kblock_offset;
+  std::uint32_t oblock_voffset;
+  std::uint64_t segment_offset;
+  std::uint32_t magic1;
+  std::uint32_t magic2;
+};
+
+inline meta_record read_meta( bytestring_view const data ) {
   auto const sz = data.size();
   if( sz < METASZ ) { throw std::runtime_error( "INVALID_FILESIZE" ); }
-  struct meta {
-    std::uint32_t magic0;
-    std::uint8_t kmethod;
-    std::uint8_t vmethod;
-    std::uint8_t reserved;
-    std::uint8_t keyty;
-    std::uint32_t kblock_offset;
-    std::uint32_t oblock_voffset;
-    std::uint64_t segment_offset;
-    std::uint32_t magic1;
-    std::uint32_t magic2;
-  } meta;
-
+  meta_record meta;
   auto is = data.template istream_at<LE>( sz - METASZ );
   is >> meta.magic0 >> meta.kmethod >> meta.vmethod >> meta.reserved >> meta.keyty >>
       meta.kblock_offset >> meta.oblock_voffset >> meta.segment_offset >> meta.magic1 >> meta.magic2;
 
   if( meta.magic0 != MAGIC ) { throw std::runtime_error( "INVALID_MAGIC" ); }
   if( meta.keyty != 0b01 && meta.keyty != 0b11 ) { throw std::runtime_error( "INVALID_KEYTYPE" ); }
+  return meta;
+}
+
+template <typename F>
+static auto from( bytestring_view const data, F const f ) {
+  auto const meta = read_meta( data );
 
   // clang-format off
   if( meta.keyty == 0b01 ) {
@@ -693,12 +1094,18 @@ static auto from( bytestring_view const data, F const f ) {
       case method::SVB256D1: { using KC = detail::svb256d1; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
       case method::BP128D1: { using KC = detail::bp128d1; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
       case method::BP256D1: { using KC = detail::bp256d1; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::SVB512D1: { using KC = detail::svb512d1; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::BP512D1: { using KC = detail::bp512d1; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::AD128: { using KC = detail::ad128; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::AD256: { using KC = detail::ad256; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
       default: throw std::runtime_error( "UNSUPPORTED_32BIT_KEY_COMPRESSION_METHOD" );
     }
   } else {
     switch( meta.kmethod ) {
       case method::UC128: { using KC = detail::raw_key128<method::UC128, 128>; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
       case method::UC256: { using KC = detail::raw_key128<method::UC256, 256>; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::PK128: { using KC = detail::pk128; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
+      case method::PK256: { using KC = detail::pk256; DISPATCH_VALUE_COMPRESSION( meta.vmethod ); }
       default: throw std::runtime_error( "UNSUPPORTED_128BIT_KEY_COMPRESSION_METHOD" );
     }
   }
@@ -717,20 +1124,35 @@ inline auto make_poly_index_view( bytestring_view const data ) {
 
 } // namespace detail
 
+// only the META record and the key filter get read upfront, keys and offsets get decoded on first
+// access of the index view. lookups of keys rejected by the key filter never decode anything
 class index_view_handle {
+  using key32_t = std::uint32_t;
+  using key128_t = __uint128_t;
 
   std::unique_ptr<nygma::mmap_view> _map;
-  poly_index_view _index;
+  bytestring_view _data;
+  detail::meta_record _meta;
+  filter::view _filter;
+  mutable poly_index_view _index;
+
+  poly_index_view& index() const {
+    if( not _index.valid() ) { _index = detail::make_poly_index_view( _data ); }
+    return _index;
+  }
 
  public:
   index_view_handle( std::filesystem::path const& path )
     : _map{ std::make_unique<nygma::mmap_view>( path ) },
-      _index{ detail::make_poly_index_view( _map->view() ) } {}
+      _data{ _map->view() },
+      _meta{ detail::read_meta( _data ) },
+      _filter{ detail::key_filter( _data ) } {}
 
   // the index view wraps `data` non-owning. make sure it outlasts
   // the lifetime of the index view
   //
-  index_view_handle( bytestring_view const data ) : _index{ detail::make_poly_index_view( data ) } {}
+  index_view_handle( bytestring_view const data )
+    : _data{ data }, _meta{ detail::read_meta( data ) }, _filter{ detail::key_filter( data ) } {}
 
   index_view_handle( index_view_handle const& ) = delete;
   index_view_handle& operator=( index_view_handle const& ) = delete;
@@ -738,10 +1160,45 @@ class index_view_handle {
   index_view_handle( index_view_handle&& ) noexcept = default;
   index_view_handle& operator=( index_view_handle&& ) noexcept = default;
 
-  auto const& operator*() const noexcept { return _index; }
-  auto const* operator->() const noexcept { return &_index; }
-  auto& operator*() noexcept { return _index; }
-  auto* operator->() noexcept { return &_index; }
+  auto const& operator*() const { return index(); }
+  auto const* operator->() const { return &index(); }
+  auto& operator*() { return index(); }
+  auto* operator->() { return &index(); }
+
+  std::uint64_t segment_offset() const noexcept { return _meta.segment_offset; }
+  bool has_key_filter() const noexcept { return _filter.valid(); }
+
+  // `false` only if the index definitely does not contain `k`
+  bool may_contain_32( key32_t const k ) const noexcept { return _filter.may_contain( k ); }
+  bool may_contain_128( key128_t const k ) const noexcept { return _filter.may_contain( k ); }
+
+  resultset_forward_type lookup_forward_32( key32_t const k ) const {
+    if( not may_contain_32( k ) ) { return resultset_forward_type{ segment_offset() }; }
+    return index().lookup_forward_32( k );
+  }
+
+  resultset_forward_type lookup_forward_128( key128_t const k ) const {
+    if( not may_contain_128( k ) ) { return resultset_forward_type{ segment_offset() }; }
+    return index().lookup_forward_128( k );
+  }
+
+  resultset_forward_type lookup_forward_and_32( key32_t const k,
+                                                resultset_forward_type const& v ) const {
+    if( not may_contain_32( k ) ) { return v & resultset_forward_type{ segment_offset() }; }
+    return index().lookup_forward_and_32( k, v );
+  }
+
+  std::size_t posting_count_32( key32_t const k ) const {
+    if( not may_contain_32( k ) ) { return 0; }
+    return index().posting_count_32( k );
+  }
+
+  method::type compression_method() const { return index().compression_method(); }
+
+  resultset_container_type lookup_containers_32( key32_t const k ) const {
+    if( not may_contain_32( k ) ) { return resultset_container_type{ segment_offset() }; }
+    return index().lookup_containers_32( k );
+  }
 };
 
 namespace {
@@ -262,6 +262,53 @@ emptyspace::pest::suite basic( "index-view basic suite", []( auto& test ) {
     expect( iv->lookup_forward_128( 23421337u ).values(), equal_to( { 16u, 400u } ) );
     expect( not iv->lookup_forward_32( 1 ) );
   } );
+
+  test( "index-view with key filter", []( auto& expect ) {
+    using index_type = riot::index_builder<std::uint32_t, map_type, 128>;
+
+    index_type idx;
+
+    idx.add( 23421337u, 16 );
+    idx.add( 13372342u, 24 );
+    idx.add( 23421337u, 400 );
+    idx.add( 1u, 300 );
+
+    std::byte data[1024];
+    auto os = nygma::cfile_ostream{ data };
+    riot::filtering_serializer<riot::uc128_serializer<nygma::cfile_ostream>> ser{ os };
+    idx.accept( ser, 0x1000u );
+
+    // 87 bytes unfiltered index plus 1 + 4 + 32 + 4 bytes trailer
+    expect( os.current_position(), equal_to( 87u + 41u ) );
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    // trailer tagged as MBLOCK, META flags the filter
+    expect( std::to_integer<unsigned>( data[len - 32 - 41] ), equal_to( 2u ) );
+    expect( std::to_integer<unsigned>( data[len - riot::META_FLAG_OFFSET] ), equal_to( 0x24u ) );
+
+    auto iv = riot::make_poly_index_view( unclassified::bytestring_view{ data, len } );
+    expect( iv.has_key_filter() );
+    expect( iv.segment_offset(), equal_to( 0x1000u ) );
+    expect( iv.may_contain_32( 1u ) );
+    expect( iv.may_contain_32( 13372342u ) );
+    expect( iv.may_contain_32( 23421337u ) );
+    expect( not iv.may_contain_32( 42u ) );
+    expect( iv.lookup_forward_32( 23421337u ).values(), equal_to( { 16u, 400u } ) );
+    expect( iv->size(), equal_to( 3u ) );
+    expect( iv->lookup_forward_32( 13372342u ).values(), equal_to( { 24u } ) );
+    expect( iv->lookup_forward_32( 42u ).values().empty() );
+
+    // rejected keys never touch the key blocks
+    data[len - riot::META_KBLOCK_OFFSET] = std::byte{ 0xff };
+    auto broken = riot::make_poly_index_view( unclassified::bytestring_view{ data, len } );
+    auto const rs = broken.lookup_forward_32( 42u );
+    expect( not rs );
+    expect( rs.segment_offset(), equal_to( 0x1000u ) );
+    auto thrown = false;
+    try {
+      broken.lookup_forward_32( 1u );
+    } catch( std::runtime_error const& ) { thrown = true; }
+    expect( thrown );
+  } );
 } );
 
 } // namespace
@@ -35,6 +35,8 @@ struct environment {
   };
 
   indices_type _indices;
+  // offsets probed against forward queries ( instead of decoding their postings )
+  mutable std::size_t _probes{ 0 };
 
   template <typename Map>
   explicit environment( Map&& map ) : _indices{ std::forward<Map>( map ) } {}
@@ -51,13 +53,114 @@ struct environment {
   resultset_type operator()( ipv4 const& ) const { return resultset_type::none(); }
   resultset_type operator()( ipv6 const& ) const { return resultset_type::none(); }
   resultset_type operator()( binary const& b ) const {
+    if( container_wise( b ) ) {
+      auto const rs = eval_containers( b );
+      return resultset_type{ rs.segment_offset(), static_cast<bool>( rs ), rs.values().values() };
+    }
     switch( b._op ) {
       case binop::UNION: return eval( b._a ) + eval( b._b );
       case binop::COMPLEMENT: return eval( b._a ) - eval( b._b );
-      case binop::INTERSECTION: return eval( b._a ) & eval( b._b );
+      case binop::INTERSECTION: {
+        // forward queries only get probed for the offsets of the other side. with forward queries
+        // on both sides the one with fewer postings gets decoded and the other one probed
+        if( b._a->type() == kind::QUERY and b._b->type() == kind::QUERY ) {
+          auto const& qa = static_cast<query const&>( *b._a );
+          auto const& qb = static_cast<query const&>( *b._b );
+          if( posting_count( qb ) < posting_count( qa ) ) { return intersect( qa, eval( b._b ) ); }
+          return intersect( qb, eval( b._a ) );
+        }
+        if( b._b->type() == kind::QUERY ) {
+          return intersect( static_cast<query const&>( *b._b ), eval( b._a ) );
+        }
+        if( b._a->type() == kind::QUERY ) {
+          return intersect( static_cast<query const&>( *b._a ), eval( b._b ) );
+        }
+        return eval( b._a ) & eval( b._b );
+      }
     }
     return resultset_type::none();
   }
+  //--container-wise-evaluation----------------------------------------------
+
+  // subtrees of forward queries on container indices ( `rc128` / `rc256` ) get combined chunk by
+  // chunk: intersecting bitmaps is a word wise `and` plus a `popcount`. with packet ordinals as
+  // postings the chunks of common keys are dense enough for bitmaps
+  bool container_wise( node const& n ) const {
+    if( n.type() == kind::BINARY ) {
+      auto const& b = static_cast<binary const&>( n );
+      return container_wise( *b._a ) and container_wise( *b._b );
+    }
+    if( n.type() != kind::QUERY ) { return false; }
+    auto const& q = static_cast<query const&>( n );
+    if( q._method != query_method::FORWARD ) { return false; }
+    if( q._what->type() != kind::NUM and q._what->type() != kind::IPV4 ) { return false; }
+    auto const name = q._name->eval<kind::ID>( []( auto const& id ) { return id._name; } );
+    auto const it = _indices.find( name );
+    if( it == _indices.end() ) { return false; }
+    auto const m = it->second.compression_method();
+    return m == method::RC128 or m == method::RC256;
+  }
+
+  // `container_wise( n )` has to hold
+  resultset_container_type eval_containers( node const& n ) const {
+    if( n.type() == kind::BINARY ) {
+      auto const& b = static_cast<binary const&>( n );
+      switch( b._op ) {
+        case binop::UNION: return eval_containers( *b._a ) + eval_containers( *b._b );
+        case binop::COMPLEMENT: return eval_containers( *b._a ) - eval_containers( *b._b );
+        case binop::INTERSECTION: return eval_containers( *b._a ) & eval_containers( *b._b );
+      }
+      return resultset_container_type::none();
+    }
+    auto const& q = static_cast<query const&>( n );
+    auto const name = q._name->eval<kind::ID>( []( auto const& id ) { return id._name; } );
+    auto const& index = _indices.at( name );
+    return q._what->eval( overloaded{
+        [&]( number const& k ) {
+          return index.lookup_containers_32( static_cast<std::uint32_t>( k._value ) );
+        },
+        [&]( ipv4 const& k ) {
+          return index.lookup_containers_32( static_cast<std::uint32_t>( k._value ) );
+        },
+        []( auto const& ) { return resultset_container_type::none(); },
+    } );
+  }
+
+  // the number of postings of a forward query from the record headers, `npos` if unknown
+  static constexpr std::size_t npos = ~std::size_t( 0 );
+  std::size_t posting_count( query const& q ) const {
+    if( q._method != query_method::FORWARD ) { return npos; }
+    auto const name = q._name->eval<kind::ID>( []( auto const& id ) { return id._name; } );
+    auto const it = _indices.find( name );
+    if( it == _indices.end() ) { return 0; }
+    return q._what->eval( overloaded{
+        [&]( number const& n ) {
+          return it->second.posting_count_32( static_cast<std::uint32_t>( n._value ) );
+        },
+        [&]( ipv4 const& i4 ) {
+          return it->second.posting_count_32( static_cast<std::uint32_t>( i4._value ) );
+        },
+        []( auto const& ) { return npos; },
+    } );
+  }
+  // `values & q`. skipping indices ( elias-fano ) avoid decoding all postings of `q`
+  resultset_type intersect( query const& q, resultset_type const& values ) const {
+    if( q._method != query_method::FORWARD ) { return values & ( *this )( q ); }
+    auto const name = q._name->eval<kind::ID>( []( auto const& id ) { return id._name; } );
+    auto const it = _indices.find( name );
+    if( it == _indices.end() ) { return values & resultset_type::none(); }
+    return q._what->eval( overloaded{
+        [&]( number const& n ) {
+          _probes += values.size();
+          return it->second.lookup_forward_and_32( static_cast<std::uint32_t>( n._value ), values );
+        },
+        [&]( ipv4 const& i4 ) {
+          _probes += values.size();
+          return it->second.lookup_forward_and_32( static_cast<std::uint32_t>( i4._value ), values );
+        },
+        [&]( auto const& ) { return values & ( *this )( q ); },
+    } );
+  }
   resultset_type operator()( query const& q ) const {
     switch( q._method ) {
       case query_method::COMBINED: throw std::runtime_error( "query_method::COMBINED unimplemented" );
@@ -68,17 +171,17 @@ struct environment {
             [&]( number const& n ) {
               auto const it = _indices.find( name );
               if( it == _indices.end() ) { return resultset_type::none(); }
-              return it->second->lookup_forward_32( static_cast<std::uint32_t>( n._value ) );
+              return it->second.lookup_forward_32( static_cast<std::uint32_t>( n._value ) );
             },
             [&]( ipv4 const& i4 ) {
               auto const it = _indices.find( name );
               if( it == _indices.end() ) { return resultset_type::none(); }
-              return it->second->lookup_forward_32( static_cast<std::uint32_t>( i4._value ) );
+              return it->second.lookup_forward_32( static_cast<std::uint32_t>( i4._value ) );
             },
             [&]( ipv6 const& i6 ) {
               auto const it = _indices.find( name );
               if( it == _indices.end() ) { return resultset_type::none(); }
-              return it->second->lookup_forward_128( i6._value );
+              return it->second.lookup_forward_128( i6._value );
             },
             []( auto const& ) { return resultset_type::none(); },
         } );
@@ -3,6 +3,7 @@
 #include <pest/pest.hxx>
 
 #include <libriot/index-builder.hxx>
+#include <libriot/index-compressor.hxx>
 #include <libriot/query-evaluator.hxx>
 #include <libriot/query-parser.hxx>
 
@@ -133,6 +134,106 @@ emptyspace::pest::suite basic( "query-evaluator basic suite", []( auto& test ) {
     expect( rs.values(), equal_to( { 16u } ) );
   } );
 
+  test( "evaluate: 'ix( 1 ) & ix( 2 )' ( elias-fano )", []( auto& expect ) {
+    index_type idx;
+    idx.add( 1u, 16 );
+    idx.add( 1u, 300 );
+    idx.add( 3u, 3000 );
+    for( std::uint32_t i = 0; i < 1000; ++i ) { idx.add( 2u, 16 + 4 * i ); }
+
+    std::byte data[4096];
+    auto os = nygma::cfile_ostream{ data };
+    riot::pef128_serializer ser{ os };
+    idx.accept( ser, 0x41414141u );
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const env = environment::builder{}.add( "ix", bytestring_view{ data, len } ).build();
+
+    for( auto const input : { "ix( 1 ) & ix( 2 )", "ix( 2 ) & ix( 1 )" } ) {
+      auto const query = riot::parse( input );
+      auto const rs = query->eval( env );
+      expect( ! ! rs );
+      expect( rs.segment_offset(), equal_to( 0x41414141ull ) );
+      expect( rs.values(), equal_to( { 16u, 300u } ) );
+    }
+
+    auto const query = riot::parse( "ix( 1 ) & ix( 4 )" );
+    auto const rs = query->eval( env );
+    expect( ! ! rs );
+    expect( rs.empty() );
+  } );
+
+  test( "evaluate: 'ix( 1 ) & ix( 2 )' decodes the smaller side", []( auto& expect ) {
+    index_type idx;
+    idx.add( 1u, 16 );
+    idx.add( 1u, 300 );
+    idx.add( 1u, 5000 );
+    for( std::uint32_t i = 0; i < 1000; ++i ) { idx.add( 2u, 16 + 4 * i ); }
+
+    std::byte data[4096];
+    auto os = nygma::cfile_ostream{ data };
+    riot::pef128_serializer ser{ os };
+    idx.accept( ser, 0x41414141u );
+    auto const len = static_cast<std::size_t>( os.current_position() );
+    auto const env = environment::builder{}.add( "ix", bytestring_view{ data, len } ).build();
+
+    expect( env._indices.at( "ix" ).posting_count_32( 1u ), equal_to( 3u ) );
+    expect( env._indices.at( "ix" ).posting_count_32( 2u ), equal_to( 1000u ) );
+    expect( env._indices.at( "ix" ).posting_count_32( 4u ), equal_to( 0u ) );
+
+    // both operand orders probe the 1000 postings of `ix( 2 )` with the 3 offsets of `ix( 1 )`
+    for( auto const input : { "ix( 1 ) & ix( 2 )", "ix( 2 ) & ix( 1 )" } ) {
+      env._probes = 0;
+      auto const query = riot::parse( input );
+      auto const rs = query->eval( env );
+      expect( ! ! rs );
+      expect( rs.values(), equal_to( { 16u, 300u } ) );
+      expect( env._probes, equal_to( 3u ) );
+    }
+  } );
+
+  test( "evaluate: container wise ( roaring )", []( auto& expect ) {
+    // dense postings like packet ordinals, the chunks of key 1 and 2 are bitmaps
+    auto const fill = []( index_type& idx ) {
+      for( std::uint32_t i = 1; i < 140000; ++i ) {
+        if( i % 2 == 0 ) { idx.add( 1u, i ); }
+        if( i % 3 == 0 ) { idx.add( 2u, i ); }
+        if( i % 1000 == 0 ) { idx.add( 3u, i ); }
+      }
+    };
+
+    index_type idx;
+    fill( idx );
+    static std::byte rc[1 << 16];
+    auto rc_os = nygma::cfile_ostream{ rc };
+    riot::rc128_serializer rc_ser{ rc_os };
+    idx.accept( rc_ser, 0x41414141u );
+    auto const rc_len = static_cast<std::size_t>( rc_os.current_position() );
+
+    index_type idy;
+    fill( idy );
+    static std::byte bp[1 << 18];
+    auto bp_os = nygma::cfile_ostream{ bp };
+    riot::bp128d1_serializer bp_ser{ bp_os };
+    idy.accept( bp_ser, 0x41414141u );
+    auto const bp_len = static_cast<std::size_t>( bp_os.current_position() );
+
+    auto const containers = environment::builder{}.add( "ix", bytestring_view{ rc, rc_len } ).build();
+    auto const lists = environment::builder{}.add( "ix", bytestring_view{ bp, bp_len } ).build();
+
+    for( auto const input : { "ix( 1 ) & ix( 2 )", "ix( 1 ) - ix( 2 )", "ix( 3 ) + ix( 1 ) & ix( 2 )",
+                              "ix( 1 ) & ix( 4 )" } ) {
+      auto const query = riot::parse( input );
+      expect( containers.container_wise( *query ), equal_to( true ) );
+      expect( lists.container_wise( *query ), equal_to( false ) );
+      auto const a = query->eval( containers );
+      auto const b = query->eval( lists );
+      expect( a.segment_offset(), equal_to( 0x41414141ull ) );
+      expect( a.values() == b.values(), equal_to( true ) );
+    }
+    auto const query = riot::parse( "ix( 1 ) & ix( 2 )" );
+    expect( query->eval( containers ).size(), equal_to( 23333u ) );
+  } );
+
   test( "evaluate: 'ix( 1 ) + iy( 2 )'", []( auto& expect ) {
     index_type ix;
     ix.add( 1u, 16 );
@@ -95,6 +95,28 @@ struct scanner {
     return consume<token_type::IPV6>( p );
   }
 
+  constexpr int at( std::size_t const offset ) const noexcept {
+    if( offset >= _data.size() ) { return -1; }
+    return static_cast<unsigned char>( _data[offset] );
+  }
+
+  // identifiers may contain a minus followed by a letter ( e.g. `flow-of` )
+  constexpr token consume_ident() noexcept {
+    auto const p = [this]( auto const c ) noexcept {
+      return ::isalnum( c ) or ( c == '-' and ::isalpha( at( _offset + 1 ) ) );
+    };
+    return consume<token_type::ID>( p );
+  }
+
+  // an ipv6 literal starting with a letter starts with a group followed by `:`, everything else
+  // is an identifier ( e.g. `flow` or `fe` )
+  constexpr token consume_ident_or_ipv6_literal() noexcept {
+    auto i = _offset;
+    while( ::isxdigit( at( i ) ) ) { i++; }
+    if( at( i ) == ':' ) { return consume_ipv6_literal(); }
+    return consume_ident();
+  }
+
   //--non-validating
   constexpr token consume_literal() noexcept {
     auto const begin = _offset;
@@ -148,14 +170,12 @@ struct scanner {
       case '&': return one<token_type::AMP>();
       case '\\': return one<token_type::BACKSLASH>();
       case ':': return consume_ipv6_literal();
-      case 'a' ... 'f': return consume_ipv6_literal();
-      case 'A' ... 'F': return consume_ipv6_literal();
+      case 'a' ... 'f': return consume_ident_or_ipv6_literal();
+      case 'A' ... 'F': return consume_ident_or_ipv6_literal();
       case '0' ... '9': return consume_literal();
       case -1: return { token_type::EOS, begin, _offset - begin };
       default:
-        if( ::isalpha( c ) ) {
-          return consume<token_type::ID>( []( auto const _ ) { return ::isalnum( _ ); } );
-        }
+        if( ::isalpha( c ) ) { return consume_ident(); }
         return { token_type::BAD, _offset, std::max( _offset - begin, 1ul ) };
     }
   }
@@ -150,6 +150,34 @@ emptyspace::pest::suite basic( "query-lexer basic suite", []( auto& test ) {
     expect( eos.size(), equal_to( 0u ) );
     expect( s.slice_of( tok ), equal_to( "i4" ) );
   } );
+
+  test( "scanner ID = `flow` ( starts with a hex digit )", []( auto& expect ) {
+    std::string_view data{ "flow( 1 )" };
+    scanner s{ data };
+    auto const tok = s.next();
+    expect( tok.type(), equal_to( token_type::ID ) );
+    expect( s.slice_of( tok ), equal_to( "flow" ) );
+    expect( s.next().type(), equal_to( token_type::LP ) );
+  } );
+
+  test( "scanner ID = `flow-of` vs. MINUS", []( auto& expect ) {
+    std::string_view data{ "flow-of-ix -ix" };
+    scanner s{ data };
+    auto const tok = s.next();
+    expect( tok.type(), equal_to( token_type::ID ) );
+    expect( s.slice_of( tok ), equal_to( "flow-of-ix" ) );
+    expect( s.next().type(), equal_to( token_type::MINUS ) );
+    expect( s.slice_of( s.next() ), equal_to( "ix" ) );
+  } );
+
+  test( "scan & slice ipv6 literal `fe80::1`", []( auto& expect ) {
+    std::string_view data{ "fe80::1 )" };
+    scanner s{ data };
+    auto const tok = s.next();
+    expect( tok.type(), equal_to( token_type::IPV6 ) );
+    expect( s.slice_of( tok ), equal_to( "fe80::1" ) );
+    expect( s.next().type(), equal_to( token_type::RP ) );
+  } );
 } );
 
 }
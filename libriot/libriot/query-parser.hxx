@@ -4,9 +4,11 @@
 
 #include <libriot/query-ast.hxx>
 #include <libriot/query-lexer.hxx>
+#include <libunclassified/bytestring.hxx>
 
 #include <cstring>
 #include <deque>
+#include <limits>
 #include <stdexcept>
 #include <string_view>
 
@@ -170,9 +172,10 @@ class ipv6 final : public prefix {
     if( auto const rc = inet_pton( AF_INET6, lit.c_str(), &addr_in ); rc != 1 ) {
       throw std::runtime_error( "invalid ipv6 address literal" );
     }
-    // TODO: verify endianess conversions ( needs to be in sync with the indexer )
-    __uint128_t addr;
-    std::memcpy( &addr, &addr_in, sizeof( __uint128_t ) );
+    // most significant byte first, like `index_trace` does for the `i6` index
+    std::byte addr_bytes[sizeof( __uint128_t )];
+    std::memcpy( addr_bytes, &addr_in, sizeof( __uint128_t ) );
+    auto const addr = unclassified::unsafe::rd128<unclassified::endianess::BE>( addr_bytes );
     return ast::ipv6( source_span::from( t ), addr );
   }
 
@@ -10,7 +10,7 @@ namespace {
 
 auto hexify_v6( __uint128_t const value ) noexcept {
   std::byte buf[sizeof( __uint128_t )];
-  std::memcpy( buf, &value, sizeof( __uint128_t ) );
+  unclassified::unsafe::wr128<unclassified::endianess::BE>( buf, value );
   return emptyspace::pest::hexify( buf );
 };
 
@@ -135,6 +135,23 @@ emptyspace::pest::suite basic( "query-parser basic suite", []( auto& test ) {
       expect( binary._b->type() == kind::QUERY );
     } );
   } );
+
+  test( "expression: 'flow-of( 1234 ) - flow( 7 )'", []( auto& expect ) {
+    std::string_view const input{ "flow-of( 1234 ) - flow( 7 )" };
+    auto q = riot::parse( input );
+    expect( ! ! q );
+    q->accept<kind::BINARY>( [&]( auto const& binary ) {
+      expect( binary._op == binop::COMPLEMENT );
+      binary._a->template accept<kind::QUERY>( [&]( auto const& query ) {
+        query._name->template accept<kind::ID>(
+            [&]( auto const& id ) { expect( id._name, equal_to( "flow-of" ) ); } );
+      } );
+      binary._b->template accept<kind::QUERY>( [&]( auto const& query ) {
+        query._name->template accept<kind::ID>(
+            [&]( auto const& id ) { expect( id._name, equal_to( "flow" ) ); } );
+      } );
+    } );
+  } );
 } );
 
 } // namespace
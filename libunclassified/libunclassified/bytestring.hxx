@@ -90,6 +90,16 @@ constexpr std::uint64_t rd64( std::byte const* p ) noexcept {
   }
 }
 
+// e.g. ipv6 addresses as integers ( `rd128<BE>` ), so they sort like their textual representation
+template <endianess E>
+constexpr __uint128_t rd128( std::byte const* p ) noexcept {
+  if constexpr( E == endianess::LE ) {
+    return __uint128_t( rd64<E>( p ) ) | ( __uint128_t( rd64<E>( p + 8 ) ) << 64 );
+  } else if constexpr( E == endianess::BE ) {
+    return ( __uint128_t( rd64<E>( p ) ) << 64 ) | __uint128_t( rd64<E>( p + 8 ) );
+  }
+}
+
 template <endianess E>
 constexpr void wr16( std::byte* const p, std::uint16_t const x ) noexcept {
   using b = std::byte;
@@ -216,6 +226,17 @@ constexpr void wr64( std::byte* const p, std::uint64_t const x ) noexcept {
   }
 }
 
+template <endianess E>
+constexpr void wr128( std::byte* const p, __uint128_t const x ) noexcept {
+  if constexpr( E == endianess::LE ) {
+    wr64<E>( p, static_cast<std::uint64_t>( x ) );
+    wr64<E>( p + 8, static_cast<std::uint64_t>( x >> 64 ) );
+  } else if constexpr( E == endianess::BE ) {
+    wr64<E>( p, static_cast<std::uint64_t>( x >> 64 ) );
+    wr64<E>( p + 8, static_cast<std::uint64_t>( x ) );
+  }
+}
+
 } // namespace unsafe
 
 template <endianess>
@@ -4,6 +4,8 @@
 
 #include <libunclassified/bytestring.hxx>
 
+#include <cstring>
+
 namespace {
 
 using namespace unclassified;
@@ -95,6 +97,22 @@ emptyspace::pest::suite basic( "bytestring suite", []( auto& test ) {
     expect( bs.rd64<BE>(), equal_to( 0x4223133713372342ull ) );
   } );
 
+  test( "unsafe::rd128 / unsafe::wr128", []( auto& expect ) {
+    std::byte buf[16];
+    std::memcpy( buf, data8, 8 );
+    std::memcpy( buf + 8, data8, 8 );
+    auto const be = unsafe::rd128<BE>( buf );
+    expect( static_cast<std::uint64_t>( be >> 64 ), equal_to( 0x4223133713372342ull ) );
+    expect( static_cast<std::uint64_t>( be ), equal_to( 0x4223133713372342ull ) );
+    auto const le = unsafe::rd128<LE>( buf );
+    expect( static_cast<std::uint64_t>( le >> 64 ), equal_to( 0x4223371337132342ull ) );
+    std::byte out[16];
+    unsafe::wr128<BE>( out, be );
+    expect( std::memcmp( out, buf, 16 ), equal_to( 0 ) );
+    unsafe::wr128<LE>( out, le );
+    expect( std::memcmp( out, buf, 16 ), equal_to( 0 ) );
+  } );
+
   test( "rd32<LE>rd32<LE>", []( auto& expect ) {
     bytestring_istream<BE> bs{ data8 };
     expect( bs.available( 4 ), equal_to( true ) );
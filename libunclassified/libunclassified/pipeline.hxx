@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#pragma once
+
+#include <libunclassified/backoff-strategy.hxx>
+#include <libunclassified/ring.hxx>
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+namespace unclassified::pipeline {
+
+// throughput and stall counters of a pipeline stage, owned and written by the stage thread only.
+// a stage waiting on its input is starved by the stage before it, a stage waiting on its output
+// is held up by the stage after it: the bottleneck is the stage that rarely waits at all.
+struct stage_counters {
+  using clock_type = std::chrono::steady_clock;
+
+  std::string_view _name;
+  std::uint64_t _batches{ 0 };
+  std::uint64_t _items{ 0 };
+  // batches the stage had to wait for / to get rid of
+  std::uint64_t _input_waits{ 0 };
+  std::uint64_t _output_waits{ 0 };
+  clock_type::duration _input_stalled{ 0 };
+  clock_type::duration _output_stalled{ 0 };
+  clock_type::time_point _start{};
+  clock_type::duration _elapsed{ 0 };
+
+  explicit stage_counters( std::string_view const name ) noexcept : _name{ name } {}
+
+  inline void start() noexcept { _start = clock_type::now(); }
+
+  inline void stop() noexcept { _elapsed = clock_type::now() - _start; }
+
+  inline void processed( std::uint64_t const items ) noexcept {
+    _batches++;
+    _items += items;
+  }
+
+  static inline double seconds( clock_type::duration const d ) noexcept {
+    return std::chrono::duration<double>( d ).count();
+  }
+
+  // the time spent on the batches themselves
+  inline double busy() const noexcept {
+    return seconds( _elapsed - _input_stalled - _output_stalled );
+  }
+
+  inline double elapsed() const noexcept { return seconds( _elapsed ); }
+
+  // millions of items per busy second: what the stage could sustain on its own
+  inline double rate() const noexcept {
+    auto const b = busy();
+    return b > 0.0 ? static_cast<double>( _items ) / b / 1e6 : 0.0;
+  }
+};
+
+// a bounded queue of `T` between two stages on top of `ring`. messages get written and read in
+// place, `open` / `commit` on the producing and `next` / `release` on the consuming side. `close`
+// ends the stream, `next` returns `nullptr` after the last message.
+//
+// `T` lives in the ring storage, it has to be trivially destructible. `open` default initializes.
+template <typename T, std::int64_t Count = 64>
+class channel {
+  static_assert( std::is_trivially_destructible_v<T> );
+
+  struct slot {
+    T _value;
+    bool _end;
+  };
+
+  static constexpr std::size_t SLOTSZ = std::bit_ceil( sizeof( slot ) );
+
+  using ring_type = ring<Count, SLOTSZ>;
+  // the stages have a core each, no sleeping
+  using backoff = backoff_strategy::backoff2;
+
+  ring_type _ring;
+  std::int64_t _wr_idx{ 0 };
+  std::int64_t _rd_idx{ 0 };
+
+ public:
+  channel() = default;
+
+  channel( channel const& ) = delete;
+  channel& operator=( channel const& ) = delete;
+
+  inline T* open( stage_counters& c ) noexcept { return &open_slot( c )->_value; }
+
+  inline void commit() noexcept { _ring.write_commit( _wr_idx ); }
+
+  inline void close( stage_counters& c ) noexcept {
+    open_slot( c )->_end = true;
+    commit();
+  }
+
+  inline T const* next( stage_counters& c ) noexcept {
+    _rd_idx = _ring.read_idx();
+    auto const* s = _ring.template read_ptr<slot>( _rd_idx );
+    if( s == nullptr ) {
+      c._input_waits++;
+      auto const t = stage_counters::clock_type::now();
+      for( backoff bo{}; ( s = _ring.template read_ptr<slot>( _rd_idx ) ) == nullptr; ++bo ) {
+        bo();
+      }
+      c._input_stalled += stage_counters::clock_type::now() - t;
+    }
+    if( s->_end ) {
+      release();
+      return nullptr;
+    }
+    return &s->_value;
+  }
+
+  inline void release() noexcept { _ring.read_commit( _rd_idx ); }
+
+ private:
+  inline slot* open_slot( stage_counters& c ) noexcept {
+    _wr_idx = _ring.write_idx();
+    auto* p = _ring.template write_ptr<slot>( _wr_idx );
+    if( p == nullptr ) {
+      c._output_waits++;
+      auto const t = stage_counters::clock_type::now();
+      for( backoff bo{}; ( p = _ring.template write_ptr<slot>( _wr_idx ) ) == nullptr; ++bo ) {
+        bo();
+      }
+      c._output_stalled += stage_counters::clock_type::now() - t;
+    }
+    auto* s = ::new( static_cast<void*>( p ) ) slot;
+    s->_end = false;
+    return s;
+  }
+};
+
+} // namespace unclassified::pipeline
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <pest/pest.hxx>
+
+#include <libunclassified/pipeline.hxx>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace {
+
+struct message {
+  std::uint64_t _seq;
+  std::uint32_t _count;
+  std::uint32_t _values[13];
+};
+
+emptyspace::pest::suite basic( "pipeline suite", []( auto& test ) {
+  using namespace emptyspace::pest;
+  using namespace unclassified::pipeline;
+
+  test( "a channel keeps the order and ends after close", []( auto& expect ) {
+    constexpr std::uint64_t N = 100000;
+    auto ch = std::make_unique<channel<message, 8>>();
+    stage_counters producer{ "producer" };
+    stage_counters consumer{ "consumer" };
+    std::thread t{ [&]() {
+      producer.start();
+      for( std::uint64_t i = 0; i < N; ++i ) {
+        auto* m = ch->open( producer );
+        m->_seq = i;
+        m->_count = static_cast<std::uint32_t>( i % 13 );
+        for( std::uint32_t j = 0; j < m->_count; ++j ) { m->_values[j] = j; }
+        ch->commit();
+        producer.processed( m->_count );
+      }
+      ch->close( producer );
+      producer.stop();
+    } };
+    consumer.start();
+    bool ordered = true;
+    std::uint64_t expected = 0;
+    std::uint64_t sum = 0;
+    while( auto const* m = ch->next( consumer ) ) {
+      ordered = ordered and m->_seq == expected++;
+      for( std::uint32_t j = 0; j < m->_count; ++j ) { sum += m->_values[j]; }
+      consumer.processed( m->_count );
+      ch->release();
+    }
+    consumer.stop();
+    t.join();
+    expect( ordered, equal_to( true ) );
+    expect( expected, equal_to( N ) );
+    expect( consumer._batches, equal_to( N ) );
+    expect( consumer._items, equal_to( producer._items ) );
+    // 0 + 1 + .. + 11 per 13 messages, with `N % 13 == 4` messages left over
+    expect( sum, equal_to( ( N / 13 ) * 286 + 0 + 0 + 1 + 3 ) );
+    expect( consumer.busy() <= consumer.elapsed(), equal_to( true ) );
+  } );
+
+  test( "stages chain through channels", []( auto& expect ) {
+    auto first = std::make_unique<channel<message, 4>>();
+    auto second = std::make_unique<channel<message, 4>>();
+    stage_counters a{ "a" };
+    stage_counters b{ "b" };
+    stage_counters c{ "c" };
+    std::thread ta{ [&]() {
+      for( std::uint64_t i = 0; i < 1000; ++i ) {
+        first->open( a )->_seq = i;
+        first->commit();
+      }
+      first->close( a );
+    } };
+    std::thread tb{ [&]() {
+      while( auto const* m = first->next( b ) ) {
+        second->open( b )->_seq = m->_seq * 2;
+        second->commit();
+        first->release();
+        b.processed( 1 );
+      }
+      second->close( b );
+    } };
+    std::uint64_t sum = 0;
+    while( auto const* m = second->next( c ) ) {
+      sum += m->_seq;
+      second->release();
+    }
+    ta.join();
+    tb.join();
+    expect( sum, equal_to( 999u * 1000u ) );
+    expect( b._batches, equal_to( 1000u ) );
+  } );
+} );
+
+} // namespace
+
+int main() {
+  basic( std::clog );
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <libriot/index-compactor.hxx>
+#include <libriot/index-ordinals.hxx>
+#include <libriot/index-view.hxx>
+#include <libunclassified/femtolog.hxx>
+
+#include <nygma/ny-command-compact.hxx>
+#include <nygma/ny-command-support.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace nygma {
+
+namespace {
+
+// an index segment of one of the captures
+struct source {
+  std::size_t _capture;
+  std::filesystem::path _i4;
+  std::filesystem::path _ix;
+  // empty for captures indexed without `.i6` / `.if` files
+  std::filesystem::path _i6;
+  std::filesystem::path _if;
+  // in the compacted offset space, `_end` is the beginning of the next segment
+  std::uint64_t _begin;
+  std::uint64_t _end;
+};
+
+template <typename IndexBuilder, typename Key = std::uint32_t, typename Cycler>
+void compact( capture_set const& set, std::vector<source> const& sources, std::size_t const first,
+              std::size_t const last, std::filesystem::path source::*const index, Cycler& cyc ) {
+  auto const segment_offset = sources[first]._begin;
+  riot::index_compactor<Key> compactor{ segment_offset };
+  // the compactor refers to the views, they must not move
+  std::vector<riot::index_view_handle> views;
+  views.reserve( last - first );
+  for( auto i = first; i < last; ++i ) {
+    auto const& s = sources[i];
+    views.push_back( riot::make_poly_index_view( s.*index ) );
+    compactor.add( *views.back(), set._captures[s._capture]._base );
+  }
+  auto builder = std::make_unique<IndexBuilder>();
+  compactor.merge( *builder );
+  cyc( std::move( builder ), segment_offset );
+}
+
+} // namespace
+
+void ny_command_compact( compact_config const& config ) {
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  capture_set set;
+  std::vector<source> sources;
+  for( auto const& path : config._paths ) {
+    // the capture set refers to its captures independent of the working directory
+    auto const p = std::filesystem::absolute( path );
+    std::error_code ec;
+    auto const size = std::filesystem::file_size( p, ec );
+    if( ec ) {
+      flog( lvl::e, "unable to stat pcap = ", p );
+      return;
+    }
+    auto const stem = p.parent_path() / p.filename().stem();
+    if( stem == std::filesystem::absolute( config._out ) ) {
+      flog( lvl::e, "compacted indices would overwrite the indices of pcap = ", p );
+      return;
+    }
+    index_file_dependencies deps;
+    deps.gather( p.parent_path(), stem );
+    if( deps._i4.empty() ) { flog( lvl::w, "no indices found for pcap = ", p ); }
+    auto const capture = set._captures.size();
+    auto const base = set.size();
+    set.add( p, size );
+    std::size_t segment = 0;
+    bool ordinals = false;
+    deps.for_each( [&]( auto const index_files ) {
+      auto [i4, ix] = index_files;
+      ordinals = ordinals or riot::posting_offsets{ i4 }.ordinals();
+      auto const* const i6 = deps.i6( segment );
+      auto const* const fi = deps.flow( segment++ );
+      // only reads the META record
+      auto const begin = base + riot::make_poly_index_view( i4 ).segment_offset();
+      if( not sources.empty() and sources.back()._capture == capture ) { sources.back()._end = begin; }
+      sources.push_back( { capture, i4, ix, i6 ? *i6 : std::filesystem::path{},
+                           fi ? *fi : std::filesystem::path{}, begin, base + size } );
+    } );
+    // the compacted offset space needs offsets as postings
+    if( ordinals ) {
+      flog( lvl::e, "unable to compact the ordinal postings of pcap = ", p );
+      return;
+    }
+  }
+
+  flog( lvl::m, "compact.captures = ", set._captures.size() );
+  flog( lvl::m, "compact.segments = ", sources.size() );
+
+  // a compacted `.i6` index would miss the ipv6 keys of captures without one
+  auto const with_i6 = not sources.empty() and
+                       std::all_of( sources.begin(), sources.end(),
+                                    []( auto const& s ) { return not s._i6.empty(); } );
+  if( not with_i6 ) { flog( lvl::w, "not all captures have i6 indices, skipping i6" ); }
+  auto const with_if = not sources.empty() and
+                       std::all_of( sources.begin(), sources.end(),
+                                    []( auto const& s ) { return not s._if.empty(); } );
+  if( not with_if ) { flog( lvl::w, "not all captures have if indices, skipping if" ); }
+
+  // the async index writer, it is shared among all cyclers
+  auto const w = std::make_shared<riot::index_writer>();
+  auto const d = config._out.parent_path();
+  auto const f = config._out.filename();
+  c256 cyc4{ "i4", config._method_i4, config._adaptive_budget, w, d, f, ".i4" };
+  c128 cycx{ "ix", config._method_ix, config._adaptive_budget, w, d, f, ".ix" };
+  c6 cyc6{ "i6", config._method_i6, config._adaptive_budget, w, d, f, ".i6" };
+  c128 cycf{ "if", config._method_if, config._adaptive_budget, w, d, f, ".if" };
+
+  // greedily merge consecutive segments as long as they span less than 4GiB
+  std::size_t compacted = 0;
+  for( std::size_t first = 0; first < sources.size(); ) {
+    auto last = first + 1;
+    while( last < sources.size() and
+           sources[last]._end - sources[first]._begin <= riot::COMPACTION_SPAN ) {
+      ++last;
+    }
+    flog( lvl::i, "compacting segments [", first, ", ", last, ") @ offset = ", sources[first]._begin );
+    compact<index_i4_type>( set, sources, first, last, &source::_i4, cyc4 );
+    compact<index_ix_type>( set, sources, first, last, &source::_ix, cycx );
+    if( with_i6 ) {
+      compact<index_i6_type, __uint128_t>( set, sources, first, last, &source::_i6, cyc6 );
+    }
+    if( with_if ) { compact<index_if_type>( set, sources, first, last, &source::_if, cycf ); }
+    ++compacted;
+    first = last;
+  }
+
+  cyc4.finish();
+  cycx.finish();
+  if( with_i6 ) { cyc6.finish(); }
+  if( with_if ) { cycf.finish(); }
+
+  auto p = config._out;
+  p += capture_set::SUFFIX;
+  if( not set.write( p ) ) { flog( lvl::e, "unable to write capture set path = ", p ); }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const delta_t = std::chrono::duration<double>( end - start ).count();
+  flog( lvl::i, "delta_t = ", delta_t );
+  flog( lvl::i, "capture set = ", p );
+  flog( lvl::i, "segments = ", sources.size(), " compacted into ", compacted );
+}
+
+} // namespace nygma
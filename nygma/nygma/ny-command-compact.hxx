@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <nygma/ny-command-index.hxx>
+
+#include <filesystem>
+#include <vector>
+
+namespace nygma {
+
+struct compact_config {
+  // via command line
+  std::vector<std::filesystem::path> _paths;
+  // writes `<out>.ic` plus `<out>-NNNN.i4` / `<out>-NNNN.ix` ( / `<out>-NNNN.i6` / `.if` )
+  std::filesystem::path _out{ "/non-existent" };
+  compression_method _method_i4{ compression_method::NONE };
+  compression_method _method_i6{ compression_method::NONE };
+  compression_method _method_ix{ compression_method::NONE };
+  compression_method _method_if{ compression_method::NONE };
+  // `ADAPTIVE` only, see `index_pcap_config::_adaptive_budget`
+  std::size_t _adaptive_budget{ 0 };
+
+  compact_config() {}
+};
+
+void ny_command_compact( compact_config const& cfg );
+
+} // namespace nygma
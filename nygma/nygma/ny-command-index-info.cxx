@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
+#include <libriot/index-stats.hxx>
 #include <libriot/index-view.hxx>
 #include <libunclassified/femtolog.hxx>
 
@@ -10,6 +11,8 @@
 #include <cstdint>
 #include <iterator>
 #include <map>
+#include <ostream>
+#include <string>
 
 extern "C" {
 #include <arpa/inet.h>
@@ -19,6 +22,36 @@ extern "C" {
 
 namespace nygma {
 
+namespace {
+
+// the counters of the keys next to the index file at `path` ( `ny index-pcap --key-stats` )
+template <typename Key>
+void output_key_stats( std::filesystem::path const& path, std::ostream& os ) {
+  auto const file = riot::key_stats_file<Key>::of( path );
+  if( not file ) {
+    flog( lvl::m, "index_view.key_stats = no" );
+    return;
+  }
+  flog( lvl::m, "index_view.key_stats = ", riot::stats::path( path ) );
+  flog( lvl::m, "index_view.key_stats = key : packets, captured bytes, first and last timestamp" );
+  auto const ext = path.extension();
+  auto const complete = ( *file )->for_each( [&]( Key const k, riot::key_stats const& s ) {
+    if constexpr( sizeof( Key ) == 16 ) {
+      os << format_i6( k );
+    } else if( ext == ".i4" ) {
+      char text[INET_ADDRSTRLEN];
+      auto const addr = htonl( k );
+      os << ::inet_ntop( AF_INET, &addr, text, sizeof( text ) );
+    } else {
+      os << k;
+    }
+    os << " : " << format_key_stats( s ) << '\n';
+  } );
+  if( not complete ) { flog( lvl::e, "truncated key stats path = ", riot::stats::path( path ) ); }
+}
+
+} // namespace
+
 void ny_command_index_info( index_info_config const& config ) {
 
   flog( lvl::i, "index_info.path = ", config._path );
@@ -27,9 +60,16 @@ void ny_command_index_info( index_info_config const& config ) {
 
   flog( lvl::m, "index_view.path = ", config._path );
   flog( lvl::m, "index_view.segment_offset = ", iv->segment_offset() );
+  flog( lvl::m, "index_view.key_filter = ", iv.has_key_filter() ? "yes" : "no" );
   flog( lvl::m, "index_view.keys = key : size ( in bytes compressed / on disk )" );
 
   iv->output_keys( std::cout );
+
+  if( config._path.extension() == ".i6" ) {
+    output_key_stats<__uint128_t>( config._path, std::cout );
+  } else {
+    output_key_stats<std::uint32_t>( config._path, std::cout );
+  }
 }
 
 } // namespace nygma
@@ -1,54 +1,194 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
+#include <libnygma/dissect-simd.hxx>
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-view.hxx>
-#include <libriot/index-builder.hxx>
-#include <libriot/index-compressor.hxx>
-#include <libriot/index-cycler.hxx>
+#include <libriot/index-shards.hxx>
+#include <libriot/index-spill.hxx>
 #include <libriot/index-trace.hxx>
 #include <libunclassified/femtolog.hxx>
 #include <libunclassified/format-timestamp.hxx>
+#include <libunclassified/pipeline.hxx>
 
 #include <nygma/ny-command-index.hxx>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
-#include <map>
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <utility>
 
 namespace nygma {
 
-using hash_type = dissect::void_hash_policy;
-template <typename K, typename V>
-using map_type = std::map<K, V>;
-using index_i4_type = typename riot::index_builder<std::uint32_t, map_type, 256>;
-using index_ix_type = typename riot::index_builder<std::uint32_t, map_type, 128>;
-using index_trace_type = typename riot::index_trace<index_i4_type, index_ix_type>;
-
-template <template <typename> typename S1, template <typename> typename S2,
-          template <typename> typename S3>
-struct poly_cycler {
-  std::string _name;
-  riot::index_cycler _cyc;
-  compression_method const _method;
-  template <typename... Args>
-  poly_cycler( std::string_view const name, compression_method const method, Args&&... args )
-    : _name{ name }, _cyc{ std::forward<Args>( args )... }, _method{ method } {}
-  template <typename I>
-  void operator()( I&& i, std::uint64_t const o ) noexcept {
-    flog( lvl::m, "cycler{", _name, "} index path = ", _cyc.path() );
-    flog( lvl::m, "cycler{", _name, "} index.keys = ", i->key_count(), " index.segment_offset = ", o );
-    switch( _method ) {
-      case compression_method::NONE: _cyc.accept<S1>( std::move( i ), o ); break;
-      case compression_method::BITPACK: _cyc.accept<S2>( std::move( i ), o ); break;
-      case compression_method::STREAMVBYTE: _cyc.accept<S3>( std::move( i ), o ); break;
+// packets dissected at once, see `dissect_en10mb_batch`
+constexpr std::size_t BATCH_SIZE = 16;
+// every builder spills sorted runs beyond `--max-builder-memory`
+template <typename I>
+using spilling_type = riot::index_spilling<I>;
+template <template <typename, std::size_t> typename Engine>
+using trace_type = typename riot::index_trace<spilling_type<typename index_types<Engine>::i4>,
+                                              spilling_type<typename index_types<Engine>::ix>,
+                                              spilling_type<typename index_types<Engine>::i6>,
+                                              spilling_type<typename index_types<Engine>::if_>>;
+
+template <typename I>
+using shards_type = riot::index_shards<spilling_type<I>>;
+template <template <typename, std::size_t> typename Engine>
+using sharded_trace_type = typename riot::index_trace<
+    shards_type<typename index_types<Engine>::i4>, shards_type<typename index_types<Engine>::ix>,
+    shards_type<typename index_types<Engine>::i6>, shards_type<typename index_types<Engine>::if_>>;
+
+namespace {
+
+using stage_counters = unclassified::pipeline::stage_counters;
+
+struct packet_stats {
+  std::size_t _total_packets{ 0 };
+  std::size_t _total_bytes{ 0 };
+  std::uint64_t _first_seen{ std::numeric_limits<std::uint64_t>::max() };
+  std::uint64_t _last_seen{ 0 };
+
+  inline void operator()( nygma::packet_view const* const pkts, std::size_t const n ) noexcept {
+    for( std::size_t i = 0; i < n; ++i ) {
+      _total_packets++;
+      _total_bytes += pkts[i]._slice.size();
+      _first_seen = std::min( pkts[i]._stamp, _first_seen );
+      _last_seen = std::max( pkts[i]._stamp, _last_seen );
     }
   }
 };
 
-using c256 = poly_cycler<riot::uc256_serializer, riot::bp256d1_serializer, riot::svb256d1_serializer>;
-using c128 = poly_cycler<riot::uc128_serializer, riot::bp128d1_serializer, riot::svb128d1_serializer>;
+template <typename Pcap>
+bool indexable( Pcap const& pcap ) noexcept {
+  if( not pcap.valid() ) {
+    flog( lvl::e, "invalid pcap" );
+    return false;
+  }
+  if constexpr( Pcap::LINKTYPE == nygma::pcap::linktype::unsupported ) {
+    flog( lvl::e, "unsupported pcap linktype = ", pcap._raw_linktype );
+    return false;
+  }
+  return true;
+}
 
-void ny_command_index_pcap( index_pcap_config const& config ) {
+// the batched dissector is ethernet only, other linktypes get dissected while building
+template <nygma::pcap::linktype::type L>
+inline void dissect_packets( nygma::packet_view const* const pkts, std::size_t const n,
+                             dissect::dissect_batch<BATCH_SIZE>& batch ) noexcept {
+  if constexpr( L == nygma::pcap::linktype::en10mb ) {
+    dissect::dissect_en10mb_batch( pkts, n, batch );
+  }
+}
+
+template <nygma::pcap::linktype::type L, typename Trace, typename Cycler>
+inline void build_packets( Trace& trace, nygma::packet_view const* const pkts,
+                           dissect::dissect_batch<BATCH_SIZE> const& batch,
+                           std::uint64_t const* const offsets, std::size_t const n,
+                           Cycler const& cycler ) noexcept {
+  if constexpr( L == nygma::pcap::linktype::en10mb ) {
+    trace.add( pkts, batch, offsets, cycler );
+  } else {
+    dissect::void_hash_policy hash;
+    for( std::size_t i = 0; i < n; ++i ) {
+      trace.prepare( offsets[i], cycler, pkts[i]._stamp,
+                     static_cast<std::uint32_t>( pkts[i].size() ) );
+      dissect::dissect_linktype<L>( hash, trace, pkts[i]._slice );
+    }
+  }
+}
+
+//--pipeline-( `--pipeline` )--------------------------------------------------
+
+// a batch of packets from the read stage, the slices point into block `_generation` of the
+// `block_ring_view` until the build stage releases it
+struct packets_message {
+  std::uint64_t _generation;
+  std::size_t _count;
+  nygma::packet_view _packets[BATCH_SIZE];
+  std::uint64_t _offsets[BATCH_SIZE];
+};
+
+struct dissected_message {
+  packets_message _packets;
+  dissect::dissect_batch<BATCH_SIZE> _batch;
+};
+
+void log_stage( stage_counters const& s ) {
+  flog( lvl::i, "stage{", s._name, "} batches = ", s._batches, " packets = ", s._items,
+        " rate = ", s.rate(), "Mpps" );
+  flog( lvl::i, "stage{", s._name, "} busy = ", s.busy(), "s elapsed = ", s.elapsed(), "s" );
+  flog( lvl::i, "stage{", s._name, "} input waits = ", s._input_waits,
+        " stalled = ", stage_counters::seconds( s._input_stalled ), "s" );
+  flog( lvl::i, "stage{", s._name, "} output waits = ", s._output_waits,
+        " stalled = ", stage_counters::seconds( s._output_stalled ), "s" );
+}
+
+// read ( block io and packet boundaries ) -> dissect -> build, the read and dissect stages get a
+// thread each, building happens on the calling thread ( or on the shard threads, see `--shards` )
+template <typename Pcap, typename Trace, typename Cycler>
+void index_pipelined( Pcap const& pcap, Trace& trace, Cycler const& cycler, packet_stats& stats ) {
+  constexpr auto LINKTYPE = Pcap::LINKTYPE;
+  auto const packets = std::make_unique<unclassified::pipeline::channel<packets_message>>();
+  auto const dissected = std::make_unique<unclassified::pipeline::channel<dissected_message>>();
+  stage_counters read{ "read" };
+  stage_counters dissect{ "dissect" };
+  stage_counters build{ "build" };
+
+  std::thread reader{ [&]() noexcept {
+    read.start();
+    pcap.template for_each_batch<BATCH_SIZE>(
+        [&]( auto const* const pkts, auto const* const offsets, std::size_t const n ) noexcept {
+          auto* const m = packets->open( read );
+          m->_generation = pcap._data->generation();
+          m->_count = n;
+          std::copy_n( pkts, n, m->_packets );
+          std::copy_n( offsets, n, m->_offsets );
+          packets->commit();
+          read.processed( n );
+        } );
+    packets->close( read );
+    read.stop();
+  } };
+
+  std::thread dissector{ [&]() noexcept {
+    dissect.start();
+    while( auto const* const m = packets->next( dissect ) ) {
+      auto* const d = dissected->open( dissect );
+      d->_packets = *m;
+      packets->release();
+      auto const& p = d->_packets;
+      dissect_packets<LINKTYPE>( p._packets, p._count, d->_batch );
+      dissected->commit();
+      dissect.processed( p._count );
+    }
+    dissected->close( dissect );
+    dissect.stop();
+  } };
+
+  build.start();
+  while( auto const* const d = dissected->next( build ) ) {
+    auto const& p = d->_packets;
+    build_packets<LINKTYPE>( trace, p._packets, d->_batch, p._offsets, p._count, cycler );
+    stats( p._packets, p._count );
+    build.processed( p._count );
+    // the blocks before this one are done
+    pcap._data->release( p._generation );
+    dissected->release();
+  }
+  trace.finish( cycler );
+  build.stop();
+
+  reader.join();
+  dissector.join();
+  log_stage( read );
+  log_stage( dissect );
+  log_stage( build );
+}
+
+template <typename Trace>
+void index_pcap( index_pcap_config const& config, Trace& trace ) {
   // the async index writer, it is shared among all cyclers
   auto const w = std::make_shared<riot::index_writer>();
 
@@ -58,62 +198,163 @@ void ny_command_index_pcap( index_pcap_config const& config ) {
   flog( lvl::m, "cycler.directory = ", d );
   flog( lvl::m, "cycler.filestem = ", f );
 
-  c256 cyc4{ "i4", config._method_i4, w, d, f, ".i4" };
-  c128 cycx{ "ix", config._method_ix, w, d, f, ".ix" };
+  c256 cyc4{ "i4", config._method_i4, config._adaptive_budget, w, d, f, ".i4" };
+  c128 cycx{ "ix", config._method_ix, config._adaptive_budget, w, d, f, ".ix" };
+  c6 cyc6{ "i6", config._method_i6, config._adaptive_budget, w, d, f, ".i6" };
+  c128 cycf{ "if", config._method_if, config._adaptive_budget, w, d, f, ".if" };
+
+  trace._ordinals = config._ordinals or config._fat_postings;
+  trace._ordinal_table = riot::ordinal_table_builder{ config._fat_postings };
+  trace._key_stats = config._key_stats;
+  trace._sketches = config._sketches;
 
-  auto const cycler = [&]( std::unique_ptr<index_i4_type> i4, std::unique_ptr<index_ix_type> ix,
+  // the counters of the keys of a segment next to its index file, the next segment starts over
+  auto const write_stats = [&w]( std::filesystem::path const& index, auto& stats ) {
+    auto p = riot::stats::path( index );
+    flog( lvl::m, "key stats path = ", p, " keys = ", stats.key_count() );
+    w->send( [p = std::move( p ), s = std::exchange( stats, {} )]() {
+      if( not s.write( p ) ) { flog( lvl::e, "unable to write key stats path = ", p ); }
+    } );
+  };
+
+  // sharded indices get merged into one builder per index first
+  auto const cycler = [&]( auto i4, auto ix, auto i6, auto fi,
                            std::uint64_t const segment_offset ) noexcept {
     flog( lvl::i, "cycler callback for segment offset = ", segment_offset );
-    cyc4( std::move( i4 ), segment_offset );
-    cycx( std::move( ix ), segment_offset );
+    // the ordinals of the segment, the next segment starts over with an empty table
+    if( trace._ordinals ) {
+      auto p = riot::ordinals::path( cyc4._cyc.path() );
+      flog( lvl::m, "ordinal table path = ", p, " packets = ", trace._ordinal_table.size() );
+      auto t = std::exchange( trace._ordinal_table,
+                              riot::ordinal_table_builder{ config._fat_postings } );
+      w->send( [p = std::move( p ), t = std::move( t )]() {
+        if( not t.write( p ) ) { flog( lvl::e, "unable to write ordinal table path = ", p ); }
+      } );
+    }
+    if( trace._key_stats ) {
+      write_stats( cyc4._cyc.path(), trace._v4_stats );
+      write_stats( cycx._cyc.path(), trace._port_stats );
+      write_stats( cyc6._cyc.path(), trace._v6_stats );
+      write_stats( cycf._cyc.path(), trace._flow_stats );
+    } else {
+      // the counters of an earlier `--key-stats` run do not match the new indices
+      for( auto const& p : { cyc4._cyc.path(), cycx._cyc.path(), cyc6._cyc.path(),
+                             cycf._cyc.path() } ) {
+        std::error_code ec;
+        std::filesystem::remove( riot::stats::path( p ), ec );
+      }
+    }
+    if( trace._sketches ) {
+      auto p = riot::sketch::path( cyc4._cyc.path() );
+      flog( lvl::m, "sketch path = ", p, " hosts = ", trace._sketch.host_count() );
+      w->send( [p = std::move( p ), s = std::exchange( trace._sketch, {} )]() {
+        if( not s.write( p ) ) { flog( lvl::e, "unable to write sketch path = ", p ); }
+      } );
+    } else {
+      std::error_code ec;
+      std::filesystem::remove( riot::sketch::path( cyc4._cyc.path() ), ec );
+    }
+    cyc4( riot::builder_of( std::move( i4 ) ), segment_offset );
+    cycx( riot::builder_of( std::move( ix ) ), segment_offset );
+    cyc6( riot::builder_of( std::move( i6 ) ), segment_offset );
+    cycf( riot::builder_of( std::move( fi ) ), segment_offset );
   };
 
-  std::size_t total_packets{ 0 };
-  std::size_t total_bytes{ 0 };
-  std::uint64_t first_seen{ std::numeric_limits<std::uint64_t>::max() };
-  std::uint64_t last_seen{ 0 };
+  packet_stats stats;
 
   flog( lvl::m, "pcap storage path = ", config._path );
 
-  auto data = std::make_unique<nygma::block_view_2m>( config._path, nygma::block_flags::rd );
   auto const start = std::chrono::high_resolution_clock::now();
 
-  index_trace_type trace;
-  hash_type hash;
-  nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
-    if( not pcap.valid() ) {
-      flog( lvl::e, "invalid pcap" );
-      return;
-    }
-    pcap.for_each( [&]( auto const& pkt, auto const offset ) noexcept {
-      trace.prepare( offset, cycler );
-      riot::dissect::dissect_en10mb( hash, trace, pkt._slice );
-      total_packets++;
-      total_bytes += pkt._slice.size();
-      first_seen = std::min( pkt._stamp, first_seen );
-      last_seen = std::max( pkt._stamp, last_seen );
+  if( config._pipeline ) {
+    auto data = std::make_unique<nygma::block_ring_view_2m>( config._path, nygma::block_flags::rd );
+    nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+      if( not indexable( pcap ) ) { return; }
+      index_pipelined( pcap, trace, cycler, stats );
+    } );
+  } else {
+    auto data = std::make_unique<nygma::block_view_2m>( config._path, nygma::block_flags::rd );
+    dissect::dissect_batch<BATCH_SIZE> batch;
+    nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+      constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
+      if( not indexable( pcap ) ) { return; }
+      pcap.template for_each_batch<BATCH_SIZE>(
+          [&]( auto const* const pkts, auto const* const offsets, std::size_t const n ) noexcept {
+            dissect_packets<LINKTYPE>( pkts, n, batch );
+            build_packets<LINKTYPE>( trace, pkts, batch, offsets, n, cycler );
+            stats( pkts, n );
+          } );
+      trace.finish( cycler );
     } );
-    trace.finish( cycler );
-  } );
+  }
+
+  cyc4.finish();
+  cycx.finish();
+  cyc6.finish();
+  cycf.finish();
 
   auto const end = std::chrono::high_resolution_clock::now();
   auto const delta_t = std::chrono::duration<double>( end - start ).count();
   char first[unclassified::format::TIMESTAMP_BUFSZ];
   char last[unclassified::format::TIMESTAMP_BUFSZ];
-  auto const nf = unclassified::format::format_ts( first, first_seen );
-  auto const nl = unclassified::format::format_ts( last, last_seen );
-  auto const rate_packtes = to_Mops( total_packets, delta_t );
-  auto const rate_bits = to_Mbps( total_bytes, delta_t );
+  auto const nf = unclassified::format::format_ts( first, stats._first_seen );
+  auto const nl = unclassified::format::format_ts( last, stats._last_seen );
+  auto const rate_packtes = to_Mops( stats._total_packets, delta_t );
+  auto const rate_bits = to_Mbps( stats._total_bytes, delta_t );
 
   flog( lvl::i, "delta_t = ", delta_t );
-  flog( lvl::i, "total bytes = ", total_bytes );
+  flog( lvl::i, "total bytes = ", stats._total_bytes );
   flog( lvl::i, "rate packets = ", rate_packtes, "Mpps" );
   flog( lvl::i, "rate bits = ", rate_bits, "Mbps" );
   flog( lvl::i, "first seen = ", std::string_view{ first, nf } );
   flog( lvl::i, "last seen = ", std::string_view{ last, nl } );
   flog( lvl::i, "v4 packet count = ", trace._v4_count );
   flog( lvl::i, "v6 packet count = ", trace._v6_count );
-  flog( lvl::i, "total packet count = ", total_packets );
+  flog( lvl::i, "tunneled packet count = ", trace._tunnel_count );
+  auto const& fragments = trace._fragments;
+  flog( lvl::i, "fragment table memory = ", to_KiB( fragments.memory() ), "KiB" );
+  flog( lvl::i, "first fragment count = ", fragments._inserted );
+  flog( lvl::i, "later fragments with ports = ", fragments._found,
+        " without = ", fragments._missed );
+  flog( lvl::i, "fragment table evictions = ", fragments._evicted );
+  flog( lvl::i, "total packet count = ", stats._total_packets );
+}
+
+} // namespace
+
+template <template <typename, std::size_t> typename Engine>
+void index_pcap_with( index_pcap_config const& config ) {
+  using types = index_types<Engine>;
+  auto const budget = config._max_builder_memory;
+  if( budget > 0 ) { flog( lvl::i, "index builder memory budget = ", to_MiB( budget ), "MiB" ); }
+  if( config._shards == 0 ) {
+    trace_type<Engine> trace{ std::make_unique<spilling_type<typename types::i4>>( budget ),
+                              std::make_unique<spilling_type<typename types::ix>>( budget ),
+                              std::make_unique<spilling_type<typename types::i6>>( budget ),
+                              std::make_unique<spilling_type<typename types::if_>>( budget ) };
+    index_pcap( config, trace );
+    return;
+  }
+  flog( lvl::i, "builder threads per index = ", config._shards );
+  // the budget is per shard
+  sharded_trace_type<Engine> trace{
+      std::make_unique<shards_type<typename types::i4>>(
+          config._shards, spilling_type<typename types::i4>{ budget } ),
+      std::make_unique<shards_type<typename types::ix>>(
+          config._shards, spilling_type<typename types::ix>{ budget } ),
+      std::make_unique<shards_type<typename types::i6>>(
+          config._shards, spilling_type<typename types::i6>{ budget } ),
+      std::make_unique<shards_type<typename types::if_>>(
+          config._shards, spilling_type<typename types::if_>{ budget } ) };
+  index_pcap( config, trace );
+}
+
+void ny_command_index_pcap( index_pcap_config const& config ) {
+  if( config._bulk ) {
+    index_pcap_with<bulk_engine>( config );
+  } else {
+    index_pcap_with<map_engine>( config );
+  }
 }
 
 } // namespace nygma
@@ -2,6 +2,7 @@
 
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-ordinals.hxx>
 #include <libriot/index-view.hxx>
 #include <libunclassified/femtolog.hxx>
 #include <libunclassified/format-timestamp.hxx>
@@ -9,6 +10,7 @@
 #include <nygma/ny-command-offset-by.hxx>
 #include <nygma/ny-command-support.hxx>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <map>
@@ -43,16 +45,12 @@ void ny_command_offset_by( offsets_by_config const& config ) {
       auto const rs = iv->lookup_forward_32( key );
       std::cout << "@resultset.size = " << rs.size() << std::endl;
       std::ostream_iterator<std::uint32_t> out{ std::cout, "\n" };
-      std::copy_n( rs.values().begin(), rs.values().size(), out );
+      std::transform( rs.values().begin(), rs.values().end(), out, riot::posting_offsets{ p } );
     }
   }
 
   if( not config._key_i6.empty() ) {
-    __uint128_t key;
-    if( auto const rc = ::inet_pton( AF_INET6, config._key_i6.c_str(), &key ); rc <= 0 ) {
-      flog( lvl::e, "invalid i6 key = ", config._key_i6 );
-      throw std::runtime_error( "invalid i6 key" );
-    }
+    auto const key = parse_i6( config._key_i6 );
     flog( lvl::i, "executing query = i6( ", config._key_i6, " )" );
     for( auto& p : deps._i6 ) {
       flog( lvl::i, "executing query on index file = ", p );
@@ -61,7 +59,7 @@ void ny_command_offset_by( offsets_by_config const& config ) {
       auto const rs = iv->lookup_forward_128( key );
       std::cout << "@resultset.size = " << rs.size() << std::endl;
       std::ostream_iterator<std::uint32_t> out{ std::cout, "\n" };
-      std::copy_n( rs.values().begin(), rs.values().size(), out );
+      std::transform( rs.values().begin(), rs.values().end(), out, riot::posting_offsets{ p } );
     }
   }
 
@@ -75,7 +73,7 @@ void ny_command_offset_by( offsets_by_config const& config ) {
       auto const rs = iv->lookup_forward_32( key );
       std::cout << "@resultset.size = " << rs.size() << std::endl;
       std::ostream_iterator<std::uint32_t> out{ std::cout, "\n" };
-      std::copy_n( rs.values().begin(), rs.values().size(), out );
+      std::transform( rs.values().begin(), rs.values().end(), out, riot::posting_offsets{ p } );
     }
   }
 
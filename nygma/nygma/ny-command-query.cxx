@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
 #include <libnygma/dissect.hxx>
+#include <libnygma/flow.hxx>
 #include <libnygma/pcap-reassembler.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-ordinals.hxx>
+#include <libriot/index-stats.hxx>
 #include <libriot/index-view.hxx>
 #include <libriot/query-evaluator.hxx>
 #include <libriot/query-parser.hxx>
@@ -12,12 +15,407 @@
 #include <nygma/ny-command-query.hxx>
 #include <nygma/ny-command-support.hxx>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <iostream>
+#include <iterator>
 #include <map>
+#include <stdexcept>
+#include <vector>
 
 namespace nygma {
 
+namespace {
+
+// the segments that can contain hits, `_all` if the directories can not tell
+struct candidates {
+  bool _all{ true };
+  std::vector<std::uint32_t> _segments;
+};
+
+struct segment_filter {
+  segment_directory<std::uint32_t> const& _i4;
+  segment_directory<std::uint32_t> const& _ix;
+  segment_directory<__uint128_t> const& _i6;
+  segment_directory<std::uint32_t> const& _if;
+
+  candidates operator()( riot::ident const& ) const { return {}; }
+  candidates operator()( riot::number const& ) const { return {}; }
+  candidates operator()( riot::ipv4 const& ) const { return {}; }
+  candidates operator()( riot::ipv6 const& ) const { return {}; }
+  candidates operator()( riot::binary const& b ) const {
+    auto a = b._a->eval( *this );
+    // `a - b` is a subset of `a`
+    if( b._op == riot::binop::COMPLEMENT ) { return a; }
+    auto c = b._b->eval( *this );
+    candidates r{ false, {} };
+    auto out = std::back_inserter( r._segments );
+    auto const& x = a._segments;
+    auto const& y = c._segments;
+    if( b._op == riot::binop::UNION ) {
+      if( a._all or c._all ) { return {}; }
+      std::set_union( x.begin(), x.end(), y.begin(), y.end(), out );
+    } else {
+      if( a._all ) { return c; }
+      if( c._all ) { return a; }
+      std::set_intersection( x.begin(), x.end(), y.begin(), y.end(), out );
+    }
+    return r;
+  }
+  candidates operator()( riot::query const& q ) const {
+    if( q._method != riot::query_method::FORWARD ) { return {}; }
+    auto const name = q._name->eval<riot::kind::ID>( []( auto const& id ) { return id._name; } );
+    auto const lookup = []( auto const& dir, auto const k ) {
+      candidates r{ false, {} };
+      if( not dir.lookup( k, r._segments ) ) { return candidates{}; }
+      return r;
+    };
+    if( name == "i6" ) {
+      return q._what->eval( riot::overloaded{
+          [&]( riot::ipv6 const& i6 ) { return lookup( _i6, i6._value ); },
+          []( auto const& ) { return candidates{}; },
+      } );
+    }
+    auto const* const dir = name == "i4"     ? &_i4
+                            : name == "ix"   ? &_ix
+                            : name == "flow" ? &_if
+                                             : nullptr;
+    if( dir == nullptr ) { return {}; }
+    return q._what->eval( riot::overloaded{
+        [&]( riot::number const& n ) {
+          return lookup( *dir, static_cast<std::uint32_t>( n._value ) );
+        },
+        [&]( riot::ipv4 const& i4 ) { return lookup( *dir, i4._value ); },
+        []( auto const& ) { return candidates{}; },
+    } );
+  }
+};
+
+// the indices of `segment` by their query names
+riot::environment environment_of( index_file_dependencies const& deps, std::size_t const segment,
+                                  std::filesystem::path const& i4,
+                                  std::filesystem::path const& ix ) {
+  auto b = riot::environment::builder();
+  b.add( "i4", i4 ).add( "ix", ix );
+  if( auto const* const i6 = deps.i6( segment ); i6 != nullptr ) { b.add( "i6", *i6 ); }
+  if( auto const* const fi = deps.flow( segment ); fi != nullptr ) { b.add( "flow", *fi ); }
+  return b.build();
+}
+
+// the flows of the `flow-of( offset )` terms of a query. their packets are found by flow hash,
+// slicing drops the packets of other flows with the same hash ( see `nygma::flow_hash` )
+struct flow_filter {
+  std::vector<std::pair<std::uint32_t, nygma::flow_tuple>> _flows;
+
+  bool empty() const noexcept { return _flows.empty(); }
+
+  // `false` if `t` has the hash of one of the flows without belonging to any of them
+  bool keep( nygma::flow_tuple const& t ) const noexcept {
+    if( t._version == 0 ) { return true; }
+    auto const h = nygma::flow_hash( t );
+    bool collides = false;
+    for( auto const& [hash, flow] : _flows ) {
+      if( hash != h ) { continue; }
+      if( flow.matches( t ) ) { return true; }
+      collides = true;
+    }
+    return not collides;
+  }
+
+  // the packets to slice of a capture of linktype `L`
+  template <nygma::pcap::linktype::type L>
+  auto predicate() const noexcept {
+    return [this, trace = nygma::flow_trace{}]( nygma::packet_view const& p ) mutable noexcept {
+      if constexpr( L == nygma::pcap::linktype::unsupported ) {
+        return true;
+      } else {
+        if( empty() ) { return true; }
+        dissect::void_hash_policy hash;
+        trace.rewind();
+        dissect::dissect_linktype<L>( hash, trace, p._slice );
+        return keep( trace._tuple );
+      }
+    };
+  }
+};
+
+// the flow of the packet at `offset` of the capture at `path`
+nygma::flow_tuple flow_at( std::filesystem::path const& path, std::uint64_t const offset ) {
+  nygma::flow_tuple t;
+  std::error_code ec;
+  auto const size = std::filesystem::file_size( path, ec );
+  if( ec or offset + pcap::PACKET_HEADERSZ > size ) { return t; }
+  auto data = std::make_unique<block_view_16k>( path, block_flags::rd );
+  nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+    constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
+    if constexpr( LINKTYPE != nygma::pcap::linktype::unsupported ) {
+      if( not pcap.valid() ) { return; }
+      nygma::flow_trace trace;
+      dissect::void_hash_policy hash;
+      dissect::dissect_linktype<LINKTYPE>( hash, trace, pcap.slice( offset )._slice );
+      t = trace._tuple;
+    }
+  } );
+  return t;
+}
+
+// replaces the `flow-of( offset )` terms of `n` by `flow( hash )` terms, `at( offset )` is the
+// flow of the packet at `offset`.
+//
+// the filter applies to all hits, so every hit has to come from the postings of a `flow-of` term.
+// `true` if that holds for `n`: `flow-of( o ) & a` or `flow-of( o ) + flow-of( p )` but not
+// `flow-of( o ) + a`. the right side of a complement would lose colliding hits, `allowed` is
+// `false` below it
+template <typename At>
+bool resolve_flows( riot::node& n, flow_filter& filter, At const& at, bool const allowed = true ) {
+  if( n.type() == riot::kind::BINARY ) {
+    auto& b = static_cast<riot::binary&>( n );
+    auto const x = resolve_flows( *b._a, filter, at, allowed );
+    auto const y = resolve_flows( *b._b, filter, at, allowed and b._op != riot::binop::COMPLEMENT );
+    switch( b._op ) {
+      case riot::binop::UNION: return x and y;
+      case riot::binop::INTERSECTION: return x or y;
+      case riot::binop::COMPLEMENT: return x;
+    }
+    return false;
+  }
+  if( n.type() != riot::kind::QUERY ) { return false; }
+  auto& q = static_cast<riot::query&>( n );
+  auto const name = q._name->eval<riot::kind::ID>( []( auto const& id ) { return id._name; } );
+  if( name != "flow-of" ) { return false; }
+  if( not allowed ) {
+    throw std::runtime_error( "flow-of: not allowed on the right side of a complement" );
+  }
+  auto const offset = q._what->eval<riot::kind::NUM>( []( auto const& o ) { return o._value; } );
+  auto const t = at( offset );
+  if( t._version == 0 ) { throw std::runtime_error( "flow-of: no ip packet at the offset" ); }
+  auto const h = nygma::flow_hash( t );
+  flog( lvl::i, "flow-of( ", offset, " ) = flow( ", h, " )" );
+  filter._flows.emplace_back( h, t );
+  q._name = riot::ast::ident( q._span, "flow" );
+  q._what = riot::ast::number( q._span, h );
+  return true;
+}
+
+// a hit of `--sort-by-time`, `_offset` is relative to the capture
+struct timed_packet {
+  std::uint64_t _offset;
+  std::uint32_t _length;
+  std::uint64_t _stamp;
+};
+
+// the hits of a segment with their timestamps. fat ordinal tables have them, otherwise the record
+// headers get read
+template <typename Pcap, typename ResultSet>
+void collect_timed( Pcap& pcap, ResultSet const& rs, riot::posting_offsets const& offsets,
+                    std::vector<timed_packet>& timed ) {
+  for( auto const v : rs.values() ) {
+    auto const e = offsets.packet( v );
+    auto const o = rs.segment_offset() + e._offset;
+    if( e._length > 0 ) {
+      timed.push_back( { o, e._length, e._stamp } );
+      continue;
+    }
+    auto const p = pcap.slice( o );
+    timed.push_back( { o, static_cast<std::uint32_t>( p.size() ), p.stamp() } );
+  }
+}
+
+// compacted indices ( `ny compact` ) span many captures. offsets are collected first, then every
+// capture with hits gets opened once
+template <typename Query, typename Selected>
+std::vector<std::uint64_t> capture_set_hits( index_file_dependencies& deps, Query const& query,
+                                             Selected const selected ) {
+  std::vector<std::uint64_t> offsets;
+  std::uint32_t segment = 0;
+  deps.for_each( [&]( auto const index_files ) {
+    auto const s = segment++;
+    if( not selected( s ) ) { return; }
+    auto [i4, ix] = index_files;
+    auto const env = environment_of( deps, s, i4, ix );
+    auto const rs = query->eval( env );
+    riot::posting_offsets const offset_of{ i4 };
+    for( auto const v : rs.values() ) { offsets.push_back( rs.segment_offset() + offset_of( v ) ); }
+  } );
+  flog( lvl::i, "capture set hits = ", offsets.size() );
+  return offsets;
+}
+
+// `f( pcap, local )` for every capture with hits, `local` are the offsets of the hits relative to
+// the capture
+template <typename F>
+void for_each_capture_hit( capture_set const& set, std::vector<std::uint64_t> const& offsets,
+                           F&& f ) {
+  auto it = offsets.begin();
+  std::vector<std::uint64_t> local;
+  for( auto const& capture : set._captures ) {
+    auto const last = std::lower_bound( it, offsets.end(), capture._base + capture._size );
+    if( it == last ) { continue; }
+    local.clear();
+    std::transform( it, last, std::back_inserter( local ),
+                    [&capture]( auto const o ) { return o - capture._base; } );
+    it = last;
+    auto data = std::make_unique<block_view_16k>( capture._path, block_flags::rd );
+    nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+      if( not pcap.valid() ) {
+        flog( lvl::e, "unable to open pcap storage path = ", capture._path );
+        return;
+      }
+      f( pcap, local );
+    } );
+  }
+}
+
+template <typename Query, typename Selected>
+void query_capture_set( query_config const& config, capture_set const& set,
+                        index_file_dependencies& deps, Query const& query, Selected const selected,
+                        flow_filter const& flows ) {
+  auto const offsets = capture_set_hits( deps, query, selected );
+
+  auto os = config._out == "-" ? nygma::pcap_ostream{ STDOUT_FILENO }
+                               : nygma::pcap_ostream{ config._out };
+  pcap::reassemble_begin( set, os );
+
+  for_each_capture_hit( set, offsets, [&]( auto& pcap, auto const& local ) {
+    constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
+    pcap::reassemble_stream_if( pcap, 0u, local.begin(), local.end(), os,
+                                flows.predicate<LINKTYPE>() );
+  } );
+}
+
+//--stats-( `stats( <query> )` )------------------------------------------------
+
+// `stats( <query> )` answers with the packets, bytes and first / last timestamp of the hits instead
+// of slicing them. `query` becomes the inner query
+bool unwrap_stats( riot::expression& query ) {
+  if( query->type() != riot::kind::QUERY ) { return false; }
+  auto& q = static_cast<riot::query&>( *query );
+  if( q._method != riot::query_method::FORWARD or q._name->type() != riot::kind::ID ) {
+    return false;
+  }
+  auto const name = q._name->eval<riot::kind::ID>( []( auto const& id ) { return id._name; } );
+  if( name != "stats" ) { return false; }
+  auto what = std::move( q._what );
+  query = std::move( what );
+  return true;
+}
+
+// the counters of `k` summed over the `--key-stats` files of the selected segments, `false` if a
+// segment has none
+template <typename Key, typename Selected>
+bool sum_key_stats( std::vector<std::filesystem::path> const& files, std::size_t const segments,
+                    Key const k, Selected const selected, riot::key_stats& r ) {
+  if( files.size() != segments ) { return false; }
+  for( std::uint32_t s = 0; s < files.size(); ++s ) {
+    if( not selected( s ) ) { continue; }
+    auto const file = riot::key_stats_file<Key>::of( files[s] );
+    if( not file ) { return false; }
+    r.merge( ( *file )->lookup( k ) );
+  }
+  return true;
+}
+
+// a single key term like `i4( 10.0.0.1 )` is answered by the counters of the key
+template <typename Selected>
+bool stats_of_key( riot::node const& n, index_file_dependencies const& deps,
+                   Selected const selected, riot::key_stats& r ) {
+  if( n.type() != riot::kind::QUERY ) { return false; }
+  auto const& q = static_cast<riot::query const&>( n );
+  if( q._method != riot::query_method::FORWARD or q._name->type() != riot::kind::ID ) {
+    return false;
+  }
+  auto const name = q._name->eval( riot::overloaded{
+      []( riot::ident const& id ) { return id._name; },
+      []( auto const& ) { return std::string{}; },
+  } );
+  auto const segments = deps._i4.size();
+  if( name == "i6" ) {
+    return q._what->eval( riot::overloaded{
+        [&]( riot::ipv6 const& i6 ) {
+          return sum_key_stats( deps._i6, segments, i6._value, selected, r );
+        },
+        []( auto const& ) { return false; },
+    } );
+  }
+  auto const* const files = name == "i4"     ? &deps._i4
+                            : name == "ix"   ? &deps._ix
+                            : name == "flow" ? &deps._if
+                                             : nullptr;
+  if( files == nullptr ) { return false; }
+  return q._what->eval( riot::overloaded{
+      [&]( riot::number const& k ) {
+        auto const k32 = static_cast<std::uint32_t>( k._value );
+        return sum_key_stats( *files, segments, k32, selected, r );
+      },
+      [&]( riot::ipv4 const& k ) {
+        return sum_key_stats( *files, segments, k._value, selected, r );
+      },
+      []( auto const& ) { return false; },
+  } );
+}
+
+// the hits of all other queries get counted one by one, by their fat ordinal table entries or
+// their record headers
+template <typename Query, typename Selected>
+riot::key_stats query_stats( query_config const& config, capture_set const& set,
+                             index_file_dependencies& deps, Query const& query,
+                             Selected const selected, flow_filter const& flows ) {
+  riot::key_stats r;
+  // colliding flow hashes need a look at the packets
+  if( flows.empty() and stats_of_key( *query, deps, selected, r ) ) {
+    flog( lvl::i, "stats from key stats" );
+    return r;
+  }
+  r = {};
+  flog( lvl::i, "stats from hits" );
+  auto const count = [&]( auto& pcap, auto const& hits ) {
+    constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
+    auto keep = flows.predicate<LINKTYPE>();
+    for( auto const& h : hits ) {
+      if( not flows.empty() and not keep( pcap.slice( h._offset ) ) ) { continue; }
+      r.add( h._length, h._stamp );
+    }
+  };
+
+  if( config._path.extension() == capture_set::SUFFIX ) {
+    auto const offsets = capture_set_hits( deps, query, selected );
+    std::vector<timed_packet> timed;
+    for_each_capture_hit( set, offsets, [&]( auto& pcap, auto const& local ) {
+      timed.clear();
+      for( auto const o : local ) {
+        auto const p = pcap.slice( o );
+        timed.push_back( { o, static_cast<std::uint32_t>( p.size() ), p.stamp() } );
+      }
+      count( pcap, timed );
+    } );
+    return r;
+  }
+
+  auto data = std::make_unique<block_view_16k>( config._path, block_flags::rd );
+  nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+    if( not pcap.valid() ) {
+      flog( lvl::e, "unable to open pcap storage path = ", config._path );
+      return;
+    }
+    std::vector<timed_packet> timed;
+    std::uint32_t segment = 0;
+    deps.for_each( [&]( auto const index_files ) {
+      auto const s = segment++;
+      if( not selected( s ) ) { return; }
+      auto [i4, ix] = index_files;
+      auto const env = environment_of( deps, s, i4, ix );
+      auto const rs = query->eval( env );
+      timed.clear();
+      collect_timed( pcap, rs, riot::posting_offsets{ i4 }, timed );
+      count( pcap, timed );
+    } );
+  } );
+  return r;
+}
+
+} // namespace
+
 void ny_command_query( query_config const& config ) {
 
   auto const d = config._root == "" ? config._path.parent_path() : config._root;
@@ -31,7 +429,51 @@ void ny_command_query( query_config const& config ) {
   index_file_dependencies deps;
   deps.gather( d, expected_base );
 
-  auto const query = riot::parse( config._query );
+  auto query = riot::parse( config._query );
+  auto const stats = unwrap_stats( query );
+
+  auto const is_capture_set = config._path.extension() == capture_set::SUFFIX;
+  auto const set = is_capture_set ? capture_set::read( config._path ) : capture_set{};
+  flow_filter flows;
+  auto const covered = resolve_flows( *query, flows, [&]( std::uint64_t const offset ) {
+    if( not is_capture_set ) { return flow_at( config._path, offset ); }
+    for( auto const& capture : set._captures ) {
+      if( offset >= capture._base and offset - capture._base < capture._size ) {
+        return flow_at( capture._path, offset - capture._base );
+      }
+    }
+    return nygma::flow_tuple{};
+  } );
+  if( not flows.empty() and not covered ) {
+    throw std::runtime_error( "flow-of: every hit has to be a hit of a flow-of term" );
+  }
+
+  // consult the key -> segment directories to skip segments without hits
+  segment_directory<std::uint32_t> const dir4{ expected_base, ".i4", deps._i4.size() };
+  segment_directory<std::uint32_t> const dirx{ expected_base, ".ix", deps._ix.size() };
+  segment_directory<__uint128_t> const dir6{ expected_base, ".i6", deps._i6.size() };
+  segment_directory<std::uint32_t> const dirf{ expected_base, ".if", deps._if.size() };
+  auto const c = query->eval( segment_filter{ dir4, dirx, dir6, dirf } );
+  if( not c._all ) {
+    flog( lvl::i, "segment directory selected ", c._segments.size(), " of ", deps._i4.size(),
+          " segments" );
+  }
+
+  auto const selected = [&c]( std::uint32_t const s ) {
+    return c._all or std::binary_search( c._segments.begin(), c._segments.end(), s );
+  };
+
+  if( stats ) {
+    std::cout << format_key_stats( query_stats( config, set, deps, query, selected, flows ) )
+              << std::endl;
+    return;
+  }
+
+  if( is_capture_set ) {
+    if( config._sort_by_time ) { flog( lvl::w, "capture sets are sliced in capture order" ); }
+    query_capture_set( config, set, deps, query, selected, flows );
+    return;
+  }
 
   auto data = std::make_unique<block_view_16k>( config._path, block_flags::rd );
   nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
@@ -45,13 +487,33 @@ void ny_command_query( query_config const& config ) {
                                  : nygma::pcap_ostream{ config._out };
 
     pcap::reassemble_begin( pcap, os );
+    constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
 
+    std::vector<timed_packet> timed;
+    std::uint32_t segment = 0;
     deps.for_each( [&]( auto const index_files ) {
+      auto const s = segment++;
+      if( not selected( s ) ) { return; }
       auto [i4, ix] = index_files;
-      auto const env = riot::environment::builder().add( "i4", i4 ).add( "ix", ix ).build();
+      auto const env = environment_of( deps, s, i4, ix );
       auto const rs = query->eval( env );
-      pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os );
+      // all indices of a segment share its postings, offsets or ordinals
+      riot::posting_offsets const offsets{ i4 };
+      if( config._sort_by_time ) {
+        collect_timed( pcap, rs, offsets, timed );
+        return;
+      }
+      pcap::reassemble_stream_if( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os,
+                                  flows.predicate<LINKTYPE>(), offsets.packets() );
     } );
+
+    if( not config._sort_by_time ) { return; }
+    std::stable_sort( timed.begin(), timed.end(),
+                      []( auto const& a, auto const& b ) { return a._stamp < b._stamp; } );
+    flog( lvl::i, "sorted hits = ", timed.size() );
+    auto const same = []( timed_packet const& t ) noexcept { return t; };
+    pcap::reassemble_stream_if( pcap, 0u, timed.cbegin(), timed.cend(), os,
+                                flows.predicate<LINKTYPE>(), same );
   } );
 }
 
@@ -12,6 +12,8 @@ struct query_config {
   std::filesystem::path _root;
   std::filesystem::path _out{ "-" };
   std::string _query;
+  // the hits ordered by timestamp instead of capture order
+  bool _sort_by_time{ false };
 
   query_config() {}
 };
@@ -3,6 +3,7 @@
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-reassembler.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-ordinals.hxx>
 #include <libriot/index-view.hxx>
 #include <libunclassified/femtolog.hxx>
 #include <libunclassified/format-timestamp.hxx>
@@ -57,6 +58,11 @@ void ny_command_reverse_slice_by( reverse_slice_config const& config ) {
     flog( lvl::i, "executing query = iy( ", config._key_iy, " ) | { i4, ix }" );
     deps.for_each_y( [&]( auto const index_files ) {
       auto [i4, ix, iy] = index_files;
+      // the `.iy` postings are offsets, they can not be looked up among ordinals
+      if( riot::posting_offsets{ i4 }.ordinals() ) {
+        flog( lvl::e, "skipping index files with ordinal postings = ", i4 );
+        return;
+      }
       flog( lvl::v, "executing query on index files = { ", iy, ", ", i4, ", ", iy, " }" );
       auto const py = riot::make_poly_index_view( iy );
       auto const p4 = riot::make_poly_index_view( i4 );
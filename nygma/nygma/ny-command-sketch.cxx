@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <libriot/index-sketch.hxx>
+#include <libunclassified/femtolog.hxx>
+
+#include <nygma/ny-command-sketch.hxx>
+#include <nygma/ny-command-support.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+}
+
+namespace nygma {
+
+namespace {
+
+std::string format_i4( std::uint32_t const key ) {
+  char text[INET_ADDRSTRLEN];
+  auto const addr = htonl( key );
+  if( ::inet_ntop( AF_INET, &addr, text, sizeof( text ) ) == nullptr ) { return "?"; }
+  return text;
+}
+
+} // namespace
+
+void ny_command_sketch( sketch_config const& config ) {
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  // the views refer to the mappings of the files
+  std::vector<std::unique_ptr<riot::sketch_file>> files;
+  for( auto const& path : config._paths ) {
+    auto const p = std::filesystem::absolute( path );
+    index_file_dependencies deps;
+    deps.gather( p.parent_path(), p.parent_path() / p.filename().stem() );
+    if( deps._i4.empty() ) { flog( lvl::w, "no indices found for pcap = ", p ); }
+    for( auto const& i4 : deps._i4 ) {
+      auto f = riot::sketch_file::of( i4 );
+      if( not f ) {
+        flog( lvl::w, "no sketches for index = ", i4, " ( see `ny index-pcap --sketches` )" );
+        continue;
+      }
+      files.push_back( std::move( f ) );
+    }
+  }
+
+  std::vector<riot::sketch_view> segments;
+  segments.reserve( files.size() );
+  std::uint64_t first = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t last = 0;
+  for( auto const& f : files ) {
+    auto const& s = segments.emplace_back( **f );
+    if( s.host_count() == 0 ) { continue; }
+    first = std::min( first, s.first() );
+    last = std::max( last, s.last() );
+  }
+
+  flog( lvl::m, "sketch.segments = ", segments.size() );
+  flog( lvl::m, "sketch.first = ", first, " last = ", last );
+
+  auto const estimate = []( riot::hyperloglog const& h ) { return std::llround( h.estimate() ); };
+
+  if( not config._peers.empty() ) {
+    auto const host = ntohl( ::inet_addr( config._peers.c_str() ) );
+    auto const peers = riot::peers_of( segments, host );
+    std::cout << format_i4( host ) << " : peers ~ " << estimate( peers ) << std::endl;
+  } else {
+    // `=` for exact counters, `~` for estimates
+    for( auto const& h : riot::heavy_hitters( segments, config._top ) ) {
+      auto const op = h._exact ? " = " : " ~ ";
+      auto const peers = riot::peers_of( segments, h._host );
+      std::cout << format_i4( h._host ) << " : packets" << op << h._packets << " bytes" << op
+                << h._bytes << " peers ~ " << estimate( peers ) << '\n';
+    }
+    std::cout << std::flush;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const delta_t = std::chrono::duration<double>( end - start ).count();
+  flog( lvl::i, "delta_t = ", delta_t );
+}
+
+} // namespace nygma
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: BlueOak-1.0.0
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace nygma {
+
+struct sketch_config {
+  // via command line, pcaps indexed with `ny index-pcap --sketches`
+  std::vector<std::filesystem::path> _paths;
+  // the number of heavy hitters to show
+  std::size_t _top{ 10 };
+  // the ipv4 host to estimate the distinct peers of instead
+  std::string _peers;
+
+  sketch_config() {}
+};
+
+void ny_command_sketch( sketch_config const& cfg );
+
+} // namespace nygma
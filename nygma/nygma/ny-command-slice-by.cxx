@@ -3,6 +3,7 @@
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-reassembler.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-ordinals.hxx>
 #include <libriot/index-view.hxx>
 #include <libunclassified/femtolog.hxx>
 #include <libunclassified/format-timestamp.hxx>
@@ -46,50 +47,55 @@ void ny_command_slice_by( slice_config const& config ) {
                                  : nygma::pcap_ostream{ config._out };
     pcap::reassemble_begin( pcap, os );
 
-    auto const stream = [&pcap, &os]( auto const& p, auto const key ) {
+    // the postings of `ny index-pcap --ordinals` get translated by the ordinal table of the segment
+    auto const stream = [&pcap, &os]( auto const& p, auto const key,
+                                      riot::posting_offsets const& offsets ) {
       flog( lvl::v, "executing query on index file = ", p );
       auto iv = riot::make_poly_index_view( p );
-      flog( lvl::v, "@segment offset = ", iv->segment_offset() );
-      auto const rs = iv->lookup_forward_32( key );
+      flog( lvl::v, "@segment offset = ", iv.segment_offset() );
+      auto const rs = iv.lookup_forward_32( key );
       flog( lvl::v, "hits = ", rs.values().size() );
-      pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os );
+      pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os,
+                               offsets.packets() );
     };
 
     auto const stream_ex = [&pcap, &os]( auto const& p, auto const key ) {
       flog( lvl::v, "executing query on index file = ", p );
       auto iv = riot::make_poly_index_view( p );
-      flog( lvl::v, "@segment offset = ", iv->segment_offset() );
-      auto const rs = iv->lookup_forward_128( key );
+      flog( lvl::v, "@segment offset = ", iv.segment_offset() );
+      auto const rs = iv.lookup_forward_128( key );
       flog( lvl::v, "hits = ", rs.values().size() );
-      pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os );
+      riot::posting_offsets const offsets{ p };
+      pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os,
+                               offsets.packets() );
     };
 
     if( not config._key_i4.empty() ) {
       auto const key = ntohl( ::inet_addr( config._key_i4.c_str() ) );
       flog( lvl::i, "executing query = i4( ", config._key_i4, " ) ( ", key, " )" );
-      for( auto& p : deps._i4 ) { stream( p, key ); }
+      segment_directory<std::uint32_t> const dir{ expected_base, ".i4", deps._i4.size() };
+      for( auto& p : dir.select( deps._i4, key ) ) { stream( p, key, riot::posting_offsets{ p } ); }
     }
 
     if( not config._key_i6.empty() ) {
-      __uint128_t key;
-      if( auto const rc = ::inet_pton( AF_INET6, config._key_i6.c_str(), &key ); rc <= 0 ) {
-        flog( lvl::e, "invalid i6 key = ", config._key_i6 );
-        throw std::runtime_error( "invalid i6 key" );
-      }
+      auto const key = parse_i6( config._key_i6 );
       flog( lvl::i, "executing query = i6( ", config._key_i6, " )" );
-      for( auto& p : deps._i6 ) { stream_ex( p, key ); }
+      segment_directory<__uint128_t> const dir{ expected_base, ".i6", deps._i6.size() };
+      for( auto& p : dir.select( deps._i6, key ) ) { stream_ex( p, key ); }
     }
 
     if( not config._key_ix.empty() ) {
       auto const key = static_cast<std::uint32_t>( std::stoul( config._key_ix ) );
       flog( lvl::i, "executing query = ix( ", config._key_ix, " ) ( ", key, " )" );
-      for( auto& p : deps._ix ) { stream( p, key ); }
+      segment_directory<std::uint32_t> const dir{ expected_base, ".ix", deps._ix.size() };
+      for( auto& p : dir.select( deps._ix, key ) ) { stream( p, key, riot::posting_offsets{ p } ); }
     }
 
     if( not config._key_iy.empty() ) {
       auto const key = static_cast<std::uint32_t>( std::stoul( config._key_iy ) );
       flog( lvl::i, "executing query = iy( ", config._key_iy, " ) ( ", key, " )" );
-      for( auto& p : deps._iy ) { stream( p, key ); }
+      // `t3 index-pcap` indices have offsets as postings
+      for( auto& p : deps._iy ) { stream( p, key, riot::posting_offsets{} ); }
     }
   } );
 }
@@ -1,24 +1,75 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
+#include <libnygma/bytestream.hxx>
+#include <libnygma/mmap.hxx>
+#include <libunclassified/bytestring.hxx>
 #include <libunclassified/femtolog.hxx>
+#include <libunclassified/format-timestamp.hxx>
 
 #include <nygma/ny-command-support.hxx>
 
 #include <algorithm>
 #include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+}
 
 namespace nygma {
 
+__uint128_t parse_i6( std::string const& address ) {
+  std::byte addr[sizeof( in6_addr )];
+  if( auto const rc = ::inet_pton( AF_INET6, address.c_str(), addr ); rc <= 0 ) {
+    flog( lvl::e, "invalid i6 key = ", address );
+    throw std::runtime_error( "invalid i6 key" );
+  }
+  return unclassified::unsafe::rd128<unclassified::endianess::BE>( addr );
+}
+
+std::string format_i6( __uint128_t const key ) {
+  std::byte addr[sizeof( in6_addr )];
+  unclassified::unsafe::wr128<unclassified::endianess::BE>( addr, key );
+  char text[INET6_ADDRSTRLEN];
+  if( ::inet_ntop( AF_INET6, addr, text, sizeof( text ) ) == nullptr ) { return "?"; }
+  return text;
+}
+
+std::string format_key_stats( riot::key_stats const& s ) {
+  namespace format = unclassified::format;
+  std::ostringstream os;
+  os << "packets = " << s._packets << " bytes = " << s._bytes;
+  if( s.empty() ) { return os.str(); }
+  char first[format::TIMESTAMP_BUFSZ];
+  char last[format::TIMESTAMP_BUFSZ];
+  auto const nf = format::format_ts( first, s._first );
+  auto const nl = format::format_ts( last, s._last );
+  os << " first = " << std::string_view{ first, nf } << " last = " << std::string_view{ last, nl };
+  return os.str();
+}
+
 void index_file_dependencies::gather( std::filesystem::path const& root,
                                       std::filesystem::path const& stem ) {
-  auto const prefix = stem.string();
+  // index files are named `<stem>-NNNN.<ext>`, a plain prefix match would also pick up the
+  // indices of `<stem>x.pcap` ( e.g. of compacted indices next to their captures )
+  auto const prefix = stem.filename().string() + "-";
+  auto const is_segment_of = [&prefix]( std::string const& name ) {
+    return name.size() > prefix.size() and name.starts_with( prefix ) and
+           std::all_of( name.begin() + static_cast<std::ptrdiff_t>( prefix.size() ), name.end(),
+                        []( char const c ) { return c >= '0' and c <= '9'; } );
+  };
   for( auto& f : std::filesystem::directory_iterator( root ) ) {
     std::error_code ec;
     if( not f.is_regular_file( ec ) ) { continue; }
     auto const p = f.path();
     flog( lvl::d, "visting file = ", p );
     if( not p.has_extension() ) { continue; }
-    if( not p.string().starts_with( prefix ) ) { continue; }
+    if( not is_segment_of( p.stem().string() ) ) { continue; }
     auto const ext = p.extension();
     if( ext == ".i4" ) {
       _i4.push_back( p );
@@ -28,6 +79,8 @@ void index_file_dependencies::gather( std::filesystem::path const& root,
       _ix.push_back( p );
     } else if( ext == ".iy" ) {
       _iy.push_back( p );
+    } else if( ext == ".if" ) {
+      _if.push_back( p );
     }
   }
 
@@ -35,11 +88,58 @@ void index_file_dependencies::gather( std::filesystem::path const& root,
   std::sort( _i6.begin(), _i6.end() );
   std::sort( _ix.begin(), _ix.end() );
   std::sort( _iy.begin(), _iy.end() );
+  std::sort( _if.begin(), _if.end() );
 
   flog( lvl::i, "index_file_dependencies._count_i4 = ", _i4.size() );
   flog( lvl::i, "index_file_dependencies._count_i6 = ", _i6.size() );
   flog( lvl::i, "index_file_dependencies._count_ix = ", _ix.size() );
   flog( lvl::i, "index_file_dependencies._count_iy = ", _iy.size() );
+  flog( lvl::i, "index_file_dependencies._count_if = ", _if.size() );
+}
+
+bool capture_set::write( std::filesystem::path const& p ) const {
+  nygma::cfile_ostream os{ p };
+  auto const count = static_cast<std::uint32_t>( _captures.size() );
+  os.write( &MAGIC, 1 );
+  os.write( &count, 1 );
+  for( auto const& c : _captures ) {
+    auto const path = c._path.string();
+    auto const length = static_cast<std::uint32_t>( path.size() );
+    os.write( &c._base, 1 );
+    os.write( &c._size, 1 );
+    os.write( &length, 1 );
+    os.write( reinterpret_cast<std::byte const*>( path.data() ), path.size() );
+  }
+  return os.ok();
+}
+
+capture_set capture_set::read( std::filesystem::path const& p ) {
+  using unclassified::endianess;
+  namespace unsafe = unclassified::unsafe;
+  nygma::mmap_view const map{ p };
+  auto const data = map.view();
+  auto const* it = data.begin();
+  auto const* const end = data.end();
+  if( end - it < 8 or unsafe::rd32<endianess::LE>( it ) != MAGIC ) {
+    throw std::runtime_error( "INVALID_CAPTURE_SET" );
+  }
+  std::size_t const count = unsafe::rd32<endianess::LE>( it + 4 );
+  it += 8;
+  capture_set set;
+  for( std::size_t i = 0; i < count; ++i ) {
+    if( end - it < 20 ) { throw std::runtime_error( "INVALID_CAPTURE_SET" ); }
+    auto const base = unsafe::rd64<endianess::LE>( it );
+    auto const size = unsafe::rd64<endianess::LE>( it + 8 );
+    std::size_t const length = unsafe::rd32<endianess::LE>( it + 16 );
+    it += 20;
+    if( static_cast<std::size_t>( end - it ) < length or base != set.size() ) {
+      throw std::runtime_error( "INVALID_CAPTURE_SET" );
+    }
+    auto const* const path = reinterpret_cast<char const*>( it );
+    set._captures.push_back( { std::string{ path, length }, base, size } );
+    it += length;
+  }
+  return set;
 }
 
 } // namespace nygma
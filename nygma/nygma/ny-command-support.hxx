@@ -1,21 +1,51 @@
 // SPDX-License-Identifier: BlueOak-1.0.0
 
+#include <libriot/index-directory.hxx>
+#include <libriot/index-stats.hxx>
+#include <libunclassified/femtolog.hxx>
+
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <string>
 #include <string_view>
 #include <tuple>
 #include <vector>
 
 namespace nygma {
 
+// the `.i6` key of a textual ipv6 address: the address as integer, most significant byte first
+// ( like `index_trace` and the query parser have it )
+__uint128_t parse_i6( std::string const& address );
+
+// the textual ipv6 address of an `.i6` key
+std::string format_i6( __uint128_t const key );
+
+// `packets = N bytes = N first = <timestamp> last = <timestamp>`
+std::string format_key_stats( riot::key_stats const& s );
+
 struct index_file_dependencies {
 
   std::vector<std::filesystem::path> _i4;
   std::vector<std::filesystem::path> _i6;
   std::vector<std::filesystem::path> _ix;
   std::vector<std::filesystem::path> _iy;
+  std::vector<std::filesystem::path> _if;
 
   void gather( std::filesystem::path const& root, std::filesystem::path const& strem );
 
+  // the `.i6` index of `segment`, captures indexed before there were `.i6` files have none
+  std::filesystem::path const* i6( std::size_t const segment ) const noexcept {
+    if( _i6.size() != _i4.size() or segment >= _i6.size() ) { return nullptr; }
+    return &_i6[segment];
+  }
+
+  // the `.if` flow index of `segment`, like `i6` it is missing for older captures
+  std::filesystem::path const* flow( std::size_t const segment ) const noexcept {
+    if( _if.size() != _i4.size() or segment >= _if.size() ) { return nullptr; }
+    return &_if[segment];
+  }
+
   template <typename F>
   void for_each( F const f ) {
     auto const sz = _i4.size();
@@ -35,4 +65,79 @@ struct index_file_dependencies {
   }
 };
 
+// the captures of a compacted index set ( see `ny compact` ). the compacted offset space is the
+// concatenation of all captures, `_base` is the offset of a capture in it.
+//
+//   [ MAGIC:4 ][ captures:4 ] ( [ base:8 ][ size:8 ][ length:4 ][ path:length ] ) x captures
+struct capture_set {
+  static constexpr std::uint32_t MAGIC = 0x13371339u;
+  static constexpr std::string_view SUFFIX = ".ic";
+
+  struct capture {
+    std::filesystem::path _path;
+    std::uint64_t _base;
+    std::uint64_t _size;
+  };
+
+  std::vector<capture> _captures;
+
+  // size of the compacted offset space
+  std::uint64_t size() const noexcept {
+    return _captures.empty() ? 0 : _captures.back()._base + _captures.back()._size;
+  }
+
+  void add( std::filesystem::path const& p, std::uint64_t const size ) {
+    _captures.push_back( { p, this->size(), size } );
+  }
+
+  bool write( std::filesystem::path const& p ) const;
+  static capture_set read( std::filesystem::path const& p );
+};
+
+// the key -> segment directory written by `ny index` next to the index files. it is ignored if
+// missing or if it does not match the gathered index files ( e.g. a re-indexed capture )
+template <typename Key>
+class segment_directory {
+  std::unique_ptr<riot::directory_handle<Key>> _handle;
+
+ public:
+  segment_directory( std::filesystem::path const& stem, std::string_view const suffix,
+                     std::size_t const segments ) {
+    auto const p = riot::directory::path( stem, suffix );
+    std::error_code ec;
+    if( not std::filesystem::exists( p, ec ) ) { return; }
+    try {
+      _handle = std::make_unique<riot::directory_handle<Key>>( p );
+    } catch( std::exception const& e ) {
+      flog( lvl::w, "unable to open segment directory = ", p, " error = ", e.what() );
+      return;
+    }
+    if( not( *_handle )->valid() or ( *_handle )->segment_count() != segments ) {
+      flog( lvl::w, "ignoring stale segment directory = ", p );
+      _handle.reset();
+      return;
+    }
+    flog( lvl::i, "segment directory = ", p, " keys = ", ( *_handle )->key_count() );
+  }
+
+  // `false` if there is no usable directory, all segments need to be consulted then
+  bool lookup( Key const k, std::vector<std::uint32_t>& segments ) const {
+    if( not _handle ) { return false; }
+    return ( *_handle )->lookup( k, segments );
+  }
+
+  // the index files which may contain `k`
+  std::vector<std::filesystem::path> select( std::vector<std::filesystem::path> const& files,
+                                             Key const k ) const {
+    std::vector<std::uint32_t> segments;
+    if( not lookup( k, segments ) ) { return files; }
+    std::vector<std::filesystem::path> selected;
+    for( auto const s : segments ) {
+      if( s < files.size() ) { selected.push_back( files[s] ); }
+    }
+    flog( lvl::i, "segment directory selected ", selected.size(), " of ", files.size(), " segments" );
+    return selected;
+  }
+};
+
 } // namespace nygma
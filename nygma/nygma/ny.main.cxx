@@ -5,11 +5,12 @@
 #include <libriot/version.hxx>
 #include <libunclassified/femtolog.hxx>
 
+#include <nygma/ny-command-compact.hxx>
 #include <nygma/ny-command-index-info.hxx>
-#include <nygma/ny-command-index.hxx>
 #include <nygma/ny-command-offset-by.hxx>
 #include <nygma/ny-command-query.hxx>
 #include <nygma/ny-command-reverse-slice-by.hxx>
+#include <nygma/ny-command-sketch.hxx>
 #include <nygma/ny-command-slice-by.hxx>
 
 #include <algorithm>
@@ -17,6 +18,7 @@
 #include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <iterator>
 
 using namespace emptyspace;
 using namespace unclassified;
@@ -51,32 +53,79 @@ void ny_show_version() {
   flog( lvl::i, "ny libnygma.version = ", LIBNYGMA_VERSION_STR );
 }
 
+auto const methods = "NONE|BITPACK|STREAMVBYTE|ADAPTIVE|ROARING|ELIASFANO";
+
+compression_method to_method( std::string const& method ) {
+  std::string M = method;
+  std::transform( M.begin(), M.end(), M.begin(), []( auto const c ) { return std::toupper( c ); } );
+  if( M == "NONE" ) {
+    return compression_method::NONE;
+  } else if( M == "BITPACK" ) {
+    return compression_method::BITPACK;
+  } else if( M == "STREAMVBYTE" ) {
+    return compression_method::STREAMVBYTE;
+  } else if( M == "ADAPTIVE" ) {
+    return compression_method::ADAPTIVE;
+  } else if( M == "ROARING" ) {
+    return compression_method::ROARING;
+  } else if( M == "ELIASFANO" ) {
+    return compression_method::ELIASFANO;
+  } else {
+    throw argh::ValidationError( "invalid compression-method" );
+  }
+}
+
+// roaring containers only pay off for dense postings: packet ordinals fill bitmaps, the byte
+// offsets of a 64k chunk never do ( at most ~1100 packets ) and end up larger than bitpacked
+void expect_dense_postings( compression_method const m, bool const ordinals ) {
+  if( m == compression_method::ROARING and not ordinals ) {
+    throw argh::ValidationError( "ROARING compression needs --ordinals or --fat-postings" );
+  }
+}
+
+auto const budgets = "0|10|25|50: percent of extra size for faster decoding ( ADAPTIVE )";
+
+std::size_t to_budget( unsigned const budget ) {
+  if( std::find( std::begin( adaptive_budgets ), std::end( adaptive_budgets ), budget ) ==
+      std::end( adaptive_budgets ) ) {
+    throw argh::ValidationError( "invalid adaptive-budget" );
+  }
+  return budget;
+}
+
 //--indexing-a-pcap------------------------------------------------------------
 
 void ny_index_pcap( argh::Subparser& argh ) {
-  auto const methods = "NONE|BITPACK|STREAMVBYTE";
   argh::HelpFlag help( argh, "help", "show this help message", { 'h', "help" } );
   argh::ValueFlag<std::string> method_4( argh, "compression", methods, { "i4" }, "STREAMVBYTE" );
   argh::ValueFlag<std::string> method_6( argh, "compression", methods, { "i6" }, "STREAMVBYTE" );
   argh::ValueFlag<std::string> method_x( argh, "compression", methods, { "ix" }, "STREAMVBYTE" );
+  argh::ValueFlag<std::string> method_f( argh, "compression", methods, { "if" }, "STREAMVBYTE" );
+  argh::ValueFlag<unsigned> adaptive_budget( argh, "percent", budgets, { "adaptive-budget" }, 0 );
+  argh::ValueFlag<unsigned> shards( argh, "integer", "builder threads per index ( 0: none )",
+                                    { "shards" }, 0 );
+  argh::Flag pipeline( argh, "pipeline", "read, dissect and build on threads of their own",
+                       { "pipeline" } );
+  argh::Flag bulk( argh, "bulk", "radix sort the postings at the end of a segment instead of a map",
+                   { "bulk" } );
+  argh::ValueFlag<unsigned> max_builder_memory(
+      argh, "MiB", "spill an index builder to disk beyond ( 0: unlimited )",
+      { "max-builder-memory" }, 0 );
+  argh::Flag ordinals( argh, "ordinals",
+                       "packet ordinals as postings, with an ordinal -> offset table per segment",
+                       { "ordinals" } );
+  argh::Flag fat_postings( argh, "fat-postings",
+                           "ordinals with the packet sizes and timestamps for exact-size slicing",
+                           { "fat-postings" } );
+  argh::Flag key_stats( argh, "key-stats",
+                        "packets, bytes and first / last timestamp of every key of a segment",
+                        { "key-stats" } );
+  argh::Flag sketches( argh, "sketches", "heavy hitters and distinct peers of the ipv4 hosts",
+                       { "sketches" } );
   argh::Positional<std::string> path( argh, "path", "path to the pcap to index" );
 
   argh.Parse();
 
-  auto const to_method = []( std::string const& method ) -> compression_method {
-    std::string M = method;
-    std::transform( M.begin(), M.end(), M.begin(), []( auto const c ) { return std::toupper( c ); } );
-    if( M == "NONE" ) {
-      return compression_method::NONE;
-    } else if( M == "BITPACK" ) {
-      return compression_method::BITPACK;
-    } else if( M == "STREAMVBYTE" ) {
-      return compression_method::STREAMVBYTE;
-    } else {
-      throw argh::ValidationError( "invalid compression-method" );
-    }
-  };
-
   if( not path ) { throw argh::Help( "path to pcap file missing" ); }
 
   ny_show_version();
@@ -86,15 +135,108 @@ void ny_index_pcap( argh::Subparser& argh ) {
   config._method_i4 = to_method( argh::get( method_4 ) );
   config._method_i6 = to_method( argh::get( method_6 ) );
   config._method_ix = to_method( argh::get( method_x ) );
+  config._method_if = to_method( argh::get( method_f ) );
+  config._adaptive_budget = to_budget( argh::get( adaptive_budget ) );
+  config._shards = argh::get( shards );
+  config._pipeline = argh::get( pipeline );
+  config._bulk = argh::get( bulk );
+  config._max_builder_memory = std::size_t{ argh::get( max_builder_memory ) } << 20;
+  config._ordinals = argh::get( ordinals );
+  config._fat_postings = argh::get( fat_postings );
+  config._key_stats = argh::get( key_stats );
+  config._sketches = argh::get( sketches );
+  for( auto const m : { config._method_i4, config._method_ix, config._method_if } ) {
+    expect_dense_postings( m, config._ordinals or config._fat_postings );
+  }
 
   flog( lvl::i, "index_pcap_config._path = ", config._path );
   flog( lvl::i, "index_pcap_config._method_i4 = ", to_string( config._method_i4 ) );
   flog( lvl::i, "index_pcap_config._method_i6 = ", to_string( config._method_i6 ) );
   flog( lvl::i, "index_pcap_config._method_ix = ", to_string( config._method_ix ) );
+  flog( lvl::i, "index_pcap_config._method_if = ", to_string( config._method_if ) );
+  flog( lvl::i, "index_pcap_config._adaptive_budget = ", config._adaptive_budget );
+  flog( lvl::i, "index_pcap_config._shards = ", config._shards );
+  flog( lvl::i, "index_pcap_config._pipeline = ", config._pipeline );
+  flog( lvl::i, "index_pcap_config._bulk = ", config._bulk );
+  flog( lvl::i, "index_pcap_config._max_builder_memory = ", config._max_builder_memory );
+  flog( lvl::i, "index_pcap_config._ordinals = ", config._ordinals );
+  flog( lvl::i, "index_pcap_config._fat_postings = ", config._fat_postings );
+  flog( lvl::i, "index_pcap_config._key_stats = ", config._key_stats );
+  flog( lvl::i, "index_pcap_config._sketches = ", config._sketches );
 
   ny_command_index_pcap( config );
 }
 
+//--compacting-the-indices-of-many-pcaps---------------------------------------
+
+void ny_compact( argh::Subparser& argh ) {
+  argh::HelpFlag help( argh, "help", "show this help message", { 'h', "help" } );
+  argh::ValueFlag<std::string> out( argh, "path", "stem of the compacted indices", { 'o', "output" } );
+  argh::ValueFlag<std::string> method_4( argh, "compression", methods, { "i4" }, "STREAMVBYTE" );
+  argh::ValueFlag<std::string> method_6( argh, "compression", methods, { "i6" }, "STREAMVBYTE" );
+  argh::ValueFlag<std::string> method_x( argh, "compression", methods, { "ix" }, "STREAMVBYTE" );
+  argh::ValueFlag<std::string> method_f( argh, "compression", methods, { "if" }, "STREAMVBYTE" );
+  argh::ValueFlag<unsigned> adaptive_budget( argh, "percent", budgets, { "adaptive-budget" }, 0 );
+  argh::PositionalList<std::string> paths( argh, "paths", "indexed pcaps ( in capture order )" );
+
+  argh.Parse();
+
+  if( not paths ) { throw argh::Help( "paths to pcap files missing" ); }
+  if( not out ) { throw argh::Help( "output path missing" ); }
+
+  ny_show_version();
+
+  compact_config config;
+  for( auto const& p : argh::get( paths ) ) { config._paths.emplace_back( p ); }
+  config._out = argh::get( out );
+  config._method_i4 = to_method( argh::get( method_4 ) );
+  config._method_i6 = to_method( argh::get( method_6 ) );
+  config._method_ix = to_method( argh::get( method_x ) );
+  config._method_if = to_method( argh::get( method_f ) );
+  config._adaptive_budget = to_budget( argh::get( adaptive_budget ) );
+  // compacted indices hold byte offsets
+  for( auto const m : { config._method_i4, config._method_ix, config._method_if } ) {
+    expect_dense_postings( m, false );
+  }
+
+  flog( lvl::i, "compact_config._paths = ", config._paths.size() );
+  flog( lvl::i, "compact_config._out = ", config._out );
+  flog( lvl::i, "compact_config._method_i4 = ", to_string( config._method_i4 ) );
+  flog( lvl::i, "compact_config._method_i6 = ", to_string( config._method_i6 ) );
+  flog( lvl::i, "compact_config._method_ix = ", to_string( config._method_ix ) );
+  flog( lvl::i, "compact_config._method_if = ", to_string( config._method_if ) );
+  flog( lvl::i, "compact_config._adaptive_budget = ", config._adaptive_budget );
+
+  ny_command_compact( config );
+}
+
+//--heavy-hitters-of-many-pcaps-----------------------------------------------
+
+void ny_sketch( argh::Subparser& argh ) {
+  argh::HelpFlag help( argh, "help", "show this help message", { 'h', "help" } );
+  argh::ValueFlag<std::size_t> top( argh, "integer", "the number of heavy hitters", { "top" }, 10 );
+  argh::ValueFlag<std::string> peers( argh, "ipv4 address", "the distinct peers of a host",
+                                      { "peers" } );
+  argh::PositionalList<std::string> paths( argh, "paths", "pcaps indexed with `--sketches`" );
+
+  argh.Parse();
+
+  if( not paths ) { throw argh::Help( "paths to pcap files missing" ); }
+
+  ny_show_version();
+
+  sketch_config config;
+  for( auto const& p : argh::get( paths ) ) { config._paths.emplace_back( p ); }
+  config._top = argh::get( top );
+  config._peers = argh::get( peers );
+
+  flog( lvl::i, "sketch_config._paths = ", config._paths.size() );
+  flog( lvl::i, "sketch_config._top = ", config._top );
+  flog( lvl::i, "sketch_config._peers = ", config._peers );
+
+  ny_command_sketch( config );
+}
+
 //--querying-offsets-----------------------------------------------------------
 
 void ny_offsets_by( argh::Subparser& argh ) {
@@ -172,10 +314,12 @@ void ny_slice_by( argh::Subparser& argh ) {
 
 void ny_query( argh::Subparser& argh ) {
   argh::HelpFlag help( argh, "help", "show this help message", { 'h', "help" } );
-  argh::Positional<std::string> path( argh, "path", "path to the indexed pcap" );
+  argh::Positional<std::string> path( argh, "path", "path to the indexed pcap or `.ic`" );
   argh::ValueFlag<std::string> root( argh, "directory", "root path override", { "root" } );
   argh::ValueFlag<std::string> out( argh, "output", "the restitched output", { 'o', "output" }, "-" );
   argh::ValueFlag<std::string> query( argh, "query-expression", "the query", { 'q', "query" } );
+  argh::Flag sort_by_time( argh, "sort-by-time", "restitch the hits ordered by timestamp",
+                           { "sort-by-time" } );
 
   argh.Parse();
 
@@ -186,6 +330,7 @@ void ny_query( argh::Subparser& argh ) {
   config._root = argh::get( root );
   config._out = argh::get( out );
   config._query = argh::get( query );
+  config._sort_by_time = argh::get( sort_by_time );
 
   ny_show_version();
 
@@ -193,6 +338,7 @@ void ny_query( argh::Subparser& argh ) {
   flog( lvl::i, "query_config._root = ", config._root );
   flog( lvl::i, "query_config._out = ", config._out );
   flog( lvl::i, "query_config._query = ", config._query );
+  flog( lvl::i, "query_config._sort_by_time = ", config._sort_by_time );
 
   ny_command_query( config );
 }
@@ -261,6 +407,8 @@ int main( int argc, char* argv[] ) {
   argh::HelpFlag help( argh, "help", "show this help message", { 'h', "help" } );
   argh::Group commands( argh, "commands" );
   argh::Command index( commands, "index-pcap", "index a pcap file", &ny_index_pcap );
+  argh::Command compact( commands, "compact", "merge the indices of many pcaps", &ny_compact );
+  argh::Command sketch( commands, "sketch", "heavy hitters of many pcaps", &ny_sketch );
   argh::Command offsets( commands, "offsets-by", "query offsets", &ny_offsets_by );
   argh::Command slice( commands, "slice-by", "restitch pcap from query", &ny_slice_by );
   argh::Command query( commands, "query", "restitch pcap from query", &ny_query );
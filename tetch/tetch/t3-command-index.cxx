@@ -2,27 +2,29 @@
 
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-arena.hxx>
 #include <libriot/index-builder.hxx>
 #include <libriot/index-compressor.hxx>
 #include <libriot/index-cycler.hxx>
 #include <libunclassified/femtolog.hxx>
 #include <libunclassified/format-timestamp.hxx>
+#include <libunclassified/pipeline.hxx>
 
 #include <tetch/t3-command-index.hxx>
 #include <tetch/t3-hyperscan.hxx>
 #include <tetch/t3-index-trace.hxx>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <fstream>
-#include <map>
+#include <thread>
+#include <vector>
 
 namespace t3tch {
 
 using hash_type = nygma::dissect::void_hash_policy;
-template <typename K, typename V>
-using map_type = std::map<K, V>;
-using index_iy_type = typename riot::index_builder<std::uint32_t, map_type, 128>;
+using index_iy_type = typename riot::arena_index_builder<std::uint32_t, 128>;
 using index_trace_type = typename t3tch::index_trace<index_iy_type, hs_engine>;
 
 template <template <typename> typename S1>
@@ -42,6 +44,162 @@ struct poly_cycler {
 
 using c128 = poly_cycler<riot::svb128d1_serializer>;
 
+//--scanning-threads-(-`--threads`-)-------------------------------------------
+
+namespace {
+
+using stage_counters = unclassified::pipeline::stage_counters;
+using scan_trace_type = typename t3tch::index_trace<batch_matches, hs_engine>;
+
+constexpr std::size_t BATCH_SIZE = 16;
+// matches per message, the matches of a batch take as many messages as they need
+constexpr std::size_t MATCHES = 1024;
+
+// a batch of packets for a scanning thread, the slices point into block `_generation` of the
+// `block_ring_view` until the indexing thread releases it
+struct packets_message {
+  std::uint64_t _generation;
+  std::size_t _count;
+  nygma::packet_view _packets[BATCH_SIZE];
+  std::uint64_t _offsets[BATCH_SIZE];
+};
+
+// matches of a batch in packet order, `_done` with the last of them
+struct matches_message {
+  std::uint64_t _generation;
+  std::size_t _packets;
+  std::uint64_t _offsets[BATCH_SIZE];
+  std::size_t _count;
+  batch_matches::match _matches[MATCHES];
+  bool _done;
+};
+
+struct scanner {
+  scan_trace_type _trace;
+  stage_counters _counters{ "scan" };
+  unclassified::pipeline::channel<packets_message> _packets;
+  unclassified::pipeline::channel<matches_message> _matches;
+
+  explicit scanner( index_trace_type const& trace )
+    : _trace{ trace._engine.clone(), trace._engine_dns.clone() } {}
+
+  template <nygma::pcap::linktype::type L>
+  void run() noexcept {
+    hash_type hash;
+    auto& matches = _trace._index->_matches;
+    _counters.start();
+    while( auto const* const m = _packets.next( _counters ) ) {
+      // the packets of a batch never cycle the segment of the scanning trace
+      for( std::size_t i = 0; i < m->_count; ++i ) {
+        _trace.prepare( i, []( auto&&... ) noexcept {} );
+        t3tch::dissect::dissect_linktype<L>( hash, _trace, m->_packets[i]._slice );
+      }
+      std::size_t sent = 0;
+      do {
+        auto* const out = _matches.open( _counters );
+        out->_generation = m->_generation;
+        out->_packets = m->_count;
+        std::copy_n( m->_offsets, m->_count, out->_offsets );
+        out->_count = std::min( matches.size() - sent, MATCHES );
+        std::copy_n( matches.data() + sent, out->_count, out->_matches );
+        sent += out->_count;
+        out->_done = sent == matches.size();
+        _matches.commit();
+      } while( sent < matches.size() );
+      _counters.processed( m->_count );
+      matches.clear();
+      _packets.release();
+    }
+    _matches.close( _counters );
+    _counters.stop();
+  }
+};
+
+// read -> scan ( round robin on `threads` threads ) -> index. every scanning thread has its own
+// hyperscan scratch, the indexing thread takes the matches from the scanners in the order it
+// handed out the batches, so the postings of a segment stay sorted
+template <typename Pcap, typename Cycler>
+std::uint64_t index_threaded( Pcap const& pcap, index_trace_type& trace, Cycler const& cycler,
+                              unsigned const threads, std::size_t& packets, std::size_t& bytes ) {
+  constexpr auto LINKTYPE = Pcap::LINKTYPE;
+  std::vector<std::unique_ptr<scanner>> scanners;
+  for( unsigned i = 0; i < threads; ++i ) {
+    scanners.push_back( std::make_unique<scanner>( trace ) );
+  }
+  std::vector<std::thread> scanning;
+  for( auto& s : scanners ) { scanning.emplace_back( [&s]() noexcept { s->run<LINKTYPE>(); } ); }
+
+  stage_counters read{ "read" };
+  std::thread reader{ [&]() noexcept {
+    std::size_t next = 0;
+    read.start();
+    pcap.template for_each_batch<BATCH_SIZE>(
+        [&]( auto const* const pkts, auto const* const offsets, std::size_t const n ) noexcept {
+          auto& s = *scanners[next++ % scanners.size()];
+          auto* const m = s._packets.open( read );
+          m->_generation = pcap._data->generation();
+          m->_count = n;
+          std::copy_n( pkts, n, m->_packets );
+          std::copy_n( offsets, n, m->_offsets );
+          s._packets.commit();
+          read.processed( n );
+          for( std::size_t i = 0; i < n; ++i ) { bytes += pkts[i]._slice.size(); }
+          packets += n;
+        } );
+    for( auto& s : scanners ) { s->_packets.close( read ); }
+    read.stop();
+  } };
+
+  stage_counters index{ "index" };
+  std::uint64_t hits = 0;
+  index.start();
+  for( std::size_t next = 0;; ++next ) {
+    auto& s = *scanners[next % scanners.size()];
+    // the next packet of the batch to prepare
+    std::size_t i = 0;
+    auto const* m = s._matches.next( index );
+    if( m == nullptr ) { break; }
+    for( ;; ) {
+      for( std::size_t j = 0; j < m->_count; ++j ) {
+        auto const& match = m->_matches[j];
+        while( i <= match._packet ) { trace.prepare( m->_offsets[i++], cycler ); }
+        trace.add( match._id );
+      }
+      hits += m->_count;
+      if( m->_done ) { break; }
+      s._matches.release();
+      m = s._matches.next( index );
+    }
+    while( i < m->_packets ) { trace.prepare( m->_offsets[i++], cycler ); }
+    index.processed( m->_packets );
+    // the blocks before this one are done
+    pcap._data->release( m->_generation );
+    s._matches.release();
+  }
+  trace.finish( cycler );
+  index.stop();
+
+  reader.join();
+  for( auto& t : scanning ) { t.join(); }
+  for( auto const& s : scanners ) {
+    trace._v4_count += s->_trace._v4_count;
+    trace._v6_count += s->_trace._v6_count;
+    trace._udp_count += s->_trace._udp_count;
+    trace._tcp_count += s->_trace._tcp_count;
+    trace._dns_count += s->_trace._dns_count;
+  }
+  for( auto const* const s : { &read, &index } ) {
+    flog( lvl::i, "stage{", s->_name, "} rate = ", s->rate(), "Mpps busy = ", s->busy(), "s" );
+  }
+  for( auto const& s : scanners ) {
+    auto const& c = s->_counters;
+    flog( lvl::i, "stage{", c._name, "} rate = ", c.rate(), "Mpps busy = ", c.busy(), "s" );
+  }
+  return hits;
+}
+
+} // namespace
+
 void t3_command_index_pcap( index_pcap_config const& config ) {
   // the async index writer, it is shared among all cyclers
   auto const w = std::make_shared<riot::index_writer>();
@@ -92,24 +250,36 @@ void t3_command_index_pcap( index_pcap_config const& config ) {
   hash_type hash;
   std::uint64_t hits = 0;
 
-  auto data = std::make_unique<nygma::block_view_2m>( config._path, nygma::block_flags::rd );
-
   auto const start = std::chrono::high_resolution_clock::now();
 
-  nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
-    if( not pcap.valid() ) {
-      flog( lvl::e, "invalid pcap" );
-      return;
-    }
-    pcap.for_each( [&]( auto const& pkt, auto const offset ) noexcept {
-      trace.prepare( offset, cycler );
-      t3tch::dissect::dissect_en10mb( hash, trace, pkt._slice );
-      total_packets++;
-      total_bytes += pkt._slice.size();
-      hits += trace._matched_ids.size();
+  if( config._threads > 0 ) {
+    flog( lvl::m, "scanning threads = ", config._threads );
+    auto data = std::make_unique<nygma::block_ring_view_2m>( config._path, nygma::block_flags::rd );
+    nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+      if( not pcap.valid() ) {
+        flog( lvl::e, "invalid pcap" );
+        return;
+      }
+      hits = index_threaded( pcap, trace, cycler, config._threads, total_packets, total_bytes );
+    } );
+  } else {
+    auto data = std::make_unique<nygma::block_view_2m>( config._path, nygma::block_flags::rd );
+    nygma::pcap::with( std::move( data ), [&]( auto& pcap ) {
+      constexpr auto LINKTYPE = std::decay_t<decltype( pcap )>::LINKTYPE;
+      if( not pcap.valid() ) {
+        flog( lvl::e, "invalid pcap" );
+        return;
+      }
+      pcap.for_each( [&]( auto const& pkt, auto const offset ) noexcept {
+        trace.prepare( offset, cycler );
+        t3tch::dissect::dissect_linktype<LINKTYPE>( hash, trace, pkt._slice );
+        total_packets++;
+        total_bytes += pkt._slice.size();
+        hits += trace._matched_ids.size();
+      } );
+      trace.finish( cycler );
     } );
-    trace.finish( cycler );
-  } );
+  }
 
   auto const end = std::chrono::high_resolution_clock::now();
 
@@ -10,6 +10,8 @@ struct index_pcap_config {
   std::filesystem::path _path{ "/non-existent" };
   std::filesystem::path _patterns{ "/non-existent" };
   std::string _mode{ "regexp" };
+  // threads scanning the payloads with a hyperscan scratch each, `0` scans on the reading thread
+  unsigned _threads{ 0 };
 
   index_pcap_config() {}
 };
@@ -18,18 +18,25 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace t3tch {
 
 enum class hs_engine_mode { PURE, PUREV, REGEXP, REGEXPV };
 
+// the compiled database is read-only during scans and shared by all clones of an engine, the
+// scratch space is per engine: an engine scans on one thread at a time ( see `clone` )
 struct hs_engine {
  private:
-  hs_database_t* _database{ nullptr };
+  std::shared_ptr<hs_database_t> _database;
   hs_scratch_t* _scrtch{ nullptr };
 
+  hs_engine( std::shared_ptr<hs_database_t> database, hs_scratch_t* const scrtch ) noexcept
+    : _database{ std::move( database ) }, _scrtch{ scrtch } {}
+
  public:
   template <typename Filter>
   explicit hs_engine( hs_engine_mode const mode, ioc::pattern_database const& patterns,
@@ -39,6 +46,7 @@ struct hs_engine {
     std::vector<hs_expr_ext> es;
     std::vector<unsigned> ids;
     std::vector<unsigned> fs;
+    hs_database_t* database{ nullptr };
     hs_platform_info_t platform;
     platform.cpu_features = HS_CPU_FEATURES_AVX2;
     platform.tune = HS_TUNE_FAMILY_GENERIC;
@@ -70,7 +78,7 @@ struct hs_engine {
                                                 static_cast<unsigned>( ps.size() ),
                                                 mode == hs_engine_mode::PURE ? HS_MODE_BLOCK
                                                                              : HS_MODE_VECTORED,
-                                                &platform, &_database, &cerr );
+                                                &platform, &database, &cerr );
           rc != HS_SUCCESS ) {
         if( cerr not_eq nullptr ) { hs_free_compile_error( cerr ); }
         throw std::runtime_error( "hs_engine::constructor: unable to compile pure(v) patterns" );
@@ -78,21 +86,22 @@ struct hs_engine {
     } else {
       // extended flags go into a separate container
       std::vector<hs_expr_ext const*> es_ptrs;
-      for( unsigned i = 0; i < es.size(); i++ ) { es_ptrs[i] = &es[i]; }
+      for( auto const& e : es ) { es_ptrs.push_back( &e ); }
       hs_compile_error_t* cerr{ nullptr };
       if( auto const rc = hs_compile_ext_multi( ps.data(), fs.data(), ids.data(), es_ptrs.data(),
                                                 static_cast<unsigned>( ps.size() ),
                                                 mode == hs_engine_mode::REGEXP ? HS_MODE_BLOCK
                                                                                : HS_MODE_VECTORED,
-                                                &platform, &_database, &cerr );
+                                                &platform, &database, &cerr );
           rc != HS_SUCCESS ) {
         if( cerr not_eq nullptr ) { hs_free_compile_error( cerr ); }
         throw std::runtime_error( "hs_engine::constructor: unable to compile regexp(v) patterns" );
       }
     }
 
-    if( auto const rc = hs_alloc_scratch( _database, &_scrtch ); rc != HS_SUCCESS ) {
-      hs_free_database( _database );
+    _database.reset( database, hs_free_database );
+
+    if( auto const rc = hs_alloc_scratch( database, &_scrtch ); rc != HS_SUCCESS ) {
       throw std::runtime_error( "hs_engine::constructor: unable to allocate scratch space" );
     }
   }
@@ -100,12 +109,21 @@ struct hs_engine {
   hs_engine( hs_engine const& ) = delete;
   hs_engine& operator=( hs_engine const& ) = delete;
 
-  hs_engine( hs_engine&& o ) noexcept : _database{ nullptr }, _scrtch{ nullptr } { o.swap( *this ); }
+  hs_engine( hs_engine&& o ) noexcept { o.swap( *this ); }
   hs_engine& operator=( hs_engine&& o ) noexcept {
     o.swap( *this );
     return *this;
   }
 
+  // an engine sharing the compiled database, with a scratch space of its own for another thread
+  hs_engine clone() const {
+    hs_scratch_t* scrtch{ nullptr };
+    if( auto const rc = hs_clone_scratch( _scrtch, &scrtch ); rc != HS_SUCCESS ) {
+      throw std::runtime_error( "hs_engine::clone: unable to clone scratch space" );
+    }
+    return hs_engine{ _database, scrtch };
+  }
+
   static hs_expr_ext to_extended_flags( ioc::pattern_database::pattern_data const& pattern ) noexcept {
     hs_expr_ext ext;
     ext.flags = 0;
@@ -155,7 +173,7 @@ struct hs_engine {
 
   void status_to( std::ostream& os ) {
     os << "hs_engine._regexp_database.size = ";
-    if( std::size_t sz{ 0 }; hs_database_size( _database, &sz ) == HS_SUCCESS ) {
+    if( std::size_t sz{ 0 }; hs_database_size( _database.get(), &sz ) == HS_SUCCESS ) {
       os << sz << std::endl;
     } else {
       os << "<error>" << std::endl;
@@ -176,7 +194,6 @@ struct hs_engine {
 
   ~hs_engine() {
     if( _scrtch not_eq nullptr ) { hs_free_scratch( _scrtch ); }
-    if( _database not_eq nullptr ) { hs_free_database( _database ); }
   }
 
   static int on_match( unsigned const id, unsigned long long const, unsigned long long const,
@@ -189,16 +206,16 @@ struct hs_engine {
   bool scan( std::byte const* const p, std::size_t const sz,
              std::vector<ioc::pattern_database::pattern_id>& ids ) {
     auto const* data = reinterpret_cast<char const*>( p );
-    auto const rc = hs_scan( _database, data, static_cast<unsigned>( sz ), 0, _scrtch, on_match,
-                             std::addressof( ids ) );
+    auto const rc = hs_scan( _database.get(), data, static_cast<unsigned>( sz ), 0, _scrtch,
+                             on_match, std::addressof( ids ) );
     return rc == HS_SUCCESS;
   }
 
   bool scanv( std::byte const* const* p, unsigned int* sz, std::size_t const count,
               std::vector<ioc::pattern_database::pattern_id>& ids ) {
     auto const data = reinterpret_cast<char const* const*>( p );
-    auto const rc = hs_scan_vector( _database, data, sz, static_cast<unsigned>( count ), 0, _scrtch,
-                                    on_match, std::addressof( ids ) );
+    auto const rc = hs_scan_vector( _database.get(), data, sz, static_cast<unsigned>( count ), 0,
+                                    _scrtch, on_match, std::addressof( ids ) );
     return rc == HS_SUCCESS;
   }
 }; // namespace t3tch
@@ -8,12 +8,31 @@
 #include <libunclassified/bytestring.hxx>
 #include <libunclassified/femtolog.hxx>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace t3tch {
 
 namespace unsafe = unclassified::unsafe;
 namespace dissect = nygma::dissect;
 using endianess = unclassified::endianess;
 
+// the matches of a batch of packets on a scanning thread ( `t3 index-pcap --threads` ), the
+// postings are the positions of the packets in the batch
+struct batch_matches {
+  struct match {
+    std::uint32_t _packet;
+    std::uint32_t _id;
+  };
+
+  std::vector<match> _matches;
+
+  inline void add( std::uint32_t const id, std::uint32_t const packet ) {
+    _matches.push_back( { packet, id } );
+  }
+};
+
 template <typename IndexType, typename Engine>
 struct index_trace : public nygma::dissect::dissect_trace {
   using index_type = IndexType;
@@ -55,6 +74,15 @@ struct index_trace : public nygma::dissect::dissect_trace {
 
     if constexpr( std::is_same_v<T, dissect::ipv4> || std::is_same_v<T, dissect::ipv4f> ) {
       _v4_count++;
+      if constexpr( std::is_same_v<T, dissect::ipv4f> ) {
+        if( unsafe::rd16<BE>( v._begin + 6 ) & 0x1fffu ) {
+          unsigned const len = ( unsigned( v._begin[0] ) & 0x0fu ) << 2;
+          scan_fragment( v._begin + len, v._end );
+        }
+      }
+
+    } else if constexpr( std::is_same_v<T, dissect::ipv6f> ) {
+      if( unsafe::rd16<BE>( v._begin + 2 ) & 0xfff8u ) { scan_fragment( v._begin + 8, v._end ); }
 
     } else if constexpr( std::is_same_v<T, dissect::ipv6> ) {
       _v6_count++;
@@ -126,11 +154,24 @@ struct index_trace : public nygma::dissect::dissect_trace {
     dissect::dissect_trace::rewind();
   }
 
+  // a posting of the current packet for a match found on a scanning thread
+  inline void add( std::uint32_t const id ) noexcept {
+    _index->add( id, static_cast<std::uint32_t>( _offset ) );
+  }
+
   template <typename Cycler>
   inline void finish( Cycler const c ) noexcept {
     // provide the last stored `_segment_offset` to the cycler
     c( std::move( _index ), _segment_offset );
   }
+
+ private:
+  // later fragments have no udp / tcp header, an ioc split across fragments is only found if
+  // one fragment holds all of it
+  inline void scan_fragment( std::byte const* const payload, std::byte const* const end ) noexcept {
+    _engine.scan( payload, static_cast<std::size_t>( end - payload ), _matched_ids );
+    for( auto const id : _matched_ids ) { _index->add( id, static_cast<std::uint32_t>( _offset ) ); }
+  }
 };
 
 } // namespace t3tch
@@ -59,6 +59,8 @@ void t3_index_pcap( argh::Subparser& argh ) {
   argh::ValueFlag<std::string> mode( argh, "mode", "engine mode", { 'm', "mode" }, "pure" );
   argh::ValueFlag<std::string> patterns( argh, "path", "path to the pattern file",
                                          { 'p', "patterns" } );
+  argh::ValueFlag<unsigned> threads( argh, "integer", "scanning threads ( 0: none )",
+                                     { "threads" }, 0 );
 
   argh.Parse();
 
@@ -71,9 +73,11 @@ void t3_index_pcap( argh::Subparser& argh ) {
   config._path = argh::get( path );
   config._patterns = argh::get( patterns );
   config._mode = argh::get( mode );
+  config._threads = argh::get( threads );
 
   flog( lvl::i, "index_pcap_config._path = ", config._path );
   flog( lvl::i, "index_pcap_config._patterns = ", config._patterns );
+  flog( lvl::i, "index_pcap_config._threads = ", config._threads );
 
   t3_command_index_pcap( config );
 }
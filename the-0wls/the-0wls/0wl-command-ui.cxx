@@ -5,6 +5,7 @@
 #include <libnygma/dissect.hxx>
 #include <libnygma/pcap-reassembler.hxx>
 #include <libnygma/pcap-view.hxx>
+#include <libriot/index-ordinals.hxx>
 #include <libriot/index-view.hxx>
 #include <libriot/query-evaluator.hxx>
 #include <libriot/query-parser.hxx>
@@ -354,7 +355,9 @@ struct state {
         flog( lvl::m, "stitching pcap = ", output );
         auto os = nygma::pcap_ostream{ output };
         pcap::reassemble_begin( pcap, os );
-        pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os );
+        riot::posting_offsets const offsets{ f4 };
+        pcap::reassemble_stream( pcap, rs.segment_offset(), rs.cbegin(), rs.cend(), os,
+                                 offsets.packets() );
         output_slice = output;
       } );
     } catch( ... ) { flog( lvl::e, "state::index_query: failed" ); }